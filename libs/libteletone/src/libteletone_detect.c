@@ -100,6 +100,12 @@
 #include <time.h>
 #include <fcntl.h>
 
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define LOW_ENG 10000000
 #define ZC 2
 static teletone_detection_descriptor_t dtmf_detect_row[GRID_FACTOR];
@@ -130,6 +136,131 @@ TELETONE_API(void) teletone_goertzel_update(teletone_goertzel_state_t *goertzel_
 		goertzel_state->v3 = (float)(goertzel_state->fac*goertzel_state->v2 - v1 + sample_buffer[i]);
 	}
 }
+
+/*
+ * The filters of a bank are independent, so they go across the SIMD lanes and
+ * the samples run down them.  BANK_GROUP vectors are stepped together so their
+ * dependency chains overlap, and the state stays in double for the whole
+ * buffer instead of being rounded through float on every sample.
+ */
+#if defined(__AVX__)
+#define BANK_LANES 4
+#define BANK_GROUP 4
+#elif defined(__SSE2__) || defined(_M_X64) || defined(__aarch64__)
+#define BANK_LANES 2
+#define BANK_GROUP 8
+#else
+#define BANK_LANES 1
+#define BANK_GROUP 8
+#endif
+#define BANK_STRIDE (BANK_LANES * BANK_GROUP)
+
+TELETONE_API(void) teletone_goertzel_bank_update(teletone_goertzel_state_t *gs[],
+							  int count,
+							  int16_t sample_buffer[],
+							  int samples)
+{
+	double fac[TELETONE_GOERTZEL_BANK_MAX + BANK_STRIDE] = { 0 };
+	double v2[TELETONE_GOERTZEL_BANK_MAX + BANK_STRIDE] = { 0 };
+	double v3[TELETONE_GOERTZEL_BANK_MAX + BANK_STRIDE] = { 0 };
+	int i, g, x;
+
+	if (count > TELETONE_GOERTZEL_BANK_MAX) {
+		for (x = 0; x < count; x++) {
+			teletone_goertzel_update(gs[x], sample_buffer, samples);
+		}
+		return;
+	}
+
+	for (x = 0; x < count; x++) {
+		fac[x] = gs[x]->fac;
+		v2[x] = gs[x]->v2;
+		v3[x] = gs[x]->v3;
+	}
+
+	for (x = 0; x < count; x += BANK_STRIDE) {
+#if defined(__AVX__)
+		__m256d f[BANK_GROUP], a[BANK_GROUP], b[BANK_GROUP], c;
+
+		for (g = 0; g < BANK_GROUP; g++) {
+			f[g] = _mm256_loadu_pd(fac + x + g * BANK_LANES);
+			a[g] = _mm256_loadu_pd(v2 + x + g * BANK_LANES);
+			b[g] = _mm256_loadu_pd(v3 + x + g * BANK_LANES);
+		}
+		for (i = 0; i < samples; i++) {
+			__m256d famp = _mm256_set1_pd((double) sample_buffer[i]);
+
+			for (g = 0; g < BANK_GROUP; g++) {
+				c = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(f[g], b[g]), a[g]), famp);
+				a[g] = b[g];
+				b[g] = c;
+			}
+		}
+		for (g = 0; g < BANK_GROUP; g++) {
+			_mm256_storeu_pd(v2 + x + g * BANK_LANES, a[g]);
+			_mm256_storeu_pd(v3 + x + g * BANK_LANES, b[g]);
+		}
+#elif defined(__SSE2__) || defined(_M_X64)
+		__m128d f[BANK_GROUP], a[BANK_GROUP], b[BANK_GROUP], c;
+
+		for (g = 0; g < BANK_GROUP; g++) {
+			f[g] = _mm_loadu_pd(fac + x + g * BANK_LANES);
+			a[g] = _mm_loadu_pd(v2 + x + g * BANK_LANES);
+			b[g] = _mm_loadu_pd(v3 + x + g * BANK_LANES);
+		}
+		for (i = 0; i < samples; i++) {
+			__m128d famp = _mm_set1_pd((double) sample_buffer[i]);
+
+			for (g = 0; g < BANK_GROUP; g++) {
+				c = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(f[g], b[g]), a[g]), famp);
+				a[g] = b[g];
+				b[g] = c;
+			}
+		}
+		for (g = 0; g < BANK_GROUP; g++) {
+			_mm_storeu_pd(v2 + x + g * BANK_LANES, a[g]);
+			_mm_storeu_pd(v3 + x + g * BANK_LANES, b[g]);
+		}
+#elif defined(__aarch64__)
+		float64x2_t f[BANK_GROUP], a[BANK_GROUP], b[BANK_GROUP], c;
+
+		for (g = 0; g < BANK_GROUP; g++) {
+			f[g] = vld1q_f64(fac + x + g * BANK_LANES);
+			a[g] = vld1q_f64(v2 + x + g * BANK_LANES);
+			b[g] = vld1q_f64(v3 + x + g * BANK_LANES);
+		}
+		for (i = 0; i < samples; i++) {
+			float64x2_t famp = vdupq_n_f64((double) sample_buffer[i]);
+
+			for (g = 0; g < BANK_GROUP; g++) {
+				c = vaddq_f64(vsubq_f64(vmulq_f64(f[g], b[g]), a[g]), famp);
+				a[g] = b[g];
+				b[g] = c;
+			}
+		}
+		for (g = 0; g < BANK_GROUP; g++) {
+			vst1q_f64(v2 + x + g * BANK_LANES, a[g]);
+			vst1q_f64(v3 + x + g * BANK_LANES, b[g]);
+		}
+#else
+		double *f = fac + x, *a = v2 + x, *b = v3 + x, c;
+
+		for (i = 0; i < samples; i++) {
+			for (g = 0; g < BANK_GROUP; g++) {
+				c = f[g] * b[g] - a[g] + sample_buffer[i];
+				a[g] = b[g];
+				b[g] = c;
+			}
+		}
+#endif
+	}
+
+	for (x = 0; x < count; x++) {
+		gs[x]->v2 = (float) v2[x];
+		gs[x]->v3 = (float) v3[x];
+	}
+}
+
 #ifdef _MSC_VER
 #pragma warning(disable:4244)
 #endif
@@ -219,9 +350,16 @@ TELETONE_API(int) teletone_multi_tone_detect (teletone_multi_tone_t *mt,
 								int samples)
 {
 	int sample, limit = 0, j, x = 0;
-	float v1, famp;
+	float famp;
 	float eng_sum = 0, eng_all[TELETONE_MAX_TONES] = {0.0};
 	int gtest = 0, see_hit = 0;
+	teletone_goertzel_state_t *bank[TELETONE_GOERTZEL_BANK_MAX];
+	int bank_count = 0;
+
+	for(x = 0; x < TELETONE_MAX_TONES && x < mt->tone_count; x++) {
+		bank[bank_count++] = &mt->gs[x];
+		bank[bank_count++] = &mt->gs2[x];
+	}
 
 	for (sample = 0;  sample >= 0 && sample < samples; sample = limit) {
 		mt->total_samples++;
@@ -239,18 +377,10 @@ TELETONE_API(int) teletone_multi_tone_detect (teletone_multi_tone_t *mt,
 			famp = sample_buffer[j];
 			
 			mt->energy += famp*famp;
-
-			for(x = 0; x < TELETONE_MAX_TONES && x < mt->tone_count; x++) {
-				v1 = mt->gs[x].v2;
-				mt->gs[x].v2 = mt->gs[x].v3;
-				mt->gs[x].v3 = (float)(mt->gs[x].fac * mt->gs[x].v2 - v1 + famp);
-	
-				v1 = mt->gs2[x].v2;
-				mt->gs2[x].v2 = mt->gs2[x].v3;
-				mt->gs2[x].v3 = (float)(mt->gs2[x].fac*mt->gs2[x].v2 - v1 + famp);
-			}
 		}
 
+		teletone_goertzel_bank_update(bank, bank_count, sample_buffer + sample, limit - sample);
+
 		mt->current_sample += (limit - sample);
 		if (mt->current_sample < mt->min_samples) {
 			continue;
@@ -311,7 +441,6 @@ TELETONE_API(teletone_hit_type_t) teletone_dtmf_detect (teletone_dtmf_detect_sta
 	float row_energy[GRID_FACTOR];
 	float col_energy[GRID_FACTOR];
 	float famp;
-	float v1;
 	int i;
 	int j;
 	int sample;
@@ -320,6 +449,14 @@ TELETONE_API(teletone_hit_type_t) teletone_dtmf_detect (teletone_dtmf_detect_sta
 	char hit = 0;
 	int limit;
 	teletone_hit_type_t r = 0;
+	teletone_goertzel_state_t *bank[GRID_FACTOR * 4];
+
+	for (i = 0; i < GRID_FACTOR; i++) {
+		bank[i] = &dtmf_detect_state->row_out[i];
+		bank[GRID_FACTOR + i] = &dtmf_detect_state->col_out[i];
+		bank[GRID_FACTOR * 2 + i] = &dtmf_detect_state->row_out2nd[i];
+		bank[GRID_FACTOR * 3 + i] = &dtmf_detect_state->col_out2nd[i];
+	}
 
 	for (sample = 0;  sample < samples;	 sample = limit) {
 		/* BLOCK_LEN is optimised to meet the DTMF specs. */
@@ -330,31 +467,14 @@ TELETONE_API(teletone_hit_type_t) teletone_dtmf_detect (teletone_dtmf_detect_sta
 		}
 
 		for (j = sample;  j < limit;  j++) {
-			int x = 0;
 			famp = sample_buffer[j];
 			
 			dtmf_detect_state->energy += famp*famp;
-
-			for(x = 0; x < GRID_FACTOR; x++) {
-				v1 = dtmf_detect_state->row_out[x].v2;
-				dtmf_detect_state->row_out[x].v2 = dtmf_detect_state->row_out[x].v3;
-				dtmf_detect_state->row_out[x].v3 = (float)(dtmf_detect_state->row_out[x].fac*dtmf_detect_state->row_out[x].v2 - v1 + famp);
-	
-				v1 = dtmf_detect_state->col_out[x].v2;
-				dtmf_detect_state->col_out[x].v2 = dtmf_detect_state->col_out[x].v3;
-				dtmf_detect_state->col_out[x].v3 = (float)(dtmf_detect_state->col_out[x].fac*dtmf_detect_state->col_out[x].v2 - v1 + famp);
-
-				v1 = dtmf_detect_state->col_out2nd[x].v2;
-				dtmf_detect_state->col_out2nd[x].v2 = dtmf_detect_state->col_out2nd[x].v3;
-				dtmf_detect_state->col_out2nd[x].v3 = (float)(dtmf_detect_state->col_out2nd[x].fac*dtmf_detect_state->col_out2nd[x].v2 - v1 + famp);
-		
-				v1 = dtmf_detect_state->row_out2nd[x].v2;
-				dtmf_detect_state->row_out2nd[x].v2 = dtmf_detect_state->row_out2nd[x].v3;
-				dtmf_detect_state->row_out2nd[x].v3 = (float)(dtmf_detect_state->row_out2nd[x].fac*dtmf_detect_state->row_out2nd[x].v2 - v1 + famp);
-			}
-
 		}
 
+		/* all 16 filters see the same samples, step them together */
+		teletone_goertzel_bank_update(bank, GRID_FACTOR * 4, sample_buffer + sample, limit - sample);
+
 		if (dtmf_detect_state->zc > 0) {
 			if (dtmf_detect_state->energy < LOW_ENG && dtmf_detect_state->lenergy < LOW_ENG) {
 				if (!--dtmf_detect_state->zc) {
@@ -133,6 +133,7 @@ extern "C" {
 #define GRID_FACTOR 4
 #define BLOCK_LEN 102
 #define M_TWO_PI 2.0*M_PI
+#define TELETONE_GOERTZEL_BANK_MAX (TELETONE_MAX_TONES * 2)
 
 	typedef enum {
 		TT_HIT_NONE = 0,
@@ -262,6 +263,21 @@ TELETONE_API(void) teletone_goertzel_update(teletone_goertzel_state_t *goertzel_
 								  int16_t sample_buffer[],
 								  int samples);
 
+	/*! 
+	  \brief Step a bank of Goertzel filters through the same samples at once
+	  \param gs the goertzel states of the bank
+	  \param count the number of states in gs, at most TELETONE_GOERTZEL_BANK_MAX
+	  \param sample_buffer an array aof 16 bit signed linear samples
+	  \param samples the number of samples present in sample_buffer
+	  \note Same as teletone_goertzel_update() on each state in turn except that
+	  the state is carried in double precision through the buffer, the filters
+	  are spread over SIMD lanes when the compiler targets them.
+	*/
+TELETONE_API(void) teletone_goertzel_bank_update(teletone_goertzel_state_t *gs[],
+								  int count,
+								  int16_t sample_buffer[],
+								  int samples);
+
 
 
 #ifdef __cplusplus
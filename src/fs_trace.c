@@ -0,0 +1,69 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2019, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * fs_trace.c -- Decode a log trace dump into log lines
+ *
+ */
+
+#include <switch.h>
+
+int main(int argc, char *argv[])
+{
+	switch_stream_handle_t stream = { 0 };
+	int r = 0;
+
+	if (argc != 2 || argv[1][0] == '-') {
+		fprintf(stderr, "Usage: %s <file>\n\n"
+				"Prints the records of a trace written by 'log_trace dump' or by a crash\n"
+				"(log/freeswitch.crash.trace), oldest first.\n", argv[0]);
+		return 255;
+	}
+
+	SWITCH_STANDARD_STREAM(stream);
+
+	if (switch_log_trace_decode(argv[1], &stream) != SWITCH_STATUS_SUCCESS) {
+		r = 1;
+	}
+
+	if (stream.data) {
+		fputs((char *) stream.data, r ? stderr : stdout);
+	}
+
+	switch_safe_free(stream.data);
+
+	return r;
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
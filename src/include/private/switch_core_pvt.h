@@ -103,6 +103,22 @@ typedef enum {
 	SSF_MEDIA_BUG_TAP_ONLY = (1 << 10)
 } switch_session_flag_t;
 
+/* 16 exact buckets, then 16 per power of 2 up to 2^37 usec */
+#define SWITCH_LATENCY_SUB_BITS 4
+#define SWITCH_LATENCY_BUCKETS 544
+#define SWITCH_LATENCY_SHARDS 8
+
+typedef struct {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[SWITCH_LATENCY_BUCKETS];
+} switch_latency_histogram_t;
+
+typedef struct {
+	switch_latency_histogram_t stage[SWITCH_LATENCY_STAGE_COUNT];
+} switch_latency_set_t;
+
 struct switch_core_session {
 	switch_memory_pool_t *pool;
 	switch_thread_t *thread;
@@ -190,6 +206,10 @@ struct switch_core_session {
 	switch_buffer_t *text_line_buffer;
 	switch_mutex_t *text_mutex;
 	const char *external_id;
+
+	switch_latency_set_t *latency;
+	int latency_enabled;
+	switch_time_t latency_state_mark;
 };
 
 struct switch_media_bug {
@@ -280,6 +300,9 @@ struct switch_runtime {
 	switch_bool_t colorize_console;
 	char *odbc_dsn;
 	char *dbname;
+	char *db_journal_mode;
+	uint32_t log_trace_records;
+	switch_bool_t log_trace_crash_handler;
 	uint32_t debug_level;
 	uint32_t runlevel;
 	uint32_t tipping_point;
@@ -307,14 +330,61 @@ struct switch_runtime {
 	char *event_channel_key_separator;
 	uint32_t max_audio_channels;
 	switch_call_cause_t shutdown_cause;
+	int latency_enabled;
+	switch_latency_set_t *latency;
 };
 
 extern struct switch_runtime runtime;
 
+/* the shard of a per-thread sharded structure the calling thread should use */
+static inline uint32_t switch_core_thread_shard(uint32_t shards)
+{
+	uintptr_t id = (uintptr_t) switch_thread_self();
+
+	id ^= id >> 16;
+	id *= 0x45d9f3b;
+	id ^= id >> 16;
+
+	return (uint32_t) (id % shards);
+}
+
+/* start timing a stage, 0 when neither the global nor the session's histograms are on */
+static inline switch_time_t switch_core_latency_start(switch_core_session_t *session)
+{
+	return (runtime.latency_enabled || (session && session->latency_enabled)) ? switch_mono_micro_time_now() : 0;
+}
+
+static inline void switch_core_latency_end(switch_core_session_t *session, switch_latency_stage_t stage, switch_time_t start)
+{
+	if (start) {
+		switch_core_latency_record(session, stage, switch_mono_micro_time_now() - start);
+	}
+}
+
+/* add a stage that runs in pieces to *acc, which starts out negative */
+static inline void switch_core_latency_accrue(switch_time_t *acc, switch_time_t start)
+{
+	if (start) {
+		switch_time_t elapsed = switch_mono_micro_time_now() - start;
+		*acc = *acc < 0 ? elapsed : *acc + elapsed;
+	}
+}
+
+
+#define SWITCH_SESSION_TABLE_SHARDS 64
+
+/* one slice of the session table, lookups only ever take the read side */
+typedef struct switch_session_shard_s {
+	switch_thread_rwlock_t *rwlock;
+	switch_hash_t *table;
+	uint32_t count;
+	uint32_t peak;
+	volatile switch_atomic_t contended;
+} switch_session_shard_t;
 
 struct switch_session_manager {
 	switch_memory_pool_t *memory_pool;
-	switch_hash_t *session_table;
+	switch_session_shard_t session_shards[SWITCH_SESSION_TABLE_SHARDS];
 	uint32_t session_count;
 	uint32_t session_limit;
 	switch_size_t session_id;
@@ -335,6 +405,21 @@ switch_status_t switch_core_sqldb_start(switch_memory_pool_t *pool, switch_bool_
 void switch_core_sqldb_stop(void);
 void switch_core_session_init(switch_memory_pool_t *pool);
 void switch_core_session_uninit(void);
+switch_status_t switch_core_codec_offload_start(int threads, const char *codecs, int first_cpu, uint32_t max_queue);
+void switch_core_codec_offload_stop(void);
+/* the session media paths, one frame behind for codecs on the offload workers */
+switch_status_t switch_core_codec_offload_decode(switch_codec_t *codec, switch_codec_t *other_codec,
+												 void *encoded_data, uint32_t encoded_data_len, uint32_t encoded_rate,
+												 void *decoded_data, uint32_t *decoded_data_len, uint32_t *decoded_rate, unsigned int *flag);
+switch_status_t switch_core_codec_offload_encode(switch_codec_t *codec, switch_codec_t *other_codec,
+												 void *decoded_data, uint32_t decoded_data_len, uint32_t decoded_rate,
+												 void *encoded_data, uint32_t *encoded_data_len, uint32_t *encoded_rate, unsigned int *flag);
+switch_status_t switch_ivr_inband_detect_start(int threads);
+void switch_ivr_inband_detect_stop(void);
+switch_status_t switch_rtp_dtls_offload_start(int threads);
+void switch_rtp_dtls_offload_stop(void);
 void switch_core_state_machine_init(switch_memory_pool_t *pool);
+void switch_core_latency_init(switch_memory_pool_t *pool);
+void switch_core_metrics_init(switch_memory_pool_t *pool);
 switch_memory_pool_t *switch_core_memory_init(void);
 void switch_core_memory_stop(void);
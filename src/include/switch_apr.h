@@ -417,6 +417,13 @@ SWITCH_DECLARE(void) switch_atomic_add(volatile switch_atomic_t *mem, uint32_t v
  */
 SWITCH_DECLARE(void) switch_atomic_inc(volatile switch_atomic_t *mem);
 
+/**
+ * Uses an atomic operation to increment the value at the specified memory
+ * location and returns the value it had before.
+ * @param mem The location of the value to increment.
+ */
+SWITCH_DECLARE(uint32_t) switch_atomic_fetch_inc(volatile switch_atomic_t *mem);
+
 /**
  * Uses an atomic operation to decrement the value at the specified memroy
  * location.
@@ -664,6 +664,42 @@ SWITCH_DECLARE(int) switch_channel_test_app_flag_key(const char *app, switch_cha
 #define switch_channel_test_app_flag(_c, _f) switch_channel_test_app_flag_key(__FILE__, _c, _f)
 
 SWITCH_DECLARE(void) switch_channel_set_bridge_time(switch_channel_t *channel);
+
+/*!
+  \brief Create a watcher that is woken up by state and flag changes on the channels it watches
+  \param watcher the new watcher, each watched channel holds a reference on it
+*/
+SWITCH_DECLARE(switch_status_t) switch_channel_watcher_create(switch_channel_watcher_t **watcher);
+
+/*!
+  \brief Drop the creator's reference on a watcher
+*/
+SWITCH_DECLARE(void) switch_channel_watcher_release(switch_channel_watcher_t **watcher);
+
+/*!
+  \brief Attach a watcher to a channel, a channel has at most one watcher
+  \param channel the channel to watch
+  \param watcher the watcher, NULL detaches the current one
+*/
+SWITCH_DECLARE(void) switch_channel_watch(switch_channel_t *channel, switch_channel_watcher_t *watcher);
+
+/*!
+  \brief Detach a watcher from a channel, if it is still the one attached
+*/
+SWITCH_DECLARE(void) switch_channel_unwatch(switch_channel_t *channel, switch_channel_watcher_t *watcher);
+
+/*!
+  \brief Wake up a watcher
+*/
+SWITCH_DECLARE(void) switch_channel_watcher_signal(switch_channel_watcher_t *watcher);
+
+/*!
+  \brief Wait until one of the watched channels changes or the timeout expires
+  \param watcher the watcher
+  \param ms the longest time to wait, in milliseconds
+  \return SWITCH_STATUS_SUCCESS if woken up by a change, SWITCH_STATUS_TIMEOUT otherwise
+*/
+SWITCH_DECLARE(switch_status_t) switch_channel_watcher_wait(switch_channel_watcher_t *watcher, uint32_t ms);
 SWITCH_DECLARE(void) switch_channel_set_hangup_time(switch_channel_t *channel);
 SWITCH_DECLARE(switch_call_direction_t) switch_channel_direction(switch_channel_t *channel);
 SWITCH_DECLARE(switch_call_direction_t) switch_channel_logical_direction(switch_channel_t *channel);
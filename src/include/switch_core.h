@@ -900,6 +900,86 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_loglevel(switch_core_ses
 */
 SWITCH_DECLARE(switch_log_level_t) switch_core_session_get_loglevel(switch_core_session_t *session);
 
+/*!
+  \brief Add one sample to the latency histograms
+  \param session the session it belongs to or NULL, it goes into the session's own histograms too when those are on
+  \param stage the stage that was timed
+  \param usec how long it took
+*/
+SWITCH_DECLARE(void) switch_core_latency_record(switch_core_session_t *session, switch_latency_stage_t stage, switch_time_t usec);
+
+/*!
+  \brief Turn the global latency histograms on or off
+*/
+SWITCH_DECLARE(void) switch_core_latency_enable(switch_bool_t enable);
+SWITCH_DECLARE(switch_bool_t) switch_core_latency_enabled(void);
+
+/*!
+  \brief Turn a session's own latency histograms on or off
+*/
+SWITCH_DECLARE(switch_status_t) switch_core_session_latency_enable(switch_core_session_t *session, switch_bool_t enable);
+
+/*!
+  \brief Clear the global histograms, or a session's when session is not NULL
+*/
+SWITCH_DECLARE(void) switch_core_latency_reset(switch_core_session_t *session);
+
+/*!
+  \brief Summarize one stage of the global histograms, or a session's when session is not NULL
+*/
+SWITCH_DECLARE(switch_status_t) switch_core_latency_get(switch_core_session_t *session, switch_latency_stage_t stage, switch_latency_summary_t *summary);
+
+/*!
+  \brief Export the global histograms, or a session's when session is not NULL, as JSON
+  \return a cJSON object keyed by stage name, destroy it when finished
+*/
+SWITCH_DECLARE(cJSON *) switch_core_latency_json(switch_core_session_t *session);
+
+SWITCH_DECLARE(const char *) switch_core_latency_stage2str(switch_latency_stage_t stage);
+
+/*!
+  \brief Register a counter or gauge in the core metrics registry
+  \param name the metric name, e.g. freeswitch_rtp_packets_received_total
+  \param labels optional label pairs, e.g. codec="PCMU", metrics with the same name and different labels are exported together
+  \param help a one line description
+  \param type counter or gauge
+  \param metric the metric, registering the same name and labels again returns the same one
+  \return SWITCH_STATUS_SUCCESS if the metric is ready
+*/
+SWITCH_DECLARE(switch_status_t) switch_core_metric_register(const char *name, const char *labels, const char *help, switch_metric_type_t type,
+															 switch_metric_t **metric);
+
+/*!
+  \brief Register a metric whose value is computed by a callback at scrape time
+*/
+SWITCH_DECLARE(switch_status_t) switch_core_metric_register_callback(const char *name, const char *labels, const char *help, switch_metric_type_t type,
+																	  switch_metric_callback_t callback, void *user_data, switch_metric_t **metric);
+
+/*!
+  \brief Stop exporting a metric, modules must do this for their callbacks before they unload
+  \note waits for a scrape that is inside the callback, so don't call it from the callback itself
+*/
+SWITCH_DECLARE(void) switch_core_metric_unregister(switch_metric_t *metric);
+
+/*!
+  \brief Add to a counter or gauge, a NULL metric is ignored
+*/
+SWITCH_DECLARE(void) switch_core_metric_add(switch_metric_t *metric, int64_t value);
+#define switch_core_metric_inc(_m) switch_core_metric_add(_m, 1)
+#define switch_core_metric_dec(_m) switch_core_metric_add(_m, -1)
+
+/*!
+  \brief Set a gauge, don't mix this with switch_core_metric_add on the same gauge
+*/
+SWITCH_DECLARE(void) switch_core_metric_set(switch_metric_t *metric, int64_t value);
+
+SWITCH_DECLARE(double) switch_core_metric_value(switch_metric_t *metric);
+
+/*!
+  \brief Write every metric in the Prometheus text exposition format
+*/
+SWITCH_DECLARE(switch_status_t) switch_core_metrics_expose(switch_stream_handle_t *stream);
+
 SWITCH_DECLARE(switch_jb_t *) switch_core_session_get_jb(switch_core_session_t *session, switch_media_type_t type);
 SWITCH_DECLARE(void) switch_core_session_soft_lock(switch_core_session_t *session, uint32_t sec);
 SWITCH_DECLARE(void) switch_core_session_soft_unlock(switch_core_session_t *session);
@@ -999,6 +1079,12 @@ SWITCH_DECLARE(uint32_t) switch_core_session_hupall_matching_var_ans(_In_ const
 SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall_matching_var(const char *var_name, const char *var_val);
 #define switch_core_session_hupall_matching_var(_vn, _vv, _c) switch_core_session_hupall_matching_var_ans(_vn, _vv, _c, SHT_UNANSWERED | SHT_ANSWERED)
 SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall(void);
+
+/*!
+  \brief Write the occupancy and lock contention of each session table shard to a stream
+  \param stream the stream to write to
+*/
+SWITCH_DECLARE(void) switch_core_session_table_stats(switch_stream_handle_t *stream);
 /*!
   \brief Hangup all sessions which match specific channel variable(s)
   \param var_name The variable name to look for
@@ -1797,6 +1883,55 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_decode_video(switch_codec_t *c
 */
 SWITCH_DECLARE(switch_status_t) switch_core_codec_destroy(switch_codec_t *codec);
 
+/*!
+  \brief Write the state of the transcoding offload workers to a stream
+  \param stream the stream to write to
+*/
+SWITCH_DECLARE(void) switch_core_codec_offload_status(switch_stream_handle_t *stream);
+
+/*!
+  \brief Start a pool of worker threads, each with its own queue
+  \param poolp the new pool
+  \param name used in the logs
+  \param threads the number of workers
+  \param max_queue the most jobs one worker may have queued
+  \param first_cpu pin worker n to cpu first_cpu + n, -1 to leave them unpinned
+  \param priority the priority of the worker threads
+  \param callback runs each job
+  \param user_data passed to the callback
+  \return SWITCH_STATUS_SUCCESS if the workers are running
+*/
+SWITCH_DECLARE(switch_status_t) switch_worker_pool_create(switch_worker_pool_t **poolp, const char *name, int threads, uint32_t max_queue, int first_cpu,
+														  switch_thread_priority_t priority, switch_worker_pool_callback_t callback, void *user_data);
+
+/*!
+  \brief Queue a job
+  \param pool the pool
+  \param slot jobs with the same slot go to the same worker, SWITCH_WORKER_ANY to spread them
+  \param job the job, it must stay valid until the callback has run it
+  \return SWITCH_STATUS_SUCCESS if queued, SWITCH_STATUS_FALSE if the worker is backed up or the pool is stopped
+*/
+SWITCH_DECLARE(switch_status_t) switch_worker_pool_push(switch_worker_pool_t *pool, uint32_t slot, switch_worker_job_t *job);
+
+/*!
+  \brief Stop the workers, jobs already queued still run
+  \note the pool stays valid and refuses new jobs, so it is safe against callers racing with the stop
+*/
+SWITCH_DECLARE(void) switch_worker_pool_stop(switch_worker_pool_t *pool);
+
+/*!
+  \brief Stop the workers and free the pool, only once nothing can push to it any more
+*/
+SWITCH_DECLARE(void) switch_worker_pool_destroy(switch_worker_pool_t **poolp);
+
+SWITCH_DECLARE(switch_bool_t) switch_worker_pool_running(switch_worker_pool_t *pool);
+SWITCH_DECLARE(int) switch_worker_pool_size(switch_worker_pool_t *pool);
+
+/*!
+  \brief Write the queue and timing counters of every worker to a stream
+*/
+SWITCH_DECLARE(void) switch_worker_pool_status(switch_worker_pool_t *pool, switch_stream_handle_t *stream);
+
 /*!
   \brief Assign the read codec to a given session
   \param session session to add the codec to
@@ -2681,6 +2816,18 @@ SWITCH_DECLARE(char *) switch_cache_db_execute_sql2str(switch_cache_db_handle_t
  \param [out] err - Error if it exists
 */
 SWITCH_DECLARE(switch_status_t) switch_cache_db_execute_sql(switch_cache_db_handle_t *dbh, char *sql, char **err);
+/*!
+ \brief Executes a single sql statement with ? placeholders bound to parameters
+ \param [in] dbh The handle
+ \param [in] sql - sql template, the core db keeps it prepared so it should not vary per call
+ \param [in] argc - number of parameters
+ \param [in] argv - parameter values, a NULL entry binds NULL
+ \param [in] callback - optional callback for row-by-row processing
+ \param [in] pdata - data to pass to the callback
+ \param [out] err - Error if it exists
+*/
+SWITCH_DECLARE(switch_status_t) switch_cache_db_execute_sql_params(switch_cache_db_handle_t *dbh, const char *sql, int argc, const char *const *argv,
+																   switch_core_db_callback_func_t callback, void *pdata, char **err);
 /*!
  \brief Executes the sql and uses callback for row-by-row processing
  \param [in] dbh The handle
@@ -2838,6 +2985,10 @@ SWITCH_DECLARE(void) switch_sql_queue_manager_resume(switch_sql_queue_manager_t
 SWITCH_DECLARE(int) switch_sql_queue_manager_size(switch_sql_queue_manager_t *qm, uint32_t index);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push_confirm(switch_sql_queue_manager_t *qm, const char *sql, uint32_t pos, switch_bool_t dup);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push(switch_sql_queue_manager_t *qm, const char *sql, uint32_t pos, switch_bool_t dup);
+/*!
+ \brief Queue a parameterized statement, see switch_cache_db_execute_sql_params(); the parameters are copied
+*/
+SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push_params(switch_sql_queue_manager_t *qm, const char *sql, int argc, const char *const *argv, uint32_t pos);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_destroy(switch_sql_queue_manager_t **qmp);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_init_name(const char *name,
 																   switch_sql_queue_manager_t **qmp,
@@ -55,8 +55,14 @@ SWITCH_BEGIN_EXTERN_C
 struct switch_coredb_handle {
 	switch_bool_t in_memory;
 	switch_core_db_t *handle;
+	/* prepared statements keyed by their sql text, see switch_core_db_prepare_cached() */
+	switch_hash_t *stmt_cache;
+	uint32_t stmt_cache_count;
 };
 
+/* the statement cache of a connection is flushed once it holds this many statements */
+#define SWITCH_CORE_DB_STMT_CACHE_MAX 256
+
 typedef struct sqlite3_stmt switch_core_db_stmt_t;
 
 typedef int (*switch_core_db_callback_func_t) (void *pArg, int argc, char **argv, char **columnNames);
@@ -411,6 +417,38 @@ SWITCH_DECLARE(int) switch_core_db_bind_double(switch_core_db_stmt_t *pStmt, int
  */
 SWITCH_DECLARE(int64_t) switch_core_db_last_insert_rowid(switch_core_db_t *db);
 
+/**
+ * Bind a NULL to a parameter of a prepared statement.
+ */
+SWITCH_DECLARE(int) switch_core_db_bind_null(switch_core_db_stmt_t *pStmt, int i);
+
+/**
+ * Reset all the parameters of a prepared statement to NULL.
+ */
+SWITCH_DECLARE(int) switch_core_db_clear_bindings(switch_core_db_stmt_t *pStmt);
+
+/**
+ * Return a prepared statement for sql from the statement cache of the connection,
+ * preparing and caching it on first use.  The statement belongs to the cache and
+ * must be reset, not finalized, when the caller is done with it.
+ */
+SWITCH_DECLARE(int) switch_core_db_prepare_cached(switch_coredb_handle_t *dbh, const char *sql, switch_core_db_stmt_t **ppStmt);
+
+/**
+ * Finalize every statement in the statement cache of the connection.
+ * This must be done before the connection is closed.
+ */
+SWITCH_DECLARE(void) switch_core_db_flush_stmt_cache(switch_coredb_handle_t *dbh);
+
+/**
+ * Like switch_core_db_exec() for a single statement whose ? placeholders are bound,
+ * in order, to the argc strings in argv (a NULL entry binds NULL).  The statement
+ * is taken from the statement cache of the connection so the sql text should be a
+ * constant template rather than a string built per call.
+ */
+SWITCH_DECLARE(int) switch_core_db_exec_params(switch_coredb_handle_t *dbh, const char *sql, int argc, const char *const *argv,
+											   switch_core_db_callback_func_t callback, void *data, char **errmsg);
+
 /**
  * This next routine is really just a wrapper around switch_core_db_exec().
  * Instead of invoking a user-supplied callback for each row of the
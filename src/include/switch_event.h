@@ -100,6 +100,10 @@ struct switch_event {
 	unsigned long key;
 	struct switch_event *next;
 	int flags;
+	/*! read-only run of headers shared with other events, linked after the event's own headers */
+	switch_event_shared_headers_t *shared;
+	/*! the last header owned by this event when a shared run is attached */
+	switch_event_header_t *owned_tail;
 };
 
 typedef struct switch_serial_event_s {
@@ -224,6 +228,54 @@ SWITCH_DECLARE(void) switch_event_destroy(switch_event_t **event);
   \return SWITCH_STATUS_SUCCESS if the event was duplicated
 */
 SWITCH_DECLARE(switch_status_t) switch_event_dup(switch_event_t **event, switch_event_t *todup);
+
+/*!
+  \brief Turn the headers of an event into an immutable, reference counted run that can be attached to other events
+  \param event the event to consume (it is destroyed and set to NULL)
+  \return the shared headers with a reference count of one
+  \note the shared headers are never modified again, events holding a reference copy them before changing any of them
+*/
+SWITCH_DECLARE(switch_event_shared_headers_t *) switch_event_shared_headers_create(switch_event_t **event);
+
+/*!
+  \brief Take another reference to a run of shared headers
+  \param shared the shared headers
+  \return the same shared headers
+*/
+SWITCH_DECLARE(switch_event_shared_headers_t *) switch_event_shared_headers_ref(switch_event_shared_headers_t *shared);
+
+/*!
+  \brief Drop a reference to a run of shared headers, freeing them with the last one
+  \param shared the shared headers to release (set to NULL)
+*/
+SWITCH_DECLARE(void) switch_event_shared_headers_release(switch_event_shared_headers_t **shared);
+
+/*!
+  \brief Link a run of shared headers after the headers of an event without copying them
+  \param event the event
+  \param shared the shared headers (the event takes its own reference)
+  \return SWITCH_STATUS_SUCCESS if the headers were attached
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_attach_shared_headers(switch_event_t *event, switch_event_shared_headers_t *shared);
+
+/*!
+  \brief Replace the shared headers of an event with private copies so they can be modified in place
+  \param event the event
+*/
+SWITCH_DECLARE(void) switch_event_unshare_headers(switch_event_t *event);
+
+/*!
+  \brief Count the event, header, name and value allocations made by the calling thread from now on, for tests and benchmarks
+  \note one thread counts at a time
+*/
+SWITCH_DECLARE(void) switch_event_alloc_count_begin(void);
+
+/*!
+  \brief Stop counting allocations
+  \return the allocations counted since switch_event_alloc_count_begin()
+*/
+SWITCH_DECLARE(uint32_t) switch_event_alloc_count_end(void);
+
 SWITCH_DECLARE(void) switch_event_merge(switch_event_t *event, switch_event_t *tomerge);
 SWITCH_DECLARE(switch_status_t) switch_event_dup_reply(switch_event_t **event, switch_event_t *todup);
 
@@ -432,6 +484,20 @@ SWITCH_DECLARE(switch_status_t) switch_event_channel_deliver(const char *event_c
 SWITCH_DECLARE(uint32_t) switch_event_channel_unbind(const char *event_channel, switch_event_channel_func_t func, void *user_data);
 SWITCH_DECLARE(switch_status_t) switch_event_channel_bind(const char *event_channel, switch_event_channel_func_t func, switch_event_channel_id_t *id, void *user_data);
 
+/*!
+  \brief Subscribe to an event channel and receive the shared, refcounted payload instead of the bare cJSON object.
+  Every subscriber of one broadcast sees the same payload, so the text form is serialized once no matter how many
+  subscribers there are.  The payload is only valid for the duration of the callback unless the subscriber takes a ref.
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_channel_bind_payload(const char *event_channel, switch_event_channel_payload_func_t func,
+																   switch_event_channel_id_t *id, void *user_data);
+SWITCH_DECLARE(uint32_t) switch_event_channel_unbind_payload(const char *event_channel, switch_event_channel_payload_func_t func, void *user_data);
+SWITCH_DECLARE(cJSON *) switch_event_channel_payload_json(switch_event_channel_payload_t *payload);
+/*! \brief Unformatted JSON text of the payload, serialized on first use and shared by every caller */
+SWITCH_DECLARE(const char *) switch_event_channel_payload_text(switch_event_channel_payload_t *payload, switch_size_t *len);
+SWITCH_DECLARE(switch_event_channel_payload_t *) switch_event_channel_payload_ref(switch_event_channel_payload_t *payload);
+SWITCH_DECLARE(void) switch_event_channel_payload_release(switch_event_channel_payload_t **payloadP);
+
 
 typedef void (*switch_live_array_command_handler_t)(switch_live_array_t *la, const char *cmd, const char *sessid, cJSON *jla, void *user_data);
 
@@ -401,6 +401,12 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_tone_detect_session(switch_core_sessi
 															   const char *flags, time_t timeout, int hits,
 															   const char *app, const char *data, switch_tone_detect_callback_t callback);
 
+/*!
+  \brief Write the state of the inband detection workers to a stream
+  \param stream the stream to write to
+*/
+SWITCH_DECLARE(void) switch_ivr_inband_detect_status(switch_stream_handle_t *stream);
+
 
 
 
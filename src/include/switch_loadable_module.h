@@ -280,6 +280,43 @@ SWITCH_DECLARE(switch_limit_interface_t *) switch_loadable_module_get_limit_inte
  */
 SWITCH_DECLARE(int) switch_loadable_module_get_codecs(const switch_codec_implementation_t **array, int arraylen);
 
+/*! \brief Cost of one codec implementation as measured by switch_loadable_module_benchmark_codecs */
+typedef struct {
+	const char *iananame;
+	const char *modname;
+	uint32_t samples_per_second;
+	uint32_t actual_samples_per_second;
+	uint32_t ptime;
+	int channels;
+	/*! frames pushed through each direction */
+	uint32_t frames;
+	uint64_t encode_usec;
+	uint64_t decode_usec;
+	/*! single core throughput */
+	double encode_fps;
+	double decode_fps;
+	double encode_ns_per_frame;
+	double decode_ns_per_frame;
+	uint64_t encoded_bytes;
+	/*! heap growth caused by codec init and by the coding loop, 0 where the platform cannot tell */
+	int64_t init_heap_bytes;
+	int64_t run_heap_bytes;
+	switch_status_t status;
+} switch_codec_benchmark_t;
+
+typedef void (*switch_codec_benchmark_callback_t)(const switch_codec_benchmark_t *result, void *user_data);
+
+/*!
+  \brief Encode and decode reference audio with every loaded audio codec implementation
+  \param name only benchmark codecs with this iananame, NULL for all of them
+  \param frames the number of frames to run through each implementation
+  \param callback called once per implementation with its result
+  \param user_data passed to the callback
+  \return the number of implementations benchmarked
+  \note this runs on the calling thread and takes as long as the codecs need
+ */
+SWITCH_DECLARE(int) switch_loadable_module_benchmark_codecs(const char *name, uint32_t frames, switch_codec_benchmark_callback_t callback, void *user_data);
+
 
 /*!
   \brief Retrieve the list of loaded codecs into an array based on another array showing the sorted order
@@ -322,6 +359,34 @@ SWITCH_DECLARE(switch_status_t) switch_json_api_execute(cJSON *json, switch_core
 */
 SWITCH_DECLARE(switch_status_t) switch_loadable_module_load_module(const char *dir, const char *fname, switch_bool_t runtime, const char **err);
 
+typedef struct switch_module_timing_s {
+	/*! the module name as it was asked for */
+	const char *name;
+	/*! time spent opening the shared object and resolving its interface table */
+	switch_time_t dlopen_usec;
+	/*! time spent in the module's load function */
+	switch_time_t load_usec;
+	/*! time it spent queued in the parallel loader, 0 when it was loaded serially */
+	switch_time_t wait_usec;
+	switch_status_t status;
+} switch_module_timing_t;
+
+typedef void (*switch_module_timing_callback_t)(const switch_module_timing_t *timing, void *user_data);
+
+/*!
+  \brief Walk the load timings of every module loaded since startup, in load order
+  \param callback called once per module
+  \param user_data passed to the callback
+  \return the number of modules reported
+*/
+SWITCH_DECLARE(int) switch_loadable_module_get_timings(switch_module_timing_callback_t callback, void *user_data);
+
+/*!
+  \brief Write a per module startup timing report
+  \param stream stream for output
+*/
+SWITCH_DECLARE(void) switch_loadable_module_timing_report(switch_stream_handle_t *stream);
+
 /*!
   \brief Check if a module is loaded
   \param mod the module name
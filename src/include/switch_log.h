@@ -102,6 +102,19 @@ typedef struct {
 } switch_log_json_format_t;
 
 typedef switch_status_t (*switch_log_function_t) (const switch_log_node_t *node, switch_log_level_t level);
+typedef void (*switch_log_flush_function_t) (void);
+
+/*! \brief Counters of the logging pipeline */
+typedef struct {
+	/*! number of queues the logging threads are spread over */
+	uint32_t shards;
+	/*! lines waiting for the log thread */
+	uint32_t backlog;
+	/*! lines handed to the loggers */
+	uint64_t delivered;
+	/*! lines lost because their queue was full */
+	uint32_t dropped;
+} switch_log_stats_t;
 
 /*!
   \brief Convert a log node to JSON object.  Destroy JSON object when finished.
@@ -201,6 +214,53 @@ SWITCH_DECLARE(void) switch_log_meta_vprintf(_In_ switch_text_channel_t channel,
 SWITCH_DECLARE(switch_status_t) switch_log_bind_logger(_In_ switch_log_function_t function, _In_ switch_log_level_t level, _In_ switch_bool_t is_console);
 SWITCH_DECLARE(switch_status_t) switch_log_unbind_logger(_In_ switch_log_function_t function);
 
+/*!
+  \brief Tell the core the most verbose level a bound logger currently wants to see
+  \param function the logger
+  \param level the level, SWITCH_LOG_DISABLE when it wants nothing at all
+  \note lines above the level wanted by every logger are not even formatted, the logger
+  is still called with anything up to the level it was bound with
+*/
+SWITCH_DECLARE(switch_status_t) switch_log_set_logger_level_hint(_In_ switch_log_function_t function, _In_ switch_log_level_t level);
+
+/*!
+  \brief Have the log thread call flush after every batch of lines it hands to a bound logger
+  \param function the logger
+  \param flush the function writing out whatever the logger buffered
+*/
+SWITCH_DECLARE(switch_status_t) switch_log_bind_logger_flush(_In_ switch_log_function_t function, _In_ switch_log_flush_function_t flush);
+
+/*!
+  \brief Read the counters of the logging pipeline
+*/
+SWITCH_DECLARE(void) switch_log_get_stats(_Out_ switch_log_stats_t *stats);
+
+/*!
+  \brief Start recording log lines nobody is logging into the binary trace rings
+  \param records the number of records kept per ring, 0 to leave tracing off
+  \note the rings can only be set up once, they live as long as the process
+*/
+SWITCH_DECLARE(switch_status_t) switch_log_trace_init(uint32_t records);
+
+/*!
+  \brief Write the trace rings to the crash trace file on SIGSEGV, SIGABRT and SIGFPE
+  \note signals that already have a handler are left alone, the default action still runs after the dump
+*/
+SWITCH_DECLARE(switch_status_t) switch_log_trace_crash_handler(void);
+
+/*!
+  \brief Write the trace rings to a file
+  \param path the file to write
+*/
+SWITCH_DECLARE(switch_status_t) switch_log_trace_dump(const char *path);
+
+/*!
+  \brief Decode a file written by switch_log_trace_dump into log lines
+  \param path the file to read
+  \param stream where the lines go, oldest first
+*/
+SWITCH_DECLARE(switch_status_t) switch_log_trace_decode(const char *path, switch_stream_handle_t *stream);
+
 /*!
   \brief Return the name of the specified log level
   \param level the level
@@ -710,6 +710,8 @@ struct switch_codec {
 	struct switch_codec *next;
 	switch_core_session_t *session;
 	switch_frame_t *cur_frame;
+	/*! frames in flight on the transcoding offload workers */
+	struct switch_codec_offload *offload;
 };
 
 /*! \brief A table of settings and callbacks that define a paticular implementation of a codec */
@@ -757,6 +759,8 @@ struct switch_codec_implementation {
 	uint32_t codec_id;
 	uint32_t impl_id;
 	char *modname;
+	/*! the freeswitch_codecs_active gauge of this implementation, registered on first use */
+	switch_metric_t *active_metric;
 	struct switch_codec_implementation *next;
 };
 
@@ -174,6 +174,65 @@ typedef enum { /* FMT Values for PSFB Payload Types http://www.iana.org/assignme
 
 SWITCH_DECLARE(switch_status_t) switch_rtp_add_crypto_key(switch_rtp_t *rtp_session, switch_rtp_crypto_direction_t direction, uint32_t index, switch_secure_settings_t *ssec);
 
+/*!
+  \brief Apply SRTP to a vector of RTP packets with the session's send context
+  \param rtp_session the RTP session
+  \param packets complete RTP packets, each with room for the SRTP trailer after its payload
+  \param lens the length of each packet, replaced by the protected length or 0 when it failed
+  \param count the number of packets
+  \return the number of packets protected
+  \note the session lock and context checks are paid once per call instead of once per packet
+*/
+SWITCH_DECLARE(int) switch_rtp_protect_batch(switch_rtp_t *rtp_session, void *packets[], int lens[], int count);
+
+/*!
+  \brief Authenticate and decrypt a vector of SRTP packets with the session's receive context
+  \param rtp_session the RTP session
+  \param packets SRTP packets as read from the wire
+  \param lens the length of each packet, replaced by the RTP length or 0 when it must be dropped
+  \param count the number of packets
+  \return the number of packets that passed
+*/
+SWITCH_DECLARE(int) switch_rtp_unprotect_batch(switch_rtp_t *rtp_session, void *packets[], int lens[], int count);
+
+/*! \brief Cost of one SRTP suite as measured by switch_rtp_benchmark_crypto */
+typedef struct {
+	const char *name;
+	switch_rtp_crypto_key_type_t type;
+	/*! packets pushed through each direction and their RTP payload size */
+	uint32_t packets;
+	uint32_t payload_bytes;
+	uint64_t protect_usec;
+	uint64_t unprotect_usec;
+	/*! single core throughput */
+	double protect_pps;
+	double unprotect_pps;
+	double protect_ns_per_packet;
+	double unprotect_ns_per_packet;
+	switch_status_t status;
+} switch_rtp_crypto_benchmark_t;
+
+typedef void (*switch_rtp_crypto_benchmark_callback_t)(const switch_rtp_crypto_benchmark_t *result, void *user_data);
+
+/*!
+  \brief Protect and unprotect synthetic RTP with every SRTP suite switch_rtp_add_crypto_key knows
+  \param name only benchmark the suite with this name, NULL for all of them
+  \param packets the number of packets to run through each suite
+  \param payload_bytes the RTP payload size of each packet
+  \param callback called once per suite with its result
+  \param user_data passed to the callback
+  \return the number of suites benchmarked
+  \note this runs on the calling thread, packets go through the same batch path as switch_rtp_protect_batch
+*/
+SWITCH_DECLARE(int) switch_rtp_benchmark_crypto(const char *name, uint32_t packets, uint32_t payload_bytes,
+												switch_rtp_crypto_benchmark_callback_t callback, void *user_data);
+
+/*!
+  \brief Write the shared DTLS context counters and the handshake workers to a stream
+  \param stream the stream to write to
+*/
+SWITCH_DECLARE(void) switch_rtp_dtls_offload_status(switch_stream_handle_t *stream);
+
 ///\defgroup rtp RTP (RealTime Transport Protocol)
 ///\ingroup core1
 ///\{
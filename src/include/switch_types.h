@@ -757,11 +757,19 @@ typedef struct {
 	switch_rtcp_video_counters_t video_out;
 } switch_rtcp_video_stats_t;
 
+typedef struct {
+	int64_t ice_to_dtls_usec;     /* ice connectivity until the dtls keys were installed */
+	int64_t dtls_queue_usec;      /* time the handshake rounds waited for a worker */
+	int64_t dtls_handshake_usec;  /* time spent in SSL_do_handshake */
+	uint32_t dtls_rounds;         /* handshake rounds run */
+} switch_rtp_setup_numbers_t;
+
 typedef struct {
 	switch_rtp_numbers_t inbound;
 	switch_rtp_numbers_t outbound;
 	switch_rtcp_numbers_t rtcp;
 	uint32_t read_count;
+	switch_rtp_setup_numbers_t setup;
 } switch_rtp_stats_t;
 
 typedef enum {
@@ -1937,6 +1945,7 @@ SWITCH_FILE_PAUSE =             (1 <<  8) - Pause
 SWITCH_FILE_NATIVE =            (1 <<  9) - File is in native format (no transcoding)
 SWITCH_FILE_SEEK = 				(1 << 10) - File has done a seek
 SWITCH_FILE_OPEN =              (1 << 11) - File is open
+SWITCH_FILE_NATIVE_FRAMED =     (1 << 22) - Native reads return exactly one encoded frame each
 </pre>
  */
 typedef enum {
@@ -1961,7 +1970,8 @@ typedef enum {
 	SWITCH_FILE_BREAK_ON_CHANGE = (1 << 18),
 	SWITCH_FILE_FLAG_VIDEO = (1 << 19),
 	SWITCH_FILE_FLAG_VIDEO_EOF = (1 << 20),
-	SWITCH_FILE_PRE_CLOSED = (1 << 21)
+	SWITCH_FILE_PRE_CLOSED = (1 << 21),
+	SWITCH_FILE_NATIVE_FRAMED = (1 << 22)
 } switch_file_flag_enum_t;
 typedef uint32_t switch_file_flag_t;
 
@@ -2332,12 +2342,14 @@ typedef struct switch_rtcp switch_rtcp_t;
 typedef struct switch_core_session_message switch_core_session_message_t;
 typedef struct switch_event_header switch_event_header_t;
 typedef struct switch_event switch_event_t;
+typedef struct switch_event_shared_headers switch_event_shared_headers_t;
 typedef struct switch_event_subclass switch_event_subclass_t;
 typedef struct switch_event_node switch_event_node_t;
 typedef struct switch_loadable_module switch_loadable_module_t;
 typedef struct switch_frame switch_frame_t;
 typedef struct switch_rtcp_frame switch_rtcp_frame_t;
 typedef struct switch_channel switch_channel_t;
+typedef struct switch_channel_watcher switch_channel_watcher_t;
 typedef struct switch_sql_queue_manager switch_sql_queue_manager_t;
 typedef struct switch_file_handle switch_file_handle_t;
 typedef struct switch_caller_profile switch_caller_profile_t;
@@ -2658,6 +2670,10 @@ typedef struct switch_media_handle_s switch_media_handle_t;
 
 typedef uint32_t switch_event_channel_id_t;
 typedef void (*switch_event_channel_func_t)(const char *event_channel, cJSON *json, const char *key, switch_event_channel_id_t id, void *user_data);
+struct switch_event_channel_payload_s;
+typedef struct switch_event_channel_payload_s switch_event_channel_payload_t;
+typedef void (*switch_event_channel_payload_func_t)(const char *event_channel, switch_event_channel_payload_t *payload, const char *key,
+													switch_event_channel_id_t id, void *user_data);
 
 struct switch_live_array_s;
 typedef struct switch_live_array_s switch_live_array_t;
@@ -2897,6 +2913,60 @@ typedef struct switch_dial_leg_list_s switch_dial_leg_list_t;
 struct switch_dial_handle_list_s;
 typedef struct switch_dial_handle_list_s switch_dial_handle_list_t;
 
+/*! \brief Stages of a call timed by the core latency histograms */
+typedef enum {
+	SWITCH_LATENCY_READ_FRAME,	/* all of switch_core_session_read_frame */
+	SWITCH_LATENCY_READ_WAIT,	/* the endpoint's read_frame */
+	SWITCH_LATENCY_DECODE,
+	SWITCH_LATENCY_READ_BUGS,
+	SWITCH_LATENCY_ENCODE,
+	SWITCH_LATENCY_WRITE_BUGS,
+	SWITCH_LATENCY_WRITE,		/* the endpoint's write_frame */
+	SWITCH_LATENCY_STATE_CHANGE,	/* a state change until the session thread picks it up */
+	SWITCH_LATENCY_DIALPLAN,
+	SWITCH_LATENCY_APPLICATION,
+	SWITCH_LATENCY_ORIGINATE_RING,	/* originate until the first ring or early media from any leg */
+	SWITCH_LATENCY_ORIGINATE_ANSWER,	/* originate until the winning leg answered */
+	SWITCH_LATENCY_ANSWER_TO_BRIDGE,	/* an originated leg answered until it was first bridged */
+	SWITCH_LATENCY_INBAND_QUEUE,	/* a frame waiting for an inband dtmf/tone detection worker */
+	SWITCH_LATENCY_INBAND_DETECT,	/* running the inband dtmf/tone detectors over one frame */
+	SWITCH_LATENCY_DTLS_QUEUE,	/* a dtls handshake round waiting for a handshake worker */
+	SWITCH_LATENCY_DTLS_HANDSHAKE,	/* one SSL_do_handshake round on a handshake worker */
+	SWITCH_LATENCY_ICE_TO_DTLS,	/* ice connectivity until the srtp keys from dtls are installed */
+	SWITCH_LATENCY_STAGE_COUNT
+} switch_latency_stage_t;
+
+/*! \brief Summary of one latency histogram, all times in microseconds */
+typedef struct {
+	uint64_t count;
+	uint64_t mean;
+	uint64_t p50;
+	uint64_t p90;
+	uint64_t p99;
+	uint64_t p999;
+	uint64_t max;
+} switch_latency_summary_t;
+
+typedef enum {
+	SWITCH_METRIC_COUNTER,
+	SWITCH_METRIC_GAUGE
+} switch_metric_type_t;
+
+typedef struct switch_metric switch_metric_t;
+/*! \brief Computes a metric's value when it is scraped, must not block */
+typedef double (*switch_metric_callback_t) (switch_metric_t *metric, void *user_data);
+
+typedef struct switch_worker_pool switch_worker_pool_t;
+/*! \brief Head of a job handed to a worker pool, embed it as the first member of the job */
+typedef struct {
+	int64_t queued;
+	/* how long the job waited for its worker, set before it runs */
+	int64_t waited;
+} switch_worker_job_t;
+/*! \brief Runs one job on a worker thread */
+typedef void (*switch_worker_pool_callback_t) (switch_worker_job_t *job, void *user_data);
+#define SWITCH_WORKER_ANY UINT32_MAX
+
 SWITCH_END_EXTERN_C
 #endif
 /* For Emacs:
@@ -96,11 +96,11 @@ extern size_t next_power_of_2(size_t v);
 
 #define CALC_BUFF_LEN(fl, bl) (((fl) >= (bl))? next_power_of_2((fl) << 1): next_power_of_2((bl) << 1))
 
-#define INIT_CIRC_BUFFER(bf, bl, fl, s)			\
+#define INIT_CIRC_BUFFER(bf, bl, fl, p)			\
     { \
 	(bf)->buf_len = CALC_BUFF_LEN((fl), (bl)); \
 	(bf)->mask = (bf)->buf_len - 1; \
-	(bf)->buf = (BUFF_TYPE *) switch_core_session_alloc(s, (bf)->buf_len * sizeof(BUFF_TYPE)); \
+	(bf)->buf = (BUFF_TYPE *) switch_core_alloc((p), (bf)->buf_len * sizeof(BUFF_TYPE)); \
 	(bf)->pos = 0; \
 	(bf)->lpos = 0; \
 	(bf)->backlog = 0; \
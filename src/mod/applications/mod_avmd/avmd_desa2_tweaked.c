@@ -24,6 +24,12 @@
     #include "avmd_fast_acosf.h"
 #endif
 
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+    #include <immintrin.h>
+#elif defined(__aarch64__)
+    #include <arm_neon.h>
+#endif
+
 
 double
 avmd_desa2_tweaked(circ_buffer_t *b, size_t i, double *amplitude) {
@@ -69,3 +75,79 @@ avmd_desa2_tweaked(circ_buffer_t *b, size_t i, double *amplitude) {
     *amplitude = 2.0 * PSI_Xn / sqrt(PSI_Yn);
     return result;
 }
+
+void
+avmd_desa2_tweaked_block(const BUFF_TYPE *x, size_t n, double *omega, double *amplitude) {
+    size_t k = 0;
+
+#if defined(__AVX__)
+    const __m256d two = _mm256_set1_pd(2.0);
+
+    for (; k + 4 <= n; k += 4) {
+        __m256d x0 = _mm256_loadu_pd(x + k);
+        __m256d x1 = _mm256_loadu_pd(x + k + 1);
+        __m256d x2 = _mm256_loadu_pd(x + k + 2);
+        __m256d x3 = _mm256_loadu_pd(x + k + 3);
+        __m256d x4 = _mm256_loadu_pd(x + k + 4);
+        __m256d x2sq = _mm256_mul_pd(x2, x2);
+        __m256d d = _mm256_mul_pd(two, _mm256_sub_pd(x2sq, _mm256_mul_pd(x1, x3)));
+        __m256d psi_xn = _mm256_sub_pd(x2sq, _mm256_mul_pd(x0, x4));
+        __m256d needed = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(x1, x1), _mm256_mul_pd(x0, x2)),
+                                       _mm256_sub_pd(_mm256_mul_pd(x3, x3), _mm256_mul_pd(x2, x4)));
+        __m256d psi_yn = _mm256_add_pd(needed, psi_xn);
+
+        _mm256_storeu_pd(omega + k, _mm256_div_pd(_mm256_sub_pd(psi_xn, needed), d));
+        _mm256_storeu_pd(amplitude + k, _mm256_div_pd(_mm256_mul_pd(two, psi_xn), _mm256_sqrt_pd(psi_yn)));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128d two = _mm_set1_pd(2.0);
+
+    for (; k + 2 <= n; k += 2) {
+        __m128d x0 = _mm_loadu_pd(x + k);
+        __m128d x1 = _mm_loadu_pd(x + k + 1);
+        __m128d x2 = _mm_loadu_pd(x + k + 2);
+        __m128d x3 = _mm_loadu_pd(x + k + 3);
+        __m128d x4 = _mm_loadu_pd(x + k + 4);
+        __m128d x2sq = _mm_mul_pd(x2, x2);
+        __m128d d = _mm_mul_pd(two, _mm_sub_pd(x2sq, _mm_mul_pd(x1, x3)));
+        __m128d psi_xn = _mm_sub_pd(x2sq, _mm_mul_pd(x0, x4));
+        __m128d needed = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(x1, x1), _mm_mul_pd(x0, x2)),
+                                    _mm_sub_pd(_mm_mul_pd(x3, x3), _mm_mul_pd(x2, x4)));
+        __m128d psi_yn = _mm_add_pd(needed, psi_xn);
+
+        _mm_storeu_pd(omega + k, _mm_div_pd(_mm_sub_pd(psi_xn, needed), d));
+        _mm_storeu_pd(amplitude + k, _mm_div_pd(_mm_mul_pd(two, psi_xn), _mm_sqrt_pd(psi_yn)));
+    }
+#elif defined(__aarch64__)
+    const float64x2_t two = vdupq_n_f64(2.0);
+
+    for (; k + 2 <= n; k += 2) {
+        float64x2_t x0 = vld1q_f64(x + k);
+        float64x2_t x1 = vld1q_f64(x + k + 1);
+        float64x2_t x2 = vld1q_f64(x + k + 2);
+        float64x2_t x3 = vld1q_f64(x + k + 3);
+        float64x2_t x4 = vld1q_f64(x + k + 4);
+        float64x2_t x2sq = vmulq_f64(x2, x2);
+        float64x2_t d = vmulq_f64(two, vsubq_f64(x2sq, vmulq_f64(x1, x3)));
+        float64x2_t psi_xn = vsubq_f64(x2sq, vmulq_f64(x0, x4));
+        float64x2_t needed = vaddq_f64(vsubq_f64(vmulq_f64(x1, x1), vmulq_f64(x0, x2)),
+                                       vsubq_f64(vmulq_f64(x3, x3), vmulq_f64(x2, x4)));
+        float64x2_t psi_yn = vaddq_f64(needed, psi_xn);
+
+        vst1q_f64(omega + k, vdivq_f64(vsubq_f64(psi_xn, needed), d));
+        vst1q_f64(amplitude + k, vdivq_f64(vmulq_f64(two, psi_xn), vsqrtq_f64(psi_yn)));
+    }
+#endif
+
+    for (; k < n; k++) {
+        double x0 = x[k], x1 = x[k + 1], x2 = x[k + 2], x3 = x[k + 3], x4 = x[k + 4];
+        double x2sq = x2 * x2;
+        double d = 2.0 * ((x2sq) - (x1 * x3));
+        double PSI_Xn = ((x2sq) - (x0 * x4));
+        double NEEDED = ((x1 * x1) - (x0 * x2)) + ((x3 * x3) - (x2 * x4));
+        double PSI_Yn = NEEDED + PSI_Xn;
+
+        omega[k] = (PSI_Xn - NEEDED) / d;
+        amplitude[k] = 2.0 * PSI_Xn / sqrt(PSI_Yn);
+    }
+}
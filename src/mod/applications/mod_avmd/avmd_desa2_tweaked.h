@@ -47,5 +47,13 @@
  */
 double avmd_desa2_tweaked(circ_buffer_t *b, size_t i, double *amplitude) __attribute__ ((nonnull(1,3)));
 
+/* Block version of the above for a linear run of samples.
+ * x must hold n + 4 samples, omega[k] and amplitude[k] receive
+ * the estimates for the window starting at x[k], exactly as
+ * avmd_desa2_tweaked() would compute them one by one.
+ * Uses AVX, SSE2 or NEON lanes when the compiler targets them,
+ * a plain loop otherwise. */
+void avmd_desa2_tweaked_block(const BUFF_TYPE *x, size_t n, double *omega, double *amplitude) __attribute__ ((nonnull(1,3,4)));
+
 
 #endif  /* __AVMD_DESA2_TWEAKED_H__ */
@@ -29,11 +29,11 @@ typedef struct {
     size_t lpos;
 } sma_buffer_t;
 
-#define INIT_SMA_BUFFER(b, l, s) \
+#define INIT_SMA_BUFFER(b, l, p) \
     { \
 	(void)memset((b), 0, sizeof(sma_buffer_t)); \
 	(b)->len = (l); \
-	(b)->data = (BUFF_TYPE *)switch_core_session_alloc((s), sizeof(BUFF_TYPE) * (l)); \
+	(b)->data = (BUFF_TYPE *)switch_core_alloc((p), sizeof(BUFF_TYPE) * (l)); \
 	(b)->sma = 0.0; \
 	(b)->pos = 0; \
 	(b)->lpos = 0; \
@@ -103,7 +103,7 @@
 #define AVMD_AMPLITUDE_RSD_THRESHOLD (0.0148)
 
 /*! Syntax of the API call. */
-#define AVMD_SYNTAX "<uuid> < start | stop | set [inbound|outbound|default] | load [inbound|outbound] | reload | show >"
+#define AVMD_SYNTAX "<uuid> < start | stop | set [inbound|outbound|default] | load [inbound|outbound] | reload | show | bench <file|dir> >"
 
 /*! Number of expected parameters in api call. */
 #define AVMD_PARAMS_API_MIN 1u
@@ -207,21 +207,23 @@ struct avmd_buffer {
 };
 
 struct avmd_detector {
-    switch_thread_t *thread;
-    switch_mutex_t  *mutex;
-    uint8_t                     flag_processing_done;
-    uint8_t                     flag_should_exit;
     enum avmd_detection_mode    result;
-    switch_thread_cond_t        *cond_start_processing;
     struct avmd_buffer          buffer;
     avmd_session_t              *s;
-    size_t                      samples;
     uint8_t                     idx;
     uint8_t                     lagged, lag;
 };
 
+enum avmd_job_state {
+    AVMD_JOB_IDLE,
+    AVMD_JOB_QUEUED,
+    AVMD_JOB_DONE
+};
+
 /*! Type that holds avmd detection session information. */
 struct avmd_session {
+    /* must be first, the worker pool hands this back */
+    switch_worker_job_t     job;
     switch_core_session_t   *session;
     switch_mutex_t          *mutex;
     struct avmd_settings    settings;
@@ -234,9 +236,20 @@ struct avmd_session {
     size_t          frame_n;
     uint8_t         frame_n_to_skip;
 
-    switch_mutex_t          *mutex_detectors_done;
-    switch_thread_cond_t    *cond_detectors_done;
     struct avmd_detector    *detectors;
+    switch_memory_pool_t    *pool;
+
+    /* DESA-2 estimates of the current frame, computed once and shared by all detectors */
+    BUFF_TYPE       *x;
+    double          *omega;
+    double          *amplitude;
+    size_t          block_len;
+    size_t          block_samples;
+
+    /* the detectors and the estimates belong to the worker while the frame is queued */
+    volatile switch_atomic_t    job_state;
+    /* the worker this session sticks to, so its detectors stay in one cache */
+    uint32_t        worker;
 };
 
 static struct avmd_globals
@@ -245,6 +258,10 @@ static struct avmd_globals
     struct avmd_settings    settings;
     switch_memory_pool_t    *pool;
     size_t                  session_n;
+    uint8_t                 worker_threads;
+    switch_worker_pool_t    *workers;
+    volatile switch_atomic_t    next_worker;
+    volatile switch_atomic_t    inline_fallbacks;
 } avmd_globals;
 
 static void avmd_process(avmd_session_t *session, switch_frame_t *frame, uint8_t direction);
@@ -257,7 +274,11 @@ static void avmd_unregister_all_events(void);
 static void avmd_fire_event(enum avmd_event type, switch_core_session_t *fs_s, double freq, double v_freq, double amp, double v_amp, avmd_beep_state_t beep_status, uint8_t info,
         switch_time_t detection_start_time, switch_time_t detection_stop_time, switch_time_t start_time, switch_time_t stop_time, uint8_t resolution, uint8_t offset, uint8_t idx);
 
-static enum avmd_detection_mode avmd_process_sample(avmd_session_t *s, circ_buffer_t *b, size_t sample_n, size_t pos, struct avmd_detector *d);
+static enum avmd_detection_mode avmd_process_sample(avmd_session_t *s, double omega, double amplitude, struct avmd_detector *d);
+
+static void avmd_run_detectors(avmd_session_t *s);
+
+static enum avmd_detection_mode avmd_detection_result(avmd_session_t *s);
 
 /* API [set default], reset to factory settings */
 static void avmd_set_xml_default_configuration(switch_mutex_t *mutex);
@@ -279,137 +300,102 @@ static void avmd_reloadxml_event_handler(switch_event_t *event);
 /* API command */
 static void avmd_show(switch_stream_handle_t *stream, switch_mutex_t *mutex);
 
-static void* SWITCH_THREAD_FUNC
-avmd_detector_func(switch_thread_t *thread, void *arg);
-
-static uint8_t
-avmd_detection_in_progress(avmd_session_t *s);
-
-static switch_status_t avmd_launch_threads(avmd_session_t *s) {
-	uint8_t                 idx;
-	struct avmd_detector    *d;
-	switch_threadattr_t     *thd_attr = NULL;
-
-	idx = 0;
-	while (idx < s->settings.detectors_n) {
-		d = &s->detectors[idx];
-		d->flag_processing_done = 1;
-		d->flag_should_exit = 0;
-		d->result = AVMD_DETECT_NONE;
-		d->lagged = 0;
-		d->lag = 0;
-		switch_threadattr_create(&thd_attr, avmd_globals.pool);
-		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
-		if (switch_thread_create(&d->thread, thd_attr, avmd_detector_func, d, switch_core_session_get_pool(s->session)) != SWITCH_STATUS_SUCCESS) {
-			return SWITCH_STATUS_FALSE;
-		}
-
-		if (s->settings.debug) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "AVMD: started thread idx=%u\n", idx);
-		}
-
-		++idx;
-	}
+#define AVMD_WORKER_QUEUE_LEN 1024
 
-	idx = 0;
-	while (idx < s->settings.detectors_lagged_n) {
-		d = &s->detectors[s->settings.detectors_n + idx];
-		d->flag_processing_done = 1;
-		d->flag_should_exit = 0;
-		d->result = AVMD_DETECT_NONE;
-		d->lagged = 1;
-		d->lag = idx + 1;
-		switch_threadattr_create(&thd_attr, avmd_globals.pool);
-		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
-		if (switch_thread_create(&d->thread, thd_attr, avmd_detector_func, d, switch_core_session_get_pool(s->session)) != SWITCH_STATUS_SUCCESS) {
-			return SWITCH_STATUS_FALSE;
-		}
-
-		if (s->settings.debug) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "AVMD: started lagged thread idx=%u\n", s->settings.detectors_n + idx);
-		}
-
-		++idx;
-	}
+static void avmd_worker_callback(switch_worker_job_t *job, void *user_data) {
+    avmd_session_t *s = (avmd_session_t *) job;
 
-	return SWITCH_STATUS_SUCCESS;
+    avmd_run_detectors(s);
+    /* the media thread owns the session again from here */
+    switch_atomic_set(&s->job_state, AVMD_JOB_DONE);
 }
 
-static void avmd_join_threads(avmd_session_t *s) {
-    uint8_t                 idx;
-    struct avmd_detector    *d;
-    switch_status_t         status;
+/*! \brief Wait for the frame on the worker and report what it found.
+ * @details The detectors run one frame behind the media thread, which only
+ *          waits here if the worker fell a whole frame behind.
+ */
+static void avmd_collect_detectors(avmd_session_t *s) {
+    uint32_t state;
 
-    idx = 0;
-    while (idx < s->settings.detectors_n) {
-        d = &s->detectors[idx];
-        switch_mutex_lock(d->mutex);
-        if (d->thread != NULL) {
-            d->flag_should_exit = 1;
-            d->samples = 0;
-            switch_thread_cond_signal(d->cond_start_processing);
-            switch_mutex_unlock(d->mutex);
-            switch_thread_join(&status, d->thread);
-            d->thread = NULL;
-            switch_mutex_destroy(d->mutex);
-            switch_thread_cond_destroy(d->cond_start_processing);
-        } else {
-            switch_mutex_unlock(d->mutex);
-        }
-        ++idx;
+    while ((state = switch_atomic_read(&s->job_state)) == AVMD_JOB_QUEUED) {
+        switch_cond_next();
     }
-    idx = 0;
-    while (idx < s->settings.detectors_lagged_n) {
-        d = &s->detectors[s->settings.detectors_n + idx];
-        switch_mutex_lock(d->mutex);
-        if (d->thread != NULL) {
-            d->flag_should_exit = 1;
-            d->samples = 0;
-            switch_thread_cond_signal(d->cond_start_processing);
-            switch_mutex_unlock(d->mutex);
-            switch_thread_join(&status, d->thread);
-            d->thread = NULL;
-            switch_mutex_destroy(d->mutex);
-            switch_thread_cond_destroy(d->cond_start_processing);
-        } else {
-            switch_mutex_unlock(d->mutex);
+
+    if (state == AVMD_JOB_DONE) {
+        switch_atomic_set(&s->job_state, AVMD_JOB_IDLE);
+        avmd_detection_result(s);
+    }
+}
+
+/*! \brief Hand the current frame to a worker, or run the detectors here if there are none.
+ * @details The result is picked up by avmd_collect_detectors() with the next frame.
+ *          Detached sessions (avmd bench) always run inline so their cost is measured.
+ */
+static void avmd_submit_detectors(avmd_session_t *s) {
+    if (s->session != NULL && switch_worker_pool_running(avmd_globals.workers)) {
+        switch_atomic_set(&s->job_state, AVMD_JOB_QUEUED);
+        if (switch_worker_pool_push(avmd_globals.workers, s->worker, &s->job) == SWITCH_STATUS_SUCCESS) {
+            return;
         }
-        ++idx;
+        switch_atomic_inc(&avmd_globals.inline_fallbacks);
     }
+
+    avmd_run_detectors(s);
+    switch_atomic_set(&s->job_state, AVMD_JOB_DONE);
+}
+
+static switch_status_t avmd_start_workers(uint8_t n) {
+    if (n == 0) {
+        return SWITCH_STATUS_SUCCESS;
+    }
+
+    if (switch_worker_pool_create(&avmd_globals.workers, "avmd", n, AVMD_WORKER_QUEUE_LEN, -1, SWITCH_PRI_NORMAL,
+                avmd_worker_callback, NULL) != SWITCH_STATUS_SUCCESS) {
+        return SWITCH_STATUS_FALSE;
+    }
+
+    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Avmd detectors running on [%u] worker threads\n", n);
+
+    return SWITCH_STATUS_SUCCESS;
+}
+
+static void avmd_stop_workers(void) {
+    /* frames already queued still run, new ones run inline from here on */
+    switch_worker_pool_destroy(&avmd_globals.workers);
 }
 
-static switch_status_t avmd_init_buffer(struct avmd_buffer *b, size_t buf_sz, uint8_t resolution, uint8_t offset, switch_core_session_t *fs_session) {
-    INIT_SMA_BUFFER(&b->sma_b, buf_sz, fs_session);
+static switch_status_t avmd_init_buffer(struct avmd_buffer *b, size_t buf_sz, uint8_t resolution, uint8_t offset, switch_memory_pool_t *pool) {
+    INIT_SMA_BUFFER(&b->sma_b, buf_sz, pool);
     if (b->sma_b.data == NULL) {
         return SWITCH_STATUS_FALSE;
     }
     memset(b->sma_b.data, 0, sizeof(BUFF_TYPE) * buf_sz);
 
-    INIT_SMA_BUFFER(&b->sqa_b, buf_sz, fs_session);
+    INIT_SMA_BUFFER(&b->sqa_b, buf_sz, pool);
     if (b->sqa_b.data == NULL) {
         return SWITCH_STATUS_FALSE;
     }
     memset(b->sqa_b.data, 0, sizeof(BUFF_TYPE) * buf_sz);
 
-    INIT_SMA_BUFFER(&b->sma_b_fir, buf_sz, fs_session);
+    INIT_SMA_BUFFER(&b->sma_b_fir, buf_sz, pool);
     if (b->sma_b_fir.data == NULL) {
         return SWITCH_STATUS_FALSE;
     }
     memset(b->sma_b_fir.data, 0, sizeof(BUFF_TYPE) * buf_sz);
 
-    INIT_SMA_BUFFER(&b->sqa_b_fir, buf_sz, fs_session);
+    INIT_SMA_BUFFER(&b->sqa_b_fir, buf_sz, pool);
     if (b->sqa_b_fir.data == NULL) {
         return SWITCH_STATUS_FALSE;
     }
     memset(b->sqa_b_fir.data, 0, sizeof(BUFF_TYPE) * buf_sz);
 
-    INIT_SMA_BUFFER(&b->sma_amp_b, buf_sz, fs_session);
+    INIT_SMA_BUFFER(&b->sma_amp_b, buf_sz, pool);
     if (b->sma_amp_b.data == NULL) {
         return SWITCH_STATUS_FALSE;
     }
     memset(b->sma_amp_b.data, 0, sizeof(BUFF_TYPE) * buf_sz);
 
-    INIT_SMA_BUFFER(&b->sqa_amp_b, buf_sz, fs_session);
+    INIT_SMA_BUFFER(&b->sqa_amp_b, buf_sz, pool);
     if (b->sqa_amp_b.data == NULL) {
         return SWITCH_STATUS_FALSE;
     }
@@ -426,7 +412,8 @@ static switch_status_t avmd_init_buffer(struct avmd_buffer *b, size_t buf_sz, ui
 
 /*! \brief  The avmd session data initialization function.
  * @param   avmd_session A reference to a avmd session.
- * @param   fs_session A reference to a FreeSWITCH session.
+ * @param   fs_session A reference to a FreeSWITCH session, NULL for a detached
+ *          session (benchmark) which must then come with its own pool.
  * @details Avmd globals mutex must be locked.
  */
 static switch_status_t init_avmd_session_data(avmd_session_t *avmd_session, switch_core_session_t *fs_session, switch_mutex_t *mutex)
@@ -441,9 +428,13 @@ static switch_status_t init_avmd_session_data(avmd_session_t *avmd_session, swit
         switch_mutex_lock(mutex);
     }
 
+    if (fs_session != NULL) {
+        avmd_session->pool = switch_core_session_get_pool(fs_session);
+    }
+
     /*! This is a worst case sample rate estimate */
     avmd_session->rate = 48000;
-    INIT_CIRC_BUFFER(&avmd_session->b, (size_t) AVMD_BEEP_LEN(avmd_session->rate), (size_t) AVMD_FRAME_LEN(avmd_session->rate), fs_session);
+    INIT_CIRC_BUFFER(&avmd_session->b, (size_t) AVMD_BEEP_LEN(avmd_session->rate), (size_t) AVMD_FRAME_LEN(avmd_session->rate), avmd_session->pool);
     if (avmd_session->b.buf == NULL) {
         status =  SWITCH_STATUS_MEMERR;
         goto end;
@@ -453,18 +444,25 @@ static switch_status_t init_avmd_session_data(avmd_session_t *avmd_session, swit
     avmd_session->f = 0.0;
     avmd_session->state.last_beep = 0;
     avmd_session->state.beep_state = BEEP_NOTDETECTED;
-    switch_mutex_init(&avmd_session->mutex, SWITCH_MUTEX_DEFAULT, switch_core_session_get_pool(fs_session));
+    switch_mutex_init(&avmd_session->mutex, SWITCH_MUTEX_DEFAULT, avmd_session->pool);
     avmd_session->frame_n = 0;
     avmd_session->detection_start_time = 0;
     avmd_session->detection_stop_time = 0;
     avmd_session->frame_n_to_skip = 0;
+    avmd_session->x = NULL;
+    avmd_session->omega = NULL;
+    avmd_session->amplitude = NULL;
+    avmd_session->block_len = 0;
+    avmd_session->block_samples = 0;
+    switch_atomic_set(&avmd_session->job_state, AVMD_JOB_IDLE);
+    avmd_session->worker = switch_atomic_fetch_inc(&avmd_globals.next_worker);
 
     buf_sz = AVMD_BEEP_LEN((uint32_t)avmd_session->rate) / (uint32_t) AVMD_SINE_LEN(avmd_session->rate);
     if (buf_sz < 1) {
         status = SWITCH_STATUS_MORE_DATA;
         goto end;
     }
-    avmd_session->detectors = (struct avmd_detector*) switch_core_session_alloc(fs_session, (avmd_session->settings.detectors_n + avmd_session->settings.detectors_lagged_n) * sizeof(struct avmd_detector));
+    avmd_session->detectors = (struct avmd_detector*) switch_core_alloc(avmd_session->pool, (avmd_session->settings.detectors_n + avmd_session->settings.detectors_lagged_n) * sizeof(struct avmd_detector));
     if (avmd_session->detectors == NULL) {
         switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(fs_session), SWITCH_LOG_ERROR, "Can't allocate memory for avmd detectors!\n");
         status = SWITCH_STATUS_NOT_INITALIZED;
@@ -477,17 +475,15 @@ static switch_status_t init_avmd_session_data(avmd_session_t *avmd_session, swit
         offset = 0;
         while ((offset < resolution) && (idx < avmd_session->settings.detectors_n)) {
             d = &avmd_session->detectors[idx];
-            if (avmd_init_buffer(&d->buffer, buf_sz, resolution, offset, fs_session) != SWITCH_STATUS_SUCCESS) {
+            if (avmd_init_buffer(&d->buffer, buf_sz, resolution, offset, avmd_session->pool) != SWITCH_STATUS_SUCCESS) {
                 status = SWITCH_STATUS_FALSE;
                 goto end;
             }
             d->s = avmd_session;
-            d->flag_processing_done = 1;
-            d->flag_should_exit = 1;
+            d->result = AVMD_DETECT_NONE;
             d->idx = idx;
-            d->thread = NULL;
-            switch_mutex_init(&d->mutex, SWITCH_MUTEX_DEFAULT, switch_core_session_get_pool(fs_session));
-            switch_thread_cond_create(&d->cond_start_processing, switch_core_session_get_pool(fs_session));
+            d->lagged = 0;
+            d->lag = 0;
             ++offset;
             ++idx;
         }
@@ -497,21 +493,17 @@ static switch_status_t init_avmd_session_data(avmd_session_t *avmd_session, swit
     offset = 0;
     while (idx < avmd_session->settings.detectors_lagged_n) {
             d = &avmd_session->detectors[avmd_session->settings.detectors_n + idx];
-            if (avmd_init_buffer(&d->buffer, buf_sz, resolution, offset, fs_session) != SWITCH_STATUS_SUCCESS) {
+            if (avmd_init_buffer(&d->buffer, buf_sz, resolution, offset, avmd_session->pool) != SWITCH_STATUS_SUCCESS) {
                 status = SWITCH_STATUS_FALSE;
                 goto end;
             }
             d->s = avmd_session;
-            d->flag_processing_done = 1;
-            d->flag_should_exit = 1;
+            d->result = AVMD_DETECT_NONE;
             d->idx = avmd_session->settings.detectors_n + idx;
-            d->thread = NULL;
-            switch_mutex_init(&d->mutex, SWITCH_MUTEX_DEFAULT, switch_core_session_get_pool(fs_session));
-            switch_thread_cond_create(&d->cond_start_processing, switch_core_session_get_pool(fs_session));
+            d->lagged = 1;
+            d->lag = idx + 1;
             ++idx;
     }
-    switch_mutex_init(&avmd_session->mutex_detectors_done, SWITCH_MUTEX_DEFAULT, switch_core_session_get_pool(fs_session));
-    switch_thread_cond_create(&avmd_session->cond_detectors_done, switch_core_session_get_pool(fs_session));
 
 end:
     if (mutex != NULL)
@@ -522,39 +514,10 @@ end:
 }
 
 static void avmd_session_close(avmd_session_t *s) {
-    uint8_t                 idx;
-    struct avmd_detector    *d;
-    switch_status_t         status;
-
-    switch_mutex_lock(s->mutex);
-
-    switch_mutex_lock(s->mutex_detectors_done);
-    while (avmd_detection_in_progress(s) == 1) {
-        switch_thread_cond_wait(s->cond_detectors_done, s->mutex_detectors_done);
+    /* let the last frame off the worker before the session memory goes */
+    while (switch_atomic_read(&s->job_state) == AVMD_JOB_QUEUED) {
+        switch_cond_next();
     }
-    switch_mutex_unlock(s->mutex_detectors_done);
-
-    idx = 0;
-    while (idx < (s->settings.detectors_n + s->settings.detectors_lagged_n)) {
-        d = &s->detectors[idx];
-        switch_mutex_lock(d->mutex);
-        d = &s->detectors[idx];
-        d->flag_processing_done = 0;
-        d->flag_should_exit = 1;
-        d->samples = 0;
-        switch_thread_cond_signal(d->cond_start_processing);
-        switch_mutex_unlock(d->mutex);
-
-        switch_thread_join(&status, d->thread);
-        d->thread = NULL;
-
-        switch_mutex_destroy(d->mutex);
-        switch_thread_cond_destroy(d->cond_start_processing);
-        ++idx;
-    }
-    switch_mutex_unlock(s->mutex);
-    switch_mutex_destroy(s->mutex_detectors_done);
-    switch_thread_cond_destroy(s->cond_detectors_done);
     switch_mutex_destroy(s->mutex);
 }
 
@@ -846,6 +809,7 @@ static void avmd_set_xml_default_configuration(switch_mutex_t *mutex) {
     avmd_globals.settings.mode = AVMD_DETECT_BOTH;
     avmd_globals.settings.detectors_n = 36;
     avmd_globals.settings.detectors_lagged_n = 1;
+    avmd_globals.worker_threads = 0;
 
     if (mutex != NULL) {
         switch_mutex_unlock(avmd_globals.mutex);
@@ -892,6 +856,9 @@ static switch_status_t avmd_load_xml_configuration(switch_mutex_t *mutex) {
 		switch_mutex_lock(mutex);
 	}
 
+	/* optional, detectors run on the media thread unless asked otherwise */
+	avmd_globals.worker_threads = 0;
+
 	if ((xml = switch_xml_open_cfg("avmd.conf", &cfg, NULL)) != NULL) {
 
 		if ((x_lists = switch_xml_child(cfg, "settings"))) {
@@ -954,6 +921,11 @@ static switch_status_t avmd_load_xml_configuration(switch_mutex_t *mutex) {
 					if(!avmd_parse_u8_user_input(value, &avmd_globals.settings.detectors_lagged_n, 0, UINT8_MAX)) {
 						bad_lagged = 0;
 					}
+				} else if (!strcmp(name, "worker_threads")) {
+					if(avmd_parse_u8_user_input(value, &avmd_globals.worker_threads, 0, UINT8_MAX)) {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "AVMD config parameter 'worker_threads' invalid - using default\n");
+						avmd_globals.worker_threads = 0;
+					}
 				}
 			} // for
 		} // if list
@@ -1123,6 +1095,9 @@ static void avmd_show(switch_stream_handle_t *stream, switch_mutex_t *mutex) {
     stream->write_function(stream, "sessions                       \t%"PRId64"\n", avmd_globals.session_n);
     stream->write_function(stream, "detectors n                    \t%u\n", avmd_globals.settings.detectors_n);
     stream->write_function(stream, "detectors lagged n             \t%u\n", avmd_globals.settings.detectors_lagged_n);
+    stream->write_function(stream, "worker threads                 \t%u (running %d)\n", avmd_globals.worker_threads, switch_worker_pool_size(avmd_globals.workers));
+    stream->write_function(stream, "inline fallbacks               \t%u\n", switch_atomic_read(&avmd_globals.inline_fallbacks));
+    switch_worker_pool_status(avmd_globals.workers, stream);
     stream->write_function(stream, "\n\n");
 
     if (mutex != NULL) {
@@ -1193,6 +1168,10 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_avmd_load) {
     }
 #endif
 
+    if (avmd_start_workers(avmd_globals.worker_threads) != SWITCH_STATUS_SUCCESS) {
+        switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Couldn't start [%u] avmd worker threads, detectors run on the media threads\n", avmd_globals.worker_threads);
+    }
+
     SWITCH_ADD_APP(app_interface, "avmd_start","Start avmd detection", "Start avmd detection", avmd_start_app, "", SAF_NONE);
     SWITCH_ADD_APP(app_interface, "avmd_stop","Stop avmd detection", "Stop avmd detection", avmd_stop_app, "", SAF_NONE);
     SWITCH_ADD_APP(app_interface, "avmd","Beep detection", "Advanced detection of voicemail beeps", avmd_start_function, AVMD_SYNTAX, SAF_NONE);
@@ -1208,6 +1187,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_avmd_load) {
     switch_console_set_complete("add avmd reload");         /* reload XML (it loads from FS installation
                                                              * folder, not module's conf/autoload_configs */
     switch_console_set_complete("add avmd show");
+    switch_console_set_complete("add avmd bench");
 
     switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Advanced voicemail detection enabled\n");
 
@@ -1503,14 +1483,6 @@ SWITCH_STANDARD_APP(avmd_start_app) {
         }
     }
 
-    status = avmd_launch_threads(avmd_session);
-    if (status != SWITCH_STATUS_SUCCESS) {
-        switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Failed to start detection threads\n");
-        avmd_join_threads(avmd_session);
-        switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Joined detection threads\n");
-        goto end_unlock;
-    }
-
     status = switch_core_media_bug_add(session, "avmd", NULL, avmd_callback, avmd_session, 0, flags, &bug); /* Add a media bug that allows me to intercept the audio stream */
     if (status != SWITCH_STATUS_SUCCESS) { /* If adding a media bug fails exit */
         switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Failed to add media bug!\n");
@@ -1626,6 +1598,8 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_avmd_shutdown) {
     int res;
 #endif
 
+    avmd_stop_workers();
+
     switch_mutex_lock(avmd_globals.mutex);
 
     session_n = avmd_globals.session_n;
@@ -1662,6 +1636,160 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_avmd_shutdown) {
 }
 
 /*! \brief FreeSWITCH API handler function. */
+/*! Results of avmd bench over a set of recordings */
+struct avmd_bench_stats {
+    size_t          files;
+    size_t          tp, fn, fp, tn;
+    uint64_t        samples;
+    switch_time_t   usec;
+    uint64_t        latency_samples;
+};
+
+#define AVMD_BENCH_RATE 8000
+#define AVMD_BENCH_FRAME_LEN 160
+
+/*! \brief Run a detached avmd session over one recording and classify the outcome.
+ * @details The file is read at 8 kHz mono in 20 ms frames, the time spent in
+ *          avmd_process is measured on the calling thread. Detection latency is
+ *          counted in audio time from the start of the recording.
+ */
+static void avmd_bench_file(const char *path, uint8_t expect_beep, const struct avmd_settings *settings, struct avmd_bench_stats *st) {
+    switch_memory_pool_t    *pool = NULL;
+    switch_file_handle_t    fh = { 0 };
+    switch_frame_t          frame = { 0 };
+    avmd_session_t          *s;
+    int16_t                 data[AVMD_BENCH_FRAME_LEN];
+    switch_size_t           len;
+    switch_time_t           start;
+    uint64_t                samples = 0;
+
+    if (switch_core_new_memory_pool(&pool) != SWITCH_STATUS_SUCCESS) {
+        return;
+    }
+
+    s = (avmd_session_t *) switch_core_alloc(pool, sizeof(avmd_session_t));
+    s->pool = pool;
+    memcpy(&s->settings, settings, sizeof(struct avmd_settings));
+    if (init_avmd_session_data(s, NULL, NULL) != SWITCH_STATUS_SUCCESS) {
+        switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Avmd bench: failed to init session for [%s]\n", path);
+        goto end;
+    }
+    s->rate = AVMD_BENCH_RATE;
+    s->start_time = switch_micro_time_now();
+
+    if (switch_core_file_open(&fh, path, 1, AVMD_BENCH_RATE, SWITCH_FILE_FLAG_READ | SWITCH_FILE_DATA_SHORT, pool) != SWITCH_STATUS_SUCCESS) {
+        switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Avmd bench: can't open [%s]\n", path);
+        avmd_session_close(s);
+        goto end;
+    }
+
+    frame.data = data;
+    while (s->state.beep_state != BEEP_DETECTED) {
+        len = AVMD_BENCH_FRAME_LEN;
+        if (switch_core_file_read(&fh, data, &len) != SWITCH_STATUS_SUCCESS || len < AVMD_BENCH_FRAME_LEN) {
+            break;
+        }
+        frame.samples = (uint32_t) len;
+        frame.datalen = (uint32_t) len * sizeof(int16_t);
+
+        start = switch_time_ref();
+        avmd_process(s, &frame, AVMD_READ_REPLACE);
+        st->usec += switch_time_ref() - start;
+        samples += len;
+    }
+    switch_core_file_close(&fh);
+
+    st->files++;
+    st->samples += samples;
+    if (s->state.beep_state == BEEP_DETECTED) {
+        if (expect_beep) {
+            st->tp++;
+            st->latency_samples += samples;
+        } else {
+            st->fp++;
+        }
+    } else {
+        if (expect_beep) {
+            st->fn++;
+        } else {
+            st->tn++;
+        }
+    }
+    avmd_session_close(s);
+
+end:
+    switch_core_destroy_memory_pool(&pool);
+}
+
+static void avmd_bench_dir(const char *dir, uint8_t expect_beep, const struct avmd_settings *settings, struct avmd_bench_stats *st, switch_memory_pool_t *pool) {
+    switch_dir_t    *dir_handle = NULL;
+    const char      *fname;
+    char            buf[256];
+
+    if (switch_dir_open(&dir_handle, dir, pool) != SWITCH_STATUS_SUCCESS) {
+        return;
+    }
+    while ((fname = switch_dir_next_file(dir_handle, buf, sizeof(buf))) != NULL) {
+        if (*fname == '.') {
+            continue;
+        }
+        avmd_bench_file(switch_core_sprintf(pool, "%s%s%s", dir, SWITCH_PATH_SEPARATOR, fname), expect_beep, settings, st);
+    }
+    switch_dir_close(dir_handle);
+}
+
+/*! \brief avmd bench <file|dir>
+ * @details Runs the detector offline over recordings and reports accuracy and
+ *          cost per channel. A directory may hold beep/ and nobeep/ subdirectories
+ *          with labelled recordings, otherwise every file is expected to contain
+ *          a beep.
+ */
+static void avmd_bench(switch_stream_handle_t *stream, const char *path, const struct avmd_settings *settings) {
+    switch_memory_pool_t    *pool = NULL;
+    struct avmd_bench_stats st = { 0 };
+    const char              *beep_dir, *nobeep_dir;
+    double                  seconds;
+
+    switch_core_new_memory_pool(&pool);
+
+    if (switch_directory_exists(path, pool) == SWITCH_STATUS_SUCCESS) {
+        beep_dir = switch_core_sprintf(pool, "%s%sbeep", path, SWITCH_PATH_SEPARATOR);
+        nobeep_dir = switch_core_sprintf(pool, "%s%snobeep", path, SWITCH_PATH_SEPARATOR);
+        if (switch_directory_exists(beep_dir, pool) == SWITCH_STATUS_SUCCESS || switch_directory_exists(nobeep_dir, pool) == SWITCH_STATUS_SUCCESS) {
+            avmd_bench_dir(beep_dir, 1, settings, &st, pool);
+            avmd_bench_dir(nobeep_dir, 0, settings, &st, pool);
+        } else {
+            avmd_bench_dir(path, 1, settings, &st, pool);
+        }
+    } else {
+        avmd_bench_file(path, 1, settings, &st);
+    }
+
+    switch_core_destroy_memory_pool(&pool);
+
+    if (st.files == 0) {
+        stream->write_function(stream, "-ERR, no recordings could be read from [%s]\n\n", path);
+        return;
+    }
+
+    seconds = (double) st.samples / AVMD_BENCH_RATE;
+    stream->write_function(stream, "files                          \t%zu\n", st.files);
+    stream->write_function(stream, "channel seconds                \t%.1f\n", seconds);
+    stream->write_function(stream, "processing time                \t%"PRId64" [us]\n", (int64_t) st.usec);
+    if (seconds > 0.0 && st.usec > 0) {
+        stream->write_function(stream, "time per channel second        \t%.1f [us]\n", st.usec / seconds);
+        stream->write_function(stream, "channels per core              \t%.0f\n", seconds * 1000000.0 / st.usec);
+    }
+    stream->write_function(stream, "detected (true positive)       \t%zu\n", st.tp);
+    stream->write_function(stream, "missed (false negative)        \t%zu\n", st.fn);
+    stream->write_function(stream, "false alarms (false positive)  \t%zu\n", st.fp);
+    stream->write_function(stream, "silent (true negative)         \t%zu\n", st.tn);
+    if (st.tp > 0) {
+        stream->write_function(stream, "avg detection latency          \t%.1f [ms]\n", (double) st.latency_samples * 1000.0 / AVMD_BENCH_RATE / st.tp);
+    }
+    stream->write_function(stream, "+OK\n\n");
+}
+
 SWITCH_STANDARD_API(avmd_api_main) {
     switch_media_bug_t  *bug = NULL;
     avmd_session_t      *avmd_session = NULL;
@@ -1775,6 +1903,22 @@ SWITCH_STANDARD_API(avmd_api_main) {
         }
         goto end;
     }
+    if (strcasecmp(command, "bench") == 0) {
+        struct avmd_settings settings;
+
+        if (argc != 2) {
+            stream->write_function(stream, "-ERR, bench command takes 1 parameter!\n-USAGE: %s\n\n", AVMD_SYNTAX);
+            goto end;
+        }
+        memcpy(&settings, &avmd_globals.settings, sizeof(struct avmd_settings));
+        settings.report_status = 0;
+        settings.debug = 0;
+        /* this may take a while, don't hold up sessions being started */
+        switch_mutex_unlock(avmd_globals.mutex);
+        avmd_bench(stream, argv[1], &settings);
+        switch_mutex_lock(avmd_globals.mutex);
+        goto end;
+    }
 
     uuid = argv[0];
     command = argv[1];
@@ -1850,6 +1994,7 @@ SWITCH_STANDARD_API(avmd_api_main) {
     }
 
     avmd_session = (avmd_session_t *) switch_core_session_alloc(fs_session, sizeof(avmd_session_t)); /* Allocate memory attached to this FreeSWITCH session for use in the callback routine and to store state information */
+    memcpy(&avmd_session->settings, &avmd_globals.settings, sizeof(struct avmd_settings));
     status = init_avmd_session_data(avmd_session, fs_session, NULL);
     if (status != SWITCH_STATUS_SUCCESS) {
         stream->write_function(stream, "-ERR, failed to initialize avmd session\n for FreeSWITCH session [%s]\n", uuid);
@@ -1971,6 +2116,12 @@ static void avmd_report_detection(avmd_session_t *s, enum avmd_detection_mode mo
     const sma_buffer_t    *sma_amp_b = &b->sma_amp_b;
     const sma_buffer_t    *sqa_amp_b = &b->sqa_amp_b;
 
+    if (s->session == NULL) {                                                                                   /* detached session, avmd bench */
+        s->detection_stop_time = switch_micro_time_now();
+        s->state.beep_state = BEEP_DETECTED;
+        return;
+    }
+
     channel = switch_core_session_get_channel(s->session);
 
     s->detection_stop_time = switch_micro_time_now();                                                           /* stop detection timer     */
@@ -2016,21 +2167,6 @@ static void avmd_report_detection(avmd_session_t *s, enum avmd_detection_mode mo
     s->state.beep_state = BEEP_DETECTED;
 }
 
-static uint8_t
-avmd_detection_in_progress(avmd_session_t *s) {
-    uint8_t idx = 0;
-    while (idx < (s->settings.detectors_n + s->settings.detectors_lagged_n)) {
-        switch_mutex_lock(s->detectors[idx].mutex);
-        if (s->detectors[idx].flag_processing_done == 0) {
-            switch_mutex_unlock(s->detectors[idx].mutex);
-            return 1;
-        }
-        switch_mutex_unlock(s->detectors[idx].mutex);
-        ++idx;
-    }
-    return 0;
-}
-
 static enum avmd_detection_mode
 avmd_detection_result(avmd_session_t *s) {
     enum avmd_detection_mode res;
@@ -2052,17 +2188,12 @@ avmd_detection_result(avmd_session_t *s) {
  */
 static void avmd_process(avmd_session_t *s, switch_frame_t *frame, uint8_t direction) {
     circ_buffer_t           *b;
-    uint8_t                 idx;
-    struct avmd_detector    *d;
+    size_t                  samples, k;
 
 
     b = &s->b;
 
-    switch_mutex_lock(s->mutex_detectors_done);
-    while (avmd_detection_in_progress(s) == 1) {
-        switch_thread_cond_wait(s->cond_detectors_done, s->mutex_detectors_done);
-    }
-    switch_mutex_unlock(s->mutex_detectors_done);
+    avmd_collect_detectors(s);                                          /* Result of the previous frame */
 
     if (s->state.beep_state == BEEP_DETECTED) {                         /* If beep has already been detected skip the CPU heavy stuff */
         return;
@@ -2083,27 +2214,22 @@ static void avmd_process(avmd_session_t *s, switch_frame_t *frame, uint8_t direc
 
     INSERT_INT16_FRAME(b, (int16_t *)(frame->data), frame->samples);    /* Insert frame of 16 bit samples into buffer */
 
-    idx = 0;
-    while (idx < (s->settings.detectors_n + s->settings.detectors_lagged_n)) {
-        d = &s->detectors[idx];
-        switch_mutex_lock(d->mutex);
-        d = &s->detectors[idx];
-        if (d->result == AVMD_DETECT_NONE) {
-            d->flag_processing_done = 0;
-            d->flag_should_exit = 0;
-            d->samples = (s->frame_n == 0 ? frame->samples - AVMD_P : frame->samples);
-            switch_thread_cond_signal(d->cond_start_processing);
-        }
-        switch_mutex_unlock(d->mutex);
-        ++idx;
+    samples = (s->frame_n == 0 ? frame->samples - AVMD_P : frame->samples);
+    if (samples + AVMD_P > s->block_len) {
+        s->block_len = samples + AVMD_P;
+        s->x = (BUFF_TYPE *) switch_core_alloc(s->pool, s->block_len * sizeof(BUFF_TYPE));
+        s->omega = (double *) switch_core_alloc(s->pool, s->block_len * sizeof(double));
+        s->amplitude = (double *) switch_core_alloc(s->pool, s->block_len * sizeof(double));
+    }
+    s->block_samples = samples;
+    for (k = 0; k < samples + AVMD_P - 1; ++k) {                        /* The worker reads a copy, the ring moves on */
+        s->x[k] = GET_SAMPLE(b, s->pos + 1 + k);
     }
 
-    switch_mutex_lock(s->mutex_detectors_done);
-    while (avmd_detection_in_progress(s) == 1) {
-        switch_thread_cond_wait(s->cond_detectors_done, s->mutex_detectors_done);
+    avmd_submit_detectors(s);
+    if (switch_atomic_read(&s->job_state) == AVMD_JOB_DONE) {          /* Ran inline, no need to wait a frame for it */
+        avmd_collect_detectors(s);
     }
-    avmd_detection_result(s);
-    switch_mutex_unlock(s->mutex_detectors_done);
 
     ++s->frame_n;
     if (s->frame_n == 1) {
@@ -2116,16 +2242,50 @@ static void avmd_process(avmd_session_t *s, switch_frame_t *frame, uint8_t direc
     return;
 }
 
+/*! \brief Run all detectors of the session over the current frame.
+ * @details The DESA-2 estimates only depend on the samples, so they are
+ *          computed once per frame in a block and each detector picks the
+ *          ones at its own resolution and offset.
+ */
+static void avmd_run_detectors(avmd_session_t *s) {
+    size_t                  sample_n, samples = s->block_samples;
+    uint8_t                 idx, resolution;
+    struct avmd_detector    *d;
+    enum avmd_detection_mode res;
+
+    avmd_desa2_tweaked_block(s->x, samples, s->omega, s->amplitude);
+
+    for (idx = 0; idx < (s->settings.detectors_n + s->settings.detectors_lagged_n); ++idx) {
+        d = &s->detectors[idx];
+        if (d->result != AVMD_DETECT_NONE) {
+            continue;
+        }
+        /* lagged detectors join in a few frames late so their averages cover a shifted window */
+        if (d->lagged == 1 && d->lag > 0) {
+            --d->lag;
+            continue;
+        }
+        resolution = d->buffer.resolution;
+        res = AVMD_DETECT_NONE;
+        for (sample_n = resolution - d->buffer.offset; sample_n <= samples; sample_n += resolution) {
+            res = avmd_process_sample(s, s->omega[sample_n - 1], s->amplitude[sample_n - 1], d);
+            if (res != AVMD_DETECT_NONE) {
+                break;
+            }
+        }
+        d->result = res;
+    }
+}
+
 static void avmd_reloadxml_event_handler(switch_event_t *event) {
     avmd_load_xml_configuration(avmd_globals.mutex);
 }
 
-static enum avmd_detection_mode avmd_process_sample(avmd_session_t *s, circ_buffer_t *b, size_t sample_n, size_t pos, struct avmd_detector *d) {
+static enum avmd_detection_mode avmd_process_sample(avmd_session_t *s, double omega, double amplitude, struct avmd_detector *d) {
     struct avmd_buffer          *buffer = &d->buffer;
     uint16_t                    sample_to_skip_n = s->settings.sample_n_to_skip;
     enum avmd_detection_mode    mode = s->settings.mode;
     uint8_t     valid_amplitude = 1, valid_omega = 1;
-    double      omega = 0.0, amplitude = 0.0;
     double      f = 0.0, f_fir = 0.0;
     double      v_amp = 9999.9, v_fir = 9999.9;
 
@@ -2145,8 +2305,6 @@ static enum avmd_detection_mode avmd_process_sample(avmd_session_t *s, circ_buff
         return AVMD_DETECT_NONE;
     }
 
-    omega = avmd_desa2_tweaked(b, pos + sample_n, &amplitude);
-
     if (mode == AVMD_DETECT_AMP || mode == AVMD_DETECT_BOTH) {
         if (ISNAN(amplitude) || ISINF(amplitude)) {
             valid_amplitude = 0;
@@ -2242,69 +2400,6 @@ static enum avmd_detection_mode avmd_process_sample(avmd_session_t *s, circ_buff
     return AVMD_DETECT_NONE;
 }
 
-static void* SWITCH_THREAD_FUNC
-avmd_detector_func(switch_thread_t *thread, void *arg) {
-    size_t      sample_n = 0, samples = AVMD_P;
-    size_t      pos;
-    uint8_t     resolution, offset;
-    avmd_session_t  *s;
-    enum avmd_detection_mode res = AVMD_DETECT_NONE;
-    struct avmd_detector *d;
-
-
-    d = (struct avmd_detector*) arg;
-    s = d->s;
-    pos = s->pos;
-    while (1) {
-        switch_mutex_lock(d->mutex);
-        while ((d->flag_processing_done == 1) && (d->flag_should_exit == 0)) {
-            switch_thread_cond_wait(d->cond_start_processing, d->mutex);
-        }
-        /* master set processing_done flag to 0 or thread should exit */
-        if (d->flag_should_exit == 1) {
-            d->flag_processing_done = 1;
-            goto end;
-        }
-        resolution = d->buffer.resolution;
-        offset = d->buffer.offset;
-        samples = d->samples;
-
-        if (d->lagged == 1) {
-            if (d->lag > 0) {
-                --d->lag;
-                goto done;
-            }
-            pos += AVMD_P;
-        }
-
-        switch_mutex_unlock(d->mutex);
-        sample_n = 1;
-        while (sample_n <= samples) {
-            if (((sample_n + offset) % resolution) == 0) {
-                res = avmd_process_sample(d->s, &s->b, sample_n, pos, d);
-                if (res != AVMD_DETECT_NONE) {
-                    break;
-                }
-            }
-            ++sample_n;
-        }
-        switch_mutex_lock(d->mutex);
-done:
-        d->flag_processing_done = 1;
-        d->result = res;
-        switch_mutex_unlock(d->mutex);
-
-        switch_mutex_lock(s->mutex_detectors_done);
-        switch_thread_cond_signal(s->cond_detectors_done);
-        switch_mutex_unlock(s->mutex_detectors_done);
-    }
-    return NULL;
-
-end:
-    switch_mutex_unlock(d->mutex);
-    return NULL;
-}
-
 
 /* For Emacs:
  * Local Variables:
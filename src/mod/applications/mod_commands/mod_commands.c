@@ -722,6 +722,183 @@ SWITCH_STANDARD_API(db_cache_function)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_STANDARD_API(session_table_function)
+{
+	if (zstr(cmd) || !strcasecmp(cmd, "stats")) {
+		switch_core_session_table_stats(stream);
+	} else {
+		stream->write_function(stream, "-USAGE: stats\n");
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(codec_offload_function)
+{
+	if (zstr(cmd) || !strcasecmp(cmd, "status")) {
+		switch_core_codec_offload_status(stream);
+	} else {
+		stream->write_function(stream, "-USAGE: status\n");
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(inband_detect_function)
+{
+	if (zstr(cmd) || !strcasecmp(cmd, "status")) {
+		switch_ivr_inband_detect_status(stream);
+	} else {
+		stream->write_function(stream, "-USAGE: status\n");
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(dtls_offload_function)
+{
+	if (zstr(cmd) || !strcasecmp(cmd, "status")) {
+		switch_rtp_dtls_offload_status(stream);
+	} else {
+		stream->write_function(stream, "-USAGE: status\n");
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void codec_bench_callback(const switch_codec_benchmark_t *result, void *user_data)
+{
+	switch_stream_handle_t *stream = (switch_stream_handle_t *) user_data;
+
+	if (result->status != SWITCH_STATUS_SUCCESS) {
+		stream->write_function(stream, "%-12s %-16s %6u %3ums %d  failed\n",
+							   result->iananame, result->modname, result->samples_per_second, result->ptime, result->channels);
+		return;
+	}
+
+	stream->write_function(stream, "%-12s %-16s %6u %3ums %d %10.0f %10.0f %10.0f %10.0f %8" SWITCH_INT64_T_FMT " %8" SWITCH_INT64_T_FMT "\n",
+						   result->iananame, result->modname, result->samples_per_second, result->ptime, result->channels,
+						   result->encode_fps, result->encode_ns_per_frame, result->decode_fps, result->decode_ns_per_frame,
+						   result->init_heap_bytes, result->run_heap_bytes);
+}
+
+#define CODEC_BENCH_SYNTAX "[<codec>|all] [<frames>]"
+SWITCH_STANDARD_API(codec_bench_function)
+{
+	char *mydata = NULL, *argv[2] = { 0 };
+	const char *name = NULL;
+	uint32_t frames = 1000;
+	int argc = 0, count;
+
+	if (!zstr(cmd)) {
+		mydata = strdup(cmd);
+		switch_assert(mydata);
+		argc = switch_separate_string(mydata, ' ', argv, (sizeof(argv) / sizeof(argv[0])));
+	}
+
+	if (argc > 0 && strcasecmp(argv[0], "all")) {
+		name = argv[0];
+	}
+
+	if (argc > 1 && (frames = atoi(argv[1])) < 1) {
+		stream->write_function(stream, "-USAGE: %s\n", CODEC_BENCH_SYNTAX);
+		goto end;
+	}
+
+	stream->write_function(stream, "%-12s %-16s %6s %5s %s %10s %10s %10s %10s %8s %8s\n",
+						   "codec", "module", "rate", "ptime", "c", "enc-fps", "enc-ns", "dec-fps", "dec-ns", "init-mem", "run-mem");
+
+	count = switch_loadable_module_benchmark_codecs(name, frames, codec_bench_callback, stream);
+
+	stream->write_function(stream, "\n%d implementations, %u frames each, fps is per core\n", count, frames);
+
+  end:
+	switch_safe_free(mydata);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void module_timing_json_callback(const switch_module_timing_t *timing, void *user_data)
+{
+	cJSON *array = (cJSON *) user_data;
+	cJSON *item = cJSON_CreateObject();
+
+	cJSON_AddItemToObject(item, "module", cJSON_CreateString(timing->name));
+	cJSON_AddItemToObject(item, "dlopen_usec", cJSON_CreateNumber((double) timing->dlopen_usec));
+	cJSON_AddItemToObject(item, "load_usec", cJSON_CreateNumber((double) timing->load_usec));
+	cJSON_AddItemToObject(item, "queued_usec", cJSON_CreateNumber((double) timing->wait_usec));
+	cJSON_AddItemToObject(item, "status", cJSON_CreateString(timing->status == SWITCH_STATUS_SUCCESS ? "ok" : "failed"));
+	cJSON_AddItemToArray(array, item);
+}
+
+SWITCH_STANDARD_API(module_timing_function)
+{
+	if (zstr(cmd)) {
+		switch_loadable_module_timing_report(stream);
+	} else if (!strcasecmp(cmd, "json")) {
+		cJSON *array = cJSON_CreateArray();
+		char *json;
+
+		switch_loadable_module_get_timings(module_timing_json_callback, array);
+		json = cJSON_Print(array);
+		stream->write_function(stream, "%s\n", json);
+		switch_safe_free(json);
+		cJSON_Delete(array);
+	} else {
+		stream->write_function(stream, "-USAGE: [json]\n");
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void srtp_bench_callback(const switch_rtp_crypto_benchmark_t *result, void *user_data)
+{
+	switch_stream_handle_t *stream = (switch_stream_handle_t *) user_data;
+
+	if (result->status != SWITCH_STATUS_SUCCESS) {
+		stream->write_function(stream, "%-24s %s\n", result->name, result->status == SWITCH_STATUS_NOTIMPL ? "not supported" : "failed");
+		return;
+	}
+
+	stream->write_function(stream, "%-24s %10.0f %10.0f %10.0f %10.0f\n", result->name,
+						   result->protect_pps, result->protect_ns_per_packet, result->unprotect_pps, result->unprotect_ns_per_packet);
+}
+
+#define SRTP_BENCH_SYNTAX "[<suite>|all] [<packets>] [<payload bytes>]"
+SWITCH_STANDARD_API(srtp_bench_function)
+{
+	char *mydata = NULL, *argv[3] = { 0 };
+	const char *name = NULL;
+	uint32_t packets = 100000, payload_bytes = 160;
+	int argc = 0, count;
+
+	if (!zstr(cmd)) {
+		mydata = strdup(cmd);
+		switch_assert(mydata);
+		argc = switch_separate_string(mydata, ' ', argv, (sizeof(argv) / sizeof(argv[0])));
+	}
+
+	if (argc > 0 && strcasecmp(argv[0], "all")) {
+		name = argv[0];
+	}
+
+	if ((argc > 1 && (packets = atoi(argv[1])) < 1) || (argc > 2 && (payload_bytes = atoi(argv[2])) < 1)) {
+		stream->write_function(stream, "-USAGE: %s\n", SRTP_BENCH_SYNTAX);
+		goto end;
+	}
+
+	stream->write_function(stream, "%-24s %10s %10s %10s %10s\n", "suite", "prot-pps", "prot-ns", "unprot-pps", "unprot-ns");
+
+	count = switch_rtp_benchmark_crypto(name, packets, payload_bytes, srtp_bench_callback, stream);
+
+	stream->write_function(stream, "\n%d suites, %u packets of %u payload bytes each, pps is per core\n", count, packets, payload_bytes);
+
+  end:
+	switch_safe_free(mydata);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_STANDARD_API(host_lookup_function)
 {
 	char host[256] = "";
@@ -5081,10 +5258,39 @@ SWITCH_STANDARD_API(pause_function)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+/* Send a freshly originated leg to <exten> or run &<application_name>(<app_args>) on it */
+static void originate_send_to_exten(switch_core_session_t *caller_session, const char *exten, const char *dp, const char *context)
+{
+	switch_channel_t *caller_channel = switch_core_session_get_channel(caller_session);
+
+	if (*exten == '&' && *(exten + 1)) {
+		switch_caller_extension_t *extension = NULL;
+		char *app_name = switch_core_session_strdup(caller_session, (exten + 1));
+		char *arg = NULL, *e;
+
+		if ((e = strchr(app_name, ')'))) {
+			*e = '\0';
+		}
+
+		if ((arg = strchr(app_name, '('))) {
+			*arg++ = '\0';
+		}
+
+		if ((extension = switch_caller_extension_new(caller_session, app_name, arg)) == 0) {
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(caller_session), SWITCH_LOG_CRIT, "Memory Error!\n");
+			abort();
+		}
+		switch_caller_extension_add_application(caller_session, extension, app_name, arg);
+		switch_channel_set_caller_extension(caller_channel, extension);
+		switch_channel_set_state(caller_channel, CS_EXECUTE);
+	} else {
+		switch_ivr_session_transfer(caller_session, exten, dp, context);
+	}
+}
+
 #define ORIGINATE_SYNTAX "<call url> <exten>|&<application_name>(<app_args>) [<dialplan>] [<context>] [<cid_name>] [<cid_num>] [<timeout_sec>]"
 SWITCH_STANDARD_API(originate_function)
 {
-	switch_channel_t *caller_channel;
 	switch_core_session_t *caller_session = NULL;
 	char *mycmd = NULL, *argv[10] = { 0 };
 	int i = 0, x, argc = 0;
@@ -5145,31 +5351,7 @@ SWITCH_STANDARD_API(originate_function)
 		goto done;
 	}
 
-	caller_channel = switch_core_session_get_channel(caller_session);
-
-	if (*exten == '&' && *(exten + 1)) {
-		switch_caller_extension_t *extension = NULL;
-		char *app_name = switch_core_session_strdup(caller_session, (exten + 1));
-		char *arg = NULL, *e;
-
-		if ((e = strchr(app_name, ')'))) {
-			*e = '\0';
-		}
-
-		if ((arg = strchr(app_name, '('))) {
-			*arg++ = '\0';
-		}
-
-		if ((extension = switch_caller_extension_new(caller_session, app_name, arg)) == 0) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_CRIT, "Memory Error!\n");
-			abort();
-		}
-		switch_caller_extension_add_application(caller_session, extension, app_name, arg);
-		switch_channel_set_caller_extension(caller_channel, extension);
-		switch_channel_set_state(caller_channel, CS_EXECUTE);
-	} else {
-		switch_ivr_session_transfer(caller_session, exten, dp, context);
-	}
+	originate_send_to_exten(caller_session, exten, dp, context);
 
 	stream->write_function(stream, "+OK %s\n", switch_core_session_get_uuid(caller_session));
 
@@ -5180,108 +5362,1000 @@ SWITCH_STANDARD_API(originate_function)
 	return status;
 }
 
-SWITCH_STANDARD_API(sched_del_function)
-{
-	uint32_t cnt = 0;
+/*
+ * originate_batch: a paced campaign dialer.
+ *
+ * Every gateway (or profile, or endpoint) has one token bucket that holds it to its calls per
+ * second, however many batches dial it.  The rate comes from the batch that finds the gateway
+ * idle, later batches leave it alone until the gateway has nothing queued again.  Each batch
+ * queues its destinations for a gateway in its own queue on that bucket, and the queues take
+ * turns at the tokens so concurrent batches get a fair share.  A fixed set of workers runs the
+ * blocking originates.  Each finished attempt fires an originate_batch::result event and the last one
+ * fires originate_batch::complete.
+ */
 
-	if (!cmd) {
-		stream->write_function(stream, "-ERR Invalid syntax\n");
-		return SWITCH_STATUS_SUCCESS;
+#define DIALER_EVENT_RESULT "originate_batch::result"
+#define DIALER_EVENT_COMPLETE "originate_batch::complete"
+#define DIALER_DEFAULT_WORKERS 64
+#define DIALER_MAX_WORKERS 1024
+
+typedef struct dialer_batch_s dialer_batch_t;
+
+typedef struct dialer_call_s {
+	char *dest;
+	dialer_batch_t *batch;
+	struct dialer_call_s *next;
+} dialer_call_t;
+
+typedef struct dialer_bucket_s dialer_bucket_t;
+
+/* The calls of one batch for one gateway, on the bucket's turn list while it has any */
+typedef struct dialer_queue_s {
+	dialer_batch_t *batch;
+	dialer_bucket_t *bucket;
+	dialer_call_t *head;
+	dialer_call_t *tail;
+	uint32_t pending;
+	struct dialer_queue_s *next;
+	struct dialer_queue_s *batch_next;
+} dialer_queue_t;
+
+struct dialer_bucket_s {
+	char *key;
+	double rate;
+	double burst;
+	double tokens;
+	switch_time_t last;
+	dialer_queue_t *head;
+	dialer_queue_t *tail;
+	struct dialer_bucket_s *next;
+};
+
+struct dialer_batch_s {
+	char id[SWITCH_UUID_FORMATTED_LENGTH + 1];
+	switch_memory_pool_t *pool;
+	char *exten;
+	char *dp;
+	char *context;
+	char *cid_name;
+	char *cid_num;
+	uint32_t timeout;
+	double rate;
+	double burst;
+	dialer_call_t *calls;
+	dialer_call_t *calls_tail;
+	dialer_queue_t *queues;
+	uint32_t total;
+	uint32_t attempted;
+	uint32_t answered;
+	uint32_t failed;
+	uint32_t cancelled;
+	uint32_t in_flight;
+	switch_time_t created;
+	switch_call_cause_t cancel_cause;
+	struct dialer_batch_s *next;
+};
+
+static struct {
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_memory_pool_t *pool;
+	switch_hash_t *buckets;
+	dialer_bucket_t *bucket_head;
+	dialer_bucket_t *bucket_tail;
+	dialer_batch_t *batches;
+	uint32_t workers;
+	uint32_t idle;
+	uint32_t max_workers;
+	uint32_t queued;
+	int running;
+	switch_metric_t *attempts;
+	switch_metric_t *answered;
+	switch_metric_t *failed;
+	switch_metric_t *in_flight;
+	switch_metric_t *queued_calls;
+} dialer;
+
+/* The pacing key of a dial string: sofia/gateway/<name>, sofia/<profile> or the endpoint name */
+static void dialer_bucket_key(const char *dest, char *buf, switch_size_t len)
+{
+	const char *p = dest, *e;
+	int parts = 1;
+
+	while (*p == '{' || *p == '[' || *p == '<') {
+		char close = *p == '{' ? '}' : *p == '[' ? ']' : '>';
+
+		if (!(e = switch_find_end_paren(p, *p, close))) {
+			break;
+		}
+		p = e + 1;
 	}
 
-	if (switch_is_digit_string(cmd)) {
-		int64_t tmp;
-		tmp = (uint32_t) atoi(cmd);
-		if (tmp > 0) {
-			cnt = switch_scheduler_del_task_id((uint32_t) tmp);
+	if (!strncasecmp(p, "sofia/gateway/", 14)) {
+		parts = 3;
+	} else if (!strncasecmp(p, "sofia/", 6)) {
+		parts = 2;
+	}
+
+	for (e = p; *e && *e != '|' && *e != ','; e++) {
+		if (*e == '/' && !--parts) {
+			break;
 		}
-	} else {
-		cnt = switch_scheduler_del_task_group(cmd);
 	}
 
-	stream->write_function(stream, "+OK Deleted: %u\n", cnt);
+	if ((switch_size_t) (e - p) >= len) {
+		e = p + len - 1;
+	}
 
-	return SWITCH_STATUS_SUCCESS;
+	switch_copy_string(buf, p, (e - p) + 1);
 }
 
-SWITCH_STANDARD_API(xml_wrap_api_function)
+static void dialer_bucket_refill(dialer_bucket_t *bucket, switch_time_t now)
 {
-	char *dcommand, *edata = NULL, *send = NULL, *command, *arg = NULL;
-	switch_stream_handle_t mystream = { 0 };
-	int encoded = 0, elen = 0;
-
-	if (!cmd) {
-		stream->write_function(stream, "-ERR Invalid syntax\n");
-		return SWITCH_STATUS_SUCCESS;
+	if (bucket->rate > 0) {
+		bucket->tokens += bucket->rate * (double) (now - bucket->last) / 1000000;
+		if (bucket->tokens > bucket->burst) {
+			bucket->tokens = bucket->burst;
+		}
 	}
 
-	if ((dcommand = strdup(cmd))) {
-		if (!strncasecmp(dcommand, "encoded ", 8)) {
-			encoded++;
-			command = dcommand + 8;
+	bucket->last = now;
+}
+
+/* The shared bucket of a gateway, call with the dialer mutex held */
+static dialer_bucket_t *dialer_bucket_locate(const char *key, double rate, double burst)
+{
+	dialer_bucket_t *bucket;
+
+	if (!(bucket = switch_core_hash_find(dialer.buckets, key))) {
+		bucket = switch_core_alloc(dialer.pool, sizeof(*bucket));
+		bucket->key = switch_core_strdup(dialer.pool, key);
+		bucket->rate = rate;
+		bucket->burst = burst;
+		bucket->tokens = burst;
+		bucket->last = switch_micro_time_now();
+		switch_core_hash_insert(dialer.buckets, bucket->key, bucket);
+
+		if (dialer.bucket_tail) {
+			dialer.bucket_tail->next = bucket;
 		} else {
-			command = dcommand;
+			dialer.bucket_head = bucket;
 		}
-
-		if ((arg = strchr(command, ' '))) {
-			*arg++ = '\0';
+		dialer.bucket_tail = bucket;
+	} else if (!bucket->head && (bucket->rate != rate || bucket->burst != burst)) {
+		/* nobody is waiting on it, so the pace is ours to set */
+		dialer_bucket_refill(bucket, switch_micro_time_now());
+		bucket->rate = rate;
+		bucket->burst = burst;
+		if (bucket->tokens > bucket->burst) {
+			bucket->tokens = bucket->burst;
 		}
-		SWITCH_STANDARD_STREAM(mystream);
-		switch_api_execute(command, arg, NULL, &mystream);
+	}
 
-		if (mystream.data) {
-			if (encoded) {
-				elen = (int) strlen(mystream.data) * 3 + 1;
-				edata = malloc(elen);
-				switch_assert(edata != NULL);
-				memset(edata, 0, elen);
-				switch_url_encode(mystream.data, edata, elen);
-				send = edata;
-			} else {
-				send = mystream.data;
-			}
-		}
+	return bucket;
+}
 
-		stream->write_function(stream, "<result>\n" "  <row id=\"1\">\n" "    <data>%s</data>\n" "  </row>\n" "</result>\n", send ? send : "ERROR");
-		switch_safe_free(mystream.data);
-		switch_safe_free(edata);
-		free(dcommand);
+/* The queue of a batch on the bucket of a gateway, call with the dialer mutex held */
+static dialer_queue_t *dialer_queue_locate(dialer_batch_t *batch, switch_hash_t *queues, const char *key)
+{
+	dialer_queue_t *queue;
+
+	if (!(queue = switch_core_hash_find(queues, key))) {
+		queue = switch_core_alloc(batch->pool, sizeof(*queue));
+		queue->batch = batch;
+		queue->bucket = dialer_bucket_locate(key, batch->rate, batch->burst);
+		queue->batch_next = batch->queues;
+		batch->queues = queue;
+		switch_core_hash_insert(queues, key, queue);
 	}
 
-	return SWITCH_STATUS_SUCCESS;
+	return queue;
 }
 
-struct api_task {
-	uint32_t recur;
-	char cmd[];
-};
-
-static void sch_api_callback(switch_scheduler_task_t *task)
+/* Queues wait for their turn at the tail, call with the dialer mutex held */
+static void dialer_queue_link(dialer_queue_t *queue)
 {
-	char *cmd, *arg = NULL;
-	switch_stream_handle_t stream = { 0 };
-	struct api_task *api_task = (struct api_task *) task->cmd_arg;
-	switch_assert(task);
+	dialer_bucket_t *bucket = queue->bucket;
 
-	cmd = strdup(api_task->cmd);
-	switch_assert(cmd);
+	queue->next = NULL;
 
-	if ((arg = strchr(cmd, ' '))) {
-		*arg++ = '\0';
+	if (bucket->tail) {
+		bucket->tail->next = queue;
+	} else {
+		bucket->head = queue;
 	}
+	bucket->tail = queue;
+}
 
-	SWITCH_STANDARD_STREAM(stream);
-	switch_api_execute(cmd, arg, NULL, &stream);
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Command %s(%s):\n%s\n", cmd, switch_str_nil(arg), switch_str_nil((char *) stream.data));
-	switch_safe_free(stream.data);
-	switch_safe_free(cmd);
+static void dialer_queue_unlink(dialer_queue_t *queue)
+{
+	dialer_bucket_t *bucket = queue->bucket;
+	dialer_queue_t *qp, *last = NULL;
 
-	if (api_task->recur) {
-		task->runtime = switch_epoch_time_now(NULL) + api_task->recur;
+	for (qp = bucket->head; qp; last = qp, qp = qp->next) {
+		if (qp == queue) {
+			if (last) {
+				last->next = qp->next;
+			} else {
+				bucket->head = qp->next;
+			}
+			if (bucket->tail == qp) {
+				bucket->tail = last;
+			}
+			break;
+		}
 	}
+
+	queue->next = NULL;
 }
 
-#define UNSCHED_SYNTAX "<task_id>"
+/* Take the next call whose bucket has a token, serving buckets round robin; otherwise say how long until one will */
+static dialer_call_t *dialer_next_call(switch_interval_time_t *wait)
+{
+	dialer_bucket_t *bucket, *prev = NULL;
+	switch_time_t now = switch_micro_time_now();
+	dialer_queue_t *queue;
+	dialer_call_t *call;
+
+	*wait = 1000000;
+
+	for (bucket = dialer.bucket_head; bucket; prev = bucket, bucket = bucket->next) {
+		if (!(queue = bucket->head)) {
+			continue;
+		}
+
+		dialer_bucket_refill(bucket, now);
+
+		if (bucket->rate > 0 && bucket->tokens < 1) {
+			switch_interval_time_t need = (switch_interval_time_t) ((1 - bucket->tokens) * 1000000 / bucket->rate) + 1;
+
+			if (need < *wait) {
+				*wait = need;
+			}
+			continue;
+		}
+
+		if (bucket->rate > 0) {
+			bucket->tokens -= 1;
+		}
+
+		call = queue->head;
+		if (!(queue->head = call->next)) {
+			queue->tail = NULL;
+		}
+		call->next = NULL;
+		queue->pending--;
+
+		/* the batches on a gateway take turns, one call each */
+		if (!(bucket->head = queue->next)) {
+			bucket->tail = NULL;
+		}
+		if (queue->pending) {
+			dialer_queue_link(queue);
+		}
+
+		dialer.queued--;
+		switch_core_metric_dec(dialer.queued_calls);
+
+		if (bucket->next) {
+			if (prev) {
+				prev->next = bucket->next;
+			} else {
+				dialer.bucket_head = bucket->next;
+			}
+			bucket->next = NULL;
+			dialer.bucket_tail->next = bucket;
+			dialer.bucket_tail = bucket;
+		}
+
+		return call;
+	}
+
+	return NULL;
+}
+
+static void dialer_batch_destroy(dialer_batch_t *batch)
+{
+	switch_memory_pool_t *pool = batch->pool;
+
+	switch_core_destroy_memory_pool(&pool);
+}
+
+/* Unlinks a finished batch, call with the dialer mutex held and fire the event once it is released */
+static int dialer_batch_done(dialer_batch_t *batch)
+{
+	dialer_batch_t *bp, *last = NULL;
+
+	if (batch->in_flight || batch->attempted + batch->cancelled < batch->total) {
+		return 0;
+	}
+
+	for (bp = dialer.batches; bp; last = bp, bp = bp->next) {
+		if (bp == batch) {
+			if (last) {
+				last->next = bp->next;
+			} else {
+				dialer.batches = bp->next;
+			}
+			break;
+		}
+	}
+
+	/* nothing queued is left, so none of its queues is on a bucket any more */
+
+	return 1;
+}
+
+static void dialer_batch_complete(dialer_batch_t *batch)
+{
+	switch_event_t *event;
+
+	if (switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, DIALER_EVENT_COMPLETE) == SWITCH_STATUS_SUCCESS) {
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Batch-ID", batch->id);
+		switch_event_add_header(event, SWITCH_STACK_BOTTOM, "Batch-Total", "%u", batch->total);
+		switch_event_add_header(event, SWITCH_STACK_BOTTOM, "Batch-Answered", "%u", batch->answered);
+		switch_event_add_header(event, SWITCH_STACK_BOTTOM, "Batch-Failed", "%u", batch->failed);
+		switch_event_add_header(event, SWITCH_STACK_BOTTOM, "Batch-Cancelled", "%u", batch->cancelled);
+		switch_event_add_header(event, SWITCH_STACK_BOTTOM, "Batch-Duration-Msec", "%" SWITCH_TIME_T_FMT,
+								(switch_micro_time_now() - batch->created) / 1000);
+		switch_event_fire(&event);
+	}
+
+	dialer_batch_destroy(batch);
+}
+
+static void dialer_run_call(dialer_call_t *call)
+{
+	dialer_batch_t *batch = call->batch;
+	switch_core_session_t *session = NULL;
+	switch_call_cause_t cause = SWITCH_CAUSE_NORMAL_CLEARING;
+	char uuid[SWITCH_UUID_FORMATTED_LENGTH + 1] = "";
+	switch_event_t *event;
+	int answered = 0;
+
+	switch_core_metric_inc(dialer.attempts);
+	switch_core_metric_inc(dialer.in_flight);
+
+	if (batch->cancel_cause) {
+		cause = batch->cancel_cause;
+	} else if (switch_ivr_originate(NULL, &session, &cause, call->dest, batch->timeout, NULL, batch->cid_name, batch->cid_num, NULL, NULL,
+									SOF_NONE, &batch->cancel_cause, NULL) == SWITCH_STATUS_SUCCESS && session) {
+		answered = 1;
+		switch_copy_string(uuid, switch_core_session_get_uuid(session), sizeof(uuid));
+		originate_send_to_exten(session, batch->exten, batch->dp, batch->context);
+		switch_core_session_rwunlock(session);
+	}
+
+	switch_core_metric_dec(dialer.in_flight);
+	switch_core_metric_inc(answered ? dialer.answered : dialer.failed);
+
+	if (switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, DIALER_EVENT_RESULT) == SWITCH_STATUS_SUCCESS) {
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Batch-ID", batch->id);
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Destination", call->dest);
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Result", answered ? "answered" : "failed");
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Hangup-Cause", answered ? "NONE" : switch_channel_cause2str(cause));
+		if (answered) {
+			switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Unique-ID", uuid);
+		}
+		switch_event_fire(&event);
+	}
+
+	switch_mutex_lock(dialer.mutex);
+	batch->in_flight--;
+	if (answered) {
+		batch->answered++;
+	} else {
+		batch->failed++;
+	}
+	if (!dialer_batch_done(batch)) {
+		batch = NULL;
+	}
+	switch_mutex_unlock(dialer.mutex);
+
+	if (batch) {
+		dialer_batch_complete(batch);
+	}
+}
+
+static void *SWITCH_THREAD_FUNC dialer_worker(switch_thread_t *thread, void *obj)
+{
+	dialer_call_t *call;
+	switch_interval_time_t wait;
+
+	switch_mutex_lock(dialer.mutex);
+
+	while (dialer.running && dialer.workers <= dialer.max_workers) {
+		if (!(call = dialer_next_call(&wait))) {
+			switch_thread_cond_timedwait(dialer.cond, dialer.mutex, wait);
+			continue;
+		}
+
+		dialer.idle--;
+		call->batch->attempted++;
+		call->batch->in_flight++;
+		switch_mutex_unlock(dialer.mutex);
+
+		dialer_run_call(call);
+
+		switch_mutex_lock(dialer.mutex);
+		dialer.idle++;
+	}
+
+	dialer.workers--;
+	dialer.idle--;
+	switch_mutex_unlock(dialer.mutex);
+
+	return NULL;
+}
+
+/* Start workers until every queued call has one or we hit the cap, call with the dialer mutex held */
+static void dialer_spawn_workers(void)
+{
+	switch_thread_t *thread;
+	switch_threadattr_t *thd_attr = NULL;
+
+	while (dialer.running && dialer.workers < dialer.max_workers && dialer.idle < dialer.queued) {
+		switch_threadattr_create(&thd_attr, dialer.pool);
+		switch_threadattr_detach_set(thd_attr, 1);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+		if (switch_thread_create(&thread, thd_attr, dialer_worker, NULL, dialer.pool) != SWITCH_STATUS_SUCCESS) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot start an originate_batch worker\n");
+			break;
+		}
+
+		dialer.workers++;
+		dialer.idle++;
+	}
+}
+
+static dialer_batch_t *dialer_batch_create(const char *exten, const char *dp, const char *context, const char *cid_name, const char *cid_num,
+										   uint32_t timeout, double rate, double burst)
+{
+	switch_memory_pool_t *pool;
+	dialer_batch_t *batch;
+	switch_uuid_t uuid;
+
+	switch_core_new_memory_pool(&pool);
+	batch = switch_core_alloc(pool, sizeof(*batch));
+	batch->pool = pool;
+	batch->exten = switch_core_strdup(pool, exten);
+	batch->dp = switch_core_strdup(pool, zstr(dp) ? "XML" : dp);
+	batch->context = switch_core_strdup(pool, zstr(context) ? "default" : context);
+	batch->cid_name = zstr(cid_name) ? NULL : switch_core_strdup(pool, cid_name);
+	batch->cid_num = zstr(cid_num) ? NULL : switch_core_strdup(pool, cid_num);
+	batch->timeout = timeout ? timeout : 60;
+	batch->rate = rate > 0 ? rate : 0;
+	batch->burst = burst >= 1 ? burst : (rate > 1 ? rate : 1);
+	batch->created = switch_micro_time_now();
+
+	switch_uuid_get(&uuid);
+	switch_uuid_format(batch->id, &uuid);
+
+	return batch;
+}
+
+static void dialer_batch_add(dialer_batch_t *batch, const char *dest)
+{
+	dialer_call_t *call;
+
+	if (zstr(dest)) {
+		return;
+	}
+
+	call = switch_core_alloc(batch->pool, sizeof(*call));
+	call->dest = switch_core_strdup(batch->pool, dest);
+	call->batch = batch;
+
+	if (batch->calls_tail) {
+		batch->calls_tail->next = call;
+	} else {
+		batch->calls = call;
+	}
+	batch->calls_tail = call;
+	batch->total++;
+}
+
+static switch_status_t dialer_batch_submit(dialer_batch_t *batch)
+{
+	dialer_call_t *call, *next;
+	switch_hash_t *queues;
+	char key[256];
+
+	if (!batch->total) {
+		dialer_batch_destroy(batch);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_mutex_lock(dialer.mutex);
+
+	if (!dialer.running) {
+		switch_mutex_unlock(dialer.mutex);
+		dialer_batch_destroy(batch);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_core_hash_init(&queues);
+
+	for (call = batch->calls; call; call = next) {
+		dialer_queue_t *queue;
+
+		next = call->next;
+		call->next = NULL;
+
+		dialer_bucket_key(call->dest, key, sizeof(key));
+		queue = dialer_queue_locate(batch, queues, key);
+
+		if (queue->tail) {
+			queue->tail->next = call;
+		} else {
+			queue->head = call;
+		}
+		queue->tail = call;
+
+		if (!queue->pending++) {
+			dialer_queue_link(queue);
+		}
+	}
+
+	switch_core_hash_destroy(&queues);
+
+	batch->calls = batch->calls_tail = NULL;
+	batch->next = dialer.batches;
+	dialer.batches = batch;
+	dialer.queued += batch->total;
+	switch_core_metric_add(dialer.queued_calls, batch->total);
+
+	dialer_spawn_workers();
+	switch_thread_cond_broadcast(dialer.cond);
+	switch_mutex_unlock(dialer.mutex);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/* Drop the queued calls of a batch and abort its ringing ones */
+static switch_status_t dialer_batch_cancel(const char *id)
+{
+	dialer_batch_t *batch;
+	dialer_queue_t *queue;
+	int done = 0;
+
+	switch_mutex_lock(dialer.mutex);
+
+	for (batch = dialer.batches; batch; batch = batch->next) {
+		if (!strcmp(batch->id, id)) {
+			break;
+		}
+	}
+
+	if (!batch) {
+		switch_mutex_unlock(dialer.mutex);
+		return SWITCH_STATUS_NOTFOUND;
+	}
+
+	batch->cancel_cause = SWITCH_CAUSE_ORIGINATOR_CANCEL;
+
+	for (queue = batch->queues; queue; queue = queue->batch_next) {
+		if (!queue->pending) {
+			continue;
+		}
+
+		dialer_queue_unlink(queue);
+		dialer.queued -= queue->pending;
+		switch_core_metric_add(dialer.queued_calls, -(int64_t) queue->pending);
+		batch->cancelled += queue->pending;
+		queue->pending = 0;
+		queue->head = queue->tail = NULL;
+	}
+
+	done = dialer_batch_done(batch);
+	switch_mutex_unlock(dialer.mutex);
+
+	if (done) {
+		dialer_batch_complete(batch);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void dialer_batch_status(dialer_batch_t *batch, switch_stream_handle_t *stream)
+{
+	stream->write_function(stream, "%s %u %u %u %u %u %u %.2f\n", batch->id, batch->total, batch->attempted, batch->answered, batch->failed,
+						   batch->cancelled, batch->in_flight, batch->rate);
+}
+
+static void dialer_status(const char *id, switch_stream_handle_t *stream)
+{
+	dialer_batch_t *batch;
+	int found = 0;
+
+	switch_mutex_lock(dialer.mutex);
+
+	if (zstr(id)) {
+		stream->write_function(stream, "workers: %u/%u idle: %u queued: %u\n", dialer.workers, dialer.max_workers, dialer.idle, dialer.queued);
+		stream->write_function(stream, "batch total attempted answered failed cancelled in_flight rate\n");
+	}
+
+	for (batch = dialer.batches; batch; batch = batch->next) {
+		if (zstr(id) || !strcmp(batch->id, id)) {
+			dialer_batch_status(batch, stream);
+			found++;
+		}
+	}
+
+	switch_mutex_unlock(dialer.mutex);
+
+	if (!zstr(id) && !found) {
+		stream->write_function(stream, "-ERR No such batch\n");
+	}
+}
+
+static void dialer_shutdown(void)
+{
+	dialer_batch_t *batch;
+	int x;
+
+	if (!dialer.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(dialer.mutex);
+	dialer.running = 0;
+	for (batch = dialer.batches; batch; batch = batch->next) {
+		batch->cancel_cause = SWITCH_CAUSE_SYSTEM_SHUTDOWN;
+	}
+	switch_thread_cond_broadcast(dialer.cond);
+	switch_mutex_unlock(dialer.mutex);
+
+	/* the handles stay valid for workers still winding down, they just stop being exposed */
+	switch_core_metric_unregister(dialer.attempts);
+	switch_core_metric_unregister(dialer.answered);
+	switch_core_metric_unregister(dialer.failed);
+	switch_core_metric_unregister(dialer.in_flight);
+	switch_core_metric_unregister(dialer.queued_calls);
+
+	for (x = 0; x < 300; x++) {
+		switch_mutex_lock(dialer.mutex);
+		if (!dialer.workers) {
+			switch_mutex_unlock(dialer.mutex);
+			break;
+		}
+		switch_thread_cond_broadcast(dialer.cond);
+		switch_mutex_unlock(dialer.mutex);
+		switch_yield(100000);
+	}
+
+	if (x == 300) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Giving up waiting for originate_batch workers.\n");
+		return;
+	}
+
+	dialer.bucket_head = dialer.bucket_tail = NULL;
+	while ((batch = dialer.batches)) {
+		dialer.batches = batch->next;
+		dialer_batch_destroy(batch);
+	}
+
+	switch_core_hash_destroy(&dialer.buckets);
+	switch_event_free_subclass(DIALER_EVENT_RESULT);
+	switch_event_free_subclass(DIALER_EVENT_COMPLETE);
+}
+
+static void dialer_init(switch_memory_pool_t *pool)
+{
+	memset(&dialer, 0, sizeof(dialer));
+	dialer.pool = pool;
+	dialer.max_workers = DIALER_DEFAULT_WORKERS;
+	dialer.running = 1;
+	switch_mutex_init(&dialer.mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_thread_cond_create(&dialer.cond, pool);
+	switch_core_hash_init(&dialer.buckets);
+
+	switch_event_reserve_subclass(DIALER_EVENT_RESULT);
+	switch_event_reserve_subclass(DIALER_EVENT_COMPLETE);
+
+	switch_core_metric_register("freeswitch_dialer_attempts_total", NULL, "originate_batch call attempts", SWITCH_METRIC_COUNTER, &dialer.attempts);
+	switch_core_metric_register("freeswitch_dialer_answered_total", NULL, "originate_batch calls answered", SWITCH_METRIC_COUNTER, &dialer.answered);
+	switch_core_metric_register("freeswitch_dialer_failed_total", NULL, "originate_batch calls that did not answer", SWITCH_METRIC_COUNTER, &dialer.failed);
+	switch_core_metric_register("freeswitch_dialer_in_flight", NULL, "originate_batch calls ringing", SWITCH_METRIC_GAUGE, &dialer.in_flight);
+	switch_core_metric_register("freeswitch_dialer_queued", NULL, "originate_batch calls waiting for a worker or a token", SWITCH_METRIC_GAUGE, &dialer.queued_calls);
+}
+
+static void dialer_batch_add_file(dialer_batch_t *batch, const char *path)
+{
+	char line[4096];
+	FILE *fp;
+
+	if (!(fp = fopen(path, "r"))) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot open %s\n", path);
+		return;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		char *dest = switch_strip_whitespace(line);
+
+		if (dest && *dest != '#') {
+			dialer_batch_add(batch, dest);
+		}
+		switch_safe_free(dest);
+	}
+
+	fclose(fp);
+}
+
+/* A single dial string, @<file> with one per line, or a ^^<delim> separated list */
+static void dialer_batch_add_list(dialer_batch_t *batch, char *list)
+{
+	char delim, *p, *e;
+
+	if (*list == '@') {
+		dialer_batch_add_file(batch, list + 1);
+		return;
+	}
+
+	if (strncmp(list, "^^", 2) || !list[2]) {
+		dialer_batch_add(batch, list);
+		return;
+	}
+
+	delim = list[2];
+
+	for (p = list + 3; p; p = e) {
+		if ((e = strchr(p, delim))) {
+			*e++ = '\0';
+		}
+		dialer_batch_add(batch, p);
+	}
+}
+
+#define ORIGINATE_BATCH_SYNTAX "<rate>[/<burst>] <destinations> <exten>|&<application_name>(<app_args>) [<dialplan>] [<context>] [<cid_name>] [<cid_num>] [<timeout_sec>]|status [<batch_id>]|cancel <batch_id>|workers <max>"
+SWITCH_STANDARD_API(originate_batch_function)
+{
+	char *mycmd = NULL, *argv[9] = { 0 };
+	char id[SWITCH_UUID_FORMATTED_LENGTH + 1];
+	int argc = 0, x;
+	double rate, burst = 0;
+	char *p;
+	dialer_batch_t *batch;
+
+	if (zstr(cmd)) {
+		stream->write_function(stream, "-USAGE: %s\n", ORIGINATE_BATCH_SYNTAX);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	mycmd = strdup(cmd);
+	switch_assert(mycmd);
+	argc = switch_separate_string(mycmd, ' ', argv, (sizeof(argv) / sizeof(argv[0])));
+
+	if (!strcasecmp(argv[0], "status")) {
+		dialer_status(argv[1], stream);
+		goto done;
+	}
+
+	if (!strcasecmp(argv[0], "cancel") && argc == 2) {
+		if (dialer_batch_cancel(argv[1]) == SWITCH_STATUS_SUCCESS) {
+			stream->write_function(stream, "+OK\n");
+		} else {
+			stream->write_function(stream, "-ERR No such batch\n");
+		}
+		goto done;
+	}
+
+	if (!strcasecmp(argv[0], "workers") && argc == 2) {
+		int max = atoi(argv[1]);
+
+		if (max < 1 || max > DIALER_MAX_WORKERS) {
+			stream->write_function(stream, "-ERR workers must be between 1 and %d\n", DIALER_MAX_WORKERS);
+			goto done;
+		}
+
+		switch_mutex_lock(dialer.mutex);
+		dialer.max_workers = max;
+		dialer_spawn_workers();
+		switch_thread_cond_broadcast(dialer.cond);
+		switch_mutex_unlock(dialer.mutex);
+		stream->write_function(stream, "+OK\n");
+		goto done;
+	}
+
+	if (argc < 3 || argc > 8) {
+		stream->write_function(stream, "-USAGE: %s\n", ORIGINATE_BATCH_SYNTAX);
+		goto done;
+	}
+
+	for (x = 0; x < argc && argv[x]; x++) {
+		if (!strcasecmp(argv[x], "undef")) {
+			argv[x] = NULL;
+		}
+	}
+
+	rate = argv[0] ? atof(argv[0]) : 0;
+	if (argv[0] && (p = strchr(argv[0], '/'))) {
+		burst = atof(p + 1);
+	}
+
+	if (!argv[1] || !argv[2]) {
+		stream->write_function(stream, "-USAGE: %s\n", ORIGINATE_BATCH_SYNTAX);
+		goto done;
+	}
+
+	batch = dialer_batch_create(argv[2], argv[3], argv[4], argv[5], argv[6], argv[7] ? atoi(argv[7]) : 0, rate, burst);
+	dialer_batch_add_list(batch, argv[1]);
+	x = batch->total;
+	switch_copy_string(id, batch->id, sizeof(id));
+
+	if (!x) {
+		dialer_batch_destroy(batch);
+		stream->write_function(stream, "-ERR No destinations\n");
+	} else if (dialer_batch_submit(batch) == SWITCH_STATUS_SUCCESS) {
+		stream->write_function(stream, "+OK %s %d\n", id, x);
+	} else {
+		stream->write_function(stream, "-ERR Dialer is shutting down\n");
+	}
+
+  done:
+	switch_safe_free(mycmd);
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static double dialer_json_number(cJSON *data, const char *name, double dft)
+{
+	cJSON *item = cJSON_GetObjectItem(data, name);
+
+	if (item && item->type == cJSON_Number) {
+		return item->valuedouble;
+	}
+
+	if (item && item->type == cJSON_String && !zstr(item->valuestring)) {
+		return atof(item->valuestring);
+	}
+
+	return dft;
+}
+
+SWITCH_STANDARD_JSON_API(json_originate_batch_function)
+{
+	cJSON *reply, *data = cJSON_GetObjectItem(json, "data"), *dests, *item;
+	const char *exten;
+	char id[SWITCH_UUID_FORMATTED_LENGTH + 1];
+	dialer_batch_t *batch;
+	uint32_t total;
+
+	reply = cJSON_CreateObject();
+	*json_reply = reply;
+
+	if (!data || !(dests = cJSON_GetObjectItem(data, "destinations")) || dests->type != cJSON_Array ||
+		zstr((exten = cJSON_GetObjectCstr(data, "exten")))) {
+		cJSON_AddItemToObject(reply, "response", cJSON_CreateString("INVALID INPUT"));
+		return SWITCH_STATUS_FALSE;
+	}
+
+	batch = dialer_batch_create(exten, cJSON_GetObjectCstr(data, "dialplan"), cJSON_GetObjectCstr(data, "context"),
+								cJSON_GetObjectCstr(data, "cid_name"), cJSON_GetObjectCstr(data, "cid_num"),
+								(uint32_t) dialer_json_number(data, "timeout", 0), dialer_json_number(data, "rate", 0), dialer_json_number(data, "burst", 0));
+
+	for (item = dests->child; item; item = item->next) {
+		if (item->type == cJSON_String) {
+			dialer_batch_add(batch, item->valuestring);
+		}
+	}
+
+	total = batch->total;
+	switch_copy_string(id, batch->id, sizeof(id));
+
+	if (dialer_batch_submit(batch) != SWITCH_STATUS_SUCCESS) {
+		cJSON_AddItemToObject(reply, "response", cJSON_CreateString(total ? "SHUTTING DOWN" : "NO DESTINATIONS"));
+		return SWITCH_STATUS_FALSE;
+	}
+
+	cJSON_AddItemToObject(reply, "batch_id", cJSON_CreateString(id));
+	cJSON_AddItemToObject(reply, "queued", cJSON_CreateNumber(total));
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(sched_del_function)
+{
+	uint32_t cnt = 0;
+
+	if (!cmd) {
+		stream->write_function(stream, "-ERR Invalid syntax\n");
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (switch_is_digit_string(cmd)) {
+		int64_t tmp;
+		tmp = (uint32_t) atoi(cmd);
+		if (tmp > 0) {
+			cnt = switch_scheduler_del_task_id((uint32_t) tmp);
+		}
+	} else {
+		cnt = switch_scheduler_del_task_group(cmd);
+	}
+
+	stream->write_function(stream, "+OK Deleted: %u\n", cnt);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(xml_wrap_api_function)
+{
+	char *dcommand, *edata = NULL, *send = NULL, *command, *arg = NULL;
+	switch_stream_handle_t mystream = { 0 };
+	int encoded = 0, elen = 0;
+
+	if (!cmd) {
+		stream->write_function(stream, "-ERR Invalid syntax\n");
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if ((dcommand = strdup(cmd))) {
+		if (!strncasecmp(dcommand, "encoded ", 8)) {
+			encoded++;
+			command = dcommand + 8;
+		} else {
+			command = dcommand;
+		}
+
+		if ((arg = strchr(command, ' '))) {
+			*arg++ = '\0';
+		}
+		SWITCH_STANDARD_STREAM(mystream);
+		switch_api_execute(command, arg, NULL, &mystream);
+
+		if (mystream.data) {
+			if (encoded) {
+				elen = (int) strlen(mystream.data) * 3 + 1;
+				edata = malloc(elen);
+				switch_assert(edata != NULL);
+				memset(edata, 0, elen);
+				switch_url_encode(mystream.data, edata, elen);
+				send = edata;
+			} else {
+				send = mystream.data;
+			}
+		}
+
+		stream->write_function(stream, "<result>\n" "  <row id=\"1\">\n" "    <data>%s</data>\n" "  </row>\n" "</result>\n", send ? send : "ERROR");
+		switch_safe_free(mystream.data);
+		switch_safe_free(edata);
+		free(dcommand);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+struct api_task {
+	uint32_t recur;
+	char cmd[];
+};
+
+static void sch_api_callback(switch_scheduler_task_t *task)
+{
+	char *cmd, *arg = NULL;
+	switch_stream_handle_t stream = { 0 };
+	struct api_task *api_task = (struct api_task *) task->cmd_arg;
+	switch_assert(task);
+
+	cmd = strdup(api_task->cmd);
+	switch_assert(cmd);
+
+	if ((arg = strchr(cmd, ' '))) {
+		*arg++ = '\0';
+	}
+
+	SWITCH_STANDARD_STREAM(stream);
+	switch_api_execute(cmd, arg, NULL, &stream);
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Command %s(%s):\n%s\n", cmd, switch_str_nil(arg), switch_str_nil((char *) stream.data));
+	switch_safe_free(stream.data);
+	switch_safe_free(cmd);
+
+	if (api_task->recur) {
+		task->runtime = switch_epoch_time_now(NULL) + api_task->recur;
+	}
+}
+
+#define UNSCHED_SYNTAX "<task_id>"
 SWITCH_STANDARD_API(unsched_api_function)
 {
 	uint32_t id;
@@ -7152,6 +8226,8 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_commands_shutdown)
 {
 	int x;
 
+	dialer_shutdown();
+
 	for (x = 30; x > 0; x--) {
 		if (switch_thread_rwlock_trywrlock(bgapi_rwlock) == SWITCH_STATUS_SUCCESS) {
 			switch_thread_rwlock_unlock(bgapi_rwlock);
@@ -7213,6 +8289,139 @@ SWITCH_STANDARD_API(log_function)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+#define LOG_TRACE_SYNTAX "dump [<file>]|decode <file>"
+SWITCH_STANDARD_API(log_trace_function)
+{
+	char *mydata = NULL, *argv[2] = { 0 };
+	char path[1024] = "";
+	int argc = 0;
+
+	if (!zstr(cmd) && (mydata = strdup(cmd))) {
+		argc = switch_separate_string(mydata, ' ', argv, (sizeof(argv) / sizeof(argv[0])));
+	}
+
+	if (argc < 1) {
+		stream->write_function(stream, "-USAGE: %s\n", LOG_TRACE_SYNTAX);
+		goto done;
+	}
+
+	if (!strcasecmp(argv[0], "dump")) {
+		if (argc > 1) {
+			switch_copy_string(path, argv[1], sizeof(path));
+		} else {
+			switch_snprintf(path, sizeof(path), "%s%sfreeswitch.trace", SWITCH_GLOBAL_dirs.log_dir, SWITCH_PATH_SEPARATOR);
+		}
+
+		if (switch_log_trace_dump(path) == SWITCH_STATUS_SUCCESS) {
+			stream->write_function(stream, "+OK %s\n", path);
+		} else {
+			stream->write_function(stream, "-ERR Cannot write %s, is log-trace-records off?\n", path);
+		}
+	} else if (!strcasecmp(argv[0], "decode") && argc > 1) {
+		if (switch_log_trace_decode(argv[1], stream) != SWITCH_STATUS_SUCCESS) {
+			stream->write_function(stream, "-ERR Cannot decode %s\n", argv[1]);
+		}
+	} else {
+		stream->write_function(stream, "-USAGE: %s\n", LOG_TRACE_SYNTAX);
+	}
+
+  done:
+	switch_safe_free(mydata);
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void latency_print(switch_core_session_t *session, switch_bool_t json, switch_stream_handle_t *stream)
+{
+	int stage;
+
+	if (json) {
+		cJSON *obj = switch_core_latency_json(session);
+		char *out;
+
+		if (!obj) {
+			stream->write_function(stream, "-ERR No latency histograms\n");
+			return;
+		}
+
+		out = cJSON_PrintUnformatted(obj);
+		stream->write_function(stream, "%s\n", out);
+		switch_safe_free(out);
+		cJSON_Delete(obj);
+		return;
+	}
+
+	stream->write_function(stream, "%-14s %10s %8s %8s %8s %8s %8s %8s\n", "stage", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+
+	for (stage = 0; stage < SWITCH_LATENCY_STAGE_COUNT; stage++) {
+		switch_latency_summary_t summary;
+
+		if (switch_core_latency_get(session, stage, &summary) != SWITCH_STATUS_SUCCESS) {
+			stream->write_function(stream, "-ERR No latency histograms\n");
+			return;
+		}
+
+		stream->write_function(stream, "%-14s %10" SWITCH_UINT64_T_FMT " %8" SWITCH_UINT64_T_FMT " %8" SWITCH_UINT64_T_FMT " %8" SWITCH_UINT64_T_FMT
+							   " %8" SWITCH_UINT64_T_FMT " %8" SWITCH_UINT64_T_FMT " %8" SWITCH_UINT64_T_FMT "\n",
+							   switch_core_latency_stage2str(stage), summary.count, summary.mean, summary.p50, summary.p90, summary.p99, summary.p999, summary.max);
+	}
+}
+
+#define LATENCY_SYNTAX "[json]|on|off|reset [<uuid>]|<uuid> [json|on|off]"
+SWITCH_STANDARD_API(latency_function)
+{
+	char *mydata = NULL, *argv[2] = { 0 };
+	switch_core_session_t *lsession = NULL;
+	int argc = 0;
+
+	if (!zstr(cmd) && (mydata = strdup(cmd))) {
+		argc = switch_separate_string(mydata, ' ', argv, (sizeof(argv) / sizeof(argv[0])));
+	}
+
+	if (argc < 1 || !strcasecmp(argv[0], "json")) {
+		latency_print(NULL, argc > 0, stream);
+	} else if (!strcasecmp(argv[0], "on") || !strcasecmp(argv[0], "off")) {
+		switch_core_latency_enable(switch_true(argv[0]));
+		stream->write_function(stream, "+OK latency histograms %s\n", switch_core_latency_enabled() ? "on" : "off");
+	} else if (!strcasecmp(argv[0], "reset")) {
+		if (argc > 1) {
+			if ((lsession = switch_core_session_locate(argv[1]))) {
+				switch_core_latency_reset(lsession);
+				stream->write_function(stream, "+OK\n");
+			} else {
+				stream->write_function(stream, "-ERR No such channel!\n");
+			}
+		} else {
+			switch_core_latency_reset(NULL);
+			stream->write_function(stream, "+OK\n");
+		}
+	} else if ((lsession = switch_core_session_locate(argv[0]))) {
+		if (argc > 1 && (!strcasecmp(argv[1], "on") || !strcasecmp(argv[1], "off"))) {
+			switch_core_session_latency_enable(lsession, switch_true(argv[1]));
+			stream->write_function(stream, "+OK\n");
+		} else {
+			latency_print(lsession, argc > 1 && !strcasecmp(argv[1], "json"), stream);
+		}
+	} else {
+		stream->write_function(stream, "-USAGE: %s\n", LATENCY_SYNTAX);
+	}
+
+	if (lsession) {
+		switch_core_session_rwunlock(lsession);
+	}
+
+	switch_safe_free(mydata);
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(metrics_function)
+{
+	if (switch_core_metrics_expose(stream) != SWITCH_STATUS_SUCCESS) {
+		stream->write_function(stream, "-ERR Metrics are not available\n");
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_STANDARD_API(file_exists_function)
 {
 	if (!zstr(cmd)) {
@@ -7586,6 +8795,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 
 	switch_thread_rwlock_create(&bgapi_rwlock, pool);
 	switch_mutex_init(&reload_mutex, SWITCH_MUTEX_NESTED, pool);
+	dialer_init(pool);
 
 	if (use_system_commands) {
 		SWITCH_ADD_API(commands_api_interface, "bg_system", "Execute a system command in the background", bg_system_function, SYSTEM_SYNTAX);
@@ -7601,6 +8811,12 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_API(commands_api_interface, "bgapi", "Execute an api command in a thread", bgapi_function, "<command>[ <arg>]");
 	SWITCH_ADD_API(commands_api_interface, "break", "uuid_break", break_function, BREAK_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "complete", "Complete", complete_function, COMPLETE_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "session_table", "Show session table shard occupancy", session_table_function, "stats");
+	SWITCH_ADD_API(commands_api_interface, "codec_offload", "Show the transcoding offload workers", codec_offload_function, "status");
+	SWITCH_ADD_API(commands_api_interface, "inband_detect", "Show the inband DTMF and tone detection workers", inband_detect_function, "status");
+	SWITCH_ADD_API(commands_api_interface, "dtls_offload", "Show the shared DTLS contexts and the handshake workers", dtls_offload_function, "status");
+	SWITCH_ADD_API(commands_api_interface, "codec_bench", "Benchmark the loaded audio codecs", codec_bench_function, CODEC_BENCH_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "module_timing", "Show how long each module took to load", module_timing_function, "[json]");
 	SWITCH_ADD_API(commands_api_interface, "cond", "Evaluate a conditional", cond_function, "<expr> ? <true val> : <false val>");
 	SWITCH_ADD_API(commands_api_interface, "console_complete", "", console_complete_function, "<line>");
 	SWITCH_ADD_API(commands_api_interface, "console_complete_xml", "", console_complete_xml_function, "<line>");
@@ -7639,11 +8855,15 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_API(commands_api_interface, "list_users", "List Users configured in Directory", list_users_function, LIST_USERS_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "load", "Load Module", load_function, LOAD_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "log", "Log", log_function, LOG_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "log_trace", "Dump or decode the log trace rings", log_trace_function, LOG_TRACE_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "metrics", "Show the core metrics in the Prometheus text format", metrics_function, "");
+	SWITCH_ADD_API(commands_api_interface, "latency", "Show media and call path latency histograms", latency_function, LATENCY_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "md5", "Return md5 hash", md5_function, "<data>");
 	SWITCH_ADD_API(commands_api_interface, "module_exists", "Check if module exists", module_exists_function, "<module>");
 	SWITCH_ADD_API(commands_api_interface, "msleep", "Sleep N milliseconds", msleep_function, "<milliseconds>");
 	SWITCH_ADD_API(commands_api_interface, "nat_map", "Manage NAT", nat_map_function, "[status|republish|reinit] | [add|del] <port> [tcp|udp] [static]");
 	SWITCH_ADD_API(commands_api_interface, "originate", "Originate a call", originate_function, ORIGINATE_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "originate_batch", "Originate a paced batch of calls", originate_batch_function, ORIGINATE_BATCH_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "pause", "Pause media on a channel", pause_function, PAUSE_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "pool_stats", "Core pool memory usage", pool_stats_function, "Core pool memory usage.");
 	SWITCH_ADD_API(commands_api_interface, "quote_shell_arg", "Quote/escape a string for use on shell command line", quote_shell_arg_function, "<data>");
@@ -7660,6 +8880,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_API(commands_api_interface, "sched_transfer", "Schedule a transfer for a running call", sched_transfer_function, SCHED_TRANSFER_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "show", "Show various reports", show_function, SHOW_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "sql_escape", "Escape a string to prevent sql injection", sql_escape, SQL_ESCAPE_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "srtp_bench", "Benchmark the SRTP crypto suites", srtp_bench_function, SRTP_BENCH_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "status", "Show current status", status_function, "");
 	SWITCH_ADD_API(commands_api_interface, "strftime_tz", "Display formatted time of timezone", strftime_tz_api_function, "<timezone_name> [<epoch>|][format string]");
 	SWITCH_ADD_API(commands_api_interface, "stun", "Execute STUN lookup", stun_function, "<stun_server>[:port] [<source_ip>[:<source_port]]");
@@ -7748,6 +8969,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_JSON_API(json_api_interface, "fsapi", "JSON FSAPI Gateway", json_api_function, "");
 	SWITCH_ADD_JSON_API(json_api_interface, "execute", "JSON session execute application", json_execute_function, "");
 	SWITCH_ADD_JSON_API(json_api_interface, "channelData", "JSON channel data application", json_channel_data_function, "");
+	SWITCH_ADD_JSON_API(json_api_interface, "originate_batch", "JSON paced batch originate", json_originate_batch_function, "");
 
 
 
@@ -7755,6 +8977,15 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add alias stickyadd");
 	switch_console_set_complete("add alias del");
 	switch_console_set_complete("add coalesce");
+	switch_console_set_complete("add codec_bench all");
+	switch_console_set_complete("add codec_offload status");
+	switch_console_set_complete("add inband_detect status");
+	switch_console_set_complete("add dtls_offload status");
+	switch_console_set_complete("add session_table stats");
+	switch_console_set_complete("add originate_batch status");
+	switch_console_set_complete("add originate_batch cancel");
+	switch_console_set_complete("add originate_batch workers");
+	switch_console_set_complete("add module_timing json");
 	switch_console_set_complete("add complete add");
 	switch_console_set_complete("add complete del");
 	switch_console_set_complete("add db_cache status");
@@ -7815,6 +9046,15 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add interface_ip ipv4 ::console::list_interfaces");
 	switch_console_set_complete("add interface_ip ipv6 ::console::list_interfaces");
 	switch_console_set_complete("add load ::console::list_available_modules");
+	switch_console_set_complete("add log_trace dump");
+	switch_console_set_complete("add log_trace decode");
+	switch_console_set_complete("add latency json");
+	switch_console_set_complete("add latency on");
+	switch_console_set_complete("add latency off");
+	switch_console_set_complete("add latency reset ::console::list_uuid");
+	switch_console_set_complete("add latency ::console::list_uuid json");
+	switch_console_set_complete("add latency ::console::list_uuid on");
+	switch_console_set_complete("add latency ::console::list_uuid off");
 	switch_console_set_complete("add nat_map reinit");
 	switch_console_set_complete("add nat_map republish");
 	switch_console_set_complete("add nat_map status");
@@ -7847,6 +9087,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add show timer");
 	switch_console_set_complete("add shutdown");
 	switch_console_set_complete("add sql_escape");
+	switch_console_set_complete("add srtp_bench all");
 	switch_console_set_complete("add unload ::console::list_loaded_modules");
 	switch_console_set_complete("add uptime ms");
 	switch_console_set_complete("add uptime s");
@@ -30,6 +30,78 @@
 
 #include <test/switch_test.h>
 
+static int batch_failed = -1;
+
+static void batch_complete_handler(switch_event_t *event)
+{
+	batch_failed = atoi(switch_event_get_header_nil(event, "Batch-Failed"));
+}
+
+#define PACED_CALLS 4
+
+/* when each call of the slow and the fast batch was attempted */
+typedef struct {
+	char id[SWITCH_UUID_FORMATTED_LENGTH + 1];
+	switch_time_t at[PACED_CALLS];
+	volatile switch_atomic_t results;
+} paced_batch_t;
+
+static paced_batch_t paced[2];
+
+static void paced_result_handler(switch_event_t *event)
+{
+	const char *id = switch_event_get_header_nil(event, "Batch-ID");
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		if (!strcmp(id, paced[i].id)) {
+			uint32_t n = switch_atomic_fetch_inc(&paced[i].results);
+
+			if (n < PACED_CALLS) {
+				paced[i].at[n] = atoll(switch_event_get_header_nil(event, "Event-Date-Timestamp"));
+			}
+		}
+	}
+}
+
+static switch_time_t paced_first(paced_batch_t *batch)
+{
+	switch_time_t min = batch->at[0];
+	int i;
+
+	for (i = 1; i < PACED_CALLS; i++) {
+		if (batch->at[i] < min) min = batch->at[i];
+	}
+
+	return min;
+}
+
+static switch_time_t paced_last(paced_batch_t *batch)
+{
+	switch_time_t max = batch->at[0];
+	int i;
+
+	for (i = 1; i < PACED_CALLS; i++) {
+		if (batch->at[i] > max) max = batch->at[i];
+	}
+
+	return max;
+}
+
+static void paced_submit(paced_batch_t *batch, const char *rate)
+{
+	switch_stream_handle_t stream = { 0 };
+	char cmd[512];
+
+	switch_snprintf(cmd, sizeof(cmd), "%s ^^:error/USER_BUSY:error/USER_BUSY:error/USER_BUSY:error/USER_BUSY &park()", rate);
+	SWITCH_STANDARD_STREAM(stream);
+	switch_api_execute("originate_batch", cmd, NULL, &stream);
+	if (!strncmp((char *) stream.data, "+OK ", 4)) {
+		switch_copy_string(batch->id, (char *) stream.data + 4, sizeof(batch->id));
+	}
+	switch_safe_free(stream.data);
+}
+
 FST_CORE_BEGIN("conf")
 {
 	FST_MODULE_BEGIN(mod_commands, mod_commands_test)
@@ -62,6 +134,69 @@ FST_CORE_BEGIN("conf")
 		}
 		FST_TEST_END()
 
+		FST_TEST_BEGIN(originate_batch_test)
+		{
+			switch_stream_handle_t stream = { 0 };
+			int x;
+
+			switch_event_bind("originate_batch_test", SWITCH_EVENT_CUSTOM, "originate_batch::complete", batch_complete_handler, NULL);
+
+			SWITCH_STANDARD_STREAM(stream);
+			switch_api_execute("originate_batch", "10 ^^:error/USER_BUSY:error/NO_ANSWER:error/CALL_REJECTED &park()", NULL, &stream);
+			fst_check(!strncmp(stream.data, "+OK ", 4));
+			fst_check(strstr(stream.data, " 3\n") != NULL);
+			switch_safe_free(stream.data);
+
+			for (x = 0; x < 50 && batch_failed < 0; x++) {
+				switch_yield(100000);
+			}
+
+			fst_check_int_equals(batch_failed, 3);
+
+			SWITCH_STANDARD_STREAM(stream);
+			switch_api_execute("originate_batch", "cancel 00000000-0000-0000-0000-000000000000", NULL, &stream);
+			fst_check_string_equals(stream.data, "-ERR No such batch\n");
+			switch_safe_free(stream.data);
+
+			switch_event_unbind_callback(batch_complete_handler);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(originate_batch_pacing_test)
+		{
+			switch_time_t first, last;
+			int x;
+
+			memset(paced, 0, sizeof(paced));
+			switch_event_bind("originate_batch_pacing_test", SWITCH_EVENT_CUSTOM, "originate_batch::result", paced_result_handler, NULL);
+
+			/* both dial the same endpoint, the second one must not change the pace the first one set */
+			paced_submit(&paced[0], "5/1");
+			paced_submit(&paced[1], "100/1");
+			fst_requires(!zstr(paced[0].id) && !zstr(paced[1].id));
+
+			for (x = 0; x < 50 && (switch_atomic_read(&paced[0].results) < PACED_CALLS || switch_atomic_read(&paced[1].results) < PACED_CALLS); x++) {
+				switch_yield(100000);
+			}
+
+			switch_event_unbind_callback(paced_result_handler);
+
+			fst_requires(switch_atomic_read(&paced[0].results) == PACED_CALLS);
+			fst_requires(switch_atomic_read(&paced[1].results) == PACED_CALLS);
+
+			first = paced_first(&paced[0]) < paced_first(&paced[1]) ? paced_first(&paced[0]) : paced_first(&paced[1]);
+			last = paced_last(&paced[0]) > paced_last(&paced[1]) ? paced_last(&paced[0]) : paced_last(&paced[1]);
+
+			/* all calls together at 5 cps with a burst of 1 is 200ms between calls, leave some slack for the scheduler */
+			fst_check(last - first >= (2 * PACED_CALLS - 1) * 150000);
+
+			/* and they take turns, neither batch gets through before the other one started */
+			fst_check(paced_first(&paced[1]) < paced_last(&paced[0]));
+			fst_check(paced_first(&paced[0]) < paced_last(&paced[1]));
+			fst_check(paced_last(&paced[1]) - paced_first(&paced[1]) >= (PACED_CALLS - 1) * 2 * 150000);
+		}
+		FST_TEST_END()
+
 		FST_TEARDOWN_BEGIN()
 		{
 		}
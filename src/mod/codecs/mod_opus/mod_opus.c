@@ -39,8 +39,17 @@
 
 #define SWITCH_OPUS_MIN_FEC_BITRATE 12400
 
+#define SWITCH_OPUS_MAX_COMPLEXITY 10
+/* seconds between two looks at the idle cpu when adapting the complexity */
+#define SWITCH_OPUS_COMPLEXITY_INTERVAL 5
+/* idle cpu percentage above the threshold needed before complexity is raised again */
+#define SWITCH_OPUS_COMPLEXITY_HYSTERESIS 10
+/* frames coded before a context folds its cpu time into the module totals */
+#define SWITCH_OPUS_ACCOUNTING_FRAMES 250
+
 SWITCH_MODULE_LOAD_FUNCTION(mod_opus_load);
-SWITCH_MODULE_DEFINITION(mod_opus, mod_opus_load, NULL, NULL);
+SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_opus_shutdown);
+SWITCH_MODULE_DEFINITION(mod_opus, mod_opus_load, mod_opus_shutdown, NULL);
 
 /*! \brief Various codec settings */
 struct opus_codec_settings {
@@ -119,6 +128,20 @@ struct enc_stats {
 };
 typedef struct enc_stats enc_stats_t;
 
+/* cpu time spent inside libopus by one codec instance */
+struct cpu_stats {
+	uint64_t encode_usec;
+	uint64_t decode_usec;
+	uint32_t encode_frames;
+	uint32_t decode_frames;
+	/* the part not yet added to the module totals */
+	uint64_t pending_encode_usec;
+	uint64_t pending_decode_usec;
+	uint32_t pending_encode_frames;
+	uint32_t pending_decode_frames;
+};
+typedef struct cpu_stats cpu_stats_t;
+
 struct codec_control_state {
 	int keep_fec;
 	opus_int32 current_bitrate;
@@ -142,6 +165,11 @@ struct opus_context {
 	dec_stats_t decoder_stats;
 	enc_stats_t encoder_stats;
 	codec_control_state_t control_state;
+	cpu_stats_t cpu_stats;
+	int complexity;
+	int enc_channels;
+	int dec_channels;
+	char cpu_usage_str[128];
 };
 
 struct {
@@ -161,12 +189,172 @@ struct {
 	uint32_t use_jb_lookahead;
 	switch_mutex_t *mutex;
 	int mono;
+	int adaptive_complexity;
+	int complexity_min;
+	int complexity_idle_threshold;
+	int pool_max_idle;
 } opus_prefs;
 
+/* idle coder states, one list per channel count, reinitialized instead of reallocated */
+typedef struct {
+	void **idle;
+	int count;
+	uint64_t hits;
+	uint64_t misses;
+} opus_state_pool_t;
+
 static struct {
 	int debug;
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	opus_state_pool_t encoders[2];
+	opus_state_pool_t decoders[2];
+	int complexity;
+	switch_time_t complexity_checked;
+	uint64_t complexity_changes;
+	uint64_t encode_usec;
+	uint64_t decode_usec;
+	uint64_t encode_frames;
+	uint64_t decode_frames;
 } globals;
 
+static void *opus_state_pool_get(opus_state_pool_t *state_pool, int size)
+{
+	void *state = NULL;
+
+	switch_mutex_lock(globals.mutex);
+	if (state_pool->count) {
+		state = state_pool->idle[--state_pool->count];
+		state_pool->hits++;
+	} else {
+		state_pool->misses++;
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	if (!state) {
+		state = malloc(size);
+	}
+
+	return state;
+}
+
+static void opus_state_pool_put(opus_state_pool_t *state_pool, void *state)
+{
+	switch_mutex_lock(globals.mutex);
+	if (state_pool->count < opus_prefs.pool_max_idle) {
+		state_pool->idle[state_pool->count++] = state;
+		state = NULL;
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	switch_safe_free(state);
+}
+
+static void opus_state_pool_drain(opus_state_pool_t *state_pool)
+{
+	switch_mutex_lock(globals.mutex);
+	while (state_pool->count) {
+		free(state_pool->idle[--state_pool->count]);
+	}
+	switch_mutex_unlock(globals.mutex);
+}
+
+static OpusEncoder *switch_opus_encoder_get(opus_int32 samplerate, int channels, int application, int *err)
+{
+	OpusEncoder *encoder_object;
+
+	if (channels < 1 || channels > 2) {
+		*err = OPUS_BAD_ARG;
+		return NULL;
+	}
+
+	if (!(encoder_object = opus_state_pool_get(&globals.encoders[channels - 1], opus_encoder_get_size(channels)))) {
+		*err = OPUS_ALLOC_FAIL;
+		return NULL;
+	}
+
+	/* a full init restores every encoder ctl to its default, just like opus_encoder_create() */
+	if ((*err = opus_encoder_init(encoder_object, samplerate, channels, application)) != OPUS_OK) {
+		free(encoder_object);
+		return NULL;
+	}
+
+	return encoder_object;
+}
+
+static OpusDecoder *switch_opus_decoder_get(opus_int32 samplerate, int channels, int *err)
+{
+	OpusDecoder *decoder_object;
+
+	if (channels < 1 || channels > 2) {
+		*err = OPUS_BAD_ARG;
+		return NULL;
+	}
+
+	if (!(decoder_object = opus_state_pool_get(&globals.decoders[channels - 1], opus_decoder_get_size(channels)))) {
+		*err = OPUS_ALLOC_FAIL;
+		return NULL;
+	}
+
+	if ((*err = opus_decoder_init(decoder_object, samplerate, channels)) != OPUS_OK) {
+		free(decoder_object);
+		return NULL;
+	}
+
+	return decoder_object;
+}
+
+/* lowers the complexity of every encoder while the box is short on idle cpu, and raises it back afterwards */
+static int switch_opus_adaptive_complexity(void)
+{
+	switch_time_t now = switch_epoch_time_now(NULL);
+
+	if (now - globals.complexity_checked >= SWITCH_OPUS_COMPLEXITY_INTERVAL && switch_mutex_trylock(globals.mutex) == SWITCH_STATUS_SUCCESS) {
+		if (now - globals.complexity_checked >= SWITCH_OPUS_COMPLEXITY_INTERVAL) {
+			double idle = switch_core_idle_cpu();
+			int max = opus_prefs.complexity ? opus_prefs.complexity : SWITCH_OPUS_MAX_COMPLEXITY;
+			int complexity = globals.complexity;
+
+			if (idle < opus_prefs.complexity_idle_threshold && complexity > opus_prefs.complexity_min) {
+				complexity--;
+			} else if (idle > opus_prefs.complexity_idle_threshold + SWITCH_OPUS_COMPLEXITY_HYSTERESIS && complexity < max) {
+				complexity++;
+			}
+
+			if (complexity != globals.complexity) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Opus encoder: idle cpu %.2f%%, changing complexity from %d to %d\n",
+								  idle, globals.complexity, complexity);
+				globals.complexity = complexity;
+				globals.complexity_changes++;
+			}
+
+			globals.complexity_checked = now;
+		}
+		switch_mutex_unlock(globals.mutex);
+	}
+
+	return globals.complexity;
+}
+
+static void switch_opus_account(struct opus_context *context, switch_bool_t force)
+{
+	cpu_stats_t *stats = &context->cpu_stats;
+
+	if (!force && stats->pending_encode_frames + stats->pending_decode_frames < SWITCH_OPUS_ACCOUNTING_FRAMES) {
+		return;
+	}
+
+	switch_mutex_lock(globals.mutex);
+	globals.encode_usec += stats->pending_encode_usec;
+	globals.decode_usec += stats->pending_decode_usec;
+	globals.encode_frames += stats->pending_encode_frames;
+	globals.decode_frames += stats->pending_decode_frames;
+	switch_mutex_unlock(globals.mutex);
+
+	stats->pending_encode_usec = stats->pending_decode_usec = 0;
+	stats->pending_encode_frames = stats->pending_decode_frames = 0;
+}
+
 static switch_bool_t switch_opus_acceptable_rate(int rate)
 {
 	if (rate != 8000 && rate != 12000 && rate != 16000 && rate != 24000 && rate != 48000) {
@@ -599,9 +787,10 @@ static switch_status_t switch_opus_init(switch_codec_t *codec, switch_codec_flag
 			}
 		}
 
-		context->encoder_object = opus_encoder_create(enc_samplerate,
-													  codec->implementation->number_of_channels,
-													  codec->implementation->number_of_channels == 1 ? OPUS_APPLICATION_VOIP : OPUS_APPLICATION_AUDIO, &err);
+		context->encoder_object = switch_opus_encoder_get(enc_samplerate,
+														  codec->implementation->number_of_channels,
+														  codec->implementation->number_of_channels == 1 ? OPUS_APPLICATION_VOIP : OPUS_APPLICATION_AUDIO, &err);
+		context->enc_channels = codec->implementation->number_of_channels;
 
 		if (err != OPUS_OK) {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot create encoder: %s\n", opus_strerror(err));
@@ -638,10 +827,16 @@ static switch_status_t switch_opus_init(switch_codec_t *codec, switch_codec_flag
 			opus_encoder_ctl(context->encoder_object, OPUS_SET_VBR(0));
 		}
 
+		if (opus_prefs.adaptive_complexity) {
+			complexity = switch_opus_adaptive_complexity();
+		}
+
 		if (complexity) {
 			opus_encoder_ctl(context->encoder_object, OPUS_SET_COMPLEXITY(complexity));
 		}
 
+		context->complexity = complexity;
+
 		if (plpct) {
 			opus_encoder_ctl(context->encoder_object, OPUS_SET_PACKET_LOSS_PERC(plpct));
 		}
@@ -692,7 +887,8 @@ static switch_status_t switch_opus_init(switch_codec_t *codec, switch_codec_flag
 			}
 		}
 
-		context->decoder_object = opus_decoder_create(dec_samplerate, (!context->codec_settings.sprop_stereo ? codec->implementation->number_of_channels : 2), &err);
+		context->dec_channels = !context->codec_settings.sprop_stereo ? codec->implementation->number_of_channels : 2;
+		context->decoder_object = switch_opus_decoder_get(dec_samplerate, context->dec_channels, &err);
 
 		switch_set_flag(codec, SWITCH_CODEC_FLAG_HAS_PLC);
 
@@ -700,7 +896,7 @@ static switch_status_t switch_opus_init(switch_codec_t *codec, switch_codec_flag
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot create decoder: %s\n", opus_strerror(err));
 
 			if (context->encoder_object) {
-				opus_encoder_destroy(context->encoder_object);
+				opus_state_pool_put(&globals.encoders[context->enc_channels - 1], context->encoder_object);
 				context->encoder_object = NULL;
 			}
 
@@ -719,13 +915,15 @@ static switch_status_t switch_opus_destroy(switch_codec_t *codec)
 	struct opus_context *context = codec->private_info;
 
 	if (context) {
+		switch_opus_account(context, SWITCH_TRUE);
+
 		if (context->decoder_object) {
 			switch_core_session_t *session = codec->session;
 			if (session) {
 				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG,"Opus decoder stats: Frames[%d] PLC[%d] FEC[%d]\n",
 										context->decoder_stats.frame_counter, context->decoder_stats.plc_counter-context->decoder_stats.fec_counter, context->decoder_stats.fec_counter);
 			}
-			opus_decoder_destroy(context->decoder_object);
+			opus_state_pool_put(&globals.decoders[context->dec_channels - 1], context->decoder_object);
 			context->decoder_object = NULL;
 		}
 		if (context->encoder_object) {
@@ -746,7 +944,7 @@ static switch_status_t switch_opus_destroy(switch_codec_t *codec)
 							"Opus encoder stats: FEC frames (only for debug mode) [%d]\n", context->encoder_stats.fec_counter);
 				}
 			}
-			opus_encoder_destroy(context->encoder_object);
+			opus_state_pool_put(&globals.encoders[context->enc_channels - 1], context->encoder_object);
 			context->encoder_object = NULL;
 		}
 	}
@@ -765,12 +963,30 @@ static switch_status_t switch_opus_encode(switch_codec_t *codec,
 	struct opus_context *context = codec->private_info;
 	int bytes = 0;
 	int len = (int) *encoded_data_len;
+	switch_time_t started, elapsed;
 
 	if (!context) {
 		return SWITCH_STATUS_FALSE;
 	}
 
+	if (opus_prefs.adaptive_complexity) {
+		int complexity = switch_opus_adaptive_complexity();
+
+		if (complexity != context->complexity) {
+			opus_encoder_ctl(context->encoder_object, OPUS_SET_COMPLEXITY(complexity));
+			context->complexity = complexity;
+		}
+	}
+
+	started = switch_time_ref();
 	bytes = opus_encode(context->encoder_object, (void *) decoded_data, context->enc_frame_size, (unsigned char *) encoded_data, len);
+	elapsed = switch_time_ref() - started;
+
+	context->cpu_stats.encode_usec += elapsed;
+	context->cpu_stats.encode_frames++;
+	context->cpu_stats.pending_encode_usec += elapsed;
+	context->cpu_stats.pending_encode_frames++;
+	switch_opus_account(context, SWITCH_FALSE);
 
 	if (globals.debug || context->debug > 1) {
 		int samplerate = context->enc_frame_size * 1000 / (codec->implementation->microseconds_per_packet / 1000);
@@ -817,6 +1033,7 @@ static switch_status_t switch_opus_decode(switch_codec_t *codec,
 	int fec = 0, plc = 0;
 	int32_t frame_size = 0, last_frame_size = 0;
 	uint32_t frame_samples;
+	switch_time_t started, elapsed;
 
 	if (!context) {
 		return SWITCH_STATUS_FALSE;
@@ -915,7 +1132,15 @@ static switch_status_t switch_opus_decode(switch_codec_t *codec,
 	/* a frame for which we decode FEC will be counted twice */
 	context->decoder_stats.frame_counter++;
 
+	started = switch_time_ref();
 	samples = opus_decode(context->decoder_object, encoded_data, encoded_data_len, decoded_data, frame_size, fec);
+	elapsed = switch_time_ref() - started;
+
+	context->cpu_stats.decode_usec += elapsed;
+	context->cpu_stats.decode_frames++;
+	context->cpu_stats.pending_decode_usec += elapsed;
+	context->cpu_stats.pending_decode_frames++;
+	switch_opus_account(context, SWITCH_FALSE);
 
 	if (samples < 0) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Decoder Error: %s fs:%u plc:%s!\n",
@@ -1045,6 +1270,9 @@ static switch_status_t opus_load_config(switch_bool_t reload)
 	opus_prefs.plpct = 20;
 	opus_prefs.use_vbr = 0;
 	opus_prefs.fec_decode = 1;
+	opus_prefs.complexity_min = 2;
+	opus_prefs.complexity_idle_threshold = 20;
+	opus_prefs.pool_max_idle = 256;
 
 	if ((settings = switch_xml_child(cfg, "settings"))) {
 		for (param = switch_xml_child(settings, "param"); param; param = param->next) {
@@ -1088,6 +1316,20 @@ static switch_status_t opus_load_config(switch_bool_t reload)
 				}
 			} else if (!strcasecmp(key, "mono")) {
 				opus_prefs.mono = atoi(val);
+			} else if (!strcasecmp(key, "adaptive-complexity")) {
+				opus_prefs.adaptive_complexity = switch_true(val);
+			} else if (!strcasecmp(key, "adaptive-complexity-min")) {
+				opus_prefs.complexity_min = atoi(val);
+				if (opus_prefs.complexity_min < 0 || opus_prefs.complexity_min > SWITCH_OPUS_MAX_COMPLEXITY) {
+					opus_prefs.complexity_min = 2;
+				}
+			} else if (!strcasecmp(key, "adaptive-complexity-idle-cpu")) {
+				opus_prefs.complexity_idle_threshold = atoi(val);
+			} else if (!strcasecmp(key, "pool-max-idle")) {
+				opus_prefs.pool_max_idle = atoi(val);
+				if (opus_prefs.pool_max_idle < 0) {
+					opus_prefs.pool_max_idle = 0;
+				}
 			}
 		}
 	}
@@ -1185,6 +1427,13 @@ static switch_status_t switch_opus_control(switch_codec_t *codec,
 						context->use_jb_lookahead = switch_true(arg);
 					}
 					reply = context->use_jb_lookahead ? "LOOKAHEAD ON" : "LOOKAHEAD OFF";
+				} else if (!strcasecmp(command, "cpu_usage")) {
+					cpu_stats_t *stats = &context->cpu_stats;
+
+					switch_snprintf(context->cpu_usage_str, sizeof(context->cpu_usage_str),
+									"encode_frames=%u encode_usec=%" SWITCH_UINT64_T_FMT " decode_frames=%u decode_usec=%" SWITCH_UINT64_T_FMT " complexity=%d",
+									stats->encode_frames, stats->encode_usec, stats->decode_frames, stats->decode_usec, context->complexity);
+					reply = context->cpu_usage_str;
 				}
 			}
 
@@ -1335,11 +1584,40 @@ SWITCH_STANDARD_API(mod_opus_debug)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_STANDARD_API(mod_opus_stats)
+{
+	int i;
+
+	switch_mutex_lock(globals.mutex);
+
+	stream->write_function(stream, "idle-cpu: %.2f\n", switch_core_idle_cpu());
+	stream->write_function(stream, "adaptive-complexity: %s\n", opus_prefs.adaptive_complexity ? "on" : "off");
+	stream->write_function(stream, "complexity: %d\n", opus_prefs.adaptive_complexity ? globals.complexity : opus_prefs.complexity);
+	stream->write_function(stream, "complexity-changes: %" SWITCH_UINT64_T_FMT "\n", globals.complexity_changes);
+
+	for (i = 0; i < 2; i++) {
+		stream->write_function(stream, "encoder-pool-%s: idle=%d hits=%" SWITCH_UINT64_T_FMT " misses=%" SWITCH_UINT64_T_FMT "\n",
+							   i ? "stereo" : "mono", globals.encoders[i].count, globals.encoders[i].hits, globals.encoders[i].misses);
+		stream->write_function(stream, "decoder-pool-%s: idle=%d hits=%" SWITCH_UINT64_T_FMT " misses=%" SWITCH_UINT64_T_FMT "\n",
+							   i ? "stereo" : "mono", globals.decoders[i].count, globals.decoders[i].hits, globals.decoders[i].misses);
+	}
+
+	stream->write_function(stream, "encode-frames: %" SWITCH_UINT64_T_FMT "\n", globals.encode_frames);
+	stream->write_function(stream, "encode-avg-usec: %.2f\n", globals.encode_frames ? (double) globals.encode_usec / globals.encode_frames : 0.0);
+	stream->write_function(stream, "decode-frames: %" SWITCH_UINT64_T_FMT "\n", globals.decode_frames);
+	stream->write_function(stream, "decode-avg-usec: %.2f\n", globals.decode_frames ? (double) globals.decode_usec / globals.decode_frames : 0.0);
+
+	switch_mutex_unlock(globals.mutex);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 
 SWITCH_MODULE_LOAD_FUNCTION(mod_opus_load)
 {
 	switch_codec_interface_t *codec_interface;
 	switch_api_interface_t *commands_api_interface;
+	int i;
 	int samples = 480;
 	int bytes = 960;
 	int mss = 10000;
@@ -1354,11 +1632,22 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_opus_load)
 		return status;
 	}
 
+	memset(&globals, 0, sizeof(globals));
+	globals.pool = pool;
+	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, pool);
+	globals.complexity = opus_prefs.complexity ? opus_prefs.complexity : SWITCH_OPUS_MAX_COMPLEXITY;
+
+	for (i = 0; i < 2; i++) {
+		globals.encoders[i].idle = switch_core_alloc(pool, sizeof(void *) * (opus_prefs.pool_max_idle + 1));
+		globals.decoders[i].idle = switch_core_alloc(pool, sizeof(void *) * (opus_prefs.pool_max_idle + 1));
+	}
+
 	/* connect my internal structure to the blank pointer passed to me */
 	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
 
 	SWITCH_ADD_CODEC(codec_interface, "OPUS (STANDARD)");
 	SWITCH_ADD_API(commands_api_interface, "opus_debug", "Set OPUS Debug", mod_opus_debug, OPUS_DEBUG_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "opus_stats", "Show OPUS pool and cpu usage", mod_opus_stats, "");
 
 	switch_console_set_complete("add opus_debug on");
 	switch_console_set_complete("add opus_debug off");
@@ -1668,6 +1957,18 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_opus_load)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_opus_shutdown)
+{
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		opus_state_pool_drain(&globals.encoders[i]);
+		opus_state_pool_drain(&globals.decoders[i]);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 
 /* For Emacs:
  * Local Variables:
@@ -56,6 +56,13 @@ SWITCH_MODULE_DEFINITION(mod_verto, mod_verto_load, mod_verto_shutdown, mod_vert
 #endif
 #include <ctype.h>
 #include <sys/stat.h>
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+#ifdef VERTO_HAVE_EPOLL
+#include <sys/epoll.h>
+#include <fcntl.h>
+#endif
 
 #ifdef WIN32
 #define strerror_r(errno, buf, len) strerror_s(buf, len, errno)
@@ -478,6 +485,7 @@ static void del_jsock(jsock_t *jsock)
 				jsock->profile->jsock_head = p->next;
 			}
 			jsock->profile->jsock_count--;
+			switch_core_metric_dec(verto_globals.connections);
 			break;
 		}
 
@@ -496,6 +504,8 @@ static void add_jsock(jsock_t *jsock)
 	jsock->profile->jsock_count++;
 	switch_mutex_unlock(jsock->profile->mutex);
 
+	switch_core_metric_inc(verto_globals.connections);
+
 }
 
 static uint32_t next_id(void)
@@ -580,6 +590,177 @@ static void jrpc_add_result(cJSON *obj, cJSON *result)
 	}
 }
 
+static char *jsock_json_text(jsock_t *jsock, cJSON *json)
+{
+	if (!zstr(jsock->uuid_str)) {
+		cJSON *result = cJSON_GetObjectItem(json, "result");
+
+		if (result) {
+			cJSON_AddItemToObject(result, "sessid", cJSON_CreateString(jsock->uuid_str));
+		}
+	}
+
+	return cJSON_PrintUnformatted(json);
+}
+
+/* Write a server to client websocket frame header for len bytes of payload, returns the header length */
+static switch_size_t verto_frame_header(uint8_t *hdr, kws_opcode_t oc, switch_size_t len)
+{
+	hdr[0] = (uint8_t) (0x80 | oc);
+
+	if (len < 126) {
+		hdr[1] = (uint8_t) len;
+		return 2;
+	} else if (len <= 0xffff) {
+		hdr[1] = 126;
+		hdr[2] = (uint8_t) (len >> 8);
+		hdr[3] = (uint8_t) len;
+		return 4;
+	} else {
+		int i;
+
+		hdr[1] = 127;
+		for (i = 0; i < 8; i++) {
+			hdr[2 + i] = (uint8_t) ((uint64_t) len >> (8 * (7 - i)));
+		}
+		return 10;
+	}
+}
+
+#ifdef VERTO_HAVE_EPOLL
+static int jsock_reactor_arm(jsock_t *jsock, int op);
+
+/* Send what the socket takes now and park the rest until it is writable again, call with the write_mutex held */
+static switch_ssize_t jsock_reactor_send(jsock_t *jsock, struct iovec *iov, int iovcnt)
+{
+	switch_size_t total = 0, left;
+	int i;
+
+	/* the connection is already closed */
+	if (!jsock->wpending) {
+		return -1;
+	}
+
+	for (i = 0; i < iovcnt; i++) {
+		total += iov[i].iov_len;
+	}
+
+	left = total;
+
+	/* nothing may overtake what is already waiting */
+	while (left && !switch_buffer_inuse(jsock->wpending)) {
+		ssize_t w = writev(jsock->client_socket, iov, iovcnt);
+
+		if (w < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			return -1;
+		}
+
+		left -= w;
+
+		while (w > 0 && iovcnt) {
+			if ((switch_size_t) w >= iov->iov_len) {
+				w -= iov->iov_len;
+				iov++;
+				iovcnt--;
+			} else {
+				iov->iov_base = (char *) iov->iov_base + w;
+				iov->iov_len -= w;
+				w = 0;
+			}
+		}
+	}
+
+	if (!left) {
+		return (switch_ssize_t) total;
+	}
+
+	if (switch_buffer_inuse(jsock->wpending) + left > VERTO_MAX_PENDING) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s Client is not reading, %" SWITCH_SIZE_T_FMT " bytes waiting\n",
+						  jsock->name, switch_buffer_inuse(jsock->wpending) + left);
+		return -1;
+	}
+
+	for (i = 0; i < iovcnt; i++) {
+		if (iov[i].iov_len && !switch_buffer_write(jsock->wpending, iov[i].iov_base, iov[i].iov_len)) {
+			return -1;
+		}
+	}
+
+	if (jsock_reactor_arm(jsock, EPOLL_CTL_MOD) < 0 && errno != ENOENT) {
+		return -1;
+	}
+
+	return (switch_ssize_t) total;
+}
+
+/* Write out what jsock_reactor_send had to park, call with the write_mutex held */
+static switch_status_t jsock_reactor_flush(jsock_t *jsock)
+{
+	const void *ptr;
+	switch_size_t len;
+
+	if (!jsock->wpending) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	while ((len = switch_buffer_peek_zerocopy(jsock->wpending, &ptr))) {
+		ssize_t w = write(jsock->client_socket, ptr, len);
+
+		if (w < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				if (jsock_reactor_arm(jsock, EPOLL_CTL_MOD) < 0 && errno != ENOENT) {
+					return SWITCH_STATUS_FALSE;
+				}
+				break;
+			}
+			return SWITCH_STATUS_FALSE;
+		}
+
+		switch_buffer_toss(jsock->wpending, w);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+#endif
+
+/* Send one frame, reactor connections on a plain socket never wait for the client to read it */
+static switch_ssize_t jsock_write_frame(jsock_t *jsock, kws_opcode_t oc, const void *data, switch_size_t len)
+{
+	switch_ssize_t r;
+
+	switch_mutex_lock(jsock->write_mutex);
+#ifdef VERTO_HAVE_EPOLL
+	if (jsock->reactor && !(jsock->ptype & PTYPE_CLIENT_SSL)) {
+		uint8_t hdr[10];
+		struct iovec iov[2];
+
+		iov[0].iov_base = hdr;
+		iov[0].iov_len = verto_frame_header(hdr, oc, len);
+		iov[1].iov_base = (void *) data;
+		iov[1].iov_len = len;
+
+		if ((r = jsock_reactor_send(jsock, iov, 2)) > 0) {
+			r = (switch_ssize_t) len;
+		}
+	} else
+#endif
+	{
+		r = kws_write_frame(jsock->ws, oc, data, len);
+	}
+	switch_mutex_unlock(jsock->write_mutex);
+
+	return r;
+}
+
 static switch_ssize_t ws_write_json(jsock_t *jsock, cJSON **json, switch_bool_t destroy)
 {
 	char *json_text;
@@ -592,23 +773,13 @@ static switch_ssize_t ws_write_json(jsock_t *jsock, cJSON **json, switch_bool_t
 		return r;
 	}
 
-	if (!zstr(jsock->uuid_str)) {
-		cJSON *result = cJSON_GetObjectItem(*json, "result");
-
-		if (result) {
-			cJSON_AddItemToObject(result, "sessid", cJSON_CreateString(jsock->uuid_str));
-		}
-	}
-
-	if ((json_text = cJSON_PrintUnformatted(*json))) {
+	if ((json_text = jsock_json_text(jsock, *json))) {
 		if (jsock->profile->debug || verto_globals.debug) {
 			//char *log_text = cJSON_Prin(*json);
 			switch_log_printf(SWITCH_CHANNEL_LOG, verto_globals.debug_level, "WRITE %s [%s]\n", jsock->name, json_text);
 			//free(log_text);
 		}
-		switch_mutex_lock(jsock->write_mutex);
-		r = kws_write_frame(jsock->ws, WSOC_TEXT, json_text, strlen(json_text));
-		switch_mutex_unlock(jsock->write_mutex);
+		r = jsock_write_frame(jsock, WSOC_TEXT, json_text, strlen(json_text));
 		switch_safe_free(json_text);
 	}
 
@@ -626,19 +797,69 @@ static switch_ssize_t ws_write_json(jsock_t *jsock, cJSON **json, switch_bool_t
 	return r;
 }
 
-static switch_status_t jsock_queue_event(jsock_t *jsock, cJSON **json, switch_bool_t destroy)
+/* Build the server to client websocket text frame header for msg->len bytes of payload */
+static void verto_msg_frame(verto_msg_t *msg)
 {
-	switch_status_t status = SWITCH_STATUS_FALSE;
-	cJSON *jp;
+	msg->hlen = verto_frame_header(msg->hdr, WSOC_TEXT, msg->len);
+}
 
-	if (destroy) {
-		jp = *json;
-	} else {
-		jp = cJSON_Duplicate(*json, 1);
+/* Frame json text as a server to client websocket text frame */
+static verto_msg_t *verto_msg_new(const char *text)
+{
+	switch_size_t len = strlen(text);
+	verto_msg_t *msg;
+
+	switch_zmalloc(msg, sizeof(*msg) + len);
+	msg->len = len;
+	msg->split = len;
+	memcpy(msg->data, text, len);
+	verto_msg_frame(msg);
+
+	return msg;
+}
+
+/* Frame a shared event channel payload between a per connection prefix and suffix, the text itself is not copied */
+static verto_msg_t *verto_msg_new_shared(const char *prefix, switch_event_channel_payload_t *payload, const char *shared, switch_size_t shared_len,
+										 const char *suffix)
+{
+	switch_size_t plen = strlen(prefix), slen = strlen(suffix);
+	verto_msg_t *msg;
+
+	switch_zmalloc(msg, sizeof(*msg) + plen + slen);
+	memcpy(msg->data, prefix, plen);
+	memcpy(msg->data + plen, suffix, slen);
+	msg->split = plen;
+	msg->payload = switch_event_channel_payload_ref(payload);
+	msg->shared = shared;
+	msg->shared_len = shared_len;
+	msg->len = plen + shared_len + slen;
+	verto_msg_frame(msg);
+
+	return msg;
+}
+
+static void verto_msg_free(verto_msg_t **msgP)
+{
+	verto_msg_t *msg = *msgP;
+
+	*msgP = NULL;
+
+	if (msg) {
+		switch_event_channel_payload_release(&msg->payload);
+		free(msg);
 	}
+}
+
+static void jsock_schedule(jsock_t *jsock, uint32_t want);
+
+static switch_status_t jsock_queue_msg(jsock_t *jsock, verto_msg_t *msg)
+{
+	switch_status_t status = SWITCH_STATUS_FALSE;
 
-	if (switch_queue_trypush(jsock->event_queue, jp) == SWITCH_STATUS_SUCCESS) {
+	if (msg && switch_queue_trypush(jsock->event_queue, msg) == SWITCH_STATUS_SUCCESS) {
 		status = SWITCH_STATUS_SUCCESS;
+		switch_core_metric_add(verto_globals.queued_bytes, (int64_t) (msg->hlen + msg->len));
+		jsock_schedule(jsock, VERTO_WANT_FLUSH);
 
 		if (jsock->lost_events) {
 			int le = jsock->lost_events;
@@ -650,26 +871,83 @@ static switch_status_t jsock_queue_event(jsock_t *jsock, cJSON **json, switch_bo
 			jsock->drop++;
 		}
 
-		if (!destroy) {
-			cJSON_Delete(jp);
-			jp = NULL;
-		}
+		verto_msg_free(&msg);
+	}
+
+	return status;
+}
+
+static switch_status_t jsock_queue_event(jsock_t *jsock, cJSON **json, switch_bool_t destroy)
+{
+	switch_status_t status;
+	verto_msg_t *msg = NULL;
+	cJSON *jp = *json;
+	char *json_text;
+
+	/* the sessid goes into results, don't touch a message we don't own */
+	if (!destroy && cJSON_GetObjectItem(jp, "result")) {
+		jp = cJSON_Duplicate(jp, 1);
+	}
+
+	if ((json_text = jsock_json_text(jsock, jp))) {
+		msg = verto_msg_new(json_text);
+		free(json_text);
+	}
+
+	if (jp != *json) {
+		cJSON_Delete(jp);
 	}
 
+	status = jsock_queue_msg(jsock, msg);
+
 	if (destroy) {
+		cJSON_Delete(*json);
 		*json = NULL;
 	}
 
 	return status;
 }
 
+/* Queue a verto.event built around the shared payload text: our own envelope, the first len bytes of the text, then suffix */
+static switch_status_t jsock_queue_payload(jsock_t *jsock, switch_event_channel_payload_t *payload, const char *text, switch_size_t len, const char *suffix)
+{
+	char prefix[128];
+
+	switch_snprintf(prefix, sizeof(prefix), "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"verto.event\",\"params\":", next_id());
+
+	return jsock_queue_msg(jsock, verto_msg_new_shared(prefix, payload, text, len, suffix));
+}
+
+/* The payload text as a non-empty object we can splice more members onto, or NULL */
+static const char *payload_object_text(switch_event_channel_payload_t *payload, switch_size_t *len)
+{
+	const char *text;
+
+	if (payload && (text = switch_event_channel_payload_text(payload, len)) && *len > 2 && text[0] == '{' && text[*len - 1] == '}') {
+		return text;
+	}
+
+	return NULL;
+}
+
 static switch_bool_t event_channel_check_auth(jsock_t *jsock, const char *event_channel);
-static void write_event(const char *event_channel, const char *super_channel, jsock_t *use_jsock, cJSON *event)
+static void write_event(const char *event_channel, const char *super_channel, jsock_t *use_jsock, cJSON *event,
+						switch_event_channel_payload_t *payload)
 {
 	jsock_sub_node_head_t *head;
 
 	if ((head = switch_core_hash_find(verto_globals.event_channel_hash, event_channel))) {
 		jsock_sub_node_t *np;
+		switch_size_t len = 0;
+		const char *text = payload_object_text(payload, &len);
+		char *channel_text = NULL;
+
+		/* every subscriber gets the same params plus its own serno, serialize them once and splice */
+		if (text) {
+			cJSON *jchannel = cJSON_CreateString(head->event_channel);
+			channel_text = cJSON_PrintUnformatted(jchannel);
+			cJSON_Delete(jchannel);
+		}
 
 		for(np = head->node; np; np = np->next) {
 			cJSON *msg = NULL, *params;
@@ -704,7 +982,15 @@ static void write_event(const char *event_channel, const char *super_channel, js
 				//tmp = cJSON_Print(event);
 				//printf("%s\n", tmp);
 				//free(tmp);
-				
+
+				if (channel_text) {
+					char *suffix = switch_mprintf(",\"eventSerno\":%u,\"subscribedChannel\":%s}}", np->serno++, channel_text);
+
+					jsock_queue_payload(np->jsock, payload, text, len - 1, suffix);
+					free(suffix);
+					continue;
+				}
+
 				params = cJSON_Duplicate(event, 1);
 				cJSON_AddItemToObject(params, "eventSerno", cJSON_CreateNumber(np->serno++));
 				cJSON_AddItemToObject(params, "subscribedChannel", cJSON_CreateString(head->event_channel));
@@ -713,10 +999,12 @@ static void write_event(const char *event_channel, const char *super_channel, js
 				jsock_queue_event(np->jsock, &msg, SWITCH_TRUE);
 			}
 		}
+
+		switch_safe_free(channel_text);
 	}
 }
 
-static void jsock_send_event(cJSON *event)
+static void jsock_send_event(cJSON *event, switch_event_channel_payload_t *payload)
 {
 
 	const char *event_channel, *session_uuid = NULL, *direct_id = NULL;
@@ -749,24 +1037,31 @@ static void jsock_send_event(cJSON *event)
 	}
 
 	if (use_jsock || (use_jsock = get_jsock(direct_id))) { /* implicit subscription to channel identical to the connection uuid or session uuid */
-		cJSON *msg = NULL, *params;
-		params = cJSON_Duplicate(event, 1);
-		msg = jrpc_new_req("verto.event", NULL, &params);
-		jsock_queue_event(use_jsock, &msg, SWITCH_TRUE);
+		const char *text;
+		switch_size_t len = 0;
+
+		if ((text = payload_object_text(payload, &len))) {
+			jsock_queue_payload(use_jsock, payload, text, len, "}");
+		} else {
+			cJSON *msg = NULL, *params;
+			params = cJSON_Duplicate(event, 1);
+			msg = jrpc_new_req("verto.event", NULL, &params);
+			jsock_queue_event(use_jsock, &msg, SWITCH_TRUE);
+		}
 		switch_thread_rwlock_unlock(use_jsock->rwlock);
 		use_jsock = NULL;
 		return;
 	}
 
 	switch_thread_rwlock_rdlock(verto_globals.event_channel_rwlock);
-	write_event(event_channel, NULL, use_jsock, event);
+	write_event(event_channel, NULL, use_jsock, event, payload);
 	if (strchr(event_channel, '.')) {
 		char *main_channel = strdup(event_channel);
 		char *p;
 		switch_assert(main_channel);
 		p = strchr(main_channel, '.');
 		if (p) *p = '\0';
-		write_event(main_channel, event_channel, use_jsock, event);
+		write_event(main_channel, event_channel, use_jsock, event, payload);
 		free(main_channel);
 	}
 	switch_thread_rwlock_unlock(verto_globals.event_channel_rwlock);
@@ -777,9 +1072,9 @@ static void jsock_send_event(cJSON *event)
 	}
 }
 
-static jrpc_func_t jrpc_get_func(jsock_t *jsock, const char *method)
+static jrpc_method_t *jrpc_get_func(jsock_t *jsock, const char *method)
 {
-	jrpc_func_t func = NULL;
+	jrpc_method_t *func = NULL;
 	char *main_method = NULL;
 
 	switch_assert(method);
@@ -800,7 +1095,7 @@ static jrpc_func_t jrpc_get_func(jsock_t *jsock, const char *method)
 	}
 
 	switch_mutex_lock(verto_globals.method_mutex);
-	func = (jrpc_func_t) (intptr_t) switch_core_hash_find(verto_globals.method_hash, method);
+	func = (jrpc_method_t *) switch_core_hash_find(verto_globals.method_hash, method);
 	switch_mutex_unlock(verto_globals.method_mutex);
 
  end:
@@ -813,11 +1108,21 @@ static jrpc_func_t jrpc_get_func(jsock_t *jsock, const char *method)
 
 static void jrpc_add_func(const char *method, jrpc_func_t func)
 {
+	jrpc_method_t *jm;
+	char labels[256];
+
 	switch_assert(method);
 	switch_assert(func);
 
+	jm = switch_core_alloc(verto_globals.pool, sizeof(*jm));
+	jm->func = func;
+	switch_snprintf(labels, sizeof(labels), "method=\"%s\"", method);
+	switch_core_metric_register("freeswitch_verto_rpc_calls_total", labels, "Verto JSON-RPC requests handled", SWITCH_METRIC_COUNTER, &jm->calls);
+	switch_core_metric_register("freeswitch_verto_rpc_microseconds_total", labels, "Time spent handling Verto JSON-RPC requests",
+								SWITCH_METRIC_COUNTER, &jm->usec);
+
 	switch_mutex_lock(verto_globals.method_mutex);
-	switch_core_hash_insert(verto_globals.method_hash, method, (void *) (intptr_t) func);
+	switch_core_hash_insert(verto_globals.method_hash, method, jm);
 	switch_mutex_unlock(verto_globals.method_mutex);
 }
 
@@ -1451,7 +1756,9 @@ static cJSON *process_jrpc(jsock_t *jsock, cJSON *json)
 {
 	cJSON *reply = NULL, *echo = NULL, *id = NULL, *params = NULL, *response = NULL, *result;
 	const char *method = NULL, *version = NULL, *sessid = NULL;
-	jrpc_func_t func = NULL;
+	jrpc_method_t *func = NULL;
+	switch_time_t started;
+	switch_bool_t ok;
 
 	switch_assert(json);
 
@@ -1498,7 +1805,12 @@ static cJSON *process_jrpc(jsock_t *jsock, cJSON *json)
 	if (!method || !(func = jrpc_get_func(jsock, method))) {
 		jrpc_add_error(reply, -32601, "Invalid Method, Missing Method or Permission Denied", id);
 	} else {
-		if (func(method, params, jsock, &response) == SWITCH_TRUE) {
+		started = switch_time_now();
+		ok = func->func(method, params, jsock, &response);
+		switch_core_metric_inc(func->calls);
+		switch_core_metric_add(func->usec, switch_time_now() - started);
+
+		if (ok == SWITCH_TRUE) {
 
 			if (params) {
 				echo = cJSON_GetObjectItem(params, "echoParams");
@@ -1575,15 +1887,164 @@ static switch_status_t process_input(jsock_t *jsock, uint8_t *data, switch_ssize
 	return status;
 }
 
+#define VERTO_WRITE_BATCH 64
+
+/* Write a run of queued frames at once, gathered straight from the messages on a plain socket or coalesced into one TLS write */
+static switch_ssize_t jsock_write_msgs(jsock_t *jsock, verto_msg_t **msgs, int count)
+{
+	switch_size_t total = 0;
+	switch_ssize_t r = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		total += msgs[i]->hlen + msgs[i]->len;
+
+		if (jsock->profile->debug || verto_globals.debug) {
+			verto_msg_t *msg = msgs[i];
+			switch_size_t own = msg->len - msg->shared_len;
+
+			switch_log_printf(SWITCH_CHANNEL_LOG, verto_globals.debug_level, "WRITE %s [%.*s%.*s%.*s]\n", jsock->name,
+							  (int) msg->split, msg->data, (int) msg->shared_len, msg->shared ? msg->shared : "",
+							  (int) (own - msg->split), msg->data + msg->split);
+		}
+	}
+
+#ifndef WIN32
+	if (!(jsock->ptype & PTYPE_CLIENT_SSL)) {
+		struct iovec iov[VERTO_WRITE_BATCH * 4];
+		struct iovec *vp = iov;
+		int iovcnt = 0;
+		switch_size_t left = total;
+
+		for (i = 0; i < count; i++) {
+			verto_msg_t *msg = msgs[i];
+			switch_size_t own = msg->len - msg->shared_len;
+
+			iov[iovcnt].iov_base = msg->hdr;
+			iov[iovcnt++].iov_len = msg->hlen;
+			iov[iovcnt].iov_base = msg->data;
+			iov[iovcnt++].iov_len = msg->split;
+
+			if (msg->shared_len) {
+				iov[iovcnt].iov_base = (void *) msg->shared;
+				iov[iovcnt++].iov_len = msg->shared_len;
+			}
+
+			if (own > msg->split) {
+				iov[iovcnt].iov_base = msg->data + msg->split;
+				iov[iovcnt++].iov_len = own - msg->split;
+			}
+		}
+
+#ifdef VERTO_HAVE_EPOLL
+		if (jsock->reactor) {
+			return jsock_reactor_send(jsock, iov, iovcnt);
+		}
+#endif
+
+		while (left) {
+			ssize_t w = writev(jsock->client_socket, vp, iovcnt);
+
+			if (w < 0) {
+				if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+					struct pollfd pfd = { 0 };
+
+					pfd.fd = jsock->client_socket;
+					pfd.events = POLLOUT;
+					if (poll(&pfd, 1, 1000) <= 0) {
+						return -1;
+					}
+					continue;
+				}
+				return -1;
+			}
+
+			left -= w;
+
+			while (w > 0 && iovcnt) {
+				if ((switch_size_t) w >= vp->iov_len) {
+					w -= vp->iov_len;
+					vp++;
+					iovcnt--;
+				} else {
+					vp->iov_base = (char *) vp->iov_base + w;
+					vp->iov_len -= w;
+					w = 0;
+				}
+			}
+		}
+
+		return (switch_ssize_t) total;
+	}
+#endif
+
+	{
+		uint8_t *buf, *p;
+
+		switch_malloc(buf, total);
+		p = buf;
+
+		for (i = 0; i < count; i++) {
+			verto_msg_t *msg = msgs[i];
+			switch_size_t own = msg->len - msg->shared_len;
+
+			memcpy(p, msg->hdr, msg->hlen);
+			p += msg->hlen;
+			memcpy(p, msg->data, msg->split);
+			p += msg->split;
+			if (msg->shared_len) {
+				memcpy(p, msg->shared, msg->shared_len);
+				p += msg->shared_len;
+			}
+			memcpy(p, msg->data + msg->split, own - msg->split);
+			p += own - msg->split;
+		}
+
+		r = kws_raw_write(jsock->ws, buf, total);
+		free(buf);
+	}
+
+	return r;
+}
+
 static void jsock_check_event_queue(jsock_t *jsock)
 {
 	void *pop;
 	int this_pass = switch_queue_size(jsock->event_queue);
+	verto_msg_t *msgs[VERTO_WRITE_BATCH];
+	int count, i;
 
 	switch_mutex_lock(jsock->write_mutex);
-	while(this_pass-- > 0 && switch_queue_trypop(jsock->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
-		cJSON *json = (cJSON *) pop;
-		ws_write_json(jsock, &json, SWITCH_TRUE);
+#ifdef VERTO_HAVE_EPOLL
+	if (jsock->reactor && jsock_reactor_flush(jsock) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ALERT, "%s WRITE RETURNED ERROR\n", jsock->name);
+		jsock->drop = 1;
+		jsock->ready = 0;
+	}
+#endif
+	while (this_pass > 0 && !jsock->drop) {
+		int64_t bytes = 0;
+
+		for (count = 0; count < VERTO_WRITE_BATCH && this_pass > 0 && switch_queue_trypop(jsock->event_queue, &pop) == SWITCH_STATUS_SUCCESS; this_pass--) {
+			msgs[count++] = (verto_msg_t *) pop;
+		}
+
+		if (!count) {
+			break;
+		}
+
+		if (jsock_write_msgs(jsock, msgs, count) <= 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ALERT, "%s WRITE RETURNED ERROR\n", jsock->name);
+			jsock->drop = 1;
+			jsock->ready = 0;
+		}
+
+		for (i = 0; i < count; i++) {
+			bytes += msgs[i]->hlen + msgs[i]->len;
+			verto_msg_free(&msgs[i]);
+		}
+
+		switch_core_metric_add(verto_globals.queued_bytes, -bytes);
 	}
 	switch_mutex_unlock(jsock->write_mutex);
 }
@@ -1903,295 +2364,980 @@ authed:
 
 			rule = rule->next;
 		}
-	}
+	}
+
+	switch_event_add_header_string(stream.param_event, SWITCH_STACK_BOTTOM, "HTTP-URI", request->uri);
+
+	if ((ext = strrchr(request->uri, '.'))) {
+		char path[1024];
+
+		if (!strncmp(ext, ".lua", 4)) {
+			switch_snprintf(path, sizeof(path), "%s%s", vhost->script_root, request->uri);
+			switch_api_execute("lua", path, NULL, &stream);
+		} else {
+			http_static_handler(request, vhost);
+		}
+	} else {
+		http_static_handler(request, vhost);
+	}
+
+done:
+
+	keepalive = request->keepalive;
+	kws_request_free(&request);
+	if (stream.param_event) switch_event_destroy(&stream.param_event);
+
+	if (keepalive) {
+		kws_t *wsh = jsock->ws;
+
+		while(jsock->profile->running) {
+			int pflags = kws_wait_sock(wsh, 3000, KS_POLL_READ);
+
+			if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
+			if (pflags < 0 && (errno != EINTR)) { die_errnof("%s POLL FAILED with %d", jsock->name, pflags); }
+			if (pflags == 0) { /* keepalive socket poll timeout */ break; }
+			if (pflags > 0 && (pflags & KS_POLL_HUP)) { log_and_exit(SWITCH_LOG_INFO, "%s POLL HANGUP DETECTED (peer closed its end of socket)\n", jsock->name); }
+			if (pflags > 0 && (pflags & KS_POLL_ERROR)) { die("%s POLL ERROR\n", jsock->name); }
+			if (pflags > 0 && (pflags & KS_POLL_INVALID)) { die("%s POLL INVALID SOCKET (not opened or already closed)\n", jsock->name); }
+			if (pflags > 0 && (pflags & KS_POLL_READ)) {
+				if (kws_keepalive(wsh) == KS_STATUS_SUCCESS) {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "socket %s is going to handle a new request\n", jsock->name);
+					goto new_req;
+				} else {
+					// switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Socket Read Error\n");
+					break;
+				}
+			} else {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "unhandled flag: %d\n", pflags);
+			}
+		}
+	}
+
+	return;
+
+request_err:
+	kws_request_free(&request);
+
+err:
+	err = "HTTP/1.1 500 Internal Server Error\r\n"
+		"Content-Length: 0\r\n\r\n";
+	kws_raw_write(jsock->ws, err, strlen(err));
+
+error:
+	return;
+}
+
+/* The download half of the speed test, upload is how long the client took to send its payload */
+static void jsock_speed_test(jsock_t *jsock, int size, switch_time_t upload)
+{
+	char repl[2048] = "";
+	switch_time_t a, b;
+	int i, loops, rem, dur = 0, j = 0;
+
+	switch_snprintf(repl, sizeof(repl), "#SPU %ld", (long)(upload / 1000));
+	jsock_write_frame(jsock, WSOC_TEXT, repl, strlen(repl));
+	loops = size / 1024;
+	rem = size % 1024;
+	switch_snprintf(repl, sizeof(repl), "#SPB ");
+	memset(repl+4, '.', 1024);
+
+	for (j = 0; j < 10 ; j++) {
+		int ddur = 0;
+		a = switch_time_now();
+		for (i = 0; i < loops; i++) {
+			jsock_write_frame(jsock, WSOC_TEXT, repl, 1024);
+		}
+		if (rem) {
+			jsock_write_frame(jsock, WSOC_TEXT, repl, rem);
+		}
+		b = switch_time_now();
+		ddur += (int)((b - a) / 1000);
+		dur += ddur;
+
+	}
+
+	dur /= j+1;
+
+	switch_snprintf(repl, sizeof(repl), "#SPD %d", dur);
+	jsock_write_frame(jsock, WSOC_TEXT, repl, strlen(repl));
+}
+
+/* Answer one frame from the client, SWITCH_STATUS_FALSE means the connection has to go */
+static switch_status_t jsock_handle_frame(jsock_t *jsock, uint8_t *data, switch_ssize_t bytes)
+{
+	char *s = (char *) data;
+
+	/* a reactor can't sit in a read loop, so the upload of a speed test arrives here a frame at a time */
+	if (jsock->spu_size) {
+		int size = jsock->spu_size;
+
+		if (bytes > 3 && s[0] == '#' && s[3] == 'B') {
+			return SWITCH_STATUS_SUCCESS;
+		}
+
+		jsock->spu_size = 0;
+
+		if (s[0] != '#') goto nm;
+
+		jsock_speed_test(jsock, size, switch_time_now() - jsock->spu_start);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (*s == '#') {
+		switch_time_t a, b;
+
+		if (s[1] == 'S' && s[2] == 'P') {
+
+			if (s[3] == 'U') {
+				int size = 0;
+				char *p = s+4;
+				kws_opcode_t oc;
+
+				if ((size = atoi(p)) <= 0) {
+					return SWITCH_STATUS_SUCCESS;
+				}
+
+				if (jsock->reactor) {
+					jsock->spu_size = size;
+					jsock->spu_start = switch_time_now();
+					return SWITCH_STATUS_SUCCESS;
+				}
+
+				a = switch_time_now();
+				do {
+					bytes = kws_read_frame(jsock->ws, &oc, &data);
+					s = (char *) data;
+				} while (bytes && data && s[0] == '#' && s[3] == 'B');
+				b = switch_time_now();
+
+				if (!bytes || !data) return SWITCH_STATUS_SUCCESS;
+
+				if (s[0] != '#') goto nm;
+
+				jsock_speed_test(jsock, size, b - a);
+			}
+		}
+
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+ nm:
+
+	if (process_input(jsock, data, bytes) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s Input Error\n", jsock->name);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void jsock_ping(jsock_t *jsock)
+{
+	cJSON *params = NULL;
+	cJSON *msg = jrpc_new_req("verto.ping", 0, &params);
+
+	if (jsock->exptime) {
+		cJSON_AddItemToObject(params, "auth-expires", cJSON_CreateNumber(jsock->exptime));
+	}
+
+	cJSON_AddItemToObject(params, "serno", cJSON_CreateNumber(switch_epoch_time_now(NULL)));
+	jsock_queue_event(jsock, &msg, SWITCH_TRUE);
+}
+
+static void jsock_check_attach(jsock_t *jsock)
+{
+	if ((!switch_test_flag(jsock, JPFLAG_CHECK_ATTACH) || (jsock->attach_timer > 0 && jsock->attach_timer-- == 0)) &&
+		switch_test_flag(jsock, JPFLAG_AUTHED)) {
+		attach_calls(jsock);
+		switch_set_flag(jsock, JPFLAG_CHECK_ATTACH);
+	}
+}
+
+static void jsock_ws_close(jsock_t *jsock)
+{
+	detach_jsock(jsock);
+	kws_destroy(&jsock->ws);
+	ks_pool_close(&jsock->kpool);
+}
+
+#ifdef VERTO_HAVE_EPOLL
+static switch_status_t verto_reactor_adopt(jsock_t *jsock);
+#endif
+
+/* Returns SWITCH_TRUE when a reactor took the connection over */
+static switch_bool_t client_run(jsock_t *jsock)
+{
+	int flags = KWS_BLOCK;
+	int idle = 0;
+	
+	if (jsock->profile->vhosts) {
+		flags |= KWS_STAY_OPEN;
+		flags |= KWS_HTTP;
+	}
+
+	ks_pool_open(&jsock->kpool);
+	if (kws_init(&jsock->ws, jsock->client_socket, (jsock->ptype & PTYPE_CLIENT_SSL) ? jsock->profile->ssl_ctx : NULL, 0, flags, jsock->kpool) != KS_STATUS_SUCCESS) {
+		log_and_exit(SWITCH_LOG_NOTICE, "%s WS SETUP FAILED\n", jsock->name);
+	}
+
+	if (kws_test_flag(jsock->ws, KWS_HTTP)) {
+		http_run(jsock);
+		kws_close(jsock->ws, WS_NONE);
+		goto end;
+	}
+
+#ifdef VERTO_HAVE_EPOLL
+	if (jsock->use_reactor && verto_reactor_adopt(jsock) == SWITCH_STATUS_SUCCESS) {
+		return SWITCH_TRUE;
+	}
+#endif
+
+	while(jsock->profile->running) {
+		int pflags, poll_time = 50;
+		time_t now;
+
+		if (!jsock->ws) { die("%s Setup Error\n", jsock->name); }
+		
+		pflags = kws_wait_sock(jsock->ws, poll_time, KS_POLL_READ);
+
+		if (jsock->exptime) {
+			now = switch_epoch_time_now(NULL);
+
+			if (now >= jsock->exptime) {
+				switch_set_flag(jsock, JPFLAG_AUTH_EXPIRED);
+				die("%s Authentication Expired [%ld] >= [%ld]\n", jsock->uid, now, jsock->exptime);
+			}
+
+		}
+
+		if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
+		if (pflags < 0 && (errno != EINTR)) { die_errnof("%s POLL FAILED with %d", jsock->name, pflags); }
+		if (pflags == 0) {/* socket poll timeout */ jsock_check_event_queue(jsock); idle += poll_time;} else {idle = 0;}
+
+		if (idle >= 30000) {
+			jsock_ping(jsock);
+			idle = 0;
+		}
+		
+		jsock_check_attach(jsock);
+
+		if (pflags > 0 && (pflags & KS_POLL_HUP)) { log_and_exit(SWITCH_LOG_INFO, "%s POLL HANGUP DETECTED (peer closed its end of socket)\n", jsock->name); }
+		if (pflags > 0 && (pflags & KS_POLL_ERROR)) { die("%s POLL ERROR\n", jsock->name); }
+		if (pflags > 0 && (pflags & KS_POLL_INVALID)) { die("%s POLL INVALID SOCKET (not opened or already closed)\n", jsock->name); }
+		if (pflags > 0 && (pflags & KS_POLL_READ)) {
+			switch_ssize_t bytes;
+			kws_opcode_t oc;
+			uint8_t *data;
+
+			bytes = kws_read_frame(jsock->ws, &oc, &data);
+
+			if (bytes < 0) {
+				if (bytes == -1000) {
+					log_and_exit(SWITCH_LOG_INFO, "%s Client sent close request\n", jsock->name);
+				} else {
+					die("%s BAD READ %" SWITCH_SSIZE_T_FMT "\n", jsock->name, bytes);
+				}
+			}
+
+			if (bytes && jsock_handle_frame(jsock, data, bytes) != SWITCH_STATUS_SUCCESS) {
+				goto error;
+			}
+		}
+	}
+
+ error:
+ end:
+	jsock_ws_close(jsock);
+	return SWITCH_FALSE;
+}
+
+static void jsock_flush(jsock_t *jsock)
+{
+	void *pop;
+
+	switch_mutex_lock(jsock->write_mutex);
+	while(switch_queue_trypop(jsock->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
+		verto_msg_t *msg = (verto_msg_t *) pop;
+
+		switch_core_metric_add(verto_globals.queued_bytes, -(int64_t) (msg->hlen + msg->len));
+		verto_msg_free(&msg);
+	}
+	switch_mutex_unlock(jsock->write_mutex);
+}
+
+/* Everything after the websocket is gone, the jsock itself stays until its pool is destroyed */
+static void client_end(jsock_t *jsock)
+{
+	switch_event_t *s_event;
+
+	detach_calls(jsock);
+
+	del_jsock(jsock);
+
+	switch_event_destroy(&jsock->params);
+	switch_event_destroy(&jsock->vars);
+	switch_event_destroy(&jsock->user_vars);
+
+	if (jsock->client_socket != KS_SOCK_INVALID) {
+		close_socket(&jsock->client_socket);
+	}
+
+	switch_event_destroy(&jsock->allowed_methods);
+	switch_event_destroy(&jsock->allowed_fsapi);
+	switch_event_destroy(&jsock->allowed_jsapi);
+	switch_event_destroy(&jsock->allowed_event_channels);
+
+	jsock_flush(jsock);
+
+    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Ending client thread.\n", jsock->name);
+	if (switch_event_create_subclass(&s_event, SWITCH_EVENT_CUSTOM, MY_EVENT_CLIENT_DISCONNECT) == SWITCH_STATUS_SUCCESS) {
+		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_profile_name", jsock->profile->name);
+		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_client_address", jsock->name);
+		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_login", switch_str_nil(jsock->uid));
+		switch_event_fire(&s_event);
+	}
+	switch_thread_rwlock_wrlock(jsock->rwlock);
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Thread ended\n", jsock->name);
+	switch_thread_rwlock_unlock(jsock->rwlock);
+}
+
+static void *SWITCH_THREAD_FUNC client_thread(switch_thread_t *thread, void *obj)
+{
+	jsock_t *jsock = (jsock_t *) obj;
+
+	switch_event_create(&jsock->params, SWITCH_EVENT_CHANNEL_DATA);
+	switch_event_create(&jsock->vars, SWITCH_EVENT_CHANNEL_DATA);
+	switch_event_create(&jsock->user_vars, SWITCH_EVENT_CHANNEL_DATA);
+
+
+	add_jsock(jsock);
+
+    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Starting client thread.\n", jsock->name);
+
+	if ((jsock->ptype & PTYPE_CLIENT) || (jsock->ptype & PTYPE_CLIENT_SSL)) {
+		if (client_run(jsock)) {
+			return NULL;
+		}
+	} else {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s Ending client thread.\n", jsock->name);
+	}
+
+	client_end(jsock);
+
+	/* connections meant for a reactor don't hand their pool to the thread pool */
+	if (jsock->use_reactor) {
+		switch_memory_pool_t *pool = jsock->pool;
+		switch_core_destroy_memory_pool(&pool);
+	}
+
+	return NULL;
+}
+
+/*
+ * With reactor-threads set, a connection only keeps a thread while its TLS and websocket handshakes run.
+ * After that one of the reactors watches its socket with epoll and hands it to the worker pool whenever
+ * it is readable, has events queued or is due a housekeeping tick; a connection is never on the work
+ * queue twice, rsched says it is queued or being worked on and rwant collects what it is wanted for.
+ */
+static void jsock_schedule(jsock_t *jsock, uint32_t want)
+{
+	int push = 0;
+
+	if (!jsock->reactor) {
+		return;
+	}
+
+	switch_mutex_lock(jsock->flag_mutex);
+	jsock->rwant |= want;
+	if (!jsock->rsched) {
+		jsock->rsched = 1;
+		push = 1;
+	}
+	switch_mutex_unlock(jsock->flag_mutex);
+
+	if (push) {
+		switch_queue_push(verto_globals.reactor_queue, jsock);
+	}
+}
+
+#ifdef VERTO_HAVE_EPOLL
+
+#define VERTO_REACTOR_EVENTS 256
+#define VERTO_READ_BATCH 16
+#define VERTO_REACTOR_ROUNDS 8
+
+static int jsock_reactor_arm(jsock_t *jsock, int op)
+{
+	struct epoll_event ev = { 0 };
+	int r;
+
+	switch_mutex_lock(jsock->write_mutex);
+	ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	if (jsock->wpending && switch_buffer_inuse(jsock->wpending)) {
+		ev.events |= EPOLLOUT;
+	}
+	ev.data.ptr = jsock;
+
+	r = epoll_ctl(jsock->reactor->epfd, op, jsock->client_socket, &ev);
+	switch_mutex_unlock(jsock->write_mutex);
+
+	return r;
+}
+
+static void verto_reactor_unlink(verto_reactor_t *reactor, jsock_t *jsock)
+{
+	if (jsock->rprev) {
+		jsock->rprev->rnext = jsock->rnext;
+	} else {
+		reactor->head = jsock->rnext;
+	}
+
+	if (jsock->rnext) {
+		jsock->rnext->rprev = jsock->rprev;
+	}
+
+	jsock->rprev = jsock->rnext = NULL;
+	reactor->count--;
+}
+
+static void jsock_reactor_buffers_destroy(jsock_t *jsock)
+{
+	switch_buffer_destroy(&jsock->rbuf);
+	switch_buffer_destroy(&jsock->rmsg);
+	switch_mutex_lock(jsock->write_mutex);
+	switch_buffer_destroy(&jsock->wpending);
+	switch_mutex_unlock(jsock->write_mutex);
+}
+
+static switch_status_t verto_reactor_adopt(jsock_t *jsock)
+{
+	verto_reactor_t *reactor = NULL;
+	int i;
+
+	if (!verto_globals.reactor_running) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if ((i = fcntl(jsock->client_socket, F_GETFL, 0)) < 0 || fcntl(jsock->client_socket, F_SETFL, i | O_NONBLOCK) < 0) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s Cannot make socket non-blocking: %s\n", jsock->name, strerror(errno));
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_buffer_create_dynamic(&jsock->rbuf, 16384, 16384, VERTO_MAX_FRAME * 2);
+	switch_buffer_create_dynamic(&jsock->rmsg, 4096, 4096, VERTO_MAX_FRAME + 1);
+	switch_buffer_create_dynamic(&jsock->wpending, 16384, 16384, VERTO_MAX_PENDING);
+
+	for (i = 0; i < verto_globals.reactor_threads; i++) {
+		if (!reactor || verto_globals.reactors[i].count < reactor->count) {
+			reactor = &verto_globals.reactors[i];
+		}
+	}
+
+	switch_mutex_lock(reactor->mutex);
+
+	/* queue it ourselves once it's armed: data may already be buffered and events queued during setup */
+	switch_mutex_lock(jsock->flag_mutex);
+	jsock->rsched = 1;
+	jsock->rwant = VERTO_WANT_READ | VERTO_WANT_FLUSH;
+	switch_mutex_unlock(jsock->flag_mutex);
+
+	jsock->reactor = reactor;
+	jsock->rnext = reactor->head;
+	if (reactor->head) {
+		reactor->head->rprev = jsock;
+	}
+	reactor->head = jsock;
+	reactor->count++;
+
+	if (jsock_reactor_arm(jsock, EPOLL_CTL_ADD) < 0) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s Cannot watch socket: %s\n", jsock->name, strerror(errno));
+		verto_reactor_unlink(reactor, jsock);
+		jsock->reactor = NULL;
+		jsock->rsched = 0;
+		jsock->rwant = 0;
+		switch_mutex_unlock(reactor->mutex);
+		jsock_reactor_buffers_destroy(jsock);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_mutex_unlock(reactor->mutex);
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Handed to the reactor.\n", jsock->name);
+	switch_queue_push(verto_globals.reactor_queue, jsock);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/* Take whole frames off the front of rbuf, returns 1 for a frame handled, 0 when the rest isn't in yet and -1 to drop the client */
+static int jsock_reactor_frame(jsock_t *jsock)
+{
+	const void *ptr;
+	const uint8_t *p;
+	uint8_t payload[4096];
+	switch_size_t have, hlen = 2, plen, off;
+	int fin, oc, masked, i;
+	uint8_t mask[4] = { 0 };
+
+	if ((have = switch_buffer_peek_zerocopy(jsock->rbuf, &ptr)) < 2) {
+		return 0;
+	}
+
+	p = (const uint8_t *) ptr;
+	fin = p[0] & 0x80;
+	oc = p[0] & 0x0f;
+	masked = p[1] & 0x80;
+	plen = p[1] & 0x7f;
+
+	if (plen == 126) {
+		if (have < 4) {
+			return 0;
+		}
+		plen = ((switch_size_t) p[2] << 8) | p[3];
+		hlen = 4;
+	} else if (plen == 127) {
+		uint64_t len64 = 0;
+
+		if (have < 10) {
+			return 0;
+		}
+		for (i = 0; i < 8; i++) {
+			len64 = (len64 << 8) | p[2 + i];
+		}
+		if (len64 > VERTO_MAX_FRAME) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s Frame of %" SWITCH_UINT64_T_FMT " bytes is too big\n", jsock->name, len64);
+			return -1;
+		}
+		plen = (switch_size_t) len64;
+		hlen = 10;
+	}
+
+	if (plen > VERTO_MAX_FRAME) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s Frame of %" SWITCH_SIZE_T_FMT " bytes is too big\n", jsock->name, plen);
+		return -1;
+	}
+
+	if (masked) {
+		if (have < hlen + 4) {
+			return 0;
+		}
+		memcpy(mask, p + hlen, 4);
+		hlen += 4;
+	}
+
+	if (have < hlen + plen) {
+		return 0;
+	}
+
+	p += hlen;
+
+	switch (oc) {
+	case WSOC_CLOSE:
+	case WSOC_PING:
+	case WSOC_PONG:
+		if (!fin || plen > 125) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s BAD READ control frame %d\n", jsock->name, oc);
+			return -1;
+		}
+
+		if (oc == WSOC_CLOSE) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "%s Client sent close request\n", jsock->name);
+			return -1;
+		}
+
+		if (oc == WSOC_PING) {
+			for (off = 0; off < plen; off++) {
+				payload[off] = p[off] ^ mask[off % 4];
+			}
+			if (jsock_write_frame(jsock, WSOC_PONG, payload, plen) < 0) {
+				return -1;
+			}
+		}
+		break;
+	case WSOC_CONTINUATION:
+	case WSOC_TEXT:
+	case WSOC_BINARY:
+		if (oc != WSOC_CONTINUATION && switch_buffer_inuse(jsock->rmsg)) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s BAD READ new message inside a fragmented one\n", jsock->name);
+			return -1;
+		}
+
+		if (switch_buffer_inuse(jsock->rmsg) + plen > VERTO_MAX_FRAME) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s Message is too big\n", jsock->name);
+			return -1;
+		}
+
+		for (off = 0; off < plen; ) {
+			switch_size_t n = plen - off > sizeof(payload) ? sizeof(payload) : plen - off, x;
+
+			for (x = 0; x < n; x++, off++) {
+				payload[x] = p[off] ^ mask[off % 4];
+			}
+			switch_buffer_write(jsock->rmsg, payload, n);
+		}
+		break;
+	default:
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s BAD READ opcode %d\n", jsock->name, oc);
+		return -1;
+	}
+
+	switch_buffer_toss(jsock->rbuf, hlen + plen);
+
+	if (fin && oc != WSOC_CLOSE && oc != WSOC_PING && oc != WSOC_PONG) {
+		switch_size_t len = switch_buffer_inuse(jsock->rmsg);
+		switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+		if (len) {
+			const void *msg;
+
+			switch_buffer_write(jsock->rmsg, "", 1);
+			switch_buffer_peek_zerocopy(jsock->rmsg, &msg);
+			status = jsock_handle_frame(jsock, (uint8_t *) msg, (switch_ssize_t) len);
+		}
+
+		switch_buffer_zero(jsock->rmsg);
+
+		if (status != SWITCH_STATUS_SUCCESS) {
+			return -1;
+		}
+	}
+
+	return 1;
+}
+
+/* The socket is non-blocking: take what is there, hand on the frames that are complete and keep the rest for next time */
+static switch_status_t jsock_reactor_read(jsock_t *jsock)
+{
+	uint8_t chunk[16384];
+	int reads = 0;
+
+	for (;;) {
+		switch_ssize_t bytes;
+		int r;
+
+		if (reads++ == VERTO_READ_BATCH) {
+			jsock_schedule(jsock, VERTO_WANT_READ);
+			return SWITCH_STATUS_SUCCESS;
+		}
+
+		bytes = kws_raw_read(jsock->ws, chunk, sizeof(chunk), 0);
+
+		if (bytes == 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "%s POLL HANGUP DETECTED (peer closed its end of socket)\n", jsock->name);
+			return SWITCH_STATUS_FALSE;
+		}
+
+		if (bytes < 0) {
+			if (bytes == -2 || errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s BAD READ %" SWITCH_SSIZE_T_FMT "\n", jsock->name, bytes);
+			return SWITCH_STATUS_FALSE;
+		}
 
-	switch_event_add_header_string(stream.param_event, SWITCH_STACK_BOTTOM, "HTTP-URI", request->uri);
+		jsock->idle = 0;
 
-	if ((ext = strrchr(request->uri, '.'))) {
-		char path[1024];
+		if (!switch_buffer_write(jsock->rbuf, chunk, bytes)) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s Too much unread input\n", jsock->name);
+			return SWITCH_STATUS_FALSE;
+		}
 
-		if (!strncmp(ext, ".lua", 4)) {
-			switch_snprintf(path, sizeof(path), "%s%s", vhost->script_root, request->uri);
-			switch_api_execute("lua", path, NULL, &stream);
-		} else {
-			http_static_handler(request, vhost);
+		while ((r = jsock_reactor_frame(jsock)) > 0);
+
+		if (r < 0) {
+			return SWITCH_STATUS_FALSE;
 		}
-	} else {
-		http_static_handler(request, vhost);
 	}
 
-done:
-
-	keepalive = request->keepalive;
-	kws_request_free(&request);
-	if (stream.param_event) switch_event_destroy(&stream.param_event);
+	if (jsock_reactor_arm(jsock, EPOLL_CTL_MOD) < 0) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s Cannot rearm socket: %s\n", jsock->name, strerror(errno));
+		return SWITCH_STATUS_FALSE;
+	}
 
-	if (keepalive) {
-		kws_t *wsh = jsock->ws;
+	return SWITCH_STATUS_SUCCESS;
+}
 
-		while(jsock->profile->running) {
-			int pflags = kws_wait_sock(wsh, 3000, KS_POLL_READ);
+static switch_status_t jsock_reactor_tick(jsock_t *jsock)
+{
+	if (jsock->exptime) {
+		time_t now = switch_epoch_time_now(NULL);
 
-			if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
-			if (pflags < 0 && (errno != EINTR)) { die_errnof("%s POLL FAILED with %d", jsock->name, pflags); }
-			if (pflags == 0) { /* keepalive socket poll timeout */ break; }
-			if (pflags > 0 && (pflags & KS_POLL_HUP)) { log_and_exit(SWITCH_LOG_INFO, "%s POLL HANGUP DETECTED (peer closed its end of socket)\n", jsock->name); }
-			if (pflags > 0 && (pflags & KS_POLL_ERROR)) { die("%s POLL ERROR\n", jsock->name); }
-			if (pflags > 0 && (pflags & KS_POLL_INVALID)) { die("%s POLL INVALID SOCKET (not opened or already closed)\n", jsock->name); }
-			if (pflags > 0 && (pflags & KS_POLL_READ)) {
-				if (kws_keepalive(wsh) == KS_STATUS_SUCCESS) {
-					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "socket %s is going to handle a new request\n", jsock->name);
-					goto new_req;
-				} else {
-					// switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Socket Read Error\n");
-					break;
-				}
-			} else {
-				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "unhandled flag: %d\n", pflags);
-			}
+		if (now >= jsock->exptime) {
+			switch_set_flag(jsock, JPFLAG_AUTH_EXPIRED);
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s Authentication Expired [%ld] >= [%ld]\n", jsock->uid, now, jsock->exptime);
+			return SWITCH_STATUS_FALSE;
 		}
 	}
 
-	return;
+	if (!jsock->profile->running) {
+		return SWITCH_STATUS_FALSE;
+	}
 
-request_err:
-	kws_request_free(&request);
+	if (jsock->idle >= 30000) {
+		jsock_ping(jsock);
+		jsock->idle = 0;
+	}
 
-err:
-	err = "HTTP/1.1 500 Internal Server Error\r\n"
-		"Content-Length: 0\r\n\r\n";
-	kws_raw_write(jsock->ws, err, strlen(err));
+	jsock_check_attach(jsock);
 
-error:
-	return;
+	return SWITCH_STATUS_SUCCESS;
 }
 
-static void client_run(jsock_t *jsock)
+/* The pool goes on the graveyard, the reactor frees it once no epoll result it fetched can still point at it */
+static void jsock_reactor_close(jsock_t *jsock)
 {
-	int flags = KWS_BLOCK;
-	int idle = 0;
-	
-	if (jsock->profile->vhosts) {
-		flags |= KWS_STAY_OPEN;
-		flags |= KWS_HTTP;
-	}
+	verto_reactor_t *reactor = jsock->reactor;
 
-	ks_pool_open(&jsock->kpool);
-	if (kws_init(&jsock->ws, jsock->client_socket, (jsock->ptype & PTYPE_CLIENT_SSL) ? jsock->profile->ssl_ctx : NULL, 0, flags, jsock->kpool) != KS_STATUS_SUCCESS) {
-		log_and_exit(SWITCH_LOG_NOTICE, "%s WS SETUP FAILED\n", jsock->name);
+	switch_mutex_lock(reactor->mutex);
+	if (jsock->client_socket != KS_SOCK_INVALID) {
+		epoll_ctl(reactor->epfd, EPOLL_CTL_DEL, jsock->client_socket, NULL);
 	}
+	verto_reactor_unlink(reactor, jsock);
+	switch_mutex_unlock(reactor->mutex);
 
-	if (kws_test_flag(jsock->ws, KWS_HTTP)) {
-		http_run(jsock);
-		kws_close(jsock->ws, WS_NONE);
-		goto end;
-	}
+	jsock_ws_close(jsock);
+	client_end(jsock);
+	jsock_reactor_buffers_destroy(jsock);
 
-	while(jsock->profile->running) {
-		int pflags, poll_time = 50;
-		time_t now;
+	switch_mutex_lock(reactor->mutex);
+	jsock->rnext = reactor->graveyard;
+	reactor->graveyard = jsock;
+	switch_mutex_unlock(reactor->mutex);
+}
 
-		if (!jsock->ws) { die("%s Setup Error\n", jsock->name); }
-		
-		pflags = kws_wait_sock(jsock->ws, poll_time, KS_POLL_READ);
+static void jsock_reactor_run(jsock_t *jsock)
+{
+	int rounds = 0;
 
-		if (jsock->exptime) {
-			now = switch_epoch_time_now(NULL);
+	for (;;) {
+		uint32_t want;
+		int requeue = 0;
 
-			if (now >= jsock->exptime) {
-				switch_set_flag(jsock, JPFLAG_AUTH_EXPIRED);
-				die("%s Authentication Expired [%ld] >= [%ld]\n", jsock->uid, now, jsock->exptime);
+		switch_mutex_lock(jsock->flag_mutex);
+		want = jsock->rwant;
+		jsock->rwant = 0;
+		if (!want || rounds++ == VERTO_REACTOR_ROUNDS) {
+			if (want) {
+				/* still busy, give the other connections a turn */
+				jsock->rwant = want;
+				requeue = 1;
+			} else {
+				jsock->rsched = 0;
 			}
+			switch_mutex_unlock(jsock->flag_mutex);
 
+			if (requeue) {
+				switch_queue_push(verto_globals.reactor_queue, jsock);
+			}
+			return;
 		}
+		switch_mutex_unlock(jsock->flag_mutex);
 
-		if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
-		if (pflags < 0 && (errno != EINTR)) { die_errnof("%s POLL FAILED with %d", jsock->name, pflags); }
-		if (pflags == 0) {/* socket poll timeout */ jsock_check_event_queue(jsock); idle += poll_time;} else {idle = 0;}
-
-		if (idle >= 30000) {
-			cJSON *params = NULL;
-			cJSON *msg = jrpc_new_req("verto.ping", 0, &params);
+		if ((want & VERTO_WANT_READ) && jsock_reactor_read(jsock) != SWITCH_STATUS_SUCCESS) {
+			break;
+		}
 
-			if (jsock->exptime) {
-				cJSON_AddItemToObject(params, "auth-expires", cJSON_CreateNumber(jsock->exptime));
-			}
-			
-			cJSON_AddItemToObject(params, "serno", cJSON_CreateNumber(switch_epoch_time_now(NULL)));
-			jsock_queue_event(jsock, &msg, SWITCH_TRUE);
-			idle = 0;
+		if ((want & VERTO_WANT_TICK) && jsock_reactor_tick(jsock) != SWITCH_STATUS_SUCCESS) {
+			break;
 		}
-		
-		if ((!switch_test_flag(jsock, JPFLAG_CHECK_ATTACH) || (jsock->attach_timer > 0 && jsock->attach_timer-- == 0)) &&
-			switch_test_flag(jsock, JPFLAG_AUTHED)) {
-			attach_calls(jsock);
-			switch_set_flag(jsock, JPFLAG_CHECK_ATTACH);
+
+		if (jsock->drop) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s Dropping Connection\n", jsock->name);
+			break;
 		}
 
-		if (pflags > 0 && (pflags & KS_POLL_HUP)) { log_and_exit(SWITCH_LOG_INFO, "%s POLL HANGUP DETECTED (peer closed its end of socket)\n", jsock->name); }
-		if (pflags > 0 && (pflags & KS_POLL_ERROR)) { die("%s POLL ERROR\n", jsock->name); }
-		if (pflags > 0 && (pflags & KS_POLL_INVALID)) { die("%s POLL INVALID SOCKET (not opened or already closed)\n", jsock->name); }
-		if (pflags > 0 && (pflags & KS_POLL_READ)) {
-			switch_ssize_t bytes;
-			kws_opcode_t oc;
-			uint8_t *data;
+		if (want & VERTO_WANT_FLUSH) {
+			jsock_check_event_queue(jsock);
+		}
+	}
 
-			bytes = kws_read_frame(jsock->ws, &oc, &data);
+	jsock_reactor_close(jsock);
+}
 
-			if (bytes < 0) {
-				if (bytes == -1000) {
-					log_and_exit(SWITCH_LOG_INFO, "%s Client sent close request\n", jsock->name);
-				} else {
-					die("%s BAD READ %" SWITCH_SSIZE_T_FMT "\n", jsock->name, bytes);
-				}
-			}
+static void verto_reactor_tick(verto_reactor_t *reactor, int elapsed)
+{
+	time_t now = switch_epoch_time_now(NULL);
+	jsock_t *jsock;
 
-			if (bytes) {
-				char *s = (char *) data;
+	switch_mutex_lock(reactor->mutex);
+	for (jsock = reactor->head; jsock; jsock = jsock->rnext) {
+		jsock->idle += elapsed;
 
-				if (*s == '#') {
-					char repl[2048] = "";
-					switch_time_t a, b;
+		if (jsock->drop || !jsock->profile->running || jsock->idle >= 30000 || (jsock->exptime && now >= jsock->exptime) ||
+			(switch_test_flag(jsock, JPFLAG_AUTHED) && (!switch_test_flag(jsock, JPFLAG_CHECK_ATTACH) || jsock->attach_timer > 0))) {
+			jsock_schedule(jsock, VERTO_WANT_TICK);
+		}
+	}
+	switch_mutex_unlock(reactor->mutex);
+}
 
-					if (s[1] == 'S' && s[2] == 'P') {
+static void verto_reactor_reap(verto_reactor_t *reactor)
+{
+	jsock_t *jsock, *next;
 
-						if (s[3] == 'U') {
-							int i, size = 0;
-							char *p = s+4;
-							int loops = 0;
-							int rem = 0;
-							int dur = 0, j = 0;
+	switch_mutex_lock(reactor->mutex);
+	jsock = reactor->graveyard;
+	reactor->graveyard = NULL;
+	switch_mutex_unlock(reactor->mutex);
 
-							if ((size = atoi(p)) <= 0) {
-								continue;
-							}
+	for (; jsock; jsock = next) {
+		switch_memory_pool_t *pool = jsock->pool;
 
-							a = switch_time_now();
-							do {
-								bytes = kws_read_frame(jsock->ws, &oc, &data);
-								s = (char *) data;
-							} while (bytes && data && s[0] == '#' && s[3] == 'B');
-							b = switch_time_now();
-
-							if (!bytes || !data) continue;
-
-							if (s[0] != '#') goto nm;
-
-							switch_snprintf(repl, sizeof(repl), "#SPU %ld", (long)((b - a) / 1000));
-							kws_write_frame(jsock->ws, WSOC_TEXT, repl, strlen(repl));
-							loops = size / 1024;
-							rem = size % 1024;
-							switch_snprintf(repl, sizeof(repl), "#SPB ");
-							memset(repl+4, '.', 1024);
-
-							for (j = 0; j < 10 ; j++) {
-								int ddur = 0;
-								a = switch_time_now();
-								for (i = 0; i < loops; i++) {
-									kws_write_frame(jsock->ws, WSOC_TEXT, repl, 1024);
-								}
-								if (rem) {
-									kws_write_frame(jsock->ws, WSOC_TEXT, repl, rem);
-								}
-								b = switch_time_now();
-								ddur += (int)((b - a) / 1000);
-								dur += ddur;
+		next = jsock->rnext;
+		switch_core_destroy_memory_pool(&pool);
+	}
+}
 
-							}
+static void *SWITCH_THREAD_FUNC verto_reactor_thread(switch_thread_t *thread, void *obj)
+{
+	verto_reactor_t *reactor = (verto_reactor_t *) obj;
+	struct epoll_event events[VERTO_REACTOR_EVENTS];
+	switch_time_t last_tick = switch_micro_time_now(), now;
 
-							dur /= j+1;
+	while (verto_globals.reactor_running) {
+		int i, n = epoll_wait(reactor->epfd, events, VERTO_REACTOR_EVENTS, VERTO_REACTOR_TICK_MS);
 
-							switch_snprintf(repl, sizeof(repl), "#SPD %d", dur);
-							kws_write_frame(jsock->ws, WSOC_TEXT, repl, strlen(repl));
-						}
-					}
+		if (n < 0 && errno != EINTR) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "epoll_wait failed: %s\n", strerror(errno));
+			switch_yield(VERTO_REACTOR_TICK_MS * 1000);
+		}
 
-					continue;
-				}
+		for (i = 0; i < n; i++) {
+			jsock_schedule((jsock_t *) events[i].data.ptr, VERTO_WANT_READ | ((events[i].events & EPOLLOUT) ? VERTO_WANT_FLUSH : 0));
+		}
 
-			nm:
+		if (n > 0) {
+			switch_core_metric_add(verto_globals.reactor_dispatches, n);
+		}
 
-				if (process_input(jsock, data, bytes) != SWITCH_STATUS_SUCCESS) {
-					die("%s Input Error\n", jsock->name);
-				}
-			}
+		now = switch_micro_time_now();
+		if (now - last_tick >= VERTO_REACTOR_TICK_MS * 1000) {
+			verto_reactor_tick(reactor, (int) ((now - last_tick) / 1000));
+			last_tick = now;
 		}
+
+		verto_reactor_reap(reactor);
 	}
 
- error:
- end:
-	detach_jsock(jsock);
-	kws_destroy(&jsock->ws);
-	ks_pool_close(&jsock->kpool);
-	return;
+	verto_reactor_reap(reactor);
+
+	return NULL;
 }
 
-static void jsock_flush(jsock_t *jsock)
+static void *SWITCH_THREAD_FUNC verto_reactor_worker(switch_thread_t *thread, void *obj)
 {
 	void *pop;
 
-	switch_mutex_lock(jsock->write_mutex);
-	while(switch_queue_trypop(jsock->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
-		cJSON *json = (cJSON *) pop;
-		cJSON_Delete(json);
+	while (switch_queue_pop(verto_globals.reactor_queue, &pop) == SWITCH_STATUS_SUCCESS && pop) {
+		jsock_reactor_run((jsock_t *) pop);
 	}
-	switch_mutex_unlock(jsock->write_mutex);
+
+	return NULL;
 }
 
-static void *SWITCH_THREAD_FUNC client_thread(switch_thread_t *thread, void *obj)
+static void verto_reactor_start(void)
 {
-	switch_event_t *s_event;
+	switch_threadattr_t *thd_attr = NULL;
+	int i;
 
-	jsock_t *jsock = (jsock_t *) obj;
+	if (verto_globals.reactor_threads <= 0) {
+		return;
+	}
 
-	switch_event_create(&jsock->params, SWITCH_EVENT_CHANNEL_DATA);
-	switch_event_create(&jsock->vars, SWITCH_EVENT_CHANNEL_DATA);
-	switch_event_create(&jsock->user_vars, SWITCH_EVENT_CHANNEL_DATA);
+	if (verto_globals.reactor_workers <= 0) {
+		verto_globals.reactor_workers = 8;
+	}
 
+	verto_globals.reactors = switch_core_alloc(verto_globals.pool, sizeof(verto_reactor_t) * verto_globals.reactor_threads);
+	verto_globals.reactor_worker_threads = switch_core_alloc(verto_globals.pool, sizeof(switch_thread_t *) * verto_globals.reactor_workers);
+	switch_queue_create(&verto_globals.reactor_queue, VERTO_REACTOR_QUEUE_LEN, verto_globals.pool);
 
-	add_jsock(jsock);
+	for (i = 0; i < verto_globals.reactor_threads; i++) {
+		if ((verto_globals.reactors[i].epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot create epoll set: %s\n", strerror(errno));
+			break;
+		}
+		switch_mutex_init(&verto_globals.reactors[i].mutex, SWITCH_MUTEX_NESTED, verto_globals.pool);
+	}
 
-    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Starting client thread.\n", jsock->name);
+	if (!(verto_globals.reactor_threads = i)) {
+		return;
+	}
 
-	if ((jsock->ptype & PTYPE_CLIENT) || (jsock->ptype & PTYPE_CLIENT_SSL)) {
-		client_run(jsock);
-	} else {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s Ending client thread.\n", jsock->name);
+	verto_globals.reactor_running = 1;
+
+	switch_threadattr_create(&thd_attr, verto_globals.pool);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+	for (i = 0; i < verto_globals.reactor_threads; i++) {
+		switch_thread_create(&verto_globals.reactors[i].thread, thd_attr, verto_reactor_thread, &verto_globals.reactors[i], verto_globals.pool);
 	}
 
-	detach_calls(jsock);
+	for (i = 0; i < verto_globals.reactor_workers; i++) {
+		switch_thread_create(&verto_globals.reactor_worker_threads[i], thd_attr, verto_reactor_worker, NULL, verto_globals.pool);
+	}
 
-	del_jsock(jsock);
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Serving websockets from %d reactor threads and %d workers\n",
+					  verto_globals.reactor_threads, verto_globals.reactor_workers);
+}
 
-	switch_event_destroy(&jsock->params);
-	switch_event_destroy(&jsock->vars);
-	switch_event_destroy(&jsock->user_vars);
+static void verto_reactor_stop(void)
+{
+	switch_status_t st;
+	uint32_t open;
+	int i, sanity = 50;
 
-	if (jsock->client_socket != KS_SOCK_INVALID) {
-		close_socket(&jsock->client_socket);
+	if (!verto_globals.reactor_running) {
+		return;
 	}
 
-	switch_event_destroy(&jsock->allowed_methods);
-	switch_event_destroy(&jsock->allowed_fsapi);
-	switch_event_destroy(&jsock->allowed_jsapi);
-	switch_event_destroy(&jsock->allowed_event_channels);
+	/* the profiles are down so every tick closes connections, let them go */
+	do {
+		open = 0;
+		for (i = 0; i < verto_globals.reactor_threads; i++) {
+			switch_mutex_lock(verto_globals.reactors[i].mutex);
+			open += verto_globals.reactors[i].count;
+			switch_mutex_unlock(verto_globals.reactors[i].mutex);
+		}
+		if (open) {
+			switch_yield(100000);
+		}
+	} while (open && --sanity > 0);
 
-	jsock_flush(jsock);
+	if (open) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%u websocket connections still open\n", open);
+	}
 
-    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Ending client thread.\n", jsock->name);
-	if (switch_event_create_subclass(&s_event, SWITCH_EVENT_CUSTOM, MY_EVENT_CLIENT_DISCONNECT) == SWITCH_STATUS_SUCCESS) {
-		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_profile_name", jsock->profile->name);
-		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_client_address", jsock->name);
-		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_login", switch_str_nil(jsock->uid));
-		switch_event_fire(&s_event);
+	verto_globals.reactor_running = 0;
+
+	for (i = 0; i < verto_globals.reactor_threads; i++) {
+		switch_thread_join(&st, verto_globals.reactors[i].thread);
 	}
-	switch_thread_rwlock_wrlock(jsock->rwlock);
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Thread ended\n", jsock->name);
-	switch_thread_rwlock_unlock(jsock->rwlock);
 
-	return NULL;
+	for (i = 0; i < verto_globals.reactor_workers; i++) {
+		switch_queue_push(verto_globals.reactor_queue, NULL);
+	}
+
+	for (i = 0; i < verto_globals.reactor_workers; i++) {
+		switch_thread_join(&st, verto_globals.reactor_worker_threads[i]);
+	}
+
+	/* nothing can touch them any more, close whatever didn't go in time */
+	for (i = 0; i < verto_globals.reactor_threads; i++) {
+		jsock_t *jsock;
+
+		while ((jsock = verto_globals.reactors[i].head)) {
+			jsock_reactor_close(jsock);
+		}
+	}
+
+	for (i = 0; i < verto_globals.reactor_threads; i++) {
+		verto_reactor_reap(&verto_globals.reactors[i]);
+		close(verto_globals.reactors[i].epfd);
+	}
 }
 
+#endif
+
 
 static switch_bool_t auth_api_command(jsock_t *jsock, const char *api_cmd, const char *arg)
 {
@@ -4430,7 +5576,7 @@ static switch_bool_t verto__broadcast_func(const char *method, cJSON *params, js
 	broadcast = cJSON_GetObjectItem(params, "localBroadcast");
 
 	if (broadcast && broadcast->type == cJSON_True) {
-		write_event(event_channel, NULL, NULL, jevent);
+		write_event(event_channel, NULL, NULL, jevent, NULL);
 	} else {
 		switch_event_channel_broadcast(event_channel, &jevent, modname, verto_globals.event_channel_id);
 	}
@@ -4733,12 +5879,19 @@ static int start_jsock(verto_profile_t *profile, ks_socket_t sock, int family)
 	setsockopt(jsock->client_socket, IPPROTO_TCP, TCP_KEEPINTVL, (void *)&flag, sizeof(flag));
 #endif
 
-	td = switch_core_alloc(jsock->pool, sizeof(*td));
+	if (verto_globals.reactor_running) {
+		/* a reactor takes the connection over once it is up, the pool has to outlive this thread */
+		switch_zmalloc(td, sizeof(*td));
+		td->alloc = 1;
+		jsock->use_reactor = 1;
+	} else {
+		td = switch_core_alloc(jsock->pool, sizeof(*td));
+		td->alloc = 0;
+		td->pool = pool;
+	}
 
-	td->alloc = 0;
 	td->func = client_thread;
 	td->obj = jsock;
-	td->pool = pool;
 
 	switch_mutex_init(&jsock->write_mutex, SWITCH_MUTEX_NESTED, jsock->pool);
 	switch_mutex_init(&jsock->filter_mutex, SWITCH_MUTEX_NESTED, jsock->pool);
@@ -4837,7 +5990,7 @@ static void handle_mcast_sub(verto_profile_t *profile)
 		profile->mcast_sub.buffer[bytes] = '\0';
 
 		if ((json = cJSON_Parse((char *)profile->mcast_sub.buffer))) {
-			jsock_send_event(json);
+			jsock_send_event(json, NULL);
 			cJSON_Delete(json);
 		} else {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s MCAST JSON PARSE ERR: %s\n", profile->name, (char *)profile->mcast_sub.buffer);
@@ -5018,6 +6171,10 @@ static void do_shutdown(void)
 
 	kill_profiles();
 
+#ifdef VERTO_HAVE_EPOLL
+	verto_reactor_stop();
+#endif
+
 	unsub_all_jsock();
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Done\n");
@@ -5446,6 +6603,22 @@ static switch_status_t parse_config(const char *cf)
 				if (val) {
 					verto_globals.kslog_on = switch_true(val);
 				}
+			} else if (!strcasecmp(var, "reactor-threads") && val) {
+				int tmp = atoi(val);
+#ifdef VERTO_HAVE_EPOLL
+				if (tmp >= 0 && tmp <= VERTO_MAX_REACTOR_THREADS) {
+					verto_globals.reactor_threads = tmp;
+				}
+#else
+				if (tmp) {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "reactor-threads needs epoll, using a thread per connection\n");
+				}
+#endif
+			} else if (!strcasecmp(var, "reactor-workers") && val) {
+				int tmp = atoi(val);
+				if (tmp > 0 && tmp <= VERTO_MAX_REACTOR_WORKERS) {
+					verto_globals.reactor_workers = tmp;
+				}
 			}
 		}
 	}
@@ -5469,6 +6642,10 @@ static int init(void)
 
 	verto_globals.running = 1;
 
+#ifdef VERTO_HAVE_EPOLL
+	verto_reactor_start();
+#endif
+
 	return 0;
 }
 
@@ -6180,7 +7357,22 @@ void verto_broadcast(const char *event_channel, cJSON *json, const char *key, sw
 		}
 	}
 
-	jsock_send_event(json);
+	jsock_send_event(json, NULL);
+}
+
+static void verto_broadcast_payload(const char *event_channel, switch_event_channel_payload_t *payload, const char *key, switch_event_channel_id_t id,
+									void *user_data)
+{
+	if (verto_globals.debug > 9) {
+		switch_size_t len = 0;
+		const char *json_text;
+
+		if ((json_text = switch_event_channel_payload_text(payload, &len))) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, verto_globals.debug_level, "EVENT BROADCAST %s %s\n", event_channel, json_text);
+		}
+	}
+
+	jsock_send_event(switch_event_channel_payload_json(payload), payload);
 }
 
 
@@ -6793,6 +7985,12 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_verto_load)
 	switch_thread_cond_create(&verto_globals.detach_cond, verto_globals.pool);
 	verto_globals.detach_timeout = 120;
 
+	switch_core_metric_register("freeswitch_verto_connections", NULL, "Open Verto websocket connections", SWITCH_METRIC_GAUGE, &verto_globals.connections);
+	switch_core_metric_register("freeswitch_verto_queued_bytes", NULL, "Bytes of Verto events waiting to be written to clients", SWITCH_METRIC_GAUGE,
+								&verto_globals.queued_bytes);
+	switch_core_metric_register("freeswitch_verto_reactor_wakeups_total", NULL, "Readable sockets handed to the Verto reactor workers", SWITCH_METRIC_COUNTER,
+								&verto_globals.reactor_dispatches);
+
 
 
 
@@ -6807,7 +8005,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_verto_load)
 
 
 
-	switch_event_channel_bind(SWITCH_EVENT_CHANNEL_GLOBAL, verto_broadcast, &verto_globals.event_channel_id, NULL);
+	switch_event_channel_bind_payload(SWITCH_EVENT_CHANNEL_GLOBAL, verto_broadcast_payload, &verto_globals.event_channel_id, NULL);
 
 
 	r = init();
@@ -6874,7 +8072,7 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_verto_shutdown)
 	json_cleanup();
 	switch_core_hash_destroy(&json_GLOBALS.store_hash);
 
-	switch_event_channel_unbind(NULL, verto_broadcast, NULL);
+	switch_event_channel_unbind_payload(NULL, verto_broadcast_payload, NULL);
 	switch_event_unbind_callback(presence_event_handler);
 	switch_event_unbind_callback(event_handler);
 
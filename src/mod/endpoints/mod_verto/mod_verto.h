@@ -72,6 +72,18 @@
 
 #define VERTO_CHAT_PROTO "verto"
 
+#if defined(__linux__)
+#define VERTO_HAVE_EPOLL
+#endif
+
+#define VERTO_REACTOR_TICK_MS 50
+/* the biggest message a reactor connection may send, and how much it may leave unread before it is dropped */
+#define VERTO_MAX_FRAME (4 * 1024 * 1024)
+#define VERTO_MAX_PENDING (8 * 1024 * 1024)
+#define VERTO_REACTOR_QUEUE_LEN 262144
+#define VERTO_MAX_REACTOR_THREADS 64
+#define VERTO_MAX_REACTOR_WORKERS 256
+
 #define copy_string(x,y,z) strncpy(x, y, z - 1)
 #define set_string(x,y) strncpy(x, y, sizeof(x)-1)
 
@@ -99,7 +111,28 @@ typedef enum {
 	JPFLAG_AUTH_EXPIRED = (1 << 6)
 } jpflag_t;
 
+typedef enum {
+	VERTO_WANT_READ  = (1 << 0),
+	VERTO_WANT_FLUSH = (1 << 1),
+	VERTO_WANT_TICK  = (1 << 2)
+} verto_want_t;
+
 struct verto_profile_s;
+struct verto_reactor_s;
+
+/* an outbound text frame, header and payload ready to be written.
+   Event channel broadcasts keep a ref on the shared payload text and only carry their own
+   envelope: the frame is data[0..split) + shared + data[split..len - shared_len) */
+typedef struct verto_msg_s {
+	switch_size_t hlen;
+	switch_size_t len;
+	uint8_t hdr[10];
+	switch_event_channel_payload_t *payload;
+	const char *shared;
+	switch_size_t shared_len;
+	switch_size_t split;
+	char data[];
+} verto_msg_t;
 
 struct jsock_s {
 	ks_socket_t client_socket;
@@ -159,6 +192,23 @@ struct jsock_s {
 	int lost_events;
 	int ready;
 
+	/* set when the connection is to be handed to a reactor once the websocket is up */
+	uint8_t use_reactor;
+	struct verto_reactor_s *reactor;
+	struct jsock_s *rprev;
+	struct jsock_s *rnext;
+	uint8_t rsched;
+	uint32_t rwant;
+	int idle;
+	/* a reactor never blocks on a connection: frames are put together in rbuf/rmsg as the bytes
+	   come in, and what the socket won't take right away waits in wpending for EPOLLOUT */
+	switch_buffer_t *rbuf;
+	switch_buffer_t *rmsg;
+	switch_buffer_t *wpending;
+	/* a speed test upload in progress */
+	int spu_size;
+	switch_time_t spu_start;
+
 	struct jsock_s *next;
 };
 
@@ -337,11 +387,38 @@ struct globals_s {
 
 	switch_log_level_t debug_level;
 
+	int reactor_threads;
+	int reactor_workers;
+	int reactor_running;
+	struct verto_reactor_s *reactors;
+	switch_thread_t **reactor_worker_threads;
+	switch_queue_t *reactor_queue;
+
+	switch_metric_t *connections;
+	switch_metric_t *queued_bytes;
+	switch_metric_t *reactor_dispatches;
+
 };
 
 
 typedef switch_bool_t (*jrpc_func_t)(const char *method, cJSON *params, jsock_t *jsock, cJSON **response);
 
+typedef struct jrpc_method_s {
+	jrpc_func_t func;
+	switch_metric_t *calls;
+	switch_metric_t *usec;
+} jrpc_method_t;
+
+/* one epoll set and the connections it watches */
+typedef struct verto_reactor_s {
+	int epfd;
+	switch_thread_t *thread;
+	switch_mutex_t *mutex;
+	jsock_t *head;
+	jsock_t *graveyard;
+	uint32_t count;
+} verto_reactor_t;
+
 
 void set_log_path(const char *path);
 
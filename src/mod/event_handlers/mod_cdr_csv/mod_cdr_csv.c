@@ -34,11 +34,36 @@ typedef enum {
 	CDR_LEG_B = (1 << 1)
 } cdr_leg_t;
 
+typedef enum {
+	CDR_SYNC_NONE,
+	CDR_SYNC_FLUSH,
+	CDR_SYNC_ROTATE
+} cdr_sync_policy_t;
+
 struct cdr_fd {
 	int fd;
 	char *path;
 	int64_t bytes;
+	/* guards the file itself: fd, bytes and rotation */
 	switch_mutex_t *mutex;
+
+	/* async-write: records are appended to buf under buf_mutex and the writer thread
+	   swaps it with spare and writes it out in one go (mutex before buf_mutex) */
+	switch_mutex_t *buf_mutex;
+	char *buf;
+	char *spare;
+	switch_size_t len;
+	switch_time_t last_flush;
+
+	uint64_t records;
+	uint64_t written;
+	uint64_t flushes;
+	uint64_t overflows;
+	uint64_t rate_written;
+	switch_time_t rate_start;
+	uint32_t bytes_per_sec;
+
+	struct cdr_fd *next;
 };
 typedef struct cdr_fd cdr_fd_t;
 
@@ -58,6 +83,20 @@ static struct {
 	int rotate;
 	int debug;
 	cdr_leg_t legs;
+
+	int async_write;
+	switch_size_t buffer_size;
+	switch_size_t flush_bytes;
+	uint32_t flush_interval_ms;
+	cdr_sync_policy_t sync_policy;
+	char *compress_command;
+
+	cdr_fd_t *fd_list;
+	switch_thread_t *writer_thread;
+	switch_mutex_t *writer_mutex;
+	switch_thread_cond_t *writer_cond;
+	int writer_running;
+	int writer_wanted;
 } globals;
 
 SWITCH_MODULE_LOAD_FUNCTION(mod_cdr_csv_load);
@@ -71,6 +110,20 @@ static off_t fd_size(int fd)
 	return s.st_size;
 }
 
+static void do_sync(cdr_fd_t *fd)
+{
+	if (fd->fd < 0) {
+		return;
+	}
+#if defined(_MSC_VER)
+	_commit(fd->fd);
+#elif defined(__linux__)
+	fdatasync(fd->fd);
+#else
+	fsync(fd->fd);
+#endif
+}
+
 static void do_reopen(cdr_fd_t *fd)
 {
 	int x = 0;
@@ -100,6 +153,10 @@ static void do_rotate(cdr_fd_t *fd)
 	switch_size_t retsize;
 	char *p;
 
+	if (globals.sync_policy == CDR_SYNC_ROTATE) {
+		do_sync(fd);
+	}
+
 	close(fd->fd);
 	fd->fd = -1;
 
@@ -111,6 +168,15 @@ static void do_rotate(cdr_fd_t *fd)
 		p = switch_mprintf("%s.%s", fd->path, date);
 		assert(p);
 		switch_file_rename(fd->path, p, globals.pool);
+
+		if (globals.compress_command) {
+			char *cmd = switch_mprintf("%s '%s'", globals.compress_command, p);
+
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Compressing rotated CDR logfile: %s\n", cmd);
+			switch_system(cmd, SWITCH_FALSE);
+			free(cmd);
+		}
+
 		free(p);
 	}
 
@@ -129,11 +195,134 @@ static void do_rotate(cdr_fd_t *fd)
 
 }
 
+/* call with fd->mutex held */
+static void write_fd(cdr_fd_t *fd, const char *data, switch_size_t bytes_out)
+{
+	switch_ssize_t bytes_in;
+	int loops = 0;
+
+	if (fd->fd < 0) {
+		do_reopen(fd);
+		if (fd->fd < 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error opening %s\n", fd->path);
+			return;
+		}
+	}
+
+	if (fd->bytes + bytes_out > UINT_MAX) {
+		do_rotate(fd);
+	}
+
+	while (bytes_out > 0) {
+		if ((bytes_in = write(fd->fd, data, (unsigned) bytes_out)) > 0) {
+			fd->bytes += bytes_in;
+			fd->written += bytes_in;
+			data += bytes_in;
+			bytes_out -= bytes_in;
+			continue;
+		}
+
+		if (++loops >= 10) {
+			break;
+		}
+
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Write error to file %s %d/%d\n", fd->path, (int) bytes_in, (int) bytes_out);
+		do_rotate(fd);
+		switch_yield(250000);
+	}
+}
+
+/* call with fd->mutex held, writes out everything buffered so far as one group */
+static void flush_fd(cdr_fd_t *fd)
+{
+	char *data;
+	switch_size_t len;
+	switch_time_t now = switch_micro_time_now();
+
+	switch_mutex_lock(fd->buf_mutex);
+	data = fd->buf;
+	len = fd->len;
+	fd->buf = fd->spare;
+	fd->spare = data;
+	fd->len = 0;
+	switch_mutex_unlock(fd->buf_mutex);
+
+	fd->last_flush = now;
+
+	if (len) {
+		write_fd(fd, data, len);
+		fd->flushes++;
+
+		if (globals.sync_policy == CDR_SYNC_FLUSH) {
+			do_sync(fd);
+		}
+	}
+
+	if (now - fd->rate_start >= 1000000) {
+		if (fd->rate_start) {
+			fd->bytes_per_sec = (uint32_t) ((fd->written - fd->rate_written) * 1000000 / (now - fd->rate_start));
+		}
+		fd->rate_written = fd->written;
+		fd->rate_start = now;
+	}
+}
+
+static void wake_writer(void)
+{
+	switch_mutex_lock(globals.writer_mutex);
+	globals.writer_wanted = 1;
+	switch_thread_cond_signal(globals.writer_cond);
+	switch_mutex_unlock(globals.writer_mutex);
+}
+
+static void flush_all(switch_bool_t force)
+{
+	cdr_fd_t *fd, *head;
+	switch_time_t now = switch_micro_time_now();
+	switch_time_t interval = (switch_time_t) globals.flush_interval_ms * 1000;
+
+	/* nodes are only ever prepended and live as long as the module so the list can be walked unlocked */
+	switch_mutex_lock(globals.mutex);
+	head = globals.fd_list;
+	switch_mutex_unlock(globals.mutex);
+
+	for (fd = head; fd; fd = fd->next) {
+		if (force || fd->len >= globals.flush_bytes || (fd->len && now - fd->last_flush >= interval)) {
+			switch_mutex_lock(fd->mutex);
+			flush_fd(fd);
+			switch_mutex_unlock(fd->mutex);
+		}
+	}
+}
+
+static void *SWITCH_THREAD_FUNC writer_thread_run(switch_thread_t *thread, void *obj)
+{
+	switch_mutex_lock(globals.writer_mutex);
+
+	while (globals.writer_running) {
+		if (!globals.writer_wanted) {
+			switch_thread_cond_timedwait(globals.writer_cond, globals.writer_mutex, (switch_interval_time_t) globals.flush_interval_ms * 1000);
+		}
+		globals.writer_wanted = 0;
+		switch_mutex_unlock(globals.writer_mutex);
+
+		flush_all(SWITCH_FALSE);
+
+		switch_mutex_lock(globals.writer_mutex);
+	}
+
+	switch_mutex_unlock(globals.writer_mutex);
+
+	flush_all(SWITCH_TRUE);
+
+	return NULL;
+}
+
 static void write_cdr(const char *path, const char *log_line)
 {
 	cdr_fd_t *fd = NULL;
-	unsigned int bytes_in, bytes_out;
-	int loops = 0;
+	switch_size_t bytes_out;
+	int wake = 0;
 
 	switch_mutex_lock(globals.mutex);
 	if (!(fd = switch_core_hash_find(globals.fd_hash, path))) {
@@ -142,38 +331,49 @@ static void write_cdr(const char *path, const char *log_line)
 		memset(fd, 0, sizeof(*fd));
 		fd->fd = -1;
 		switch_mutex_init(&fd->mutex, SWITCH_MUTEX_NESTED, globals.pool);
+		switch_mutex_init(&fd->buf_mutex, SWITCH_MUTEX_NESTED, globals.pool);
 		fd->path = switch_core_strdup(globals.pool, path);
+		if (globals.async_write) {
+			fd->buf = switch_core_alloc(globals.pool, globals.buffer_size);
+			fd->spare = switch_core_alloc(globals.pool, globals.buffer_size);
+		}
+		fd->last_flush = switch_micro_time_now();
 		switch_core_hash_insert(globals.fd_hash, path, fd);
+		fd->next = globals.fd_list;
+		globals.fd_list = fd;
 	}
 	switch_mutex_unlock(globals.mutex);
 
-	switch_mutex_lock(fd->mutex);
-	bytes_out = (unsigned) strlen(log_line);
-
-	if (fd->fd < 0) {
-		do_reopen(fd);
-		if (fd->fd < 0) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error opening %s\n", path);
-			goto end;
-		}
-	}
+	bytes_out = strlen(log_line);
 
-	if (fd->bytes + bytes_out > UINT_MAX) {
-		do_rotate(fd);
-	}
+	if (fd->buf) {
+		switch_mutex_lock(fd->buf_mutex);
+		fd->records++;
+		if (fd->len + bytes_out <= globals.buffer_size) {
+			memcpy(fd->buf + fd->len, log_line, bytes_out);
+			fd->len += bytes_out;
+			wake = fd->len >= globals.flush_bytes;
+			switch_mutex_unlock(fd->buf_mutex);
 
-	while ((bytes_in = write(fd->fd, log_line, bytes_out)) != bytes_out && ++loops < 10) {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Write error to file %s %d/%d\n", path, (int) bytes_in, (int) bytes_out);
-		do_rotate(fd);
-		switch_yield(250000);
-	}
+			if (wake) {
+				wake_writer();
+			}
+			return;
+		}
+		switch_mutex_unlock(fd->buf_mutex);
 
-	if (bytes_in > 0) {
-		fd->bytes += bytes_in;
+		/* the writer has fallen behind, rather than lose the record write it out ourselves */
+		switch_mutex_lock(fd->mutex);
+		fd->overflows++;
+		flush_fd(fd);
+		write_fd(fd, log_line, bytes_out);
+		switch_mutex_unlock(fd->mutex);
+		return;
 	}
 
-  end:
-
+	switch_mutex_lock(fd->mutex);
+	fd->records++;
+	write_fd(fd, log_line, bytes_out);
 	switch_mutex_unlock(fd->mutex);
 }
 
@@ -287,6 +487,9 @@ static void do_rotate_all()
 		switch_core_hash_this(hi, NULL, NULL, &val);
 		fd = (cdr_fd_t *) val;
 		switch_mutex_lock(fd->mutex);
+		if (fd->buf) {
+			flush_fd(fd);
+		}
 		do_rotate(fd);
 		switch_mutex_unlock(fd->mutex);
 	}
@@ -304,7 +507,13 @@ static void do_teardown()
 		switch_core_hash_this(hi, NULL, NULL, &val);
 		fd = (cdr_fd_t *) val;
 		switch_mutex_lock(fd->mutex);
+		if (fd->buf) {
+			flush_fd(fd);
+		}
 		if (fd->fd > -1) {
+			if (globals.sync_policy != CDR_SYNC_NONE) {
+				do_sync(fd);
+			}
 			close(fd->fd);
 			fd->fd = -1;
 		}
@@ -324,14 +533,46 @@ static void event_handler(switch_event_t *event)
 }
 
 
+static void do_status(switch_stream_handle_t *stream)
+{
+	cdr_fd_t *fd, *head;
+	uint64_t backlog = 0, bytes_per_sec = 0;
+
+	switch_mutex_lock(globals.mutex);
+	head = globals.fd_list;
+	switch_mutex_unlock(globals.mutex);
+
+	stream->write_function(stream, "mode: %s\n", globals.async_write ? "async" : "sync");
+	stream->write_function(stream, "%-40s %10s %10s %14s %10s %10s %10s\n", "file", "records", "backlog", "written", "bytes/sec", "flushes", "overflows");
+
+	for (fd = head; fd; fd = fd->next) {
+		stream->write_function(stream, "%-40s %10" SWITCH_UINT64_T_FMT " %10" SWITCH_SIZE_T_FMT " %14" SWITCH_UINT64_T_FMT " %10u %10" SWITCH_UINT64_T_FMT " %10" SWITCH_UINT64_T_FMT "\n",
+							   fd->path, fd->records, fd->len, fd->written, fd->bytes_per_sec, fd->flushes, fd->overflows);
+		backlog += fd->len;
+		bytes_per_sec += fd->bytes_per_sec;
+	}
+
+	stream->write_function(stream, "total backlog: %" SWITCH_UINT64_T_FMT " bytes, %" SWITCH_UINT64_T_FMT " bytes/sec\n", backlog, bytes_per_sec);
+}
+
 SWITCH_STANDARD_API(cdr_csv_function)
 {
+	if (zstr(cmd)) {
+		stream->write_function(stream, "-USAGE: rotate|status\n");
+		return SWITCH_STATUS_SUCCESS;
+	}
+
 	if (!strcmp(cmd, "rotate")) {
 		do_rotate_all();
 		stream->write_function(stream, "+OK");
 		return SWITCH_STATUS_SUCCESS;
 	}
 
+	if (!strcmp(cmd, "status")) {
+		do_status(stream);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
 	return SWITCH_STATUS_FALSE;
 }
 
@@ -367,6 +608,9 @@ static switch_status_t load_config(switch_memory_pool_t *pool)
 	switch_core_hash_insert(globals.template_hash, "default", default_template);
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Adding default template.\n");
 	globals.legs = CDR_LEG_A;
+	globals.buffer_size = 256 * 1024;
+	globals.flush_bytes = 64 * 1024;
+	globals.flush_interval_ms = 1000;
 
 	if ((xml = switch_xml_open_cfg(cf, &cfg, NULL))) {
 
@@ -394,6 +638,35 @@ static switch_status_t load_config(switch_memory_pool_t *pool)
 					globals.default_template = switch_core_strdup(pool, val);
 				} else if (!strcasecmp(var, "master-file-only")) {
 					globals.masterfileonly = switch_true(val);
+				} else if (!strcasecmp(var, "async-write")) {
+					globals.async_write = switch_true(val);
+				} else if (!strcasecmp(var, "buffer-size")) {
+					int tmp = atoi(val);
+					if (tmp >= 4096) {
+						globals.buffer_size = tmp;
+					}
+				} else if (!strcasecmp(var, "flush-bytes")) {
+					int tmp = atoi(val);
+					if (tmp > 0) {
+						globals.flush_bytes = tmp;
+					}
+				} else if (!strcasecmp(var, "flush-interval-ms")) {
+					int tmp = atoi(val);
+					if (tmp >= 10) {
+						globals.flush_interval_ms = tmp;
+					}
+				} else if (!strcasecmp(var, "fsync")) {
+					if (!strcasecmp(val, "flush")) {
+						globals.sync_policy = CDR_SYNC_FLUSH;
+					} else if (!strcasecmp(val, "rotate")) {
+						globals.sync_policy = CDR_SYNC_ROTATE;
+					} else {
+						globals.sync_policy = CDR_SYNC_NONE;
+					}
+				} else if (!strcasecmp(var, "compress-rotated-command")) {
+					if (!zstr(val)) {
+						globals.compress_command = switch_core_strdup(pool, val);
+					}
 				}
 			}
 		}
@@ -428,6 +701,10 @@ static switch_status_t load_config(switch_memory_pool_t *pool)
 		globals.log_dir = switch_core_sprintf(pool, "%s%scdr-csv", SWITCH_GLOBAL_dirs.log_dir, SWITCH_PATH_SEPARATOR);
 	}
 
+	if (globals.flush_bytes > globals.buffer_size) {
+		globals.flush_bytes = globals.buffer_size / 2;
+	}
+
 	return status;
 }
 
@@ -441,6 +718,18 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_cdr_csv_load)
 
 	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, globals.pool);
 
+	if (globals.async_write) {
+		switch_threadattr_t *thd_attr = NULL;
+
+		switch_mutex_init(&globals.writer_mutex, SWITCH_MUTEX_NESTED, globals.pool);
+		switch_thread_cond_create(&globals.writer_cond, globals.pool);
+		globals.writer_running = 1;
+
+		switch_threadattr_create(&thd_attr, globals.pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_thread_create(&globals.writer_thread, thd_attr, writer_thread_run, NULL, globals.pool);
+	}
+
 	if ((status = switch_dir_make_recursive(globals.log_dir, SWITCH_DEFAULT_DIR_PERMS, pool)) != SWITCH_STATUS_SUCCESS) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error creating %s\n", globals.log_dir);
 		return status;
@@ -456,6 +745,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_cdr_csv_load)
 
 	SWITCH_ADD_API(api_interface, "cdr_csv", "cdr_csv controls", cdr_csv_function, "parameters");
 	switch_console_set_complete("add cdr_csv rotate");
+	switch_console_set_complete("add cdr_csv status");
 
 	return status;
 }
@@ -469,6 +759,18 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_cdr_csv_shutdown)
 	switch_event_unbind_callback(event_handler);
 	switch_core_remove_state_handler(&state_handlers);
 
+	if (globals.writer_thread) {
+		switch_status_t st;
+
+		switch_mutex_lock(globals.writer_mutex);
+		globals.writer_running = 0;
+		switch_thread_cond_signal(globals.writer_cond);
+		switch_mutex_unlock(globals.writer_mutex);
+
+		switch_thread_join(&st, globals.writer_thread);
+		globals.writer_thread = NULL;
+	}
+
 	do_teardown();
 	switch_core_hash_destroy(&globals.fd_hash);
 	switch_core_hash_destroy(&globals.template_hash);
@@ -73,6 +73,12 @@ typedef struct {
 	cdr_field_t fields[1];
 } db_schema_t;
 
+/* one queued CDR when batching, the row as an INSERT value list and as a COPY text line */
+typedef struct {
+	char *values;
+	char *copy;
+} cdr_row_t;
+
 static struct {
 	switch_memory_pool_t *pool;
 	switch_hash_t *fd_hash;
@@ -88,6 +94,24 @@ static struct {
 	spool_format_t spool_format;
 	int rotate;
 	int debug;
+
+	int batch_size;
+	int batch_latency_ms;
+	int queue_size;
+	switch_queue_t *queue;
+	switch_thread_t *batch_thread;
+	int batch_running;
+
+	switch_mutex_t *mutex;
+	uint64_t rows_copied;
+	uint64_t rows_inserted;
+	uint64_t rows_spooled;
+	uint64_t rows_backpressure;
+	uint64_t batches;
+	uint32_t batch_max;
+	uint64_t rate_rows;
+	switch_time_t rate_start;
+	uint32_t rows_per_sec;
 } globals;
 
 static switch_xml_config_enum_item_t config_opt_cdr_leg_enum[] = {
@@ -122,6 +146,9 @@ static switch_xml_config_item_t config_settings[] = {
 	SWITCH_CONFIG_ITEM("spool-format", SWITCH_CONFIG_ENUM, CONFIG_RELOADABLE, &globals.spool_format, (void *) SPOOL_FORMAT_CSV, &config_opt_spool_format_enum, "csv|sql", "Disk spool format to use if SQL insert fails."),
 	SWITCH_CONFIG_ITEM("rotate-on-hup", SWITCH_CONFIG_BOOL, CONFIG_RELOADABLE, &globals.rotate, SWITCH_FALSE, NULL, NULL, NULL),
 	SWITCH_CONFIG_ITEM("debug", SWITCH_CONFIG_BOOL, CONFIG_RELOADABLE, &globals.debug, SWITCH_FALSE, NULL, NULL, NULL),
+	SWITCH_CONFIG_ITEM("batch-size", SWITCH_CONFIG_INT, 0, &globals.batch_size, 0, NULL, NULL, "Rows per COPY, 0 inserts synchronously from the hangup."),
+	SWITCH_CONFIG_ITEM("batch-latency-ms", SWITCH_CONFIG_INT, 0, &globals.batch_latency_ms, (void *) 500, NULL, NULL, "Longest a row waits for its batch to fill."),
+	SWITCH_CONFIG_ITEM("queue-size", SWITCH_CONFIG_INT, 0, &globals.queue_size, (void *) 10000, NULL, NULL, "Rows waiting for the database before new ones are spooled."),
 
 	/* key, type, flags, ptr, defaultvalue, function, functiondata, syntax, helptext */
 	SWITCH_CONFIG_ITEM_CALLBACK("spool-dir", SWITCH_CONFIG_STRING, CONFIG_RELOADABLE, &globals.spool_dir, NULL, config_validate_spool_dir, NULL, NULL, NULL),
@@ -196,6 +223,8 @@ static void spool_cdr(const char *path, const char *log_line)
 	unsigned int bytes_in, bytes_out;
 	int loops = 0;
 
+	switch_mutex_lock(globals.mutex);
+	globals.rows_spooled++;
 	if (!(fd = switch_core_hash_find(globals.fd_hash, path))) {
 		fd = switch_core_alloc(globals.pool, sizeof(*fd));
 		switch_assert(fd);
@@ -205,6 +234,7 @@ static void spool_cdr(const char *path, const char *log_line)
 		fd->path = switch_core_strdup(globals.pool, path);
 		switch_core_hash_insert(globals.fd_hash, path, fd);
 	}
+	switch_mutex_unlock(globals.mutex);
 
 	if (end_of(log_line) != '\n') {
 		log_line_lf = switch_mprintf("%s\n", log_line);
@@ -244,9 +274,46 @@ static void spool_cdr(const char *path, const char *log_line)
 	switch_safe_free(log_line_lf);
 }
 
-static switch_status_t insert_cdr(const char *values)
+/* call with db_mutex held */
+static switch_bool_t db_connect(void)
+{
+	if (!globals.db_online || PQstatus(globals.db_connection) != CONNECTION_OK) {
+		globals.db_connection = PQconnectdb(globals.db_info);
+	}
+
+	if (PQstatus(globals.db_connection) == CONNECTION_OK) {
+		globals.db_online = 1;
+		return SWITCH_TRUE;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Connection to database failed: %s", PQerrorMessage(globals.db_connection));
+
+	return SWITCH_FALSE;
+}
+
+static void spool_values(const char *values)
 {
 	char *sql = NULL, *path = NULL;
+
+	if (globals.spool_format == SPOOL_FORMAT_SQL) {
+		sql = switch_mprintf("INSERT INTO %s (%s) VALUES (%s);", globals.db_table, globals.db_schema->columns, values);
+		assert(sql);
+		path = switch_mprintf("%s%scdr-spool.sql", globals.spool_dir, SWITCH_PATH_SEPARATOR);
+		assert(path);
+		spool_cdr(path, sql);
+	} else {
+		path = switch_mprintf("%s%scdr-spool.csv", globals.spool_dir, SWITCH_PATH_SEPARATOR);
+		assert(path);
+		spool_cdr(path, values);
+	}
+
+	switch_safe_free(path);
+	switch_safe_free(sql);
+}
+
+static switch_status_t insert_cdr(const char *values)
+{
+	char *sql = NULL;
 	PGresult *res;
 
 	sql = switch_mprintf("INSERT INTO %s (%s) VALUES (%s);", globals.db_table, globals.db_schema->columns, values);
@@ -258,14 +325,7 @@ static switch_status_t insert_cdr(const char *values)
 
 	switch_mutex_lock(globals.db_mutex);
 
-	if (!globals.db_online || PQstatus(globals.db_connection) != CONNECTION_OK) {
-		globals.db_connection = PQconnectdb(globals.db_info);
-	}
-
-	if (PQstatus(globals.db_connection) == CONNECTION_OK) {
-		globals.db_online = 1;
-	} else {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Connection to database failed: %s", PQerrorMessage(globals.db_connection));
+	if (!db_connect()) {
 		goto error;
 	}
 
@@ -281,6 +341,10 @@ static switch_status_t insert_cdr(const char *values)
 
 	switch_mutex_unlock(globals.db_mutex);
 
+	switch_mutex_lock(globals.mutex);
+	globals.rows_inserted++;
+	switch_mutex_unlock(globals.mutex);
+
 	return SWITCH_STATUS_SUCCESS;
 
 
@@ -291,20 +355,189 @@ static switch_status_t insert_cdr(const char *values)
 	switch_mutex_unlock(globals.db_mutex);
 
 	/* SQL INSERT failed for whatever reason. Spool the attempted query to disk */
-	if (globals.spool_format == SPOOL_FORMAT_SQL) {
-		path = switch_mprintf("%s%scdr-spool.sql", globals.spool_dir, SWITCH_PATH_SEPARATOR);
-		assert(path);
-		spool_cdr(path, sql);
+	switch_safe_free(sql);
+	spool_values(values);
+
+	return SWITCH_STATUS_FALSE;
+}
+
+static void free_row(cdr_row_t *row)
+{
+	switch_safe_free(row->values);
+	switch_safe_free(row->copy);
+	free(row);
+}
+
+/* send a batch with one COPY, if the server rejects it fall back to one INSERT per row so only the bad rows are spooled */
+static void insert_batch(cdr_row_t **rows, int count)
+{
+	char *sql;
+	PGresult *res;
+	switch_bool_t ok = SWITCH_FALSE;
+	int i;
+
+	switch_mutex_lock(globals.db_mutex);
+
+	if (!db_connect()) {
+		PQfinish(globals.db_connection);
+		globals.db_online = 0;
+		switch_mutex_unlock(globals.db_mutex);
+
+		for (i = 0; i < count; i++) {
+			spool_values(rows[i]->values);
+		}
+
+		return;
+	}
+
+	sql = switch_mprintf("COPY %s (%s) FROM STDIN", globals.db_table, globals.db_schema->columns);
+	assert(sql);
+
+	res = PQexec(globals.db_connection, sql);
+
+	if (PQresultStatus(res) == PGRES_COPY_IN) {
+		PQclear(res);
+
+		for (i = 0; i < count; i++) {
+			if (PQputCopyData(globals.db_connection, rows[i]->copy, (int) strlen(rows[i]->copy)) != 1) {
+				break;
+			}
+		}
+
+		PQputCopyEnd(globals.db_connection, i == count ? NULL : "write failed");
+
+		res = PQgetResult(globals.db_connection);
+		if (PQresultStatus(res) == PGRES_COMMAND_OK) {
+			ok = SWITCH_TRUE;
+		} else {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "COPY of %d rows failed: %s", count, PQresultErrorMessage(res));
+		}
+		PQclear(res);
+
+		while ((res = PQgetResult(globals.db_connection))) {
+			PQclear(res);
+		}
 	} else {
-		path = switch_mprintf("%s%scdr-spool.csv", globals.spool_dir, SWITCH_PATH_SEPARATOR);
-		assert(path);
-		spool_cdr(path, values);
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "COPY command failed: %s", PQresultErrorMessage(res));
+		PQclear(res);
 	}
 
-	switch_safe_free(path);
+	switch_mutex_unlock(globals.db_mutex);
 	switch_safe_free(sql);
 
-	return SWITCH_STATUS_FALSE;
+	if (ok) {
+		switch_mutex_lock(globals.mutex);
+		globals.rows_copied += count;
+		globals.batches++;
+		if ((uint32_t) count > globals.batch_max) {
+			globals.batch_max = count;
+		}
+		switch_mutex_unlock(globals.mutex);
+	} else {
+		for (i = 0; i < count; i++) {
+			insert_cdr(rows[i]->values);
+		}
+	}
+}
+
+static void update_rate(void)
+{
+	switch_time_t now = switch_micro_time_now();
+	uint64_t rows;
+
+	switch_mutex_lock(globals.mutex);
+	if (now - globals.rate_start >= 1000000) {
+		rows = globals.rows_copied + globals.rows_inserted;
+		if (globals.rate_start) {
+			globals.rows_per_sec = (uint32_t) ((rows - globals.rate_rows) * 1000000 / (now - globals.rate_start));
+		}
+		globals.rate_rows = rows;
+		globals.rate_start = now;
+	}
+	switch_mutex_unlock(globals.mutex);
+}
+
+static void *SWITCH_THREAD_FUNC batch_thread_run(switch_thread_t *thread, void *obj)
+{
+	cdr_row_t **rows;
+	void *pop;
+	int count, i;
+
+	switch_zmalloc(rows, sizeof(*rows) * globals.batch_size);
+
+	while (globals.batch_running || switch_queue_size(globals.queue)) {
+		switch_time_t deadline, now;
+
+		update_rate();
+
+		if (switch_queue_pop_timeout(globals.queue, &pop, 1000000) != SWITCH_STATUS_SUCCESS || !pop) {
+			continue;
+		}
+
+		count = 0;
+		rows[count++] = (cdr_row_t *) pop;
+		deadline = switch_micro_time_now() + (switch_time_t) globals.batch_latency_ms * 1000;
+
+		while (count < globals.batch_size && (now = switch_micro_time_now()) < deadline) {
+			if (switch_queue_pop_timeout(globals.queue, &pop, deadline - now) != SWITCH_STATUS_SUCCESS || !pop) {
+				break;
+			}
+			rows[count++] = (cdr_row_t *) pop;
+		}
+
+		insert_batch(rows, count);
+
+		for (i = 0; i < count; i++) {
+			free_row(rows[i]);
+		}
+	}
+
+	free(rows);
+
+	return NULL;
+}
+
+/* the row in COPY text format: tab separated, \N for null and backslash escapes */
+static void copy_append(switch_stream_handle_t *stream, const char *var, switch_bool_t first, switch_bool_t null)
+{
+	const char *p, *run;
+
+	if (!first) {
+		stream->write_function(stream, "\t");
+	}
+
+	if (null) {
+		stream->write_function(stream, "\\N");
+		return;
+	}
+
+	for (p = run = var; p && *p; p++) {
+		const char *esc;
+
+		switch (*p) {
+		case '\\':
+			esc = "\\\\";
+			break;
+		case '\t':
+			esc = "\\t";
+			break;
+		case '\n':
+			esc = "\\n";
+			break;
+		case '\r':
+			esc = "\\r";
+			break;
+		default:
+			continue;
+		}
+
+		stream->write_function(stream, "%.*s%s", (int) (p - run), run, esc);
+		run = p + 1;
+	}
+
+	if (run && *run) {
+		stream->write_function(stream, "%s", run);
+	}
 }
 
 static switch_status_t my_on_reporting(switch_core_session_t *session)
@@ -315,6 +548,7 @@ static switch_status_t my_on_reporting(switch_core_session_t *session)
 	const char *var = NULL;
 	cdr_field_t *cdr_field = NULL;
 	switch_size_t len, offset;
+	switch_stream_handle_t copy = { 0 };
 
 	if (globals.shutdown) {
 		return SWITCH_STATUS_SUCCESS;
@@ -353,8 +587,18 @@ static switch_status_t my_on_reporting(switch_core_session_t *session)
 	switch_zmalloc(values, 1);
 	offset = 0;
 
+	if (globals.queue) {
+		SWITCH_STANDARD_STREAM(copy);
+	}
+
 	for (cdr_field = globals.db_schema->fields; cdr_field->var_name; cdr_field++) {
-		if ((var = switch_channel_get_variable(channel, cdr_field->var_name))) {
+		var = switch_channel_get_variable(channel, cdr_field->var_name);
+
+		if (globals.queue) {
+			copy_append(&copy, var, cdr_field == globals.db_schema->fields, (cdr_field->not_null == SWITCH_FALSE) && zstr(var));
+		}
+
+		if (var) {
 			/* Allocate sufficient buffer for PQescapeString */
 			len = strlen(var);
 			tmp = switch_core_session_alloc(session, len * 2 + 1);
@@ -382,6 +626,28 @@ static switch_status_t my_on_reporting(switch_core_session_t *session)
 	}
 	*(values + --offset) = '\0';
 
+	if (globals.queue) {
+		cdr_row_t *row;
+
+		copy.write_function(&copy, "\n");
+
+		switch_zmalloc(row, sizeof(*row));
+		row->values = values;
+		row->copy = (char *) copy.data;
+
+		if (switch_queue_trypush(globals.queue, row) != SWITCH_STATUS_SUCCESS) {
+			/* the database is not keeping up, don't hold up the hangup */
+			switch_mutex_lock(globals.mutex);
+			globals.rows_backpressure++;
+			switch_mutex_unlock(globals.mutex);
+
+			spool_values(values);
+			free_row(row);
+		}
+
+		return status;
+	}
+
 	insert_cdr(values);
 	switch_safe_free(values);
 
@@ -416,6 +682,42 @@ static void event_handler(switch_event_t *event)
 }
 
 
+SWITCH_STANDARD_API(cdr_pg_csv_function)
+{
+	switch_hash_index_t *hi;
+	void *val;
+	cdr_fd_t *fd;
+	int64_t spool_bytes = 0;
+
+	if (zstr(cmd) || strcmp(cmd, "status")) {
+		stream->write_function(stream, "-USAGE: status\n");
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_lock(globals.mutex);
+	for (hi = switch_core_hash_first(globals.fd_hash); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		fd = (cdr_fd_t *) val;
+		spool_bytes += fd->bytes;
+	}
+
+	stream->write_function(stream, "mode: %s\n", globals.queue ? "batch" : "sync");
+	stream->write_function(stream, "db: %s\n", globals.db_online ? "online" : "offline");
+	stream->write_function(stream, "rows/sec: %u\n", globals.rows_per_sec);
+	stream->write_function(stream, "rows copied: %" SWITCH_UINT64_T_FMT "\n", globals.rows_copied);
+	stream->write_function(stream, "rows inserted: %" SWITCH_UINT64_T_FMT "\n", globals.rows_inserted);
+	stream->write_function(stream, "rows spooled: %" SWITCH_UINT64_T_FMT " (%" SWITCH_UINT64_T_FMT " on backpressure)\n",
+						   globals.rows_spooled, globals.rows_backpressure);
+	stream->write_function(stream, "batches: %" SWITCH_UINT64_T_FMT ", avg %.1f rows, max %u rows\n", globals.batches,
+						   globals.batches ? (double) globals.rows_copied / globals.batches : 0.0, globals.batch_max);
+	stream->write_function(stream, "queue depth: %u\n", globals.queue ? switch_queue_size(globals.queue) : 0);
+	stream->write_function(stream, "spool depth: %" SWITCH_INT64_T_FMT " bytes\n", spool_bytes);
+	switch_mutex_unlock(globals.mutex);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+
 static switch_state_handler_table_t state_handlers = {
 	/*.on_init */ NULL,
 	/*.on_routing */ NULL,
@@ -450,6 +752,7 @@ static switch_status_t load_config(switch_memory_pool_t *pool)
 	memset(&globals, 0, sizeof(globals));
 	switch_core_hash_init(&globals.fd_hash);
 	switch_mutex_init(&globals.db_mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, pool);
 
 	globals.pool = pool;
 
@@ -522,6 +825,7 @@ static switch_status_t load_config(switch_memory_pool_t *pool)
 SWITCH_MODULE_LOAD_FUNCTION(mod_cdr_pg_csv_load)
 {
 	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	switch_api_interface_t *api_interface;
 
 	load_config(pool);
 
@@ -535,9 +839,31 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_cdr_pg_csv_load)
 		return status;
 	}
 
+	if (globals.batch_size > 0) {
+		switch_threadattr_t *thd_attr = NULL;
+
+		if (globals.batch_latency_ms < 1) {
+			globals.batch_latency_ms = 1;
+		}
+
+		if (globals.queue_size < globals.batch_size) {
+			globals.queue_size = globals.batch_size;
+		}
+
+		switch_queue_create(&globals.queue, globals.queue_size, pool);
+		globals.batch_running = 1;
+
+		switch_threadattr_create(&thd_attr, pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_thread_create(&globals.batch_thread, thd_attr, batch_thread_run, NULL, pool);
+	}
+
 	switch_core_add_state_handler(&state_handlers);
 	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
 
+	SWITCH_ADD_API(api_interface, "cdr_pg_csv", "cdr_pg_csv status", cdr_pg_csv_function, "status");
+	switch_console_set_complete("add cdr_pg_csv status");
+
 	return status;
 }
 
@@ -547,13 +873,25 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_cdr_pg_csv_shutdown)
 
 	globals.shutdown = 1;
 
+	switch_console_set_complete("del cdr_pg_csv");
+	switch_core_remove_state_handler(&state_handlers);
+
+	if (globals.batch_thread) {
+		switch_status_t st;
+
+		/* the thread drains what is still queued before it exits */
+		globals.batch_running = 0;
+		switch_queue_trypush(globals.queue, NULL);
+		switch_thread_join(&st, globals.batch_thread);
+		globals.batch_thread = NULL;
+	}
+
 	if (globals.db_online) {
 		PQfinish(globals.db_connection);
 		globals.db_online = 0;
 	}
 
 	switch_event_unbind_callback(event_handler);
-	switch_core_remove_state_handler(&state_handlers);
 
 	switch_core_hash_destroy(&globals.fd_hash);
 
@@ -601,6 +601,23 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_event_socket_shutdown)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+/* let the core skip log lines that no listener is going to take */
+static void update_log_level_hint(void)
+{
+	listener_t *l;
+	int max = SWITCH_LOG_DISABLE;
+
+	switch_mutex_lock(globals.listener_mutex);
+	for (l = listen_list.listeners; l; l = l->next) {
+		if (switch_test_flag(l, LFLAG_LOG) && (int) l->level > max) {
+			max = l->level;
+		}
+	}
+	switch_mutex_unlock(globals.listener_mutex);
+
+	switch_log_set_logger_level_hint(socket_logger, (switch_log_level_t) max);
+}
+
 static void add_listener(listener_t *listener)
 {
 	/* add me to the listeners so I get events */
@@ -608,6 +625,8 @@ static void add_listener(listener_t *listener)
 	listener->next = listen_list.listeners;
 	listen_list.listeners = listener;
 	switch_mutex_unlock(globals.listener_mutex);
+
+	update_log_level_hint();
 }
 
 static void remove_listener(listener_t *listener)
@@ -626,6 +645,8 @@ static void remove_listener(listener_t *listener)
 		last = l;
 	}
 	switch_mutex_unlock(globals.listener_mutex);
+
+	update_log_level_hint();
 }
 
 static void send_disconnect(listener_t *listener, const char *message)
@@ -825,6 +846,7 @@ SWITCH_STANDARD_API(event_sink_function)
 
 		if (switch_test_flag(listener, LFLAG_LOG)) {
 			switch_clear_flag_locked(listener, LFLAG_LOG);
+			update_log_level_hint();
 			stream->write_function(stream, "<data><reply type=\"success\">Not Logging</reply></data>\n");
 		} else {
 			stream->write_function(stream, "<data><reply type=\"error\">Not Logging</reply></data>\n");
@@ -851,6 +873,7 @@ SWITCH_STANDARD_API(event_sink_function)
 			if (ltype != SWITCH_LOG_INVALID) {
 				listener->level = ltype;
 				switch_set_flag(listener, LFLAG_LOG);
+				update_log_level_hint();
 				stream->write_function(stream, "<data><reply type=\"success\">Log Level %s</reply></data>\n", loglevel);
 			} else {
 				stream->write_function(stream, "<data><reply type=\"error\">Invalid Level</reply></data>\n");
@@ -1195,6 +1218,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_event_socket_load)
 	}
 
 	switch_log_bind_logger(socket_logger, SWITCH_LOG_DEBUG, SWITCH_FALSE);
+	update_log_level_hint();
 
 	/* connect my internal structure to the blank pointer passed to me */
 	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
@@ -2418,6 +2442,7 @@ static switch_status_t parse_command(listener_t *listener, switch_event_t **even
 		if (ltype != SWITCH_LOG_INVALID) {
 			listener->level = ltype;
 			switch_set_flag(listener, LFLAG_LOG);
+			update_log_level_hint();
 			switch_snprintf(reply, reply_len, "+OK log level %s [%d]", level_s, listener->level);
 		} else {
 			switch_snprintf(reply, reply_len, "-ERR invalid log level");
@@ -2452,6 +2477,7 @@ static switch_status_t parse_command(listener_t *listener, switch_event_t **even
 		flush_listener(listener, SWITCH_TRUE, SWITCH_FALSE);
 		if (switch_test_flag(listener, LFLAG_LOG)) {
 			switch_clear_flag_locked(listener, LFLAG_LOG);
+			update_log_level_hint();
 			switch_snprintf(reply, reply_len, "+OK no longer logging");
 		} else {
 			switch_snprintf(reply, reply_len, "-ERR not loging");
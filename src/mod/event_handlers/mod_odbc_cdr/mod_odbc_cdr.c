@@ -64,8 +64,33 @@ static struct {
 	uint32_t running;
 	switch_mutex_t *mutex;
 	switch_memory_pool_t *pool;
+
+	uint32_t batch_size;
+	uint32_t batch_latency_ms;
+	uint32_t queue_size;
+	switch_queue_t *queue;
+	switch_thread_t *batch_thread;
+	uint32_t batch_running;
+
+	switch_mutex_t *stats_mutex;
+	uint64_t rows_inserted;
+	uint64_t rows_failed;
+	uint64_t rows_backpressure;
+	uint64_t statements;
+	uint32_t batch_max;
+	uint64_t rate_rows;
+	switch_time_t rate_start;
+	uint32_t rows_per_sec;
 } globals;
 
+/* one queued CDR when batching */
+typedef struct {
+	char *uuid;
+	char *table_name;
+	char *fields;
+	char *values;
+} cdr_row_t;
+
 typedef struct {
 	char *chan_var_name;
 	char *default_value;
@@ -227,6 +252,180 @@ static void write_cdr(const char *path, const char *log_line)
 	}
 }
 
+/* write the csv copy of a row according to write-csv, the fail path is also used to spool rows on backpressure */
+static void finish_row(const char *uuid, const char *table_name, const char *values, switch_bool_t insert_fail, switch_bool_t force_spool)
+{
+	char *full_path = NULL;
+
+	if (insert_fail == SWITCH_TRUE) {
+		switch_mutex_lock(globals.stats_mutex);
+		globals.rows_failed++;
+		switch_mutex_unlock(globals.stats_mutex);
+	}
+
+	if (globals.write_csv == ODBC_CDR_CSV_ALWAYS) {
+		if (insert_fail == SWITCH_TRUE) {
+			full_path = switch_mprintf("%s%s%s_%s.csv", globals.csv_fail_path, SWITCH_PATH_SEPARATOR, uuid, table_name);
+		} else {
+			full_path = switch_mprintf("%s%s%s_%s.csv", globals.csv_path, SWITCH_PATH_SEPARATOR, uuid, table_name);
+		}
+	} else if ((globals.write_csv == ODBC_CDR_CSV_ON_FAIL || force_spool == SWITCH_TRUE) && insert_fail == SWITCH_TRUE) {
+		full_path = switch_mprintf("%s%s%s_%s.csv", globals.csv_fail_path, SWITCH_PATH_SEPARATOR, uuid, table_name);
+	}
+
+	if (full_path) {
+		write_cdr(full_path, values);
+		switch_safe_free(full_path);
+	}
+}
+
+static void free_row(cdr_row_t *row)
+{
+	switch_safe_free(row->uuid);
+	switch_safe_free(row->table_name);
+	switch_safe_free(row->fields);
+	switch_safe_free(row->values);
+	free(row);
+}
+
+/*
+ * Rows for the same table with the same set of columns go out as one multi-row INSERT.
+ * If the database rejects it the rows are retried one by one so only the bad ones fail.
+ */
+static void insert_batch(cdr_row_t **rows, uint32_t count)
+{
+	switch_cache_db_handle_t *dbh = get_db_handle();
+	switch_bool_t *done;
+	uint32_t i, j, n;
+
+	switch_zmalloc(done, sizeof(*done) * count);
+
+	for (i = 0; i < count; i++) {
+		switch_stream_handle_t stream = { 0 };
+		switch_status_t status = SWITCH_STATUS_FALSE;
+
+		if (done[i]) {
+			continue;
+		}
+
+		SWITCH_STANDARD_STREAM(stream);
+		stream.write_function(&stream, "INSERT INTO %q (%s) VALUES (%s)", rows[i]->table_name, rows[i]->fields, rows[i]->values);
+		n = 1;
+
+		for (j = i + 1; j < count; j++) {
+			if (!done[j] && !strcmp(rows[j]->table_name, rows[i]->table_name) && !strcmp(rows[j]->fields, rows[i]->fields)) {
+				stream.write_function(&stream, ", (%s)", rows[j]->values);
+				n++;
+			}
+		}
+
+		if (globals.debug_sql == SWITCH_TRUE) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "sql %s\n", (char *) stream.data);
+		}
+
+		if (dbh) {
+			status = switch_cache_db_execute_sql(dbh, (char *) stream.data, NULL);
+		}
+
+		switch_safe_free(stream.data);
+
+		if (status == SWITCH_STATUS_SUCCESS) {
+			switch_mutex_lock(globals.stats_mutex);
+			globals.rows_inserted += n;
+			globals.statements++;
+			if (n > globals.batch_max) {
+				globals.batch_max = n;
+			}
+			switch_mutex_unlock(globals.stats_mutex);
+		}
+
+		for (j = i; j < count; j++) {
+			if (done[j] || strcmp(rows[j]->table_name, rows[i]->table_name) || strcmp(rows[j]->fields, rows[i]->fields)) {
+				continue;
+			}
+
+			done[j] = SWITCH_TRUE;
+
+			if (status != SWITCH_STATUS_SUCCESS && n > 1 && dbh) {
+				char *sql = switch_mprintf("INSERT INTO %q (%s) VALUES (%s)", rows[j]->table_name, rows[j]->fields, rows[j]->values);
+
+				if (switch_cache_db_execute_sql(dbh, sql, NULL) == SWITCH_STATUS_SUCCESS) {
+					switch_mutex_lock(globals.stats_mutex);
+					globals.rows_inserted++;
+					globals.statements++;
+					switch_mutex_unlock(globals.stats_mutex);
+					finish_row(rows[j]->uuid, rows[j]->table_name, rows[j]->values, SWITCH_FALSE, SWITCH_FALSE);
+				} else {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error executing query %s\n", sql);
+					finish_row(rows[j]->uuid, rows[j]->table_name, rows[j]->values, SWITCH_TRUE, SWITCH_TRUE);
+				}
+
+				switch_safe_free(sql);
+			} else {
+				finish_row(rows[j]->uuid, rows[j]->table_name, rows[j]->values, status != SWITCH_STATUS_SUCCESS, SWITCH_TRUE);
+			}
+		}
+	}
+
+	switch_cache_db_release_db_handle(&dbh);
+	free(done);
+}
+
+static void update_rate(void)
+{
+	switch_time_t now = switch_micro_time_now();
+
+	switch_mutex_lock(globals.stats_mutex);
+	if (now - globals.rate_start >= 1000000) {
+		if (globals.rate_start) {
+			globals.rows_per_sec = (uint32_t) ((globals.rows_inserted - globals.rate_rows) * 1000000 / (now - globals.rate_start));
+		}
+		globals.rate_rows = globals.rows_inserted;
+		globals.rate_start = now;
+	}
+	switch_mutex_unlock(globals.stats_mutex);
+}
+
+static void *SWITCH_THREAD_FUNC batch_thread_run(switch_thread_t *thread, void *obj)
+{
+	cdr_row_t **rows;
+	void *pop;
+	uint32_t count, i;
+
+	switch_zmalloc(rows, sizeof(*rows) * globals.batch_size);
+
+	while (globals.batch_running || switch_queue_size(globals.queue)) {
+		switch_time_t deadline, now;
+
+		update_rate();
+
+		if (switch_queue_pop_timeout(globals.queue, &pop, 1000000) != SWITCH_STATUS_SUCCESS || !pop) {
+			continue;
+		}
+
+		count = 0;
+		rows[count++] = (cdr_row_t *) pop;
+		deadline = switch_micro_time_now() + (switch_time_t) globals.batch_latency_ms * 1000;
+
+		while (count < globals.batch_size && (now = switch_micro_time_now()) < deadline) {
+			if (switch_queue_pop_timeout(globals.queue, &pop, deadline - now) != SWITCH_STATUS_SUCCESS || !pop) {
+				break;
+			}
+			rows[count++] = (cdr_row_t *) pop;
+		}
+
+		insert_batch(rows, count);
+
+		for (i = 0; i < count; i++) {
+			free_row(rows[i]);
+		}
+	}
+
+	free(rows);
+
+	return NULL;
+}
+
 static switch_status_t odbc_cdr_reporting(switch_core_session_t *session)
 {
 	switch_channel_t *channel = switch_core_session_get_channel(session);
@@ -300,7 +499,6 @@ static switch_status_t odbc_cdr_reporting(switch_core_session_t *session)
 				char *field_hash_key;
 				cdr_field_t *field_hash_val;
 				char *sql = NULL;
-				char *full_path = NULL;
 				switch_stream_handle_t stream_field = { 0 };
 				switch_stream_handle_t stream_value = { 0 };
 				switch_bool_t insert_fail = SWITCH_FALSE;
@@ -339,6 +537,28 @@ static switch_status_t odbc_cdr_reporting(switch_core_session_t *session)
 				}
 				switch_safe_free(i_hi);
 
+				if (globals.queue) {
+					cdr_row_t *row;
+
+					switch_zmalloc(row, sizeof(*row));
+					row->uuid = strdup(uuid);
+					row->table_name = strdup(table_name);
+					row->fields = (char *) stream_field.data;
+					row->values = (char *) stream_value.data;
+
+					if (switch_queue_trypush(globals.queue, row) != SWITCH_STATUS_SUCCESS) {
+						/* the database is not keeping up, spool the row rather than hold up the hangup */
+						switch_mutex_lock(globals.stats_mutex);
+						globals.rows_backpressure++;
+						switch_mutex_unlock(globals.stats_mutex);
+
+						finish_row(uuid, table_name, row->values, SWITCH_TRUE, SWITCH_TRUE);
+						free_row(row);
+					}
+
+					continue;
+				}
+
 				sql = switch_mprintf("INSERT INTO %q (%s) VALUES (%s)", table_name, stream_field.data, stream_value.data);
 				if (globals.debug_sql == SWITCH_TRUE) {
 					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "sql %s\n", sql);
@@ -346,23 +566,14 @@ static switch_status_t odbc_cdr_reporting(switch_core_session_t *session)
 				if (odbc_cdr_execute_sql_no_callback(sql) != SWITCH_STATUS_SUCCESS) {
 					insert_fail = SWITCH_TRUE;
 					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Error executing query %s\n", sql);
+				} else {
+					switch_mutex_lock(globals.stats_mutex);
+					globals.rows_inserted++;
+					globals.statements++;
+					switch_mutex_unlock(globals.stats_mutex);
 				}
 
-				if (globals.write_csv == ODBC_CDR_CSV_ALWAYS) {
-					if (insert_fail == SWITCH_TRUE) {
-						full_path = switch_mprintf("%s%s%s_%s.csv", globals.csv_fail_path, SWITCH_PATH_SEPARATOR, uuid, table_name);
-					} else {
-						full_path = switch_mprintf("%s%s%s_%s.csv", globals.csv_path, SWITCH_PATH_SEPARATOR, uuid, table_name);
-					}
-					assert(full_path);
-					write_cdr(full_path, stream_value.data);
-					switch_safe_free(full_path);
-				} else if (globals.write_csv == ODBC_CDR_CSV_ON_FAIL && insert_fail == SWITCH_TRUE) {
-					full_path = switch_mprintf("%s%s%s_%s.csv", globals.csv_fail_path, SWITCH_PATH_SEPARATOR, uuid, table_name);
-					assert(full_path);
-					write_cdr(full_path, stream_value.data);
-					switch_safe_free(full_path);
-				}
+				finish_row(uuid, table_name, stream_value.data, insert_fail, SWITCH_FALSE);
 
 				switch_safe_free(sql);
 
@@ -414,6 +625,9 @@ static switch_status_t odbc_cdr_load_config(void)
 	globals.debug_sql = SWITCH_FALSE;
 	globals.log_leg = ODBC_CDR_LOG_BOTH;
 	globals.write_csv = ODBC_CDR_CSV_NEVER;
+	globals.batch_size = 0;
+	globals.batch_latency_ms = 500;
+	globals.queue_size = 10000;
 
 	if ((settings = switch_xml_child(cfg, "settings")) != NULL) {
 		for (param = switch_xml_child(settings, "param"); param; param = param->next) {
@@ -448,6 +662,19 @@ static switch_status_t odbc_cdr_load_config(void)
 				globals.csv_path = switch_mprintf("%s%s", val, SWITCH_PATH_SEPARATOR);
 			} else if (!strcasecmp(var, "csv-path-on-fail") && !zstr(val)) {
 				globals.csv_fail_path = switch_mprintf("%s%s", val, SWITCH_PATH_SEPARATOR);
+			} else if (!strcasecmp(var, "batch-size")) {
+				int tmp = atoi(val);
+				globals.batch_size = tmp > 0 ? tmp : 0;
+			} else if (!strcasecmp(var, "batch-latency-ms")) {
+				int tmp = atoi(val);
+				if (tmp > 0) {
+					globals.batch_latency_ms = tmp;
+				}
+			} else if (!strcasecmp(var, "queue-size")) {
+				int tmp = atoi(val);
+				if (tmp > 0) {
+					globals.queue_size = tmp;
+				}
 			}
 		}
 	}
@@ -501,22 +728,45 @@ end:
 }
 
 
+SWITCH_STANDARD_API(odbc_cdr_function)
+{
+	if (zstr(cmd) || strcmp(cmd, "status")) {
+		stream->write_function(stream, "-USAGE: status\n");
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_lock(globals.stats_mutex);
+	stream->write_function(stream, "mode: %s\n", globals.queue ? "batch" : "sync");
+	stream->write_function(stream, "rows/sec: %u\n", globals.rows_per_sec);
+	stream->write_function(stream, "rows inserted: %" SWITCH_UINT64_T_FMT "\n", globals.rows_inserted);
+	stream->write_function(stream, "rows failed: %" SWITCH_UINT64_T_FMT " (%" SWITCH_UINT64_T_FMT " on backpressure)\n",
+						   globals.rows_failed, globals.rows_backpressure);
+	stream->write_function(stream, "statements: %" SWITCH_UINT64_T_FMT ", avg %.1f rows, max %u rows\n", globals.statements,
+						   globals.statements ? (double) globals.rows_inserted / globals.statements : 0.0, globals.batch_max);
+	stream->write_function(stream, "queue depth: %u\n", globals.queue ? switch_queue_size(globals.queue) : 0);
+	switch_mutex_unlock(globals.stats_mutex);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_MODULE_LOAD_FUNCTION(mod_odbc_cdr_load)
 {
 	switch_status_t status;
+	switch_api_interface_t *api_interface;
 
 	memset(&globals, 0, sizeof(globals));
 	switch_core_hash_init(&globals.table_hash);
 	if (switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, pool) != SWITCH_STATUS_SUCCESS) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "failed to initialize mutex\n");
 	}
+	switch_mutex_init(&globals.stats_mutex, SWITCH_MUTEX_NESTED, pool);
 	globals.pool = pool;
 
 	if ((status = odbc_cdr_load_config()) != SWITCH_STATUS_SUCCESS) {
 		return status;
 	}
 
-	if (globals.write_csv != ODBC_CDR_CSV_NEVER) {
+	if (globals.write_csv != ODBC_CDR_CSV_NEVER || globals.batch_size) {
 		if ((status = switch_dir_make_recursive(globals.csv_path, SWITCH_DEFAULT_DIR_PERMS, pool)) != SWITCH_STATUS_SUCCESS) {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error creating %s\n", globals.csv_path);
 			return status;
@@ -533,9 +783,27 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_odbc_cdr_load)
 	globals.running = 1;
 	switch_mutex_unlock(globals.mutex);
 
+	if (globals.batch_size) {
+		switch_threadattr_t *thd_attr = NULL;
+
+		if (globals.queue_size < globals.batch_size) {
+			globals.queue_size = globals.batch_size;
+		}
+
+		switch_queue_create(&globals.queue, globals.queue_size, pool);
+		globals.batch_running = 1;
+
+		switch_threadattr_create(&thd_attr, pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_thread_create(&globals.batch_thread, thd_attr, batch_thread_run, NULL, pool);
+	}
+
 	switch_core_add_state_handler(&odbc_cdr_state_handlers);
 	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
 
+	SWITCH_ADD_API(api_interface, "odbc_cdr", "odbc_cdr status", odbc_cdr_function, "status");
+	switch_console_set_complete("add odbc_cdr status");
+
 	/* indicate that the module should continue to be loaded */
 	return SWITCH_STATUS_SUCCESS;
 }
@@ -551,6 +819,19 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_odbc_cdr_shutdown)
 	const void *key;
 	switch_ssize_t keylen;
 
+	switch_console_set_complete("del odbc_cdr");
+	switch_core_remove_state_handler(&odbc_cdr_state_handlers);
+
+	if (globals.batch_thread) {
+		switch_status_t st;
+
+		/* the thread drains what is still queued before it exits */
+		globals.batch_running = 0;
+		switch_queue_trypush(globals.queue, NULL);
+		switch_thread_join(&st, globals.batch_thread);
+		globals.batch_thread = NULL;
+	}
+
 	switch_mutex_lock(globals.mutex);
 	if (globals.running == 1) {
 		globals.running = 0;
@@ -590,8 +871,6 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_odbc_cdr_shutdown)
 	switch_mutex_unlock(globals.mutex);
 	switch_mutex_destroy(globals.mutex);
 
-	switch_core_remove_state_handler(&odbc_cdr_state_handlers);
-
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -0,0 +1,1166 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2021, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * mod_prompt_cache.c -- Shared, memory mapped cache of decoded prompts
+ *
+ * Files opened as prompt_cache:///path/to/file.wav are decoded once per
+ * rate/channel combination into a flat store that is mmap'd read only and
+ * shared by every handle playing the same prompt.  Setting sound_prefix to
+ * prompt_cache://$${sounds_dir}/... routes all relative playback through it.
+ *
+ * When playback asks for a codec named file (foo.G729, foo.OPUS) that does not
+ * exist, the matching source (foo.wav) is encoded once into that codec and
+ * handed out as native frames, so callers on that codec skip transcoding.
+ *
+ */
+#include <switch.h>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
+SWITCH_MODULE_LOAD_FUNCTION(mod_prompt_cache_load);
+SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_prompt_cache_shutdown);
+SWITCH_MODULE_DEFINITION(mod_prompt_cache, mod_prompt_cache_load, mod_prompt_cache_shutdown, NULL);
+
+#define PROMPT_CACHE_SYNTAX "status|list|flush [<path>]|load <path> [<rate> [<channels> [<codec> [<ptime>]]]]"
+#define PROMPT_STORE_MAGIC "FSPCACHE"
+#define PROMPT_STORE_VERSION 2
+#define PROMPT_MAX_SOURCE_EXTS 8
+
+/* on-disk layout of a persisted variant, the data follows directly */
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t rate;
+	uint32_t channels;
+	uint32_t ptime;
+	char codec[32];
+	uint32_t bytes_per_frame;
+	uint32_t samples_per_frame;
+	uint64_t samples;
+	uint64_t data_len;
+	int64_t src_mtime;
+	uint64_t src_size;
+} prompt_store_header_t;
+
+typedef struct prompt_variant_s {
+	char *key;
+	char *path;
+	/* NULL for linear audio, otherwise the iananame of the encoded data */
+	char *codec;
+	/* the rate of the linear audio, and the rate the codec is registered at (they differ for g722) */
+	uint32_t rate;
+	uint32_t codec_rate;
+	uint32_t channels;
+	uint32_t ptime;
+	uint32_t samples_per_frame;
+	/* 0 for variable sized frames, which are stored with a 16 bit length prefix */
+	uint32_t bytes_per_frame;
+	int64_t src_mtime;
+	uint64_t src_size;
+	/* the mapping and the audio inside of it */
+	void *map;
+	switch_size_t map_len;
+	uint8_t *data;
+	switch_size_t data_len;
+	switch_size_t sample_count;
+	int refs;
+	int retired;
+	uint64_t hits;
+	switch_time_t last_used;
+} prompt_variant_t;
+
+typedef struct {
+	prompt_variant_t *variant;
+	switch_size_t pos;
+	int passthrough;
+	switch_file_handle_t fh;
+} prompt_cache_context_t;
+
+static struct {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_hash_t *variants;
+	char *location;
+	int persist;
+	int check_mtime;
+	int encode_variants;
+	char *source_exts[PROMPT_MAX_SOURCE_EXTS];
+	int source_ext_count;
+	switch_size_t max_memory;
+	switch_size_t max_prompt_bytes;
+	switch_size_t used_memory;
+	uint32_t entries;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t disk_loads;
+	uint64_t evictions;
+	uint64_t passthrough;
+	uint64_t encoded_hits;
+	switch_time_t build_time;
+	uint64_t builds;
+	switch_time_t encode_time;
+	uint64_t encodes;
+} globals;
+
+static void variant_unmap(prompt_variant_t *variant)
+{
+	if (variant->map) {
+#ifndef WIN32
+		munmap(variant->map, variant->map_len);
+#else
+		free(variant->map);
+#endif
+		variant->map = NULL;
+	}
+}
+
+static void variant_destroy(prompt_variant_t **variantp)
+{
+	prompt_variant_t *variant = *variantp;
+
+	*variantp = NULL;
+
+	variant_unmap(variant);
+	switch_safe_free(variant->key);
+	switch_safe_free(variant->path);
+	switch_safe_free(variant->codec);
+	free(variant);
+}
+
+/* must be called with globals.mutex held */
+static void variant_retire(prompt_variant_t *variant)
+{
+	if (variant->retired) {
+		return;
+	}
+
+	switch_core_hash_delete(globals.variants, variant->key);
+	globals.used_memory -= variant->map_len;
+	globals.entries--;
+	variant->retired = 1;
+
+	if (!variant->refs) {
+		variant_destroy(&variant);
+	}
+}
+
+/* must be called with globals.mutex held */
+static switch_bool_t make_room(switch_size_t bytes)
+{
+	while (globals.max_memory && globals.used_memory + bytes > globals.max_memory) {
+		switch_hash_index_t *hi;
+		prompt_variant_t *oldest = NULL;
+
+		for (hi = switch_core_hash_first(globals.variants); hi; hi = switch_core_hash_next(&hi)) {
+			void *val;
+			prompt_variant_t *variant;
+
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			variant = (prompt_variant_t *) val;
+
+			if (!variant->refs && (!oldest || variant->last_used < oldest->last_used)) {
+				oldest = variant;
+			}
+		}
+
+		if (!oldest) {
+			return SWITCH_FALSE;
+		}
+
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Evicting [%s]\n", oldest->key);
+		variant_retire(oldest);
+		globals.evictions++;
+	}
+
+	return SWITCH_TRUE;
+}
+
+static char *store_path(const char *key)
+{
+	char digest[SWITCH_MD5_DIGEST_STRING_SIZE] = { 0 };
+
+	switch_md5_string(digest, (void *) key, strlen(key));
+
+	return switch_mprintf("%s%s%s.pcm", globals.location, SWITCH_PATH_SEPARATOR, digest);
+}
+
+#ifndef WIN32
+static switch_status_t store_map_file(prompt_variant_t *variant, const char *path)
+{
+	prompt_store_header_t *header;
+	struct stat st;
+	void *map;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (fstat(fd, &st) || (switch_size_t) st.st_size < sizeof(*header)) {
+		close(fd);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	header = (prompt_store_header_t *) map;
+
+	if (memcmp(header->magic, PROMPT_STORE_MAGIC, sizeof(header->magic)) || header->version != PROMPT_STORE_VERSION ||
+		header->rate != variant->rate || header->channels != variant->channels || header->ptime != variant->ptime ||
+		strncmp(header->codec, switch_str_nil(variant->codec), sizeof(header->codec)) ||
+		header->bytes_per_frame != variant->bytes_per_frame || header->samples_per_frame != variant->samples_per_frame ||
+		header->src_mtime != variant->src_mtime || header->src_size != variant->src_size ||
+		sizeof(*header) + header->data_len != (switch_size_t) st.st_size) {
+		munmap(map, st.st_size);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	variant->map = map;
+	variant->map_len = st.st_size;
+	variant->data = (uint8_t *) map + sizeof(*header);
+	variant->data_len = (switch_size_t) header->data_len;
+	variant->sample_count = (switch_size_t) header->samples;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t store_write_file(prompt_variant_t *variant, const char *path, switch_buffer_t *buffer, switch_size_t samples)
+{
+	prompt_store_header_t header = { { 0 } };
+	char *tmp_path = switch_mprintf("%s.%d.tmp", path, (int) getpid());
+	const void *data = NULL;
+	switch_size_t len = switch_buffer_peek_zerocopy(buffer, &data);
+	switch_status_t status = SWITCH_STATUS_FALSE;
+	FILE *fp;
+
+	memcpy(header.magic, PROMPT_STORE_MAGIC, sizeof(header.magic));
+	header.version = PROMPT_STORE_VERSION;
+	header.rate = variant->rate;
+	header.channels = variant->channels;
+	header.ptime = variant->ptime;
+	switch_copy_string(header.codec, switch_str_nil(variant->codec), sizeof(header.codec));
+	header.bytes_per_frame = variant->bytes_per_frame;
+	header.samples_per_frame = variant->samples_per_frame;
+	header.samples = samples;
+	header.data_len = len;
+	header.src_mtime = variant->src_mtime;
+	header.src_size = variant->src_size;
+
+	if ((fp = fopen(tmp_path, "wb"))) {
+		if (fwrite(&header, sizeof(header), 1, fp) == 1 && (!len || fwrite(data, len, 1, fp) == 1) && !fclose(fp)) {
+			if (!rename(tmp_path, path)) {
+				status = SWITCH_STATUS_SUCCESS;
+			}
+		} else {
+			fclose(fp);
+		}
+	}
+
+	if (status != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Cannot write prompt store [%s]: %s\n", path, strerror(errno));
+		unlink(tmp_path);
+	}
+
+	free(tmp_path);
+
+	return status;
+}
+#endif
+
+static switch_status_t store_map_memory(prompt_variant_t *variant, switch_buffer_t *buffer, switch_size_t samples)
+{
+	const void *data = NULL;
+	switch_size_t len = switch_buffer_peek_zerocopy(buffer, &data);
+	void *map;
+
+#ifndef WIN32
+	map = mmap(NULL, len ? len : 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		return SWITCH_STATUS_MEMERR;
+	}
+	memcpy(map, data, len);
+	mprotect(map, len ? len : 1, PROT_READ);
+#else
+	if (!(map = malloc(len ? len : 1))) {
+		return SWITCH_STATUS_MEMERR;
+	}
+	memcpy(map, data, len);
+#endif
+
+	variant->map = map;
+	variant->map_len = len ? len : 1;
+	variant->data = (uint8_t *) map;
+	variant->data_len = len;
+	variant->sample_count = samples;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t decode_prompt(prompt_variant_t *variant, switch_buffer_t *buffer)
+{
+	switch_file_handle_t fh = { 0 };
+	int16_t frame[SWITCH_RECOMMENDED_BUFFER_SIZE / 2];
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	if (switch_core_file_open(&fh, variant->path, variant->channels, variant->rate,
+							  SWITCH_FILE_FLAG_READ | SWITCH_FILE_DATA_SHORT, NULL) != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_NOTFOUND;
+	}
+
+	if (switch_test_flag(&fh, SWITCH_FILE_NATIVE)) {
+		switch_core_file_close(&fh);
+		return SWITCH_STATUS_IGNORE;
+	}
+
+	for (;;) {
+		switch_size_t len = sizeof(frame) / 2 / variant->channels;
+
+		if (switch_core_file_read(&fh, frame, &len) != SWITCH_STATUS_SUCCESS || !len) {
+			break;
+		}
+
+		switch_buffer_write(buffer, frame, len * 2 * variant->channels);
+
+		if (globals.max_prompt_bytes && switch_buffer_inuse(buffer) > globals.max_prompt_bytes) {
+			status = SWITCH_STATUS_IGNORE;
+			break;
+		}
+	}
+
+	switch_core_file_close(&fh);
+
+	return status;
+}
+
+static switch_status_t encode_prompt(prompt_variant_t *variant, switch_buffer_t *pcm, switch_buffer_t *out, switch_size_t *samples)
+{
+	switch_codec_t codec = { 0 };
+	const switch_codec_implementation_t *impl;
+	uint32_t codec_rate = variant->codec_rate ? variant->codec_rate : variant->rate;
+	uint8_t decoded[SWITCH_RECOMMENDED_BUFFER_SIZE];
+	uint8_t encoded[SWITCH_RECOMMENDED_BUFFER_SIZE];
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	switch_size_t decoded_len;
+	switch_time_t start = switch_micro_time_now();
+
+	*samples = 0;
+
+	if (switch_core_codec_init(&codec, variant->codec, NULL, NULL, codec_rate, variant->ptime, variant->channels,
+							   SWITCH_CODEC_FLAG_ENCODE, NULL, NULL) != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_IGNORE;
+	}
+
+	impl = codec.implementation;
+	decoded_len = impl->decoded_bytes_per_packet;
+
+	if (!decoded_len || decoded_len > sizeof(decoded) || (uint32_t) impl->actual_samples_per_second != variant->rate) {
+		switch_core_codec_destroy(&codec);
+		return SWITCH_STATUS_IGNORE;
+	}
+
+	while (switch_buffer_inuse(pcm)) {
+		uint32_t encoded_len = sizeof(encoded), encoded_rate = impl->actual_samples_per_second;
+		unsigned int flag = 0;
+		switch_size_t got = switch_buffer_read(pcm, decoded, decoded_len);
+
+		if (got < decoded_len) {
+			memset(decoded + got, 0, decoded_len - got);
+		}
+
+		if (switch_core_codec_encode(&codec, NULL, decoded, (uint32_t) decoded_len, impl->actual_samples_per_second,
+									 encoded, &encoded_len, &encoded_rate, &flag) != SWITCH_STATUS_SUCCESS) {
+			status = SWITCH_STATUS_IGNORE;
+			break;
+		}
+
+		if (variant->bytes_per_frame) {
+			if (encoded_len != variant->bytes_per_frame) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s produced a %u byte frame, expected %u\n",
+								  variant->codec, encoded_len, variant->bytes_per_frame);
+				status = SWITCH_STATUS_IGNORE;
+				break;
+			}
+		} else {
+			uint16_t frame_len = (uint16_t) encoded_len;
+
+			switch_buffer_write(out, &frame_len, sizeof(frame_len));
+		}
+
+		switch_buffer_write(out, encoded, encoded_len);
+		*samples += variant->samples_per_frame;
+	}
+
+	switch_core_codec_destroy(&codec);
+
+	if (status == SWITCH_STATUS_SUCCESS) {
+		switch_mutex_lock(globals.mutex);
+		globals.encodes++;
+		globals.encode_time += switch_micro_time_now() - start;
+		switch_mutex_unlock(globals.mutex);
+	}
+
+	return status;
+}
+
+static switch_status_t variant_build(prompt_variant_t *variant)
+{
+	switch_buffer_t *buffer = NULL, *encoded = NULL, *store;
+	switch_status_t status;
+	switch_size_t samples = 0;
+	switch_time_t start = switch_micro_time_now();
+#ifndef WIN32
+	char *spath = NULL;
+
+	if (globals.persist) {
+		spath = store_path(variant->key);
+
+		if (store_map_file(variant, spath) == SWITCH_STATUS_SUCCESS) {
+			switch_mutex_lock(globals.mutex);
+			globals.disk_loads++;
+			switch_mutex_unlock(globals.mutex);
+			free(spath);
+			return SWITCH_STATUS_SUCCESS;
+		}
+	}
+#endif
+
+	switch_buffer_create_dynamic(&buffer, 65536, 65536, 0);
+	switch_assert(buffer);
+
+	store = buffer;
+
+	if ((status = decode_prompt(variant, buffer)) == SWITCH_STATUS_SUCCESS) {
+		samples = switch_buffer_inuse(buffer) / 2 / variant->channels;
+
+		if (variant->codec) {
+			switch_buffer_create_dynamic(&encoded, 16384, 16384, 0);
+			switch_assert(encoded);
+			status = encode_prompt(variant, buffer, encoded, &samples);
+			store = encoded;
+		}
+	}
+
+	if (status == SWITCH_STATUS_SUCCESS) {
+#ifndef WIN32
+		if (spath && store_write_file(variant, spath, store, samples) == SWITCH_STATUS_SUCCESS &&
+			store_map_file(variant, spath) == SWITCH_STATUS_SUCCESS) {
+			status = SWITCH_STATUS_SUCCESS;
+		} else
+#endif
+		status = store_map_memory(variant, store, samples);
+	}
+
+	switch_buffer_destroy(&buffer);
+	if (encoded) {
+		switch_buffer_destroy(&encoded);
+	}
+#ifndef WIN32
+	switch_safe_free(spath);
+#endif
+
+	if (status == SWITCH_STATUS_SUCCESS) {
+		switch_mutex_lock(globals.mutex);
+		globals.builds++;
+		globals.build_time += switch_micro_time_now() - start;
+		switch_mutex_unlock(globals.mutex);
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Cached [%s] %" SWITCH_SIZE_T_FMT " samples in %" SWITCH_TIME_T_FMT "ms\n",
+						  variant->key, variant->sample_count, (switch_micro_time_now() - start) / 1000);
+	}
+
+	return status;
+}
+
+/* returns a referenced variant matching the spec, building it if needed */
+static switch_status_t variant_acquire(const prompt_variant_t *spec, prompt_variant_t **variantp)
+{
+	prompt_variant_t *variant, *existing;
+	const char *path = spec->path;
+	struct stat st;
+	char *key;
+	switch_status_t status;
+
+	*variantp = NULL;
+
+	if (stat(path, &st)) {
+		return SWITCH_STATUS_NOTFOUND;
+	}
+
+	if (spec->codec) {
+		key = switch_mprintf("%s|%u|%u|%s|%u", path, spec->rate, spec->channels, spec->codec, spec->ptime);
+	} else {
+		key = switch_mprintf("%s|%u|%u", path, spec->rate, spec->channels);
+	}
+
+	switch_mutex_lock(globals.mutex);
+	if ((variant = switch_core_hash_find(globals.variants, key))) {
+		if (globals.check_mtime && (variant->src_mtime != (int64_t) st.st_mtime || variant->src_size != (uint64_t) st.st_size)) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Prompt [%s] changed on disk, reloading\n", path);
+			variant_retire(variant);
+			variant = NULL;
+		} else {
+			variant->refs++;
+			variant->hits++;
+			variant->last_used = switch_micro_time_now();
+			globals.hits++;
+			if (variant->codec) {
+				globals.encoded_hits++;
+			}
+		}
+	}
+	if (!variant) {
+		globals.misses++;
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	if (variant) {
+		free(key);
+		*variantp = variant;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_zmalloc(variant, sizeof(*variant));
+	variant->key = key;
+	variant->path = strdup(path);
+	variant->codec = spec->codec ? strdup(spec->codec) : NULL;
+	variant->rate = spec->rate;
+	variant->codec_rate = spec->codec_rate;
+	variant->channels = spec->channels;
+	variant->ptime = spec->ptime;
+	variant->samples_per_frame = spec->samples_per_frame;
+	variant->bytes_per_frame = spec->bytes_per_frame;
+	variant->src_mtime = (int64_t) st.st_mtime;
+	variant->src_size = (uint64_t) st.st_size;
+
+	if ((status = variant_build(variant)) != SWITCH_STATUS_SUCCESS) {
+		variant_destroy(&variant);
+		return status;
+	}
+
+	variant->refs = 1;
+	variant->last_used = switch_micro_time_now();
+
+	switch_mutex_lock(globals.mutex);
+	if ((existing = switch_core_hash_find(globals.variants, key)) && existing->src_mtime == variant->src_mtime) {
+		/* somebody else decoded it first, use theirs */
+		existing->refs++;
+		existing->last_used = variant->last_used;
+		switch_mutex_unlock(globals.mutex);
+		variant->refs = 0;
+		variant_destroy(&variant);
+		*variantp = existing;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (existing) {
+		variant_retire(existing);
+	}
+
+	if (make_room(variant->map_len)) {
+		switch_core_hash_insert(globals.variants, variant->key, variant);
+		globals.used_memory += variant->map_len;
+		globals.entries++;
+	} else {
+		/* over budget with everything in use, serve it uncached */
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Prompt cache full, not caching [%s]\n", variant->key);
+		variant->retired = 1;
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	*variantp = variant;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void variant_release(prompt_variant_t **variantp)
+{
+	prompt_variant_t *variant = *variantp;
+
+	*variantp = NULL;
+
+	switch_mutex_lock(globals.mutex);
+	if (!--variant->refs && variant->retired) {
+		variant_destroy(&variant);
+	}
+	switch_mutex_unlock(globals.mutex);
+}
+
+/*
+ * path is foo.<iananame> and does not exist: find a source to encode from and
+ * the implementation matching the rate and packetization playback asked for.
+ */
+static switch_bool_t encoded_spec(const char *path, uint32_t rate, uint32_t channels, uint32_t ptime, prompt_variant_t *spec, switch_memory_pool_t *pool)
+{
+	switch_codec_interface_t *codec_interface;
+	const switch_codec_implementation_t *impl, *match = NULL;
+	const char *ext;
+	char *base;
+	int i;
+
+	if (!globals.encode_variants || !(ext = strrchr(path, '.')) || !*++ext || strchr(ext, '/')) {
+		return SWITCH_FALSE;
+	}
+
+	if (!(codec_interface = switch_loadable_module_get_codec_interface(ext, NULL))) {
+		return SWITCH_FALSE;
+	}
+
+	for (impl = codec_interface->implementations; impl; impl = impl->next) {
+		if (impl->codec_type != SWITCH_CODEC_TYPE_AUDIO || impl->number_of_channels != (int) channels) {
+			continue;
+		}
+
+		if (ptime && (uint32_t) (impl->microseconds_per_packet / 1000) != ptime) {
+			continue;
+		}
+
+		if ((uint32_t) impl->actual_samples_per_second == rate) {
+			match = impl;
+			break;
+		}
+
+		if (!match) {
+			match = impl;
+		}
+	}
+
+	if (match) {
+		spec->codec = switch_core_strdup(pool, match->iananame);
+		spec->rate = match->actual_samples_per_second;
+		spec->codec_rate = match->samples_per_second;
+		spec->channels = channels;
+		spec->ptime = match->microseconds_per_packet / 1000;
+		spec->samples_per_frame = match->samples_per_packet;
+		spec->bytes_per_frame = match->encoded_bytes_per_packet;
+	}
+
+	UNPROTECT_INTERFACE(codec_interface);
+
+	if (!match) {
+		return SWITCH_FALSE;
+	}
+
+	base = switch_core_strdup(pool, path);
+	*(base + (ext - path) - 1) = '\0';
+
+	for (i = 0; i < globals.source_ext_count; i++) {
+		char *source = switch_core_sprintf(pool, "%s.%s", base, globals.source_exts[i]);
+
+		if (switch_file_exists(source, pool) == SWITCH_STATUS_SUCCESS) {
+			spec->path = source;
+			return SWITCH_TRUE;
+		}
+	}
+
+	return SWITCH_FALSE;
+}
+
+static switch_status_t prompt_cache_file_open(switch_file_handle_t *handle, const char *path)
+{
+	prompt_cache_context_t *context = switch_core_alloc(handle->memory_pool, sizeof(*context));
+	uint32_t channels = handle->channels ? handle->channels : 1;
+	uint32_t rate = handle->samplerate ? handle->samplerate : 8000;
+	prompt_variant_t spec = { 0 };
+	switch_status_t status;
+
+	if (switch_test_flag(handle, SWITCH_FILE_FLAG_WRITE)) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "prompt_cache:// is read only\n");
+		return SWITCH_STATUS_FALSE;
+	}
+
+	handle->private_info = context;
+
+	if (switch_file_exists(path, handle->memory_pool) == SWITCH_STATUS_SUCCESS ||
+		!encoded_spec(path, rate, channels, handle->interval, &spec, handle->memory_pool)) {
+		spec.path = (char *) path;
+		spec.rate = rate;
+		spec.channels = channels;
+	}
+
+	if ((status = variant_acquire(&spec, &context->variant)) == SWITCH_STATUS_NOTFOUND) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot open prompt [%s]\n", path);
+		return status;
+	}
+
+	if (status != SWITCH_STATUS_SUCCESS) {
+		/* native, oversized or undecodable in one go: just play it directly */
+		context->passthrough = 1;
+		context->fh.pre_buffer_datalen = handle->pre_buffer_datalen;
+
+		if ((status = switch_core_file_open(&context->fh, path, handle->channels, handle->samplerate,
+											SWITCH_FILE_FLAG_READ | SWITCH_FILE_DATA_SHORT, NULL)) != SWITCH_STATUS_SUCCESS) {
+			return status;
+		}
+
+		switch_mutex_lock(globals.mutex);
+		globals.passthrough++;
+		switch_mutex_unlock(globals.mutex);
+
+		handle->samples = context->fh.samples;
+		handle->samplerate = context->fh.samplerate;
+		handle->format = context->fh.format;
+		handle->sections = context->fh.sections;
+		handle->seekable = context->fh.seekable;
+		handle->speed = context->fh.speed;
+		handle->interval = context->fh.interval;
+		handle->channels = context->fh.channels;
+		handle->cur_channels = context->fh.real_channels;
+		handle->flags |= SWITCH_FILE_NOMUX;
+		handle->pre_buffer_datalen = 0;
+
+		if (switch_test_flag((&context->fh), SWITCH_FILE_NATIVE)) {
+			switch_set_flag_locked(handle, SWITCH_FILE_NATIVE);
+		} else {
+			switch_clear_flag_locked(handle, SWITCH_FILE_NATIVE);
+		}
+
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (context->variant->codec) {
+		switch_set_flag_locked(handle, SWITCH_FILE_NATIVE);
+		if (!context->variant->bytes_per_frame) {
+			switch_set_flag_locked(handle, SWITCH_FILE_NATIVE_FRAMED);
+		}
+	}
+
+	handle->samples = (unsigned int) context->variant->sample_count;
+	handle->samplerate = context->variant->rate;
+	handle->channels = channels;
+	handle->format = 0;
+	handle->sections = 0;
+	handle->seekable = 1;
+	handle->speed = 0;
+	handle->pos = 0;
+	handle->flags |= SWITCH_FILE_NOMUX;
+	/* the data is already in memory, prebuffering it again is pointless */
+	handle->pre_buffer_datalen = 0;
+	switch_clear_flag_locked(handle, SWITCH_FILE_FLAG_VIDEO);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t prompt_cache_file_close(switch_file_handle_t *handle)
+{
+	prompt_cache_context_t *context = handle->private_info;
+
+	if (!context) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (context->passthrough) {
+		return switch_core_file_close(&context->fh);
+	}
+
+	if (context->variant) {
+		variant_release(&context->variant);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t prompt_cache_file_read(switch_file_handle_t *handle, void *data, size_t *len)
+{
+	prompt_cache_context_t *context = handle->private_info;
+	prompt_variant_t *variant = context->variant;
+	switch_size_t avail;
+
+	if (context->passthrough) {
+		return switch_core_file_read(&context->fh, data, len);
+	}
+
+	if (variant->codec && !variant->bytes_per_frame) {
+		uint16_t frame_len;
+
+		if (context->pos + sizeof(frame_len) > variant->data_len) {
+			*len = 0;
+			return SWITCH_STATUS_FALSE;
+		}
+
+		memcpy(&frame_len, variant->data + context->pos, sizeof(frame_len));
+
+		if (frame_len > *len || context->pos + sizeof(frame_len) + frame_len > variant->data_len) {
+			*len = 0;
+			return SWITCH_STATUS_FALSE;
+		}
+
+		memcpy(data, variant->data + context->pos + sizeof(frame_len), frame_len);
+		context->pos += sizeof(frame_len) + frame_len;
+		handle->pos += variant->samples_per_frame;
+		*len = frame_len;
+
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (variant->codec) {
+		/* constant bitrate, the file module contract is plain bytes */
+		avail = variant->data_len - context->pos;
+	} else {
+		avail = variant->sample_count - context->pos;
+	}
+
+	if (!avail) {
+		*len = 0;
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (*len > avail) {
+		*len = avail;
+	}
+
+	if (variant->codec) {
+		memcpy(data, variant->data + context->pos, *len);
+		context->pos += *len;
+		handle->pos = context->pos / variant->bytes_per_frame * variant->samples_per_frame;
+	} else {
+		memcpy(data, variant->data + context->pos * 2 * variant->channels, *len * 2 * variant->channels);
+		context->pos += *len;
+		handle->pos = context->pos;
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t prompt_cache_file_seek(switch_file_handle_t *handle, unsigned int *cur_sample, int64_t samples, int whence)
+{
+	prompt_cache_context_t *context = handle->private_info;
+	int64_t target;
+
+	if (context->passthrough) {
+		switch_status_t status;
+
+		if ((status = switch_core_file_seek(&context->fh, cur_sample, samples, whence)) == SWITCH_STATUS_SUCCESS) {
+			handle->pos = context->fh.pos;
+		}
+
+		return status;
+	}
+
+	switch (whence) {
+	case SEEK_CUR:
+		target = (int64_t) handle->pos + samples;
+		break;
+	case SEEK_END:
+		target = (int64_t) context->variant->sample_count + samples;
+		break;
+	default:
+		target = samples;
+		break;
+	}
+
+	if (target < 0) {
+		target = 0;
+	} else if (target > (int64_t) context->variant->sample_count) {
+		target = context->variant->sample_count;
+	}
+
+	if (context->variant->codec) {
+		prompt_variant_t *variant = context->variant;
+		int64_t frames = target / variant->samples_per_frame;
+
+		target = frames * variant->samples_per_frame;
+
+		if (variant->bytes_per_frame) {
+			context->pos = (switch_size_t) frames * variant->bytes_per_frame;
+		} else {
+			uint16_t frame_len;
+
+			for (context->pos = 0; frames > 0 && context->pos + sizeof(frame_len) <= variant->data_len; frames--) {
+				memcpy(&frame_len, variant->data + context->pos, sizeof(frame_len));
+				context->pos += sizeof(frame_len) + frame_len;
+			}
+		}
+	} else {
+		context->pos = (switch_size_t) target;
+	}
+
+	*cur_sample = (unsigned int) target;
+	handle->pos = *cur_sample;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t prompt_cache_file_get_string(switch_file_handle_t *handle, switch_audio_col_t col, const char **string)
+{
+	prompt_cache_context_t *context = handle->private_info;
+
+	if (context->passthrough) {
+		return switch_core_file_get_string(&context->fh, col, string);
+	}
+
+	return SWITCH_STATUS_FALSE;
+}
+
+static void flush_variants(const char *path)
+{
+	switch_hash_index_t *hi;
+	prompt_variant_t *list[256];
+	int i, x;
+
+	switch_mutex_lock(globals.mutex);
+	do {
+		x = 0;
+		for (hi = switch_core_hash_first(globals.variants); hi && x < 256; hi = switch_core_hash_next(&hi)) {
+			void *val;
+
+			switch_core_hash_this(hi, NULL, NULL, &val);
+
+			if (!path || !strcmp(((prompt_variant_t *) val)->path, path)) {
+				list[x++] = (prompt_variant_t *) val;
+			}
+		}
+		switch_safe_free(hi);
+
+		for (i = 0; i < x; i++) {
+			variant_retire(list[i]);
+		}
+	} while (x == 256);
+	switch_mutex_unlock(globals.mutex);
+}
+
+SWITCH_STANDARD_API(prompt_cache_function)
+{
+	char *mydata = NULL, *argv[4] = { 0 };
+	int argc = 0;
+
+	if (!zstr(cmd)) {
+		mydata = strdup(cmd);
+		switch_assert(mydata);
+		argc = switch_separate_string(mydata, ' ', argv, (sizeof(argv) / sizeof(argv[0])));
+	}
+
+	if (argc < 1) {
+		stream->write_function(stream, "-USAGE: %s\n", PROMPT_CACHE_SYNTAX);
+		goto done;
+	}
+
+	if (!strcasecmp(argv[0], "status")) {
+		uint64_t total;
+
+		switch_mutex_lock(globals.mutex);
+		total = globals.hits + globals.misses;
+		stream->write_function(stream, "entries: %u\n", globals.entries);
+		stream->write_function(stream, "memory: %" SWITCH_SIZE_T_FMT "/%" SWITCH_SIZE_T_FMT " bytes\n", globals.used_memory, globals.max_memory);
+		stream->write_function(stream, "hits: %" SWITCH_UINT64_T_FMT "\n", globals.hits);
+		stream->write_function(stream, "misses: %" SWITCH_UINT64_T_FMT "\n", globals.misses);
+		stream->write_function(stream, "hit-rate: %.2f%%\n", total ? (double) globals.hits * 100 / total : 0.0);
+		stream->write_function(stream, "disk-loads: %" SWITCH_UINT64_T_FMT "\n", globals.disk_loads);
+		stream->write_function(stream, "evictions: %" SWITCH_UINT64_T_FMT "\n", globals.evictions);
+		stream->write_function(stream, "passthrough: %" SWITCH_UINT64_T_FMT "\n", globals.passthrough);
+		stream->write_function(stream, "encoded-hits: %" SWITCH_UINT64_T_FMT "\n", globals.encoded_hits);
+		stream->write_function(stream, "avg-decode-ms: %.3f\n", globals.builds ? (double) globals.build_time / globals.builds / 1000 : 0.0);
+		stream->write_function(stream, "avg-encode-ms: %.3f\n", globals.encodes ? (double) globals.encode_time / globals.encodes / 1000 : 0.0);
+		switch_mutex_unlock(globals.mutex);
+	} else if (!strcasecmp(argv[0], "list")) {
+		switch_hash_index_t *hi;
+
+		switch_mutex_lock(globals.mutex);
+		for (hi = switch_core_hash_first(globals.variants); hi; hi = switch_core_hash_next(&hi)) {
+			void *val;
+			prompt_variant_t *variant;
+
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			variant = (prompt_variant_t *) val;
+			stream->write_function(stream, "%s,%s,%u,%u,%u,%" SWITCH_SIZE_T_FMT ",%d,%" SWITCH_UINT64_T_FMT "\n",
+								   variant->path, variant->codec ? variant->codec : "L16", variant->rate, variant->channels, variant->ptime,
+								   variant->map_len, variant->refs, variant->hits);
+		}
+		switch_mutex_unlock(globals.mutex);
+	} else if (!strcasecmp(argv[0], "flush")) {
+		flush_variants(argv[1]);
+		stream->write_function(stream, "+OK\n");
+	} else if (!strcasecmp(argv[0], "load") && argc > 1) {
+		prompt_variant_t *variant = NULL, spec = { 0 };
+		switch_memory_pool_t *pool = NULL;
+		uint32_t rate = argc > 2 ? atoi(argv[2]) : 8000;
+		uint32_t channels = argc > 3 ? atoi(argv[3]) : 1;
+		uint32_t ptime = argc > 5 ? atoi(argv[5]) : 20;
+
+		switch_core_new_memory_pool(&pool);
+
+		spec.path = argv[1];
+		spec.rate = rate;
+		spec.channels = channels;
+
+		if (argc > 4) {
+			/* prime an encoded variant the same way playback of foo.<codec> would */
+			char *ext = strrchr(argv[1], '.');
+			char *target = ext ? switch_core_sprintf(pool, "%.*s.%s", (int) (ext - argv[1]), argv[1], argv[4]) : NULL;
+
+			if (!target || !encoded_spec(target, rate, channels, ptime, &spec, pool)) {
+				rate = 0;
+			}
+		}
+
+		if (rate < 8000 || !channels || channels > 2) {
+			stream->write_function(stream, "-ERR invalid rate, channels or codec\n");
+		} else if (variant_acquire(&spec, &variant) == SWITCH_STATUS_SUCCESS) {
+			stream->write_function(stream, "+OK %" SWITCH_SIZE_T_FMT " samples\n", variant->sample_count);
+			variant_release(&variant);
+		} else {
+			stream->write_function(stream, "-ERR cannot cache %s\n", argv[1]);
+		}
+
+		switch_core_destroy_memory_pool(&pool);
+	} else {
+		stream->write_function(stream, "-USAGE: %s\n", PROMPT_CACHE_SYNTAX);
+	}
+
+  done:
+
+	switch_safe_free(mydata);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t do_config(void)
+{
+	char *cf = "prompt_cache.conf";
+	switch_xml_t cfg, xml, settings, param;
+
+	globals.max_memory = 256 * 1024 * 1024;
+	globals.max_prompt_bytes = 16 * 1024 * 1024;
+	globals.check_mtime = 1;
+	globals.persist = 0;
+	globals.encode_variants = 1;
+	globals.source_exts[0] = "wav";
+	globals.source_ext_count = 1;
+	globals.location = switch_core_sprintf(globals.pool, "%s%sprompt_cache", SWITCH_GLOBAL_dirs.cache_dir, SWITCH_PATH_SEPARATOR);
+
+	if (!(xml = switch_xml_open_cfg(cf, &cfg, NULL))) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Open of %s failed, using defaults\n", cf);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if ((settings = switch_xml_child(cfg, "settings"))) {
+		for (param = switch_xml_child(settings, "param"); param; param = param->next) {
+			char *var = (char *) switch_xml_attr_soft(param, "name");
+			char *val = (char *) switch_xml_attr_soft(param, "value");
+
+			if (!strcasecmp(var, "max-memory-mb")) {
+				int tmp = atoi(val);
+				if (tmp >= 0) {
+					globals.max_memory = (switch_size_t) tmp * 1024 * 1024;
+				}
+			} else if (!strcasecmp(var, "max-prompt-mb")) {
+				int tmp = atoi(val);
+				if (tmp >= 0) {
+					globals.max_prompt_bytes = (switch_size_t) tmp * 1024 * 1024;
+				}
+			} else if (!strcasecmp(var, "check-mtime")) {
+				globals.check_mtime = switch_true(val);
+			} else if (!strcasecmp(var, "persist")) {
+				globals.persist = switch_true(val);
+			} else if (!strcasecmp(var, "encode-variants")) {
+				globals.encode_variants = switch_true(val);
+			} else if (!strcasecmp(var, "source-extensions")) {
+				if (!zstr(val)) {
+					char *exts = switch_core_strdup(globals.pool, val);
+					globals.source_ext_count = switch_separate_string(exts, ',', globals.source_exts, PROMPT_MAX_SOURCE_EXTS);
+				}
+			} else if (!strcasecmp(var, "location")) {
+				if (!zstr(val)) {
+					globals.location = switch_core_strdup(globals.pool, val);
+				}
+			} else {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Unsupported param: %s\n", var);
+			}
+		}
+	}
+
+	switch_xml_free(xml);
+
+#ifdef WIN32
+	globals.persist = 0;
+#endif
+
+	if (globals.persist && switch_dir_make_recursive(globals.location, SWITCH_DEFAULT_DIR_PERMS, globals.pool) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Cannot create %s, prompts will only be cached in memory\n", globals.location);
+		globals.persist = 0;
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static char *supported_formats[] = { "prompt_cache", NULL };
+
+SWITCH_MODULE_LOAD_FUNCTION(mod_prompt_cache_load)
+{
+	switch_file_interface_t *file_interface;
+	switch_api_interface_t *api_interface;
+
+	memset(&globals, 0, sizeof(globals));
+	globals.pool = pool;
+	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, globals.pool);
+	switch_core_hash_init(&globals.variants);
+
+	do_config();
+
+	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
+
+	file_interface = switch_loadable_module_create_interface(*module_interface, SWITCH_FILE_INTERFACE);
+	file_interface->interface_name = modname;
+	file_interface->extens = supported_formats;
+	file_interface->file_open = prompt_cache_file_open;
+	file_interface->file_close = prompt_cache_file_close;
+	file_interface->file_read = prompt_cache_file_read;
+	file_interface->file_seek = prompt_cache_file_seek;
+	file_interface->file_get_string = prompt_cache_file_get_string;
+
+	SWITCH_ADD_API(api_interface, "prompt_cache", "Prompt cache control", prompt_cache_function, PROMPT_CACHE_SYNTAX);
+	switch_console_set_complete("add prompt_cache status");
+	switch_console_set_complete("add prompt_cache list");
+	switch_console_set_complete("add prompt_cache flush");
+	switch_console_set_complete("add prompt_cache load");
+
+	/* indicate that the module should continue to be loaded */
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_prompt_cache_shutdown)
+{
+	flush_variants(NULL);
+	switch_core_hash_destroy(&globals.variants);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
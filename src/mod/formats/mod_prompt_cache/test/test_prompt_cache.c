@@ -0,0 +1,123 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2018, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * test_prompt_cache.c -- tests mod_prompt_cache
+ *
+ */
+#include <switch.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <test/switch_test.h>
+
+/* one second of a 1 kHz tone at 16 kHz */
+static switch_status_t write_tone(const char *path)
+{
+	switch_file_handle_t fh = { 0 };
+	int16_t data[320];
+	switch_size_t len;
+	int i, n = 0, frame;
+
+	if (switch_core_file_open(&fh, path, 1, 16000, SWITCH_FILE_FLAG_WRITE | SWITCH_FILE_DATA_SHORT, NULL) != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	for (frame = 0; frame < 50; frame++) {
+		for (i = 0; i < 320; i++, n++) {
+			data[i] = (int16_t) (8000 * sin(2 * M_PI * 1000 * n / 16000));
+		}
+		len = 320;
+		switch_core_file_write(&fh, data, &len);
+	}
+
+	return switch_core_file_close(&fh);
+}
+
+FST_CORE_BEGIN(".")
+{
+	FST_SUITE_BEGIN(test_prompt_cache)
+	{
+		FST_SETUP_BEGIN()
+		{
+			fst_requires_module("mod_sndfile");
+			fst_requires_module("mod_spandsp");
+			fst_requires_module("mod_prompt_cache");
+		}
+		FST_SETUP_END()
+
+		FST_TEARDOWN_BEGIN()
+		{
+		}
+		FST_TEARDOWN_END()
+
+		/* g722 is registered at 8000 but carries 16 kHz audio */
+		FST_TEST_BEGIN(g722_variant)
+		{
+			char base[1024], wav[1024], cmd[2048], encoded[2048];
+			switch_stream_handle_t stream = { 0 };
+			switch_file_handle_t fh = { 0 };
+			switch_codec_t codec = { 0 };
+			uint8_t frame[SWITCH_RECOMMENDED_BUFFER_SIZE];
+			int16_t decoded[SWITCH_RECOMMENDED_BUFFER_SIZE / 2];
+			uint32_t decoded_len = sizeof(decoded), decoded_rate = 16000, flag = 0;
+			switch_size_t len;
+
+			switch_snprintf(base, sizeof(base), "%s%sprompt_cache_g722_%d", SWITCH_GLOBAL_dirs.temp_dir, SWITCH_PATH_SEPARATOR, (int) getpid());
+			switch_snprintf(wav, sizeof(wav), "%s.wav", base);
+			fst_requires(write_tone(wav) == SWITCH_STATUS_SUCCESS);
+
+			/* priming the variant encodes it */
+			switch_snprintf(cmd, sizeof(cmd), "load %s 16000 1 G722 20", wav);
+			SWITCH_STANDARD_STREAM(stream);
+			switch_api_execute("prompt_cache", cmd, NULL, &stream);
+			fst_check_string_equals((char *) stream.data, "+OK 16000 samples\n");
+			switch_safe_free(stream.data);
+
+			/* playback of foo.G722 gets the same variant, native at the 16 kHz pcm rate */
+			switch_snprintf(encoded, sizeof(encoded), "prompt_cache://%s.G722", base);
+			fst_requires(switch_core_file_open(&fh, encoded, 1, 16000, SWITCH_FILE_FLAG_READ | SWITCH_FILE_DATA_SHORT, NULL) == SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(fh.samplerate, 16000);
+			fst_check(switch_test_flag(&fh, SWITCH_FILE_NATIVE));
+			fst_check_int_equals(fh.samples, 16000);
+
+			len = 160;
+			fst_check(switch_core_file_read(&fh, frame, &len) == SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(len, 160);
+			switch_core_file_close(&fh);
+
+			/* and it decodes back to a full 20 ms of 16 kHz audio */
+			fst_requires(switch_core_codec_init(&codec, "G722", NULL, NULL, 8000, 20, 1, SWITCH_CODEC_FLAG_DECODE, NULL, NULL) == SWITCH_STATUS_SUCCESS);
+			fst_check(switch_core_codec_decode(&codec, NULL, frame, (uint32_t) len, 8000, decoded, &decoded_len, &decoded_rate, &flag) == SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(decoded_len, 640);
+			switch_core_codec_destroy(&codec);
+
+			unlink(wav);
+		}
+		FST_TEST_END()
+	}
+	FST_SUITE_END()
+}
+FST_CORE_END()
@@ -42,9 +42,45 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_lua_load);
 SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_lua_shutdown);
 
 SWITCH_MODULE_DEFINITION_EX(mod_lua, mod_lua_load, mod_lua_shutdown, NULL, SMODF_GLOBAL_SYMBOLS);
+
+#ifndef lua_pushglobaltable
+#define lua_pushglobaltable(L) lua_pushvalue(L,LUA_GLOBALSINDEX)
+#endif
+
+#if LUA_VERSION_NUM >= 502
+#define mod_lua_objlen(L, i) lua_rawlen(L, i)
+#else
+#define mod_lua_objlen(L, i) lua_objlen(L, i)
+#endif
+
+#define LUA_POOL_MAX 1024
+
+/* a compiled script, reused for as long as the file keeps the same mtime, size and inode */
+typedef struct {
+	char *data;
+	switch_size_t len;
+	time_t mtime;
+	off_t size;
+	ino_t ino;
+} lua_chunk_t;
+
 static struct {
 	switch_memory_pool_t *pool;
 	char *xml_handler;
+	switch_mutex_t *state_mutex;
+	lua_State *states[LUA_POOL_MAX];
+	uint32_t state_count;
+	uint32_t state_pool_size;
+	uint32_t state_max_uses;
+	switch_bool_t bytecode_cache;
+	switch_thread_rwlock_t *chunk_rwlock;
+	switch_hash_t *chunks;
+	switch_metric_t *pool_hits;
+	switch_metric_t *pool_misses;
+	switch_metric_t *cache_hits;
+	switch_metric_t *cache_misses;
+	switch_metric_t *setup_usec;
+	switch_metric_t *setups;
 } globals;
 
 int luaopen_freeswitch(lua_State * L);
@@ -131,6 +167,281 @@ static lua_State *lua_init(void)
 	return L;
 }
 
+static void lua_copy_table(lua_State * L, int from, int to)
+{
+	lua_pushnil(L);
+	while (lua_next(L, from)) {
+		lua_pushvalue(L, -2);
+		lua_insert(L, -2);
+		lua_rawset(L, to);
+	}
+}
+
+/* make the table at idx look like the snapshot at pristine again */
+static void lua_restore_table(lua_State * L, int idx, int pristine)
+{
+	lua_pushnil(L);
+	while (lua_next(L, idx)) {
+		lua_pop(L, 1);
+		lua_pushvalue(L, -1);
+		lua_rawget(L, pristine);
+		if (lua_isnil(L, -1)) {
+			/* clearing a field is allowed while traversing */
+			lua_pushvalue(L, -2);
+			lua_pushnil(L);
+			lua_rawset(L, idx);
+		}
+		lua_pop(L, 1);
+	}
+
+	lua_copy_table(L, pristine, idx);
+}
+
+/* remember the globals and loaded modules of a fresh state so it can be reset after every use */
+static void lua_snapshot(lua_State * L)
+{
+	lua_settop(L, 0);
+
+	lua_newtable(L);
+	lua_pushglobaltable(L);
+	lua_copy_table(L, 2, 1);
+	lua_pop(L, 1);
+	lua_setfield(L, LUA_REGISTRYINDEX, "mod_lua_globals");
+
+	lua_newtable(L);
+	lua_getglobal(L, "package");
+	if (lua_istable(L, -1)) {
+		lua_getfield(L, -1, "loaded");
+		if (lua_istable(L, -1)) {
+			lua_copy_table(L, 3, 1);
+		}
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 1);
+	lua_setfield(L, LUA_REGISTRYINDEX, "mod_lua_loaded");
+
+	lua_pushinteger(L, 0);
+	lua_setfield(L, LUA_REGISTRYINDEX, "mod_lua_uses");
+
+	lua_pushinteger(L, (lua_Integer) mod_lua_objlen(L, LUA_REGISTRYINDEX));
+	lua_setfield(L, LUA_REGISTRYINDEX, "mod_lua_reflen");
+}
+
+/* put a used state back the way lua_snapshot found it, non-zero when it can't be reused */
+static int lua_reset(lua_State * L)
+{
+	lua_Integer uses, reflen;
+
+	lua_settop(L, 0);
+
+	lua_getfield(L, LUA_REGISTRYINDEX, "mod_lua_globals");
+	if (!lua_istable(L, 1)) {
+		lua_settop(L, 0);
+		return -1;
+	}
+	lua_pushglobaltable(L);
+	lua_restore_table(L, 2, 1);
+	lua_pushnil(L);
+	lua_setmetatable(L, 2);
+	lua_settop(L, 0);
+
+	lua_getfield(L, LUA_REGISTRYINDEX, "mod_lua_loaded");
+	lua_getglobal(L, "package");
+	if (lua_istable(L, 1) && lua_istable(L, 2)) {
+		lua_getfield(L, 2, "loaded");
+		if (lua_istable(L, 3)) {
+			lua_restore_table(L, 3, 1);
+		}
+	}
+	lua_settop(L, 0);
+
+	lua_getfield(L, LUA_REGISTRYINDEX, "mod_lua_uses");
+	uses = lua_tointeger(L, -1) + 1;
+	lua_pop(L, 1);
+	lua_pushinteger(L, uses);
+	lua_setfield(L, LUA_REGISTRYINDEX, "mod_lua_uses");
+
+	lua_getfield(L, LUA_REGISTRYINDEX, "mod_lua_reflen");
+	reflen = lua_tointeger(L, -1);
+	lua_pop(L, 1);
+
+	lua_gc(L, LUA_GCCOLLECT, 0);
+
+	/* anything a script left referenced from the registry would outlive the reset */
+	if ((lua_Integer) mod_lua_objlen(L, LUA_REGISTRYINDEX) != reflen) {
+		return -1;
+	}
+
+	return (globals.state_max_uses && uses >= globals.state_max_uses) ? -1 : 0;
+}
+
+/* take a ready state from the pool or make a new one */
+static lua_State *lua_acquire(void)
+{
+	switch_time_t start = switch_time_now();
+	lua_State *L = NULL;
+
+	if (globals.state_pool_size) {
+		switch_mutex_lock(globals.state_mutex);
+		if (globals.state_count) {
+			L = globals.states[--globals.state_count];
+		}
+		switch_mutex_unlock(globals.state_mutex);
+	}
+
+	if (L) {
+		switch_core_metric_inc(globals.pool_hits);
+	} else {
+		if ((L = lua_init()) && globals.state_pool_size) {
+			lua_snapshot(L);
+		}
+		switch_core_metric_inc(globals.pool_misses);
+	}
+
+	switch_core_metric_inc(globals.setups);
+	switch_core_metric_add(globals.setup_usec, switch_time_now() - start);
+
+	return L;
+}
+
+/* give a state from lua_acquire back, it is closed unless it finished cleanly and can be reset */
+static void lua_release(lua_State * L, int error)
+{
+	int keep = 0;
+
+	if (!L) {
+		return;
+	}
+
+	if (globals.state_pool_size && !error && !lua_reset(L)) {
+		switch_mutex_lock(globals.state_mutex);
+		if (globals.state_count < globals.state_pool_size) {
+			globals.states[globals.state_count++] = L;
+			keep = 1;
+		}
+		switch_mutex_unlock(globals.state_mutex);
+	}
+
+	if (!keep) {
+		lua_uninit(L);
+	}
+}
+
+static void lua_drain_pool(void)
+{
+	lua_State *L;
+
+	for (;;) {
+		L = NULL;
+		switch_mutex_lock(globals.state_mutex);
+		if (globals.state_count) {
+			L = globals.states[--globals.state_count];
+		}
+		switch_mutex_unlock(globals.state_mutex);
+
+		if (!L) {
+			break;
+		}
+
+		lua_uninit(L);
+	}
+}
+
+static int lua_chunk_writer(lua_State * L, const void *p, size_t sz, void *ud)
+{
+	switch_stream_handle_t *stream = (switch_stream_handle_t *) ud;
+
+	return stream->raw_write_function(stream, (uint8_t *) p, sz) == SWITCH_STATUS_SUCCESS ? 0 : 1;
+}
+
+static void lua_chunk_free(lua_chunk_t *chunk)
+{
+	if (chunk) {
+		switch_safe_free(chunk->data);
+		free(chunk);
+	}
+}
+
+static void lua_flush_chunks(void)
+{
+	switch_hash_index_t *hi = NULL;
+	const void *key;
+	void *val;
+
+	switch_thread_rwlock_wrlock(globals.chunk_rwlock);
+	while ((hi = switch_core_hash_first_iter(globals.chunks, hi))) {
+		switch_core_hash_this(hi, &key, NULL, &val);
+		switch_core_hash_delete(globals.chunks, (const char *) key);
+		lua_chunk_free((lua_chunk_t *) val);
+	}
+	switch_safe_free(hi);
+	switch_thread_rwlock_unlock(globals.chunk_rwlock);
+}
+
+/* luaL_loadfile that keeps the compiled chunk and only parses the file again when it changes */
+static int lua_load_file(lua_State * L, const char *file)
+{
+	switch_time_t start = switch_time_now();
+	switch_stream_handle_t stream = { 0 };
+	lua_chunk_t *chunk, *old;
+	struct stat st;
+	int error;
+
+	if (!globals.bytecode_cache || stat(file, &st)) {
+		error = luaL_loadfile(L, file);
+		goto end;
+	}
+
+	switch_thread_rwlock_rdlock(globals.chunk_rwlock);
+	if ((chunk = (lua_chunk_t *) switch_core_hash_find(globals.chunks, file)) &&
+		chunk->mtime == st.st_mtime && chunk->size == st.st_size && chunk->ino == st.st_ino) {
+		error = luaL_loadbuffer(L, chunk->data, chunk->len, file);
+		switch_thread_rwlock_unlock(globals.chunk_rwlock);
+		switch_core_metric_inc(globals.cache_hits);
+		goto end;
+	}
+	switch_thread_rwlock_unlock(globals.chunk_rwlock);
+
+	switch_core_metric_inc(globals.cache_misses);
+
+	if ((error = luaL_loadfile(L, file))) {
+		goto end;
+	}
+
+	SWITCH_STANDARD_STREAM(stream);
+
+#if LUA_VERSION_NUM >= 503
+	if (lua_dump(L, lua_chunk_writer, &stream, 0) || !stream.data_len) {
+#else
+	if (lua_dump(L, lua_chunk_writer, &stream) || !stream.data_len) {
+#endif
+		switch_safe_free(stream.data);
+		goto end;
+	}
+
+	chunk = (lua_chunk_t *) calloc(1, sizeof(*chunk));
+	switch_assert(chunk);
+	chunk->data = (char *) stream.data;
+	chunk->len = stream.data_len;
+	chunk->mtime = st.st_mtime;
+	chunk->size = st.st_size;
+	chunk->ino = st.st_ino;
+
+	switch_thread_rwlock_wrlock(globals.chunk_rwlock);
+	if ((old = (lua_chunk_t *) switch_core_hash_find(globals.chunks, file))) {
+		switch_core_hash_delete(globals.chunks, file);
+		lua_chunk_free(old);
+	}
+	switch_core_hash_insert(globals.chunks, file, chunk);
+	switch_thread_rwlock_unlock(globals.chunk_rwlock);
+
+  end:
+
+	switch_core_metric_add(globals.setup_usec, switch_time_now() - start);
+
+	return error;
+}
+
 
 static int lua_parse_and_execute(lua_State * L, char *input_code, switch_core_session_t *session)
 {
@@ -191,7 +502,7 @@ static int lua_parse_and_execute(lua_State * L, char *input_code, switch_core_se
 				switch_assert(fdup);
 				file = fdup;
 			}
-			error = luaL_loadfile(L, file) || docall(L, 0, 0, 0, 1);
+			error = lua_load_file(L, file) || docall(L, 0, 0, 0, 1);
 			switch_safe_free(fdup);
 		}
 	}
@@ -237,11 +548,11 @@ static switch_xml_t lua_fetch(const char *section,
 	switch_xml_t xml = NULL;
 	char *mycmd = NULL;
 	lua_State *L = NULL;
+	int error = 0;
 
 	if (!zstr(globals.xml_handler)) {
-		L = lua_init();
+		L = lua_acquire();
 		const char *str;
-		int error;
 
 		mycmd = strdup(globals.xml_handler);
 		switch_assert(mycmd);
@@ -291,9 +602,7 @@ static switch_xml_t lua_fetch(const char *section,
 
 	switch_safe_free(mycmd);
 
-	if (L) {
-		lua_uninit(L);
-	}
+	lua_release(L, error);
 
 	return xml;
 }
@@ -333,6 +642,14 @@ static switch_status_t do_config(void)
 					cpath_stream.write_function(&cpath_stream, ";");
 				}
 				cpath_stream.write_function(&cpath_stream, "%s", val);
+			} else if (!strcmp(var, "state-pool-size")) {
+				int tmp = atoi(val);
+				globals.state_pool_size = tmp > 0 ? (tmp > LUA_POOL_MAX ? LUA_POOL_MAX : tmp) : 0;
+			} else if (!strcmp(var, "state-pool-max-uses")) {
+				int tmp = atoi(val);
+				globals.state_max_uses = tmp > 0 ? tmp : 0;
+			} else if (!strcmp(var, "bytecode-cache")) {
+				globals.bytecode_cache = switch_true(val);
 			} else if (!strcmp(var, "script-directory") && !zstr(val)) {
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "lua: appending script directory: '%s'\n", val);
 				if (path_stream.data_len) {
@@ -450,8 +767,9 @@ int lua_thread(const char *text)
 
 static void lua_event_handler(switch_event_t *event)
 {
-	lua_State *L = lua_init();
+	lua_State *L = lua_acquire();
 	char *script = NULL;
+	int error;
 
 	if (event->bind_user_data) {
 		script = strdup((char *)event->bind_user_data);
@@ -459,33 +777,75 @@ static void lua_event_handler(switch_event_t *event)
 
 	mod_lua_conjure_event(L, event, "event", 1);
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG10, "lua event hook: execute '%s'\n", (char *)script);
-	lua_parse_and_execute(L, (char *)script, NULL);
-	lua_uninit(L);
+	error = lua_parse_and_execute(L, (char *)script, NULL);
+	lua_release(L, error);
 
 	switch_safe_free(script);
 }
 
 SWITCH_STANDARD_APP(lua_function)
 {
-	lua_State *L = lua_init();
+	lua_State *L;
 	char *mycmd;
+	int error;
 
 	if (zstr(data)) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "no args specified!\n");
 		return;
 	}
 
+	L = lua_acquire();
 	mod_lua_conjure_session(L, session, "session", 1);
 
 	mycmd = strdup((char *) data);
 	switch_assert(mycmd);
 
-	lua_parse_and_execute(L, mycmd, session);
-	lua_uninit(L);
+	error = lua_parse_and_execute(L, mycmd, session);
+	lua_release(L, error);
 	free(mycmd);
 
 }
 
+static void lua_reload_event_handler(switch_event_t *event)
+{
+	lua_flush_chunks();
+}
+
+#define LUACACHE_SYNTAX "status|flush"
+SWITCH_STANDARD_API(luacache_api_function)
+{
+	if (zstr(cmd) || !strcasecmp(cmd, "status")) {
+		double setups = switch_core_metric_value(globals.setups);
+		uint32_t idle, chunks = 0;
+		switch_hash_index_t *hi;
+
+		switch_mutex_lock(globals.state_mutex);
+		idle = globals.state_count;
+		switch_mutex_unlock(globals.state_mutex);
+
+		switch_thread_rwlock_rdlock(globals.chunk_rwlock);
+		for (hi = switch_core_hash_first(globals.chunks); hi; hi = switch_core_hash_next(&hi)) {
+			chunks++;
+		}
+		switch_thread_rwlock_unlock(globals.chunk_rwlock);
+
+		stream->write_function(stream, "state pool: %u idle of %u, %.0f hits, %.0f misses\n",
+							   idle, globals.state_pool_size, switch_core_metric_value(globals.pool_hits), switch_core_metric_value(globals.pool_misses));
+		stream->write_function(stream, "bytecode cache: %s, %u scripts, %.0f hits, %.0f misses\n", globals.bytecode_cache ? "on" : "off",
+							   chunks, switch_core_metric_value(globals.cache_hits), switch_core_metric_value(globals.cache_misses));
+		stream->write_function(stream, "script setup: %.0f, %.1fus average\n", setups,
+							   setups ? switch_core_metric_value(globals.setup_usec) / setups : 0);
+	} else if (!strcasecmp(cmd, "flush")) {
+		lua_flush_chunks();
+		lua_drain_pool();
+		stream->write_function(stream, "+OK\n");
+	} else {
+		stream->write_function(stream, "-USAGE: %s\n", LUACACHE_SYNTAX);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_STANDARD_API(luarun_api_function)
 {
 
@@ -501,16 +861,17 @@ SWITCH_STANDARD_API(luarun_api_function)
 
 SWITCH_STANDARD_CHAT_APP(lua_chat_function)
 {
-	lua_State *L = lua_init();
+	lua_State *L = lua_acquire();
 	char *dup = NULL;
+	int error;
 
 	if (data) {
 		dup = strdup(data);
 	}
 
 	mod_lua_conjure_event(L, message, "message", 1);
-	lua_parse_and_execute(L, (char *)dup, NULL);
-	lua_uninit(L);
+	error = lua_parse_and_execute(L, (char *)dup, NULL);
+	lua_release(L, error);
 
 	switch_safe_free(dup);
 
@@ -527,7 +888,7 @@ SWITCH_STANDARD_API(lua_api_function)
 	if (zstr(cmd)) {
 		stream->write_function(stream, "");
 	} else {
-		lua_State *L = lua_init();
+		lua_State *L = lua_acquire();
 		mycmd = strdup(cmd);
 		switch_assert(mycmd);
 
@@ -552,7 +913,7 @@ SWITCH_STANDARD_API(lua_api_function)
 				stream->write_function(stream, "-ERR Cannot execute script\n");
 			}
 		}
-		lua_uninit(L);
+		lua_release(L, error);
 		free(mycmd);
 	}
 	return SWITCH_STATUS_SUCCESS;
@@ -560,10 +921,11 @@ SWITCH_STANDARD_API(lua_api_function)
 
 SWITCH_STANDARD_DIALPLAN(lua_dialplan_hunt)
 {
-	lua_State *L = lua_init();
+	lua_State *L = lua_acquire();
 	switch_caller_extension_t *extension = NULL;
 	switch_channel_t *channel = switch_core_session_get_channel(session);
 	char *cmd = NULL;
+	int error = 0;
 
 	if (!caller_profile) {
 		if (!(caller_profile = switch_channel_get_caller_profile(channel))) {
@@ -588,7 +950,7 @@ SWITCH_STANDARD_DIALPLAN(lua_dialplan_hunt)
 	switch_assert(cmd);
 
 	mod_lua_conjure_session(L, session, "session", 1);
-	lua_parse_and_execute(L, cmd, session);
+	error = lua_parse_and_execute(L, cmd, session);
 
 	/* expecting ACTIONS = { {"app1", "app_data1"}, { "app2" }, "app3" } -- each of three is valid */
 	lua_getglobal(L, "ACTIONS");
@@ -672,7 +1034,7 @@ SWITCH_STANDARD_DIALPLAN(lua_dialplan_hunt)
 
  done:
 	switch_safe_free(cmd);
-	lua_uninit(L);
+	lua_release(L, error);
 	return extension;
 }
 
@@ -688,6 +1050,9 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_lua_load)
 
 	SWITCH_ADD_API(api_interface, "luarun", "run a script", luarun_api_function, "<script>");
 	SWITCH_ADD_API(api_interface, "lua", "run a script as an api function", lua_api_function, "<script>");
+	SWITCH_ADD_API(api_interface, "luacache", "show or flush the lua state pool and bytecode cache", luacache_api_function, LUACACHE_SYNTAX);
+	switch_console_set_complete("add luacache status");
+	switch_console_set_complete("add luacache flush");
 	SWITCH_ADD_APP(app_interface, "lua", "Launch LUA ivr", "Run a lua ivr on a channel", lua_function, "<script>",
 				   SAF_SUPPORT_NOMEDIA | SAF_ROUTING_EXEC | SAF_ZOMBIE_EXEC | SAF_SUPPORT_TEXT_ONLY);
 	SWITCH_ADD_DIALPLAN(dp_interface, "LUA", lua_dialplan_hunt);
@@ -696,6 +1061,23 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_lua_load)
 
 
 	globals.pool = pool;
+	globals.state_max_uses = 1000;
+	globals.bytecode_cache = SWITCH_TRUE;
+	switch_mutex_init(&globals.state_mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_thread_rwlock_create(&globals.chunk_rwlock, pool);
+	switch_core_hash_init(&globals.chunks);
+
+	switch_core_metric_register("freeswitch_lua_state_pool_hits_total", NULL, "Lua states taken from the pool", SWITCH_METRIC_COUNTER, &globals.pool_hits);
+	switch_core_metric_register("freeswitch_lua_state_pool_misses_total", NULL, "Lua states created because the pool was empty", SWITCH_METRIC_COUNTER, &globals.pool_misses);
+	switch_core_metric_register("freeswitch_lua_bytecode_cache_hits_total", NULL, "Lua scripts loaded from the bytecode cache", SWITCH_METRIC_COUNTER, &globals.cache_hits);
+	switch_core_metric_register("freeswitch_lua_bytecode_cache_misses_total", NULL, "Lua scripts parsed from disk", SWITCH_METRIC_COUNTER, &globals.cache_misses);
+	switch_core_metric_register("freeswitch_lua_setup_microseconds_total", NULL, "Time spent getting a state and loading scripts", SWITCH_METRIC_COUNTER, &globals.setup_usec);
+	switch_core_metric_register("freeswitch_lua_setups_total", NULL, "Lua script runs set up", SWITCH_METRIC_COUNTER, &globals.setups);
+
+	if (switch_event_bind(modname, SWITCH_EVENT_RELOADXML, NULL, lua_reload_event_handler, NULL) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Couldn't bind to reloadxml, the bytecode cache will only notice changed files\n");
+	}
+
 	do_config();
 
 	/* indicate that the module should continue to be loaded */
@@ -705,6 +1087,11 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_lua_load)
 SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_lua_shutdown)
 {
 	switch_event_unbind_callback(lua_event_handler);
+	switch_event_unbind_callback(lua_reload_event_handler);
+
+	lua_drain_pool();
+	lua_flush_chunks();
+	switch_core_hash_destroy(&globals.chunks);
 
 	return SWITCH_STATUS_SUCCESS;
 }
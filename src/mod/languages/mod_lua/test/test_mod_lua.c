@@ -56,6 +56,29 @@ FST_CORE_BEGIN("conf")
 		}
 		FST_TEST_END()
 
+		FST_TEST_BEGIN(pool_test)
+		{
+			switch_stream_handle_t stream = { 0 };
+			int i;
+
+			for (i = 0; i < 3; i++) {
+				SWITCH_STANDARD_STREAM(stream);
+				switch_api_execute("lua", "test_pool.lua", NULL, &stream);
+				fst_requires(stream.data);
+				fst_check(strstr(stream.data, "+OK") == stream.data);
+				free(stream.data);
+			}
+
+			SWITCH_STANDARD_STREAM(stream);
+			switch_api_execute("luacache", "status", NULL, &stream);
+			fst_requires(stream.data);
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "LUA CACHE: %s\n", (char *)stream.data);
+			fst_check(strstr(stream.data, "state pool: 1 idle of 4") != NULL);
+			fst_check(strstr(stream.data, "bytecode cache: on") != NULL);
+			free(stream.data);
+		}
+		FST_TEST_END()
+
 		FST_TEARDOWN_BEGIN()
 		{
 		}
@@ -0,0 +1,10 @@
+-- a pooled state must not carry globals over from the last run
+local seen = leaked_global ~= nil
+
+leaked_global = true
+
+if seen then
+	stream:write("-ERR leaked_global survived the reset\n")
+else
+	stream:write("+OK\n")
+end
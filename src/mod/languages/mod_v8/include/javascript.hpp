@@ -235,6 +235,9 @@ public:
 	/* Returns the JS object related to the C++ instance */
 	v8::Handle<v8::Object> GetJavaScriptObject();
 
+	/* Build the constructor template of a C++ class, so it can be baked into a global object template (must be called within a entered isolate) */
+	static v8::Handle<v8::FunctionTemplate> CreateClassTemplate(v8::Isolate *isolate, const js_class_definition_t *desc);
+
 	/* Register a C++ class inside V8 (must be called within a entered isolate, and context) */
 	static void Register(v8::Isolate *isolate, const js_class_definition_t *desc);
 
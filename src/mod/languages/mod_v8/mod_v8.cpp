@@ -110,10 +110,18 @@ SWITCH_MODULE_DEFINITION_EX(mod_v8, mod_v8_load, mod_v8_shutdown, NULL, SMODF_GL
 static switch_api_interface_t *jsrun_interface = NULL;
 static switch_api_interface_t *jsapi_interface = NULL;
 static switch_api_interface_t *jsmon_interface = NULL;
+static switch_api_interface_t *jsstats_interface = NULL;
 
 /* Module manager for loadable modules */
 module_manager_t module_manager = { 0 };
 
+/* An isolate kept warm between script runs, together with its prebuilt global template */
+typedef struct v8_pooled_isolate_s {
+	JSMain *js;
+	Persistent<ObjectTemplate> global_template;	/* Global functions and core classes, built once per isolate */
+	uint32_t uses;
+} v8_pooled_isolate_t;
+
 /* Global data for this module */
 typedef struct {
 	switch_memory_pool_t *pool;
@@ -131,7 +139,21 @@ typedef struct {
 	switch_time_t cache_expires_seconds;
 	bool performance_monitor;
 	switch_mutex_t *mutex;
+	char *script_cache_dir;
+	bool persistent_script_cache;
+	switch_hash_t *script_stats_hash;
+	switch_mutex_t *script_stats_mutex;
+	switch_metric_t *compile_metric;
+	switch_metric_t *run_metric;
+	switch_metric_t *cache_hit_metric;
 #endif
+	switch_mutex_t *isolate_pool_mutex;
+	vector<v8_pooled_isolate_t *> *isolate_pool;
+	uint32_t isolate_pool_size;
+	uint32_t isolate_pool_max_uses;
+	switch_metric_t *isolate_created_metric;
+	switch_metric_t *isolate_reused_metric;
+	switch_metric_t *isolate_idle_metric;
 } mod_v8_global_t;
 
 static mod_v8_global_t globals = { 0 };
@@ -142,7 +164,31 @@ typedef struct {
 	std::shared_ptr<uint8_t> data;
 	int length;
 	switch_time_t compile_time;
+	uint32_t source_hash;
+	uint32_t source_length;
 } v8_compiled_script_cache_t;
+
+/* Header of a code cache file persisted in script-cache-dir */
+#define V8_CODE_CACHE_MAGIC 0x38565346 /* "FSV8" */
+typedef struct {
+	uint32_t magic;
+	uint32_t version_tag;		/* ScriptCompiler::CachedDataVersionTag() of the V8 that produced it */
+	uint32_t source_hash;
+	uint32_t source_length;
+	uint32_t data_length;
+} v8_code_cache_header_t;
+
+/* Compile and run timing of a single script */
+typedef struct {
+	uint64_t runs;
+	uint64_t errors;
+	uint64_t cache_hits;
+	switch_time_t compile_total;
+	switch_time_t compile_max;
+	switch_time_t run_total;
+	switch_time_t run_max;
+	switch_time_t last_run;
+} v8_script_stats_t;
 #endif
 
 /* Loadable module struct, used for external extension modules */
@@ -341,9 +387,21 @@ static void load_configuration(void)
 				} else if (!strcmp(var, "cache-expires-sec")) {
 					int v = atoi(val);
 					globals.cache_expires_seconds = (v > 0) ? v : 0;
+				} else if (!strcmp(var, "persistent-script-cache")) {
+					globals.persistent_script_cache = switch_true(val);
+				} else if (!strcmp(var, "script-cache-dir")) {
+					if (!zstr(val)) {
+						globals.script_cache_dir = switch_core_strdup(globals.pool, val);
+					}
 				} else 
 #endif
-				if (!strcmp(var, "xml-handler-script")) {
+				if (!strcmp(var, "isolate-pool-size")) {
+					int v = atoi(val);
+					globals.isolate_pool_size = (v > 0) ? v : 0;
+				} else if (!strcmp(var, "isolate-pool-max-uses")) {
+					int v = atoi(val);
+					globals.isolate_pool_max_uses = (v > 0) ? v : 0;
+				} else if (!strcmp(var, "xml-handler-script")) {
 					globals.xml_handler = switch_core_strdup(globals.pool, val);
 				}
 				else if (!strcmp(var, "xml-handler-bindings")) {
@@ -418,6 +476,130 @@ static int env_init(JSMain *js)
 	return 1;
 }
 
+/* Take a warm isolate from the pool, or create a new one if the pool is empty */
+static v8_pooled_isolate_t *v8_acquire_isolate(void)
+{
+	v8_pooled_isolate_t *pi = NULL;
+
+	switch_mutex_lock(globals.isolate_pool_mutex);
+	if (!globals.isolate_pool->empty()) {
+		pi = globals.isolate_pool->back();
+		globals.isolate_pool->pop_back();
+	}
+	switch_mutex_unlock(globals.isolate_pool_mutex);
+
+	if (pi) {
+		switch_core_metric_dec(globals.isolate_idle_metric);
+		switch_core_metric_inc(globals.isolate_reused_metric);
+	} else {
+		pi = new v8_pooled_isolate_t();
+		pi->js = new JSMain();
+		pi->uses = 0;
+		env_init(pi->js);
+		switch_core_metric_inc(globals.isolate_created_metric);
+	}
+
+	pi->uses++;
+
+	return pi;
+}
+
+static void v8_destroy_isolate(v8_pooled_isolate_t *pi)
+{
+	Isolate *isolate = pi->js->GetIsolate();
+
+	{
+		Locker lock(isolate);
+		Isolate::Scope iscope(isolate);
+		pi->global_template.Reset();
+	}
+
+	delete pi->js;
+	delete pi;
+}
+
+/* Hand an isolate back to the pool, isolates that ran into an error or are worn out are destroyed instead */
+static void v8_release_isolate(v8_pooled_isolate_t *pi, bool reusable)
+{
+	if (reusable && (!globals.isolate_pool_max_uses || pi->uses < globals.isolate_pool_max_uses)) {
+		switch_mutex_lock(globals.isolate_pool_mutex);
+		if (globals.isolate_pool->size() < globals.isolate_pool_size) {
+			globals.isolate_pool->push_back(pi);
+			pi = NULL;
+		}
+		switch_mutex_unlock(globals.isolate_pool_mutex);
+
+		if (!pi) {
+			switch_core_metric_inc(globals.isolate_idle_metric);
+			return;
+		}
+	}
+
+	v8_destroy_isolate(pi);
+}
+
+static void v8_drain_isolate_pool(void)
+{
+	v8_pooled_isolate_t *pi;
+
+	for (;;) {
+		pi = NULL;
+
+		switch_mutex_lock(globals.isolate_pool_mutex);
+		if (!globals.isolate_pool->empty()) {
+			pi = globals.isolate_pool->back();
+			globals.isolate_pool->pop_back();
+		}
+		switch_mutex_unlock(globals.isolate_pool_mutex);
+
+		if (!pi) {
+			break;
+		}
+
+		switch_core_metric_dec(globals.isolate_idle_metric);
+		v8_destroy_isolate(pi);
+	}
+}
+
+/*
+	The global object template holds the global functions and the always available classes.
+	It is built once per isolate and every script run on that isolate instantiates its context from it,
+	instead of rebuilding all the bindings from scratch. Must be called within a entered isolate and handle scope.
+*/
+static Local<ObjectTemplate> v8_global_template(v8_pooled_isolate_t *pi)
+{
+	JSMain *js = pi->js;
+	Isolate *isolate = js->GetIsolate();
+
+	if (!pi->global_template.IsEmpty()) {
+		return Local<ObjectTemplate>::New(isolate, pi->global_template);
+	}
+
+	Local<ObjectTemplate> global = ObjectTemplate::New(isolate);
+
+	if (global.IsEmpty()) {
+		return global;
+	}
+
+	/* Add all global functions */
+	for (size_t i = 0; i < js->GetExtenderFunctions().size(); i++) {
+		js_function_t *proc = js->GetExtenderFunctions()[i];
+		global->Set(String::NewFromUtf8(isolate, proc->name), FunctionTemplate::New(isolate, proc->func));
+	}
+
+#if defined(V8_MAJOR_VERSION) && V8_MAJOR_VERSION >=5
+	/* Add all plugin classes */
+	for (size_t i = 0; i < js->GetExtenderClasses().size(); i++) {
+		const js_class_definition_t *desc = js->GetExtenderClasses()[i];
+		global->Set(String::NewFromUtf8(isolate, desc->name), JSBase::CreateClassTemplate(isolate, desc));
+	}
+#endif
+
+	pi->global_template.Reset(isolate, global);
+
+	return global;
+}
+
 static void v8_error(Isolate* isolate, TryCatch* try_catch)
 {
 	HandleScope handle_scope(isolate);
@@ -516,13 +698,170 @@ static void destructor(void *ptr)
 	delete (v8_compiled_script_cache_t*)ptr;
 }
 
-void LoadScript(MaybeLocal<v8::Script> *v8_script, Isolate *isolate, const char *script_data, const char *script_file)
+static void v8_script_stats_record(const char *script_file, switch_time_t compile_time, switch_time_t run_time, bool cache_hit, bool error)
+{
+	v8_script_stats_t *stats;
+
+	switch_mutex_lock(globals.script_stats_mutex);
+
+	if (!(stats = (v8_script_stats_t *)switch_core_hash_find(globals.script_stats_hash, script_file))) {
+		stats = (v8_script_stats_t *) calloc(1, sizeof(*stats));
+		switch_assert(stats);
+		switch_core_hash_insert_destructor(globals.script_stats_hash, script_file, stats, free);
+	}
+
+	stats->runs++;
+	if (error) stats->errors++;
+	if (cache_hit) stats->cache_hits++;
+	stats->compile_total += compile_time;
+	if (compile_time > stats->compile_max) stats->compile_max = compile_time;
+	stats->run_total += run_time;
+	if (run_time > stats->run_max) stats->run_max = run_time;
+	stats->last_run = switch_time_now();
+
+	switch_mutex_unlock(globals.script_stats_mutex);
+
+	switch_core_metric_add(globals.compile_metric, compile_time);
+	switch_core_metric_add(globals.run_metric, run_time);
+	if (cache_hit) switch_core_metric_inc(globals.cache_hit_metric);
+}
+
+/* The code cache file of a script is named after the md5 of its path */
+static char *v8_code_cache_file(const char *script_file)
+{
+	char digest[SWITCH_MD5_DIGEST_STRING_SIZE] = { 0 };
+
+	switch_md5_string(digest, (void *) script_file, strlen(script_file));
+
+	return switch_mprintf("%s%s%s.jsc", globals.script_cache_dir, SWITCH_PATH_SEPARATOR, digest);
+}
+
+/* Load a code cache persisted by a previous run, it's only used when it matches both the V8 build and the current source */
+static v8_compiled_script_cache_t *v8_code_cache_read(const char *script_file, uint32_t source_hash, uint32_t source_length)
+{
+	v8_compiled_script_cache_t *cache = NULL;
+	v8_code_cache_header_t header;
+	uint8_t *data = NULL;
+	char *file;
+	FILE *fp;
+
+	if (!globals.persistent_script_cache || !(file = v8_code_cache_file(script_file))) {
+		return NULL;
+	}
+
+	if (!(fp = fopen(file, "rb"))) {
+		goto end;
+	}
+
+	if (fread(&header, sizeof(header), 1, fp) != 1 || header.magic != V8_CODE_CACHE_MAGIC || header.version_tag != ScriptCompiler::CachedDataVersionTag() ||
+		header.source_hash != source_hash || header.source_length != source_length || !header.data_length) {
+		perf_log("Javascript ['%s'] persisted cache is stale.\n", script_file);
+		fclose(fp);
+		remove(file);
+		goto end;
+	}
+
+	data = new uint8_t[header.data_length];
+
+	if (fread(data, header.data_length, 1, fp) != 1) {
+		delete[] data;
+		fclose(fp);
+		remove(file);
+		goto end;
+	}
+
+	fclose(fp);
+
+	cache = new v8_compiled_script_cache_t;
+	cache->data.reset(data, array_deleter<uint8_t>());
+	cache->length = header.data_length;
+	cache->compile_time = switch_time_now();
+	cache->source_hash = source_hash;
+	cache->source_length = source_length;
+
+	perf_log("Javascript ['%s'] cache was loaded from %s.\n", script_file, file);
+
+  end:
+
+	switch_safe_free(file);
+
+	return cache;
+}
+
+/* Persist a freshly produced code cache, written to a temporary file first so a crash never leaves a torn cache behind */
+static void v8_code_cache_write(const char *script_file, const v8_compiled_script_cache_t *cache)
+{
+	v8_code_cache_header_t header = { 0 };
+	char *file, *tmp = NULL;
+	FILE *fp;
+
+	if (!globals.persistent_script_cache || !(file = v8_code_cache_file(script_file))) {
+		return;
+	}
+
+	header.magic = V8_CODE_CACHE_MAGIC;
+	header.version_tag = ScriptCompiler::CachedDataVersionTag();
+	header.source_hash = cache->source_hash;
+	header.source_length = cache->source_length;
+	header.data_length = cache->length;
+
+	tmp = switch_mprintf("%s.%d.tmp", file, (int) switch_thread_self());
+
+	if (!(fp = fopen(tmp, "wb"))) {
+		/* The cache directory is created on the first write */
+		switch_mutex_lock(globals.mutex);
+		switch_dir_make_recursive(globals.script_cache_dir, SWITCH_DEFAULT_DIR_PERMS, globals.pool);
+		switch_mutex_unlock(globals.mutex);
+
+		fp = fopen(tmp, "wb");
+	}
+
+	if (!fp) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Cannot write Javascript cache file %s\n", tmp);
+		goto end;
+	}
+
+	if (fwrite(&header, sizeof(header), 1, fp) != 1 || fwrite(cache->data.get(), cache->length, 1, fp) != 1) {
+		fclose(fp);
+		remove(tmp);
+		goto end;
+	}
+
+	fclose(fp);
+
+	if (rename(tmp, file)) {
+		remove(tmp);
+	}
+
+  end:
+
+	switch_safe_free(tmp);
+	switch_safe_free(file);
+}
+
+static void v8_code_cache_remove(const char *script_file)
+{
+	char *file;
+
+	switch_core_hash_delete_locked(globals.compiled_script_hash, script_file, globals.compiled_script_hash_mutex);
+
+	if (globals.persistent_script_cache && (file = v8_code_cache_file(script_file))) {
+		remove(file);
+		free(file);
+	}
+}
+
+void LoadScript(MaybeLocal<v8::Script> *v8_script, Isolate *isolate, const char *script_data, const char *script_file, bool *cache_hit)
 {
 	switch_time_t start = switch_time_now();
 
 	ScriptCompiler::CachedData *cached_data = 0;
 	v8_compiled_script_cache_t *stored_compiled_script_cache = NULL;
 	ScriptCompiler::CompileOptions options;
+	switch_ssize_t source_length = (switch_ssize_t)strlen(script_data);
+	uint32_t source_hash = switch_hashfunc_default(script_data, &source_length);
+
+	*cache_hit = false;
 
 	/*
 		Do not cache if the caching is disabled
@@ -545,14 +884,29 @@ void LoadScript(MaybeLocal<v8::Script> *v8_script, Isolate *isolate, const char
 
 		switch_mutex_unlock(globals.compiled_script_hash_mutex);
 
+		if (!stored_compiled_script_cache) {
+			/* Nothing in memory yet, try the cache persisted by a previous run */
+			if ((stored_compiled_script_cache = v8_code_cache_read(script_file, source_hash, (uint32_t)source_length))) {
+				v8_compiled_script_cache_t *compiled_script_cache = new v8_compiled_script_cache_t;
+				*compiled_script_cache = *stored_compiled_script_cache;
+
+				switch_mutex_lock(globals.compiled_script_hash_mutex);
+				switch_core_hash_insert_destructor(globals.compiled_script_hash, script_file, compiled_script_cache, destructor);
+				switch_mutex_unlock(globals.compiled_script_hash_mutex);
+			}
+		}
+
 		if (stored_compiled_script_cache)
 		{
 			switch_time_t time_left_since_compile_sec = (switch_time_now() - stored_compiled_script_cache->compile_time) / 1000000;
-			if (time_left_since_compile_sec <= globals.cache_expires_seconds || globals.cache_expires_seconds == 0) {
+			if (stored_compiled_script_cache->source_hash != source_hash || stored_compiled_script_cache->source_length != (uint32_t)source_length) {
+				perf_log("Javascript ['%s'] source changed, cache dropped.\n", script_file);
+				v8_code_cache_remove(script_file);
+			} else if (time_left_since_compile_sec <= globals.cache_expires_seconds || globals.cache_expires_seconds == 0) {
 				cached_data = new ScriptCompiler::CachedData(stored_compiled_script_cache->data.get(), stored_compiled_script_cache->length, ScriptCompiler::CachedData::BufferNotOwned);
 			} else {
 				perf_log("Javascript ['%s'] cache expired.\n", script_file);
-				switch_core_hash_delete_locked(globals.compiled_script_hash, script_file, globals.compiled_script_hash_mutex);
+				v8_code_cache_remove(script_file);
 			}
 
 		}
@@ -574,6 +928,10 @@ void LoadScript(MaybeLocal<v8::Script> *v8_script, Isolate *isolate, const char
 			compiled_script_cache->data.reset(raw_cached_data, array_deleter<uint8_t>());
 			compiled_script_cache->length = length;
 			compiled_script_cache->compile_time = switch_time_now();
+			compiled_script_cache->source_hash = source_hash;
+			compiled_script_cache->source_length = (uint32_t)source_length;
+
+			v8_code_cache_write(script_file, compiled_script_cache);
 
 			switch_mutex_lock(globals.compiled_script_hash_mutex);
 			switch_core_hash_insert_destructor(globals.compiled_script_hash, script_file, compiled_script_cache, destructor);
@@ -585,9 +943,10 @@ void LoadScript(MaybeLocal<v8::Script> *v8_script, Isolate *isolate, const char
 
 			if (source.GetCachedData()->rejected) {
 				perf_log("Javascript ['%s'] cache was rejected.\n", script_file);
-				switch_core_hash_delete_locked(globals.compiled_script_hash, script_file, globals.compiled_script_hash_mutex);
+				v8_code_cache_remove(script_file);
 			} else {
 				perf_log("Javascript ['%s'] execution using cache.\n", script_file);
+				*cache_hit = true;
 			}
 
 		}
@@ -605,8 +964,10 @@ void LoadScript(MaybeLocal<v8::Script> *v8_script, Isolate *isolate, const char
 static int v8_parse_and_execute(switch_core_session_t *session, const char *input_code, switch_stream_handle_t *api_stream, v8_event_t *v8_event, v8_xml_handler_t* xml_handler)
 {
 	string res;
+	v8_pooled_isolate_t *pi;
 	JSMain *js;
 	Isolate *isolate;
+	bool reusable = true;
 	char *arg, *argv[512];
 	int argc = 0;
 	unsigned int flags = 0;
@@ -618,11 +979,10 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 		return -1;
 	}
 
-	js = new JSMain();
+	pi = v8_acquire_isolate();
+	js = pi->js;
 	isolate = js->GetIsolate();
 
-	env_init(js);
-
 	/* Try to read lock the session first */
 	if (session) {
 		if (switch_core_session_read_lock_hangup(session) != SWITCH_STATUS_SUCCESS) {
@@ -645,6 +1005,10 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 			// Store our object internally
 			isolate->SetData(ISOLATE_DATA_OBJECT, js);
 
+			// A pooled isolate must not inherit a termination aimed at its previous script
+			isolate->CancelTerminateExecution();
+			js->ResetForcedTermination();
+
 			// Set isolate related data.
 			switch_uuid_t task_id;
 			switch_uuid_get(&task_id);
@@ -664,23 +1028,19 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 			(*globals.task_manager)[str_task_id] = isolate;
 			switch_mutex_unlock(globals.task_manager_mutex);
 
-			// New global template
-			Handle<ObjectTemplate> global = ObjectTemplate::New(isolate);
+			// Global template, prebuilt once per isolate
+			Handle<ObjectTemplate> global = v8_global_template(pi);
 
 			if (global.IsEmpty()) {
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Failed to create JS global object template\n");
+				reusable = false;
 			} else {
-				/* Add all global functions */
-				for (size_t i = 0; i < js->GetExtenderFunctions().size(); i++) {
-					js_function_t *proc = js->GetExtenderFunctions()[i];
-					global->Set(String::NewFromUtf8(isolate, proc->name), FunctionTemplate::New(isolate, proc->func));
-				}
-
 				// Create a new context.
 				Local<Context> context = Context::New(isolate, NULL, global);
 
 				if (context.IsEmpty()) {
 					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Failed to create JS context\n");
+					reusable = false;
 				} else {
 					// Enter the created context for compiling and running the script.
 					Context::Scope context_scope(context);
@@ -703,10 +1063,12 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 					}
 #endif
 
+#if !defined(V8_MAJOR_VERSION) || V8_MAJOR_VERSION < 5
 					/* Register all plugin classes */
 					for (size_t i = 0; i < js->GetExtenderClasses().size(); i++) {
 						JSBase::Register(isolate, js->GetExtenderClasses()[i]);
 					}
+#endif
 
 					/* Register all instances of specific plugin classes */
 					for (size_t i = 0; i < js->GetExtenderInstances().size(); i++) {
@@ -814,9 +1176,11 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 
 						// Compile the source code.
 #if defined(V8_MAJOR_VERSION) && V8_MAJOR_VERSION >=5
+						bool cache_hit = false;
 						switch_time_t start = switch_time_now();
 						MaybeLocal<v8::Script> v8_script;
-						LoadScript(&v8_script, isolate, script_data, script_file);
+						LoadScript(&v8_script, isolate, script_data, script_file, &cache_hit);
+						switch_time_t compiled = switch_time_now();
 #else
 						// Create a string containing the JavaScript source code.
 						Handle<String> source = String::NewFromUtf8(isolate, script_data);
@@ -825,6 +1189,10 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 
 						if (try_catch.HasCaught()) {
 							v8_error(isolate, &try_catch);
+							reusable = false;
+#if defined(V8_MAJOR_VERSION) && V8_MAJOR_VERSION >=5
+							v8_script_stats_record(script_file, compiled - start, 0, cache_hit, true);
+#endif
 						} else {
 							// Run the script
 #ifdef V8_ENABLE_DEBUGGING
@@ -841,18 +1209,22 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 								script_result = v8_script.ToLocalChecked()->Run();
 							}
 
+							switch_time_t end = switch_time_now();
+
 							switch_mutex_lock(globals.mutex);
 							if (globals.performance_monitor) {
-								switch_time_t end = switch_time_now();
 								unsigned int delay = (end - start);
 								switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Javascript execution time: %u microseconds\n", delay);
 							}
 							switch_mutex_unlock(globals.mutex);
+
+							v8_script_stats_record(script_file, compiled - start, end - compiled, cache_hit, try_catch.HasCaught());
 #else
 							Handle<Value> result = v8_script->Run();
 #endif
 							if (try_catch.HasCaught()) {
 								v8_error(isolate, &try_catch);
+								reusable = false;
 							} else {
 								if (js->GetForcedTermination()) {
 									js->ResetForcedTermination();
@@ -878,12 +1250,12 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 								}
 							}
 						}
+					}
 
 #ifndef V8_FORCE_GC_AFTER_EXECUTION
-						/* Clear up all destroyable C++ instances */
-						js->DisposeActiveInstances();
+					/* Clear up all destroyable C++ instances, the FSSession/FSRequest ones exist even when there was no script to run */
+					js->DisposeActiveInstances();
 #endif
-					}
 #ifdef V8_ENABLE_DEBUGGING
 					isolate->SetData(ISOLATE_DATA_DEBUG, NULL);
 					if (debug_listen_port > 0) {
@@ -911,6 +1283,9 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 		V8::ContextDisposedNotification();
 		while (!V8::IdleNotification()) {}
 		js->DisposeActiveInstances();
+#else
+		/* Let the GC know the context is gone, the isolate might be reused by the next script */
+		isolate->ContextDisposedNotification();
 #endif
 	}
 	//isolate->Exit();
@@ -926,7 +1301,7 @@ static int v8_parse_and_execute(switch_core_session_t *session, const char *inpu
 	}
 
 	switch_safe_free(path);
-	delete js;
+	v8_release_isolate(pi, reusable);
 
 	return result;
 }
@@ -1204,6 +1579,55 @@ SWITCH_STANDARD_API(jsmon_function)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+#if defined(V8_MAJOR_VERSION) && V8_MAJOR_VERSION >=5
+SWITCH_STANDARD_API(jsstats_function)
+{
+	switch_hash_index_t *hi = NULL;
+	const void *var;
+	void *val;
+	size_t idle;
+
+	if (!zstr(cmd) && !strcasecmp(cmd, "reset")) {
+		switch_mutex_lock(globals.script_stats_mutex);
+		while ((hi = switch_core_hash_first_iter(globals.script_stats_hash, hi))) {
+			switch_core_hash_this(hi, &var, NULL, &val);
+			switch_core_hash_delete(globals.script_stats_hash, (const char *) var);
+		}
+		switch_safe_free(hi);
+		switch_mutex_unlock(globals.script_stats_mutex);
+
+		stream->write_function(stream, "+OK\n");
+		return SWITCH_STATUS_SUCCESS;
+	} else if (!zstr(cmd)) {
+		stream->write_function(stream, "USAGE: %s\n", jsstats_interface->syntax);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_lock(globals.isolate_pool_mutex);
+	idle = globals.isolate_pool->size();
+	switch_mutex_unlock(globals.isolate_pool_mutex);
+
+	stream->write_function(stream, "Isolate pool: %u idle, size %u, max uses %u\n", (unsigned) idle, globals.isolate_pool_size, globals.isolate_pool_max_uses);
+	stream->write_function(stream, "%-10s %-8s %-8s %-12s %-12s %-12s %-12s %s\n", "runs", "errors", "cached", "compile_avg", "compile_max", "run_avg", "run_max", "script");
+
+	switch_mutex_lock(globals.script_stats_mutex);
+	for (hi = switch_core_hash_first(globals.script_stats_hash); hi; hi = switch_core_hash_next(&hi)) {
+		v8_script_stats_t *stats;
+
+		switch_core_hash_this(hi, &var, NULL, &val);
+		stats = (v8_script_stats_t *) val;
+
+		stream->write_function(stream, "%-10" SWITCH_UINT64_T_FMT " %-8" SWITCH_UINT64_T_FMT " %-8" SWITCH_UINT64_T_FMT " %-12" SWITCH_TIME_T_FMT " %-12" SWITCH_TIME_T_FMT " %-12" SWITCH_TIME_T_FMT " %-12" SWITCH_TIME_T_FMT " %s\n",
+							   stats->runs, stats->errors, stats->cache_hits,
+							   (switch_time_t) (stats->compile_total / stats->runs), stats->compile_max,
+							   (switch_time_t) (stats->run_total / stats->runs), stats->run_max, (const char *) var);
+	}
+	switch_mutex_unlock(globals.script_stats_mutex);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+#endif
+
 SWITCH_STANDARD_API(kill_function)
 {
 	if (!zstr(cmd)) {
@@ -1495,7 +1919,12 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_v8_load)
 	switch_mutex_init(&globals.compiled_script_hash_mutex, SWITCH_MUTEX_NESTED, globals.pool);
 	switch_mutex_init(&globals.task_manager_mutex, SWITCH_MUTEX_NESTED, globals.pool);
 	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, globals.pool);
+	switch_mutex_init(&globals.script_stats_mutex, SWITCH_MUTEX_NESTED, globals.pool);
 #endif
+	switch_mutex_init(&globals.isolate_pool_mutex, SWITCH_MUTEX_NESTED, globals.pool);
+	globals.isolate_pool = new vector<v8_pooled_isolate_t *>();
+	globals.isolate_pool_size = 0;
+	globals.isolate_pool_max_uses = 1000;
 	switch_mutex_init(&globals.event_mutex, SWITCH_MUTEX_NESTED, globals.pool);
 	globals.event_handlers = new set<FSEventHandler *>();
 
@@ -1510,11 +1939,18 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_v8_load)
 	globals.cache_expires_seconds = 0;
 	globals.performance_monitor = false;
 	globals.script_caching = switch_core_strdup(globals.pool, "disabled");
+	globals.persistent_script_cache = true;
+	globals.script_cache_dir = switch_core_sprintf(globals.pool, "%s%sv8", SWITCH_GLOBAL_dirs.cache_dir, SWITCH_PATH_SEPARATOR);
 
 	JSMain::Initialize(&globals.v8platform);
 
 	switch_core_hash_init(&globals.compiled_script_hash);
+	switch_core_hash_init(&globals.script_stats_hash);
 	globals.task_manager = new map<string, Isolate *>();
+
+	switch_core_metric_register("freeswitch_v8_compile_microseconds_total", NULL, "Time spent compiling JavaScript", SWITCH_METRIC_COUNTER, &globals.compile_metric);
+	switch_core_metric_register("freeswitch_v8_run_microseconds_total", NULL, "Time spent running JavaScript", SWITCH_METRIC_COUNTER, &globals.run_metric);
+	switch_core_metric_register("freeswitch_v8_code_cache_hits_total", NULL, "JavaScript compiles served from the code cache", SWITCH_METRIC_COUNTER, &globals.cache_hit_metric);
 #else
 	JSMain::Initialize();
 #endif
@@ -1540,11 +1976,19 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_v8_load)
 	SWITCH_ADD_API(jsmon_interface, "jsmon", "toggle performance monitor", jsmon_function, "jsmon on|off");
 	SWITCH_ADD_API(jsrun_interface, "jsps", "process status", process_status_function, "jsps [as plain|json|xml|delim|csv [<delimeter>]]");
 	SWITCH_ADD_API(jsrun_interface, "jskill", "kill a task", kill_function, "jskill <task_id>");
+#if defined(V8_MAJOR_VERSION) && V8_MAJOR_VERSION >=5
+	SWITCH_ADD_API(jsstats_interface, "jsstats", "per script compile and run times", jsstats_function, "jsstats [reset]");
+	switch_console_set_complete("add jsstats reset");
+#endif
 	SWITCH_ADD_APP(app_interface, "javascript", "Launch JS ivr", "Run a javascript ivr on a channel", v8_dp_function, "<script> [additional_vars [...]]", SAF_SUPPORT_NOMEDIA);
 	SWITCH_ADD_CHAT_APP(chat_app_interface, "javascript", "execute a js script", "execute a js script", v8_chat_function, "<script>", SCAF_NONE);
 
 	SWITCH_ADD_JSON_API(json_api_interface, "jsjson", "JSON JS Gateway", json_function, "");
 
+	switch_core_metric_register("freeswitch_v8_isolates_created_total", NULL, "V8 isolates created", SWITCH_METRIC_COUNTER, &globals.isolate_created_metric);
+	switch_core_metric_register("freeswitch_v8_isolates_reused_total", NULL, "Script runs served by a pooled V8 isolate", SWITCH_METRIC_COUNTER, &globals.isolate_reused_metric);
+	switch_core_metric_register("freeswitch_v8_isolates_idle", NULL, "V8 isolates waiting in the pool", SWITCH_METRIC_GAUGE, &globals.isolate_idle_metric);
+
 	load_configuration();
 
 	/* indicate that the module should continue to be loaded */
@@ -1558,9 +2002,23 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_v8_shutdown)
 	delete globals.event_handlers;
 	switch_mutex_destroy(globals.event_mutex);
 
+	v8_drain_isolate_pool();
+	delete globals.isolate_pool;
+	switch_mutex_destroy(globals.isolate_pool_mutex);
+
+	switch_core_metric_unregister(globals.isolate_created_metric);
+	switch_core_metric_unregister(globals.isolate_reused_metric);
+	switch_core_metric_unregister(globals.isolate_idle_metric);
+
 #if defined(V8_MAJOR_VERSION) && V8_MAJOR_VERSION >=5
 	delete globals.v8platform;
 
+	switch_core_metric_unregister(globals.compile_metric);
+	switch_core_metric_unregister(globals.run_metric);
+	switch_core_metric_unregister(globals.cache_hit_metric);
+
+	switch_core_hash_destroy(&globals.script_stats_hash);
+	switch_mutex_destroy(globals.script_stats_mutex);
 	switch_core_hash_destroy(&globals.compiled_script_hash);
 	switch_mutex_destroy(globals.compiled_script_hash_mutex);
 	switch_mutex_destroy(globals.task_manager_mutex);
@@ -184,11 +184,9 @@ void JSBase::CreateInstance(const v8::FunctionCallbackInfo<Value>& args)
 	}
 }
 
-void JSBase::Register(Isolate *isolate, const js_class_definition_t *desc)
+Handle<FunctionTemplate> JSBase::CreateClassTemplate(Isolate *isolate, const js_class_definition_t *desc)
 {
-	// Get the context's global scope (that's where we'll put the constructor)
-	Handle<Object> global = isolate->GetCurrentContext()->Global();
-
+	EscapableHandleScope handle_scope(isolate);
 	Local<External> data = External::New(isolate, (void *)desc->constructor);
 
 	// Create function template for our constructor it will call the JSBase::createInstance method
@@ -210,6 +208,15 @@ void JSBase::Register(Isolate *isolate, const js_class_definition_t *desc)
 		function->InstanceTemplate()->SetAccessor(String::NewFromUtf8(isolate, desc->properties[i].name), desc->properties[i].get, desc->properties[i].set);
 	}
 
+	return handle_scope.Escape(function);
+}
+
+void JSBase::Register(Isolate *isolate, const js_class_definition_t *desc)
+{
+	// Get the context's global scope (that's where we'll put the constructor)
+	Handle<Object> global = isolate->GetCurrentContext()->Global();
+	Handle<FunctionTemplate> function = CreateClassTemplate(isolate, desc);
+
 #if defined(V8_MAJOR_VERSION) && V8_MAJOR_VERSION >=5
 #else
 	function->GetFunction()->SetHiddenValue(String::NewFromUtf8(isolate, "constructor_method"), External::New(isolate, (void *)desc->constructor));
@@ -39,6 +39,7 @@ SWITCH_MODULE_DEFINITION(mod_logfile, mod_logfile_load, mod_logfile_shutdown, NU
 #define DEFAULT_LIMIT	 0xA00000	/* About 10 MB */
 #define WARM_FUZZY_OFFSET 256
 #define MAX_ROT 4096			/* why not */
+#define LOGFILE_BUFFER_SIZE 65536	/* lines are collected here and written once per batch */
 
 static switch_memory_pool_t *module_pool = NULL;
 static switch_hash_t *profile_hash = NULL;
@@ -60,11 +61,14 @@ struct logfile_profile {
 	uint32_t all_level;
 	uint32_t suffix;			/* suffix of the highest logfile name */
 	switch_bool_t log_uuid;
+	char *buf;					/* lines waiting for the next write */
+	switch_size_t buf_len;
 };
 
 typedef struct logfile_profile logfile_profile_t;
 
 static switch_status_t load_profile(switch_xml_t xml);
+static switch_status_t mod_logfile_logger(const switch_log_node_t *node, switch_log_level_t level);
 
 #if 0
 static void del_mapping(char *var, logfile_profile_t *profile)
@@ -224,11 +228,10 @@ static switch_status_t mod_logfile_rotate(logfile_profile_t *profile)
 }
 
 /* write to the actual logfile */
-static switch_status_t mod_logfile_raw_write(logfile_profile_t *profile, char *log_data)
+static switch_status_t mod_logfile_file_write(logfile_profile_t *profile, const char *log_data, switch_size_t datalen)
 {
-	switch_size_t len;
+	switch_size_t len = datalen;
 	switch_status_t status = SWITCH_STATUS_SUCCESS;
-	len = strlen(log_data);
 
 	if (len <= 0 || !profile->log_afd) {
 		return SWITCH_STATUS_FALSE;
@@ -239,7 +242,7 @@ static switch_status_t mod_logfile_raw_write(logfile_profile_t *profile, char *l
 	if (switch_file_write(profile->log_afd, log_data, &len) != SWITCH_STATUS_SUCCESS) {
 		switch_file_close(profile->log_afd);
 		if ((status = mod_logfile_openlogfile(profile, SWITCH_TRUE)) == SWITCH_STATUS_SUCCESS) {
-			len = strlen(log_data);
+			len = datalen;
 			switch_file_write(profile->log_afd, log_data, &len);
 		}
 	}
@@ -257,6 +260,105 @@ static switch_status_t mod_logfile_raw_write(logfile_profile_t *profile, char *l
 	return status;
 }
 
+/* write out whatever the profile has buffered */
+static switch_status_t mod_logfile_flush_profile(logfile_profile_t *profile)
+{
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	switch_mutex_lock(globals.mutex);
+	if (profile->buf_len) {
+		status = mod_logfile_file_write(profile, profile->buf, profile->buf_len);
+		profile->buf_len = 0;
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	return status;
+}
+
+static void mod_logfile_flush(void)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	switch_mutex_lock(globals.mutex);
+	for (hi = switch_core_hash_first(profile_hash); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		mod_logfile_flush_profile((logfile_profile_t *) val);
+	}
+	switch_mutex_unlock(globals.mutex);
+}
+
+/* queue a line for the logfile, the core calls mod_logfile_flush once it has handed us a batch */
+static switch_status_t mod_logfile_raw_write(logfile_profile_t *profile, char *log_data)
+{
+	switch_size_t len;
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	len = strlen(log_data);
+
+	if (len <= 0 || !profile->log_afd) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_mutex_lock(globals.mutex);
+
+	if (profile->buf_len + len > LOGFILE_BUFFER_SIZE) {
+		mod_logfile_flush_profile(profile);
+	}
+
+	if (len > LOGFILE_BUFFER_SIZE) {
+		status = mod_logfile_file_write(profile, log_data, len);
+	} else {
+		memcpy(profile->buf + profile->buf_len, log_data, len);
+		profile->buf_len += len;
+	}
+
+	switch_mutex_unlock(globals.mutex);
+
+	return status;
+}
+
+static int mask_max_level(size_t mask)
+{
+	int level;
+
+	for (level = SWITCH_LOG_DEBUG; level >= SWITCH_LOG_CONSOLE; level--) {
+		if (switch_log_check_mask(mask, level)) {
+			return level;
+		}
+	}
+
+	return SWITCH_LOG_DISABLE;
+}
+
+/* tell the core the most verbose level any profile maps so it can skip the rest */
+static void update_level_hint(void)
+{
+	switch_hash_index_t *hi, *mhi;
+	void *val;
+	int max = SWITCH_LOG_DISABLE;
+
+	for (hi = switch_core_hash_first(profile_hash); hi; hi = switch_core_hash_next(&hi)) {
+		logfile_profile_t *profile;
+		int level;
+
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		profile = (logfile_profile_t *) val;
+
+		if ((level = mask_max_level(profile->all_level)) > max) {
+			max = level;
+		}
+
+		for (mhi = switch_core_hash_first(profile->log_hash); mhi; mhi = switch_core_hash_next(&mhi)) {
+			switch_core_hash_this(mhi, NULL, NULL, &val);
+			if ((level = mask_max_level((size_t) val)) > max) {
+				max = level;
+			}
+		}
+	}
+
+	switch_log_set_logger_level_hint(mod_logfile_logger, (switch_log_level_t) max);
+}
+
 static switch_status_t process_node(const switch_log_node_t *node, switch_log_level_t level)
 {
 	switch_hash_index_t *hi;
@@ -324,6 +426,7 @@ static void cleanup_profile(void *ptr)
 {
 	logfile_profile_t *profile = (logfile_profile_t *) ptr;
 
+	mod_logfile_flush_profile(profile);
 	switch_core_hash_destroy(&profile->log_hash);
 	switch_file_close(profile->log_afd);
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Closing %s\n", profile->logfile);
@@ -341,6 +444,7 @@ static switch_status_t load_profile(switch_xml_t xml)
 	memset(new_profile, 0, sizeof(*new_profile));
 	switch_core_hash_init(&(new_profile->log_hash));
 	new_profile->name = switch_core_strdup(module_pool, switch_str_nil(name));
+	new_profile->buf = switch_core_alloc(module_pool, LOGFILE_BUFFER_SIZE);
 
 	new_profile->suffix = 1;
 	new_profile->log_uuid = SWITCH_TRUE;
@@ -401,6 +505,7 @@ static void event_handler(switch_event_t *event)
 			for (hi = switch_core_hash_first(profile_hash); hi; hi = switch_core_hash_next(&hi)) {
 				switch_core_hash_this(hi, &var, NULL, &val);
 				profile = val;
+				mod_logfile_flush_profile(profile);
 				mod_logfile_rotate(profile);
 			}
 		} else {
@@ -408,6 +513,7 @@ static void event_handler(switch_event_t *event)
 			for (hi = switch_core_hash_first(profile_hash); hi; hi = switch_core_hash_next(&hi)) {
 				switch_core_hash_this(hi, &var, NULL, &val);
 				profile = val;
+				mod_logfile_flush_profile(profile);
 				switch_file_close(profile->log_afd);
 				if (mod_logfile_openlogfile(profile, SWITCH_TRUE) != SWITCH_STATUS_SUCCESS) {
 					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Error Re-opening Log!\n");
@@ -466,6 +572,8 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_logfile_load)
 	}
 
 	switch_log_bind_logger(mod_logfile_logger, SWITCH_LOG_DEBUG, SWITCH_FALSE);
+	switch_log_bind_logger_flush(mod_logfile_logger, mod_logfile_flush);
+	update_level_hint();
 
 	return SWITCH_STATUS_SUCCESS;
 }
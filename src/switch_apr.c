@@ -1403,6 +1403,15 @@ SWITCH_DECLARE(void) switch_atomic_inc(volatile switch_atomic_t *mem)
 #endif
 }
 
+SWITCH_DECLARE(uint32_t) switch_atomic_fetch_inc(volatile switch_atomic_t *mem)
+{
+#ifdef apr_atomic_t
+	return apr_atomic_inc((apr_atomic_t *)mem);
+#else
+	return apr_atomic_inc32((apr_uint32_t *)mem);
+#endif
+}
+
 SWITCH_DECLARE(int) switch_atomic_dec(volatile switch_atomic_t *mem)
 {
 #ifdef apr_atomic_t
@@ -171,6 +171,7 @@ struct switch_channel {
 	const switch_state_handler_table_t *state_handlers[SWITCH_MAX_STATE_HANDLERS];
 	int state_handler_index;
 	switch_event_t *variables;
+	switch_event_shared_headers_t *variables_snapshot;
 	switch_event_t *scope_variables;
 	switch_hash_t *private_hash;
 	switch_hash_t *app_flag_hash;
@@ -188,11 +189,146 @@ struct switch_channel {
 	switch_device_node_t *device_node;
 	char *device_id;
 	switch_event_t *log_tags;
+	switch_channel_watcher_t *watcher;
+};
+
+struct switch_channel_watcher {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	uint32_t pending;
+	uint32_t refs;
 };
 
 static void process_device_hup(switch_channel_t *channel);
 static void switch_channel_check_device_state(switch_channel_t *channel, switch_channel_callstate_t callstate);
 
+SWITCH_DECLARE(switch_status_t) switch_channel_watcher_create(switch_channel_watcher_t **watcher)
+{
+	switch_memory_pool_t *pool = NULL;
+	switch_channel_watcher_t *w;
+
+	if (switch_core_new_memory_pool(&pool) != SWITCH_STATUS_SUCCESS) {
+		*watcher = NULL;
+		return SWITCH_STATUS_MEMERR;
+	}
+
+	w = switch_core_alloc(pool, sizeof(*w));
+	w->pool = pool;
+	w->refs = 1;
+	switch_mutex_init(&w->mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_thread_cond_create(&w->cond, pool);
+
+	*watcher = w;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void watcher_ref(switch_channel_watcher_t *watcher)
+{
+	switch_mutex_lock(watcher->mutex);
+	watcher->refs++;
+	switch_mutex_unlock(watcher->mutex);
+}
+
+SWITCH_DECLARE(void) switch_channel_watcher_release(switch_channel_watcher_t **watcher)
+{
+	switch_channel_watcher_t *w = *watcher;
+	uint32_t refs;
+
+	*watcher = NULL;
+
+	if (!w) {
+		return;
+	}
+
+	switch_mutex_lock(w->mutex);
+	refs = --w->refs;
+	switch_mutex_unlock(w->mutex);
+
+	if (!refs) {
+		switch_memory_pool_t *pool = w->pool;
+		switch_core_destroy_memory_pool(&pool);
+	}
+}
+
+SWITCH_DECLARE(void) switch_channel_watcher_signal(switch_channel_watcher_t *watcher)
+{
+	if (!watcher) {
+		return;
+	}
+
+	switch_mutex_lock(watcher->mutex);
+	watcher->pending++;
+	switch_thread_cond_signal(watcher->cond);
+	switch_mutex_unlock(watcher->mutex);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_channel_watcher_wait(switch_channel_watcher_t *watcher, uint32_t ms)
+{
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	if (!watcher) {
+		switch_yield(ms * 1000);
+		return SWITCH_STATUS_TIMEOUT;
+	}
+
+	switch_mutex_lock(watcher->mutex);
+	if (!watcher->pending) {
+		status = switch_thread_cond_timedwait(watcher->cond, watcher->mutex, (switch_interval_time_t) ms * 1000);
+	}
+	watcher->pending = 0;
+	switch_mutex_unlock(watcher->mutex);
+
+	return status == SWITCH_STATUS_SUCCESS ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_TIMEOUT;
+}
+
+SWITCH_DECLARE(void) switch_channel_watch(switch_channel_t *channel, switch_channel_watcher_t *watcher)
+{
+	switch_channel_watcher_t *old = NULL;
+
+	switch_mutex_lock(channel->flag_mutex);
+	if (channel->watcher != watcher) {
+		old = channel->watcher;
+		if (watcher) {
+			watcher_ref(watcher);
+		}
+		channel->watcher = watcher;
+	}
+	switch_mutex_unlock(channel->flag_mutex);
+
+	switch_channel_watcher_release(&old);
+
+	if (watcher) {
+		/* whatever happened before we were attached still needs a look */
+		switch_channel_watcher_signal(watcher);
+	}
+}
+
+SWITCH_DECLARE(void) switch_channel_unwatch(switch_channel_t *channel, switch_channel_watcher_t *watcher)
+{
+	switch_channel_watcher_t *old = NULL;
+
+	switch_mutex_lock(channel->flag_mutex);
+	if (channel->watcher == watcher) {
+		old = channel->watcher;
+		channel->watcher = NULL;
+	}
+	switch_mutex_unlock(channel->flag_mutex);
+
+	switch_channel_watcher_release(&old);
+}
+
+/* flag_mutex keeps the channel's reference on the watcher while we signal it */
+static inline void channel_wake_watcher(switch_channel_t *channel)
+{
+	switch_mutex_lock(channel->flag_mutex);
+	if (channel->watcher) {
+		switch_channel_watcher_signal(channel->watcher);
+	}
+	switch_mutex_unlock(channel->flag_mutex);
+}
+
 SWITCH_DECLARE(switch_hold_record_t *) switch_channel_get_hold_record(switch_channel_t *channel)
 {
 	return channel->hold_record;
@@ -752,7 +888,10 @@ SWITCH_DECLARE(void) switch_channel_uninit(switch_channel_t *channel)
 		switch_core_hash_destroy(&channel->app_flag_hash);
 	}
 
+	switch_channel_watch(channel, NULL);
+
 	switch_mutex_lock(channel->profile_mutex);
+	switch_event_shared_headers_release(&channel->variables_snapshot);
 	switch_event_destroy(&channel->variables);
 	switch_event_destroy(&channel->api_list);
 	switch_event_destroy(&channel->var_list);
@@ -1475,6 +1614,7 @@ SWITCH_DECLARE(switch_status_t) switch_channel_set_variable_var_check(switch_cha
 
 	switch_mutex_lock(channel->profile_mutex);
 	if (channel->variables && !zstr(varname)) {
+		switch_event_shared_headers_release(&channel->variables_snapshot);
 		if (zstr(value)) {
 			switch_event_del_header(channel->variables, varname);
 		} else {
@@ -1505,6 +1645,7 @@ SWITCH_DECLARE(switch_status_t) switch_channel_set_variable_strip_quotes_var_che
 
 	switch_mutex_lock(channel->profile_mutex);
 	if (channel->variables && !zstr(varname)) {
+		switch_event_shared_headers_release(&channel->variables_snapshot);
 		if (zstr(value)) {
 			switch_event_del_header(channel->variables, varname);
 		} else {
@@ -1549,6 +1690,7 @@ SWITCH_DECLARE(switch_status_t) switch_channel_add_variable_var_check(switch_cha
 
 	switch_mutex_lock(channel->profile_mutex);
 	if (channel->variables && !zstr(varname)) {
+		switch_event_shared_headers_release(&channel->variables_snapshot);
 		if (zstr(value)) {
 			switch_event_del_header(channel->variables, varname);
 		} else {
@@ -1584,6 +1726,7 @@ SWITCH_DECLARE(switch_status_t) switch_channel_set_variable_printf(switch_channe
 
 	switch_mutex_lock(channel->profile_mutex);
 	if (channel->variables && !zstr(varname)) {
+		switch_event_shared_headers_release(&channel->variables_snapshot);
 		switch_event_del_header(channel->variables, varname);
 
 		va_start(ap, fmt);
@@ -1944,6 +2087,9 @@ SWITCH_DECLARE(void) switch_channel_set_flag_value(switch_channel_t *channel, sw
 		just_set = 1;
 		channel->flags[flag] = value;
 	}
+	if (just_set && channel->watcher) {
+		switch_channel_watcher_signal(channel->watcher);
+	}
 	switch_mutex_unlock(channel->flag_mutex);
 
 	if (flag == CF_VIDEO_READY && just_set) {
@@ -2370,6 +2516,7 @@ SWITCH_DECLARE(switch_channel_state_t) switch_channel_perform_set_running_state(
 	switch_mutex_lock(channel->state_mutex);
 
 	careful_set(channel, &channel->running_state, state);
+	channel_wake_watcher(channel);
 
 	if (state <= CS_DESTROY) {
 		switch_event_t *event;
@@ -2605,6 +2752,8 @@ SWITCH_DECLARE(switch_channel_state_t) switch_channel_perform_set_state(switch_c
 		if (state <= CS_DESTROY) {
 			switch_core_session_signal_state_change(channel->session);
 		}
+
+		channel_wake_watcher(channel);
 	} else {
 		switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, switch_channel_get_uuid(channel), SWITCH_LOG_WARNING,
 						  "(%s) Invalid State Change %s -> %s\n", channel->name, state_names[last_state], state_names[state]);
@@ -2803,16 +2952,30 @@ SWITCH_DECLARE(void) switch_channel_event_set_extended_data(switch_channel_t *ch
 		}
 
 		if (channel->variables) {
-			for (hi = channel->variables->headers; hi; hi = hi->next) {
-				char buf[1024];
-				char *vvar = NULL, *vval = NULL;
+			/* the variable_ headers are built once per change to the channel variables and shared by every event after that */
+			if (!channel->variables_snapshot && channel->variables->headers) {
+				switch_event_t *snapshot;
+
+				switch_event_create(&snapshot, SWITCH_EVENT_CLONE);
+				switch_assert(snapshot);
+
+				for (hi = channel->variables->headers; hi; hi = hi->next) {
+					char buf[1024];
+					char *vvar = NULL, *vval = NULL;
 
-				vvar = (char *) hi->name;
-				vval = (char *) hi->value;
+					vvar = (char *) hi->name;
+					vval = (char *) hi->value;
+
+					switch_assert(vvar && vval);
+					switch_snprintf(buf, sizeof(buf), "variable_%s", vvar);
+					switch_event_add_header_string(snapshot, SWITCH_STACK_BOTTOM, buf, vval);
+				}
 
-				switch_assert(vvar && vval);
-				switch_snprintf(buf, sizeof(buf), "variable_%s", vvar);
-				switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, buf, vval);
+				channel->variables_snapshot = switch_event_shared_headers_create(&snapshot);
+			}
+
+			if (channel->variables_snapshot) {
+				switch_event_attach_shared_headers(event, channel->variables_snapshot);
 			}
 		}
 	}
@@ -3342,7 +3505,15 @@ SWITCH_DECLARE(void) switch_channel_set_bridge_time(switch_channel_t *channel)
 {
 	switch_mutex_lock(channel->profile_mutex);
 	if (channel->caller_profile && channel->caller_profile->times) {
+		int first = !channel->caller_profile->times->bridged;
+
 		channel->caller_profile->times->bridged = switch_micro_time_now();
+
+		/* how long an originated leg sat answered before it got bridged the first time */
+		if (first && channel->direction == SWITCH_CALL_DIRECTION_OUTBOUND && channel->caller_profile->times->answered) {
+			switch_core_latency_record(channel->session, SWITCH_LATENCY_ANSWER_TO_BRIDGE,
+									   channel->caller_profile->times->bridged - channel->caller_profile->times->answered);
+		}
 	}
 	switch_mutex_unlock(channel->profile_mutex);
 }
@@ -3430,6 +3601,7 @@ SWITCH_DECLARE(switch_channel_state_t) switch_channel_perform_hangup(switch_chan
 
 		switch_core_session_kill_channel(channel->session, SWITCH_SIG_KILL);
 		switch_core_session_signal_state_change(channel->session);
+		channel_wake_watcher(channel);
 		switch_core_session_hangup_state(channel->session, SWITCH_FALSE);
 	}
 
@@ -1889,6 +1889,9 @@ SWITCH_DECLARE(switch_status_t) switch_core_init(switch_core_flag_t flags, switc
 	runtime.min_dtmf_duration = SWITCH_MIN_DTMF_DURATION;
 	runtime.odbc_dbtype = DBTYPE_DEFAULT;
 	runtime.dbname = NULL;
+	runtime.db_journal_mode = "WAL";
+	runtime.log_trace_records = 4096;
+	runtime.latency_enabled = 1;
 #ifndef WIN32
 	runtime.cpu_count = sysconf (_SC_NPROCESSORS_ONLN);
 #else
@@ -1943,6 +1946,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_init(switch_core_flag_t flags, switc
 
 	switch_thread_rwlock_create(&runtime.global_var_rwlock, runtime.memory_pool);
 	switch_core_set_globals();
+	switch_core_metrics_init(runtime.memory_pool);
 	switch_core_session_init(runtime.memory_pool);
 	switch_event_create_plain(&runtime.global_vars, SWITCH_EVENT_CHANNEL_DATA);
 	switch_core_hash_init_case(&runtime.mime_types, SWITCH_FALSE);
@@ -2017,10 +2021,20 @@ SWITCH_DECLARE(switch_status_t) switch_core_init(switch_core_flag_t flags, switc
 	runtime.timer_affinity = -1;
 	runtime.microseconds_per_tick = 20000;
 
+	switch_core_latency_init(runtime.memory_pool);
+
 	if (flags & SCF_MINIMAL) return SWITCH_STATUS_SUCCESS;
 
 	switch_load_core_config("switch.conf");
 
+	if (runtime.log_trace_records) {
+		switch_log_trace_init(runtime.log_trace_records);
+
+		if (runtime.log_trace_crash_handler) {
+			switch_log_trace_crash_handler();
+		}
+	}
+
 	switch_core_state_machine_init(runtime.memory_pool);
 
 	switch_core_media_init();
@@ -2098,6 +2112,9 @@ static uint32_t d_30 = 30;
 static void switch_load_core_config(const char *file)
 {
 	switch_xml_t xml = NULL, cfg = NULL;
+	int offload_threads = 0, offload_cpu = -1, inband_detect_threads = 0, dtls_handshake_threads = 0;
+	uint32_t offload_max_queue = 0;
+	const char *offload_codecs = "OPUS,AMR-WB,AMR,G729";
 
 	switch_core_hash_insert(runtime.ptimes, "ilbc", &d_30);
 	switch_core_hash_insert(runtime.ptimes, "isac", &d_30);
@@ -2158,6 +2175,16 @@ static void switch_load_core_config(const char *file)
 					rlp.rlim_max = RLIM_INFINITY;
 					setrlimit(RLIMIT_CORE, &rlp);
 #endif
+				} else if (!strcasecmp(var, "latency-histograms")) {
+					switch_core_latency_enable(switch_true(val));
+				} else if (!strcasecmp(var, "log-trace-records")) {
+					int tmp = atoi(val);
+
+					if (tmp >= 0) {
+						runtime.log_trace_records = (uint32_t) tmp;
+					}
+				} else if (!strcasecmp(var, "log-trace-crash-handler")) {
+					runtime.log_trace_crash_handler = switch_true(val);
 				} else if (!strcasecmp(var, "debug-level")) {
 					int tmp = atoi(val);
 					if (tmp > -1 && tmp < 11) {
@@ -2366,6 +2393,16 @@ static void switch_load_core_config(const char *file)
 					runtime.port_alloc_flags |= SPF_ROBUST_UDP;
 				} else if (!strcasecmp(var, "core-db-name") && !zstr(val)) {
 					runtime.dbname = switch_core_strdup(runtime.memory_pool, val);
+				} else if (!strcasecmp(var, "core-db-journal-mode") && !zstr(val)) {
+					const char *p;
+
+					for (p = val; *p && isalpha((unsigned char) *p); p++);
+
+					if (*p) {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Invalid core-db-journal-mode [%s]\n", val);
+					} else {
+						runtime.db_journal_mode = switch_core_strdup(runtime.memory_pool, val);
+					}
 				} else if (!strcasecmp(var, "core-db-dsn") && !zstr(val)) {
 					runtime.odbc_dsn = switch_core_strdup(runtime.memory_pool, val);
 				} else if (!strcasecmp(var, "core-non-sqlite-db-required") && !zstr(val)) {
@@ -2428,10 +2465,34 @@ static void switch_load_core_config(const char *file)
 					}
 				} else if (!strcasecmp(var, "max-audio-channels") && !zstr(val)) {
 					switch_core_max_audio_channels(atoi(val));
+				} else if (!strcasecmp(var, "transcode-offload-threads") && !zstr(val)) {
+					offload_threads = atoi(val);
+				} else if (!strcasecmp(var, "transcode-offload-codecs") && !zstr(val)) {
+					offload_codecs = val;
+				} else if (!strcasecmp(var, "transcode-offload-cpu-start") && !zstr(val)) {
+					offload_cpu = atoi(val);
+				} else if (!strcasecmp(var, "transcode-offload-max-queue") && !zstr(val)) {
+					offload_max_queue = atoi(val);
+				} else if (!strcasecmp(var, "inband-detect-threads") && !zstr(val)) {
+					inband_detect_threads = atoi(val);
+				} else if (!strcasecmp(var, "dtls-handshake-threads") && !zstr(val)) {
+					dtls_handshake_threads = atoi(val);
 				}
 			}
 		}
 
+		if (offload_threads > 0) {
+			switch_core_codec_offload_start(offload_threads, offload_codecs, offload_cpu, offload_max_queue);
+		}
+
+		if (inband_detect_threads > 0) {
+			switch_ivr_inband_detect_start(inband_detect_threads);
+		}
+
+		if (dtls_handshake_threads > 0) {
+			switch_rtp_dtls_offload_start(dtls_handshake_threads);
+		}
+
 		if (runtime.event_channel_key_separator == NULL) {
 			runtime.event_channel_key_separator = switch_core_strdup(runtime.memory_pool, ".");
 		}
@@ -3084,6 +3145,10 @@ SWITCH_DECLARE(switch_status_t) switch_core_destroy(void)
 
 	switch_loadable_module_shutdown();
 
+	switch_core_codec_offload_stop();
+	switch_ivr_inband_detect_stop();
+	switch_rtp_dtls_offload_stop();
+
 	switch_curl_destroy();
 
 	switch_ssl_destroy_ssl_locks();
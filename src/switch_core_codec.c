@@ -38,6 +38,292 @@
 
 static uint32_t CODEC_ID = 1;
 
+#define CODEC_OFFLOAD_MAX_CODECS 32
+
+/*
+ * Transcoding offload.  The session read and write paths go through
+ * switch_core_codec_offload_decode()/encode(), which for the listed codecs run
+ * one frame behind: each call hands the frame to a worker and returns the result
+ * of the frame handed over on the previous call, so the media thread never waits
+ * for the codec unless the worker fell a whole frame behind.  One slot per
+ * direction is enough for that, a codec never has more than one frame in flight
+ * which also keeps its state in order.
+ */
+typedef enum {
+	OFFLOAD_IDLE,
+	OFFLOAD_QUEUED,
+	OFFLOAD_DONE
+} codec_offload_state_t;
+
+typedef struct {
+	/* must be first, the worker pool hands this back */
+	switch_worker_job_t job;
+	switch_codec_t *codec;
+	switch_codec_t *other_codec;
+	int encode;
+	uint8_t in[SWITCH_RECOMMENDED_BUFFER_SIZE];
+	uint32_t in_len;
+	uint32_t in_rate;
+	uint8_t out[SWITCH_RECOMMENDED_BUFFER_SIZE];
+	uint32_t out_len;
+	uint32_t out_rate;
+	unsigned int flag;
+	switch_status_t status;
+	volatile switch_atomic_t state;
+} codec_offload_slot_t;
+
+struct switch_codec_offload {
+	/* the worker this codec instance sticks to, so its state stays in one cache */
+	uint32_t worker;
+	codec_offload_slot_t slot[2];
+};
+
+/* set up once by switch_core_codec_offload_start() and never changed after, the pool outlives its stop */
+static struct {
+	switch_worker_pool_t *pool;
+	switch_memory_pool_t *memory_pool;
+	char *codecs[CODEC_OFFLOAD_MAX_CODECS];
+	int codec_count;
+	volatile switch_atomic_t next_worker;
+} codec_offload;
+
+static void codec_offload_run(codec_offload_slot_t *slot)
+{
+	switch_codec_t *codec = slot->codec;
+	const switch_codec_implementation_t *impl = codec->implementation;
+
+	slot->out_len = sizeof(slot->out);
+	slot->out_rate = 0;
+
+	if (slot->encode) {
+		slot->status = impl->encode(codec, slot->other_codec, slot->in, slot->in_len, slot->in_rate,
+									slot->out, &slot->out_len, &slot->out_rate, &slot->flag);
+	} else {
+		slot->status = impl->decode(codec, slot->other_codec, slot->in, slot->in_len, slot->in_rate,
+									slot->out, &slot->out_len, &slot->out_rate, &slot->flag);
+	}
+}
+
+static void codec_offload_callback(switch_worker_job_t *job, void *user_data)
+{
+	codec_offload_slot_t *slot = (codec_offload_slot_t *) job;
+
+	/*
+	 * No codec mutex here, the media thread may hold it for the whole write.
+	 * Frames are queued under the mutex and everyone else who takes it waits
+	 * for the queued ones first, see codec_offload_wait().
+	 */
+	codec_offload_run(slot);
+	/* the media thread owns the slot again from here */
+	switch_atomic_set(&slot->state, OFFLOAD_DONE);
+}
+
+static switch_bool_t codec_offload_wanted(switch_codec_t *codec)
+{
+	int i;
+
+	if (!switch_worker_pool_running(codec_offload.pool)) {
+		return SWITCH_FALSE;
+	}
+
+	for (i = 0; i < codec_offload.codec_count; i++) {
+		if (!strcasecmp(codec_offload.codecs[i], codec->implementation->iananame)) {
+			return SWITCH_TRUE;
+		}
+	}
+
+	return SWITCH_FALSE;
+}
+
+/* let a queued frame finish before the caller uses the codec itself, call with codec->mutex held; the result stays for the pipeline */
+static void codec_offload_wait(switch_codec_t *codec)
+{
+	int i;
+
+	if (!codec->offload) {
+		return;
+	}
+
+	for (i = 0; i < 2; i++) {
+		while (switch_atomic_read(&codec->offload->slot[i].state) == OFFLOAD_QUEUED) {
+			switch_cond_next();
+		}
+	}
+}
+
+/* wait for anything still on a worker, before the codec state goes away */
+static void codec_offload_drain(switch_codec_t *codec)
+{
+	int i;
+
+	if (!codec->offload) {
+		return;
+	}
+
+	for (i = 0; i < 2; i++) {
+		while (switch_atomic_read(&codec->offload->slot[i].state) == OFFLOAD_QUEUED) {
+			switch_cond_next();
+		}
+		switch_atomic_set(&codec->offload->slot[i].state, OFFLOAD_IDLE);
+	}
+}
+
+static switch_status_t codec_offload_pipeline(switch_codec_t *codec, switch_codec_t *other_codec, int encode,
+											  void *in_data, uint32_t in_len, uint32_t in_rate,
+											  void *out_data, uint32_t *out_len, uint32_t *out_rate, unsigned int *flag)
+{
+	codec_offload_slot_t *slot;
+	switch_status_t status;
+	uint32_t state;
+	unsigned int in_flag = *flag;
+
+	/* held while queueing so nobody else starts on the codec state in between */
+	if (codec->mutex) switch_mutex_lock(codec->mutex);
+
+	if (!codec->offload) {
+		codec->offload = switch_core_alloc(codec->memory_pool, sizeof(*codec->offload));
+		codec->offload->worker = switch_atomic_fetch_inc(&codec_offload.next_worker);
+	}
+
+	slot = &codec->offload->slot[encode ? 1 : 0];
+
+	/* normally long done, the frame went out a whole ptime ago */
+	while ((state = switch_atomic_read(&slot->state)) == OFFLOAD_QUEUED) {
+		switch_cond_next();
+	}
+
+	if (state == OFFLOAD_DONE) {
+		if (slot->out_len > *out_len) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Offloaded %s frame of %u bytes does not fit in %u\n",
+							  codec->implementation->iananame, slot->out_len, *out_len);
+			slot->out_len = *out_len;
+		}
+		memcpy(out_data, slot->out, slot->out_len);
+		*out_len = slot->out_len;
+		*out_rate = slot->out_rate;
+		/* the caller gets the flags that go with the audio it got */
+		*flag = slot->flag;
+		status = slot->status;
+	} else {
+		/* nothing in the pipeline yet: decode gives silence, encode skips this packet */
+		*out_len = 0;
+		status = encode ? SWITCH_STATUS_MORE_DATA : SWITCH_STATUS_BREAK;
+	}
+
+	slot->codec = codec;
+	slot->other_codec = other_codec;
+	slot->encode = encode;
+	memcpy(slot->in, in_data, in_len);
+	slot->in_len = in_len;
+	slot->in_rate = in_rate;
+	slot->flag = in_flag;
+
+	/* plc needs the live jitter buffer of the session, so it runs here */
+	if (!(in_flag & SFF_PLC)) {
+		switch_atomic_set(&slot->state, OFFLOAD_QUEUED);
+		if (switch_worker_pool_push(codec_offload.pool, codec->offload->worker, &slot->job) == SWITCH_STATUS_SUCCESS) {
+			if (codec->mutex) switch_mutex_unlock(codec->mutex);
+			return status;
+		}
+	}
+
+	/* backed up or stopped workers: do it here and keep the result in line for the next call */
+	codec_offload_run(slot);
+	switch_atomic_set(&slot->state, OFFLOAD_DONE);
+
+	if (codec->mutex) switch_mutex_unlock(codec->mutex);
+
+	return status;
+}
+
+/* frames too big for a slot go through the plain path, whatever was in flight is dropped to keep the order */
+static switch_bool_t codec_offload_fits(switch_codec_t *codec, uint32_t in_len)
+{
+	if (in_len <= SWITCH_RECOMMENDED_BUFFER_SIZE) {
+		return SWITCH_TRUE;
+	}
+
+	codec_offload_drain(codec);
+
+	return SWITCH_FALSE;
+}
+
+switch_status_t switch_core_codec_offload_decode(switch_codec_t *codec, switch_codec_t *other_codec,
+												 void *encoded_data, uint32_t encoded_data_len, uint32_t encoded_rate,
+												 void *decoded_data, uint32_t *decoded_data_len, uint32_t *decoded_rate, unsigned int *flag)
+{
+	if (!codec_offload_wanted(codec) || !switch_core_codec_ready(codec) || !switch_test_flag(codec, SWITCH_CODEC_FLAG_DECODE) ||
+		!codec_offload_fits(codec, encoded_data_len)) {
+		codec_offload_drain(codec);
+		return switch_core_codec_decode(codec, other_codec, encoded_data, encoded_data_len, encoded_rate,
+										decoded_data, decoded_data_len, decoded_rate, flag);
+	}
+
+	return codec_offload_pipeline(codec, other_codec, 0, encoded_data, encoded_data_len, encoded_rate,
+								  decoded_data, decoded_data_len, decoded_rate, flag);
+}
+
+switch_status_t switch_core_codec_offload_encode(switch_codec_t *codec, switch_codec_t *other_codec,
+												 void *decoded_data, uint32_t decoded_data_len, uint32_t decoded_rate,
+												 void *encoded_data, uint32_t *encoded_data_len, uint32_t *encoded_rate, unsigned int *flag)
+{
+	if (!codec_offload_wanted(codec) || !switch_core_codec_ready(codec) || !switch_test_flag(codec, SWITCH_CODEC_FLAG_ENCODE) ||
+		!codec_offload_fits(codec, decoded_data_len)) {
+		codec_offload_drain(codec);
+		return switch_core_codec_encode(codec, other_codec, decoded_data, decoded_data_len, decoded_rate,
+										encoded_data, encoded_data_len, encoded_rate, flag);
+	}
+
+	return codec_offload_pipeline(codec, other_codec, 1, decoded_data, decoded_data_len, decoded_rate,
+								  encoded_data, encoded_data_len, encoded_rate, flag);
+}
+
+switch_status_t switch_core_codec_offload_start(int threads, const char *codecs, int first_cpu, uint32_t max_queue)
+{
+	char *dup;
+
+	if (codec_offload.pool || threads < 1 || zstr(codecs)) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_core_new_memory_pool(&codec_offload.memory_pool);
+	dup = switch_core_strdup(codec_offload.memory_pool, codecs);
+	codec_offload.codec_count = switch_separate_string(dup, ',', codec_offload.codecs, CODEC_OFFLOAD_MAX_CODECS);
+
+	if (switch_worker_pool_create(&codec_offload.pool, "Transcode", threads, max_queue, first_cpu, SWITCH_PRI_REALTIME,
+								  codec_offload_callback, NULL) != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Transcoding offload started with %d workers for %s\n", threads, codecs);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+void switch_core_codec_offload_stop(void)
+{
+	/* frames already queued still complete, later ones run inline; the pool itself stays for late callers */
+	switch_worker_pool_stop(codec_offload.pool);
+}
+
+SWITCH_DECLARE(void) switch_core_codec_offload_status(switch_stream_handle_t *stream)
+{
+	int i;
+
+	if (!codec_offload.pool) {
+		stream->write_function(stream, "transcoding offload is disabled\n");
+		return;
+	}
+
+	stream->write_function(stream, "codecs:");
+	for (i = 0; i < codec_offload.codec_count; i++) {
+		stream->write_function(stream, " %s", codec_offload.codecs[i]);
+	}
+	stream->write_function(stream, "\n");
+
+	switch_worker_pool_status(codec_offload.pool, stream);
+}
+
 SWITCH_DECLARE(uint32_t) switch_core_codec_next_id(void)
 {
 	return CODEC_ID++;
@@ -604,6 +890,8 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_reset(switch_codec_t *codec)
 {
 	switch_assert(codec != NULL);
 
+	codec_offload_drain(codec);
+
 	codec->implementation->destroy(codec);
 	codec->implementation->init(codec, codec->flags, NULL);
 
@@ -634,6 +922,26 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_copy(switch_codec_t *codec, sw
 
 }
 
+static void codec_metric_add(const switch_codec_implementation_t *implementation, int64_t value)
+{
+	switch_codec_implementation_t *impl = (switch_codec_implementation_t *) implementation;
+
+	/* registering is idempotent, two threads racing here end up with the same handle */
+	if (!impl->active_metric) {
+		switch_metric_t *metric;
+		char labels[128];
+
+		switch_snprintf(labels, sizeof(labels), "codec=\"%s\"", impl->iananame);
+
+		if (switch_core_metric_register("freeswitch_codecs_active", labels, "Codecs currently initialized", SWITCH_METRIC_GAUGE, &metric) != SWITCH_STATUS_SUCCESS) {
+			return;
+		}
+		impl->active_metric = metric;
+	}
+
+	switch_core_metric_add(impl->active_metric, value);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_core_codec_init_with_bitrate(switch_codec_t *codec, const char *codec_name, const char *modname, const char *fmtp,
 													   uint32_t rate, int ms, int channels, uint32_t bitrate, uint32_t flags,
 													   const switch_codec_settings_t *codec_settings, switch_memory_pool_t *pool)
@@ -722,6 +1030,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_init_with_bitrate(switch_codec
 		implementation->init(codec, flags, codec_settings);
 		switch_mutex_init(&codec->mutex, SWITCH_MUTEX_NESTED, codec->memory_pool);
 		switch_set_flag(codec, SWITCH_CODEC_FLAG_READY);
+		codec_metric_add(implementation, 1);
 		return SWITCH_STATUS_SUCCESS;
 	} else {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Codec %s Exists but not at the desired implementation. %dhz %dms %dch\n",
@@ -758,6 +1067,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_encode(switch_codec_t *codec,
 	}
 
 	if (codec->mutex) switch_mutex_lock(codec->mutex);
+	codec_offload_wait(codec);
 	status = codec->implementation->encode(codec, other_codec, decoded_data, decoded_data_len,
 										   decoded_rate, encoded_data, encoded_data_len, encoded_rate, flag);
 	if (codec->mutex) switch_mutex_unlock(codec->mutex);
@@ -802,6 +1112,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_decode(switch_codec_t *codec,
 	}
 
 	if (codec->mutex) switch_mutex_lock(codec->mutex);
+	codec_offload_wait(codec);
 	status = codec->implementation->decode(codec, other_codec, encoded_data, encoded_data_len, encoded_rate,
 										   decoded_data, decoded_data_len, decoded_rate, flag);
 	if (codec->mutex) switch_mutex_unlock(codec->mutex);
@@ -897,6 +1208,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_control(switch_codec_t *codec,
 
 
 	if (codec->mutex) switch_mutex_lock(codec->mutex);
+	codec_offload_wait(codec);
 
 	if (codec->implementation->codec_control) {
 		status = codec->implementation->codec_control(codec, cmd, ctype, cmd_data, atype, cmd_arg, rtype, ret_data);
@@ -918,6 +1230,9 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_destroy(switch_codec_t *codec)
 	mutex = codec->mutex;
 	pool = codec->memory_pool;
 
+	/* a worker may still be on it */
+	codec_offload_drain(codec);
+
 	if (mutex) switch_mutex_lock(mutex);
 
 	if (switch_core_codec_ready(codec)) {
@@ -933,6 +1248,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_destroy(switch_codec_t *codec)
 	}
 
 	codec->implementation->destroy(codec);
+	codec_metric_add(codec->implementation, -1);
 
 	UNPROTECT_INTERFACE(codec->codec_interface);
 
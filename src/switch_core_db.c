@@ -111,6 +111,141 @@ SWITCH_DECLARE(int) switch_core_db_exec(switch_core_db_t *db, const char *sql, s
 	return ret;
 }
 
+SWITCH_DECLARE(int) switch_core_db_prepare_cached(switch_coredb_handle_t *dbh, const char *sql, switch_core_db_stmt_t **ppStmt)
+{
+	switch_core_db_stmt_t *stmt;
+	int ret;
+
+	*ppStmt = NULL;
+
+	if (dbh->stmt_cache && (stmt = switch_core_hash_find(dbh->stmt_cache, sql))) {
+		*ppStmt = stmt;
+		return SQLITE_OK;
+	}
+
+	if (dbh->stmt_cache_count >= SWITCH_CORE_DB_STMT_CACHE_MAX) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Statement cache is full, flushing %u statements\n", dbh->stmt_cache_count);
+		switch_core_db_flush_stmt_cache(dbh);
+	}
+
+	if ((ret = sqlite3_prepare_v2(dbh->handle, sql, -1, &stmt, NULL)) != SQLITE_OK) {
+		return ret;
+	}
+
+	if (!dbh->stmt_cache) {
+		switch_core_hash_init(&dbh->stmt_cache);
+	}
+
+	switch_core_hash_insert(dbh->stmt_cache, sql, stmt);
+	dbh->stmt_cache_count++;
+	*ppStmt = stmt;
+
+	return SQLITE_OK;
+}
+
+SWITCH_DECLARE(void) switch_core_db_flush_stmt_cache(switch_coredb_handle_t *dbh)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	if (!dbh->stmt_cache) {
+		return;
+	}
+
+	for (hi = switch_core_hash_first(dbh->stmt_cache); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		sqlite3_finalize((switch_core_db_stmt_t *) val);
+	}
+
+	switch_core_hash_destroy(&dbh->stmt_cache);
+	dbh->stmt_cache_count = 0;
+}
+
+SWITCH_DECLARE(int) switch_core_db_exec_params(switch_coredb_handle_t *dbh, const char *sql, int argc, const char *const *argv,
+											   switch_core_db_callback_func_t callback, void *data, char **errmsg)
+{
+	switch_core_db_stmt_t *stmt = NULL;
+	char **cols = NULL;
+	int ret, i, ncols = 0;
+	int sane = 300;
+
+	if (errmsg) {
+		*errmsg = NULL;
+	}
+
+	if ((ret = switch_core_db_prepare_cached(dbh, sql, &stmt)) != SQLITE_OK) {
+		goto end;
+	}
+
+	for (i = 0; i < argc; i++) {
+		if (argv[i]) {
+			ret = sqlite3_bind_text(stmt, i + 1, argv[i], -1, SQLITE_STATIC);
+		} else {
+			ret = sqlite3_bind_null(stmt, i + 1);
+		}
+
+		if (ret != SQLITE_OK) {
+			goto end;
+		}
+	}
+
+	for (;;) {
+		ret = sqlite3_step(stmt);
+
+		if (ret == SQLITE_ROW) {
+			if (!callback) {
+				continue;
+			}
+
+			if (!cols) {
+				ncols = sqlite3_column_count(stmt);
+				switch_zmalloc(cols, sizeof(char *) * ncols * 2);
+				for (i = 0; i < ncols; i++) {
+					cols[ncols + i] = (char *) sqlite3_column_name(stmt, i);
+				}
+			}
+
+			for (i = 0; i < ncols; i++) {
+				cols[i] = (char *) sqlite3_column_text(stmt, i);
+			}
+
+			if (callback(data, ncols, cols, cols + ncols)) {
+				ret = SQLITE_ABORT;
+				break;
+			}
+		} else if ((ret == SQLITE_BUSY || ret == SQLITE_LOCKED) && --sane > 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "SQLite is %s, sane=%d [%s]\n", (ret == SQLITE_BUSY ? "BUSY" : "LOCKED"), sane, sql);
+			sqlite3_reset(stmt);
+			switch_yield(100000);
+		} else {
+			break;
+		}
+	}
+
+	if (ret == SQLITE_DONE) {
+		ret = SQLITE_OK;
+	}
+
+ end:
+
+	if (ret != SQLITE_OK && ret != SQLITE_ABORT) {
+		if (errmsg) {
+			*errmsg = sqlite3_mprintf("%s", sqlite3_errmsg(dbh->handle));
+		} else {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "SQL ERR [%s]\n", sqlite3_errmsg(dbh->handle));
+		}
+	}
+
+	if (stmt) {
+		sqlite3_reset(stmt);
+		sqlite3_clear_bindings(stmt);
+	}
+
+	switch_safe_free(cols);
+
+	return ret;
+}
+
 SWITCH_DECLARE(int) switch_core_db_finalize(switch_core_db_stmt_t *pStmt)
 {
 	return sqlite3_finalize(pStmt);
@@ -151,6 +286,16 @@ SWITCH_DECLARE(int) switch_core_db_bind_double(switch_core_db_stmt_t *pStmt, int
 	return sqlite3_bind_double(pStmt, i, dValue);
 }
 
+SWITCH_DECLARE(int) switch_core_db_bind_null(switch_core_db_stmt_t *pStmt, int i)
+{
+	return sqlite3_bind_null(pStmt, i);
+}
+
+SWITCH_DECLARE(int) switch_core_db_clear_bindings(switch_core_db_stmt_t *pStmt)
+{
+	return sqlite3_clear_bindings(pStmt);
+}
+
 SWITCH_DECLARE(int64_t) switch_core_db_last_insert_rowid(switch_core_db_t *db)
 {
 	return sqlite3_last_insert_rowid(db);
@@ -209,7 +354,22 @@ static int switch_core_db_connection_setup(switch_core_db_t *db, switch_bool_t i
 		if ((db_ret = switch_core_db_exec(db, "PRAGMA cache_size=8000;", NULL, NULL, NULL)) != SQLITE_OK) {
 			goto end;
 		}
+		/* with a write-ahead log the readers on other connections never block the writer, nor it them */
+		if (!zstr(runtime.db_journal_mode)) {
+			char *sql = switch_mprintf("PRAGMA journal_mode=%s;", runtime.db_journal_mode);
+
+			db_ret = switch_core_db_exec(db, sql, NULL, NULL, NULL);
+			switch_safe_free(sql);
+
+			if (db_ret != SQLITE_OK) {
+				goto end;
+			}
+		}
 	} else {
+		/* in memory the connections share one cache, let the readers skip its table locks */
+		if ((db_ret = switch_core_db_exec(db, "PRAGMA read_uncommitted=1;", NULL, NULL, NULL)) != SQLITE_OK) {
+			goto end;
+		}
 		if ((db_ret = switch_core_db_exec(db, "PRAGMA cache_size=-8192;", NULL, NULL, NULL)) != SQLITE_OK) {
 			goto end;
 		}
@@ -73,9 +73,11 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 	switch_codec_implementation_t codec_impl;
 	unsigned int flag = 0;
 	int i;
+	switch_time_t lat_start, lat_mark, lat_bugs = -1;
 
 	switch_assert(session != NULL);
 
+	lat_start = switch_core_latency_start(session);
 	tap_only = switch_test_flag(session, SSF_MEDIA_BUG_TAP_ONLY);
 
 	switch_os_yield();
@@ -172,6 +174,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 	if (session->endpoint_interface->io_routines->read_frame) {
 		switch_mutex_unlock(session->read_codec->mutex);
 		switch_mutex_unlock(session->codec_read_mutex);
+		lat_mark = switch_core_latency_start(session);
 		if ((status = session->endpoint_interface->io_routines->read_frame(session, frame, flags, stream_id)) == SWITCH_STATUS_SUCCESS) {
 			for (ptr = session->event_hooks.read_frame; ptr; ptr = ptr->next) {
 				if ((status = ptr->read_frame(session, frame, flags, stream_id)) != SWITCH_STATUS_SUCCESS) {
@@ -179,6 +182,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 				}
 			}
 		}
+		switch_core_latency_end(session, SWITCH_LATENCY_READ_WAIT, lat_mark);
 
 		if (status == SWITCH_STATUS_INUSE) {
 			*frame = &runtime.dummy_cng_frame;
@@ -237,6 +241,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 		switch_bool_t ok = SWITCH_TRUE;
 		int prune = 0;
 
+		lat_mark = switch_core_latency_start(session);
 		switch_thread_rwlock_rdlock(session->bug_rwlock);
 
 		for (bp = session->bugs; bp; bp = bp->next) {
@@ -276,6 +281,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 			}
 		}
 		switch_thread_rwlock_unlock(session->bug_rwlock);
+		switch_core_latency_accrue(&lat_bugs, lat_mark);
 
 		if (prune) {
 			switch_core_media_bug_prune(session);
@@ -299,6 +305,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 		int prune = 0;
 
 		if (session->bugs && switch_test_flag((*frame), SFF_CNG)) {
+			lat_mark = switch_core_latency_start(session);
 			switch_thread_rwlock_rdlock(session->bug_rwlock);
 			for (bp = session->bugs; bp; bp = bp->next) {
 				ok = SWITCH_TRUE;
@@ -343,6 +350,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 				}
 			}
 			switch_thread_rwlock_unlock(session->bug_rwlock);
+			switch_core_latency_accrue(&lat_bugs, lat_mark);
 
 			if (prune) {
 				switch_core_media_bug_prune(session);
@@ -495,13 +503,15 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 
 					codec->cur_frame = read_frame;
 					session->read_codec->cur_frame = read_frame;
-					status = switch_core_codec_decode(codec,
+					lat_mark = switch_core_latency_start(session);
+					status = switch_core_codec_offload_decode(codec,
 													  session->read_codec,
 													  read_frame->data,
 													  read_frame->datalen,
 													  session->read_impl.actual_samples_per_second,
 													  session->raw_read_frame.data, &session->raw_read_frame.datalen, &session->raw_read_frame.rate,
 													  &read_frame->flags);
+					switch_core_latency_end(session, SWITCH_LATENCY_DECODE, lat_mark);
 
 					if (status == SWITCH_STATUS_NOT_INITALIZED) {
 						switch_thread_rwlock_unlock(session->bug_rwlock);
@@ -647,6 +657,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 			switch_media_bug_t *bp;
 			switch_bool_t ok = SWITCH_TRUE;
 			int prune = 0;
+			lat_mark = switch_core_latency_start(session);
 			switch_thread_rwlock_rdlock(session->bug_rwlock);
 
 			for (bp = session->bugs; bp; bp = bp->next) {
@@ -689,6 +700,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 
 			}
 			switch_thread_rwlock_unlock(session->bug_rwlock);
+			switch_core_latency_accrue(&lat_bugs, lat_mark);
 			if (prune) {
 				switch_core_media_bug_prune(session);
 			}
@@ -698,6 +710,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 			switch_media_bug_t *bp;
 			switch_bool_t ok = SWITCH_TRUE;
 			int prune = 0;
+			lat_mark = switch_core_latency_start(session);
 			switch_thread_rwlock_rdlock(session->bug_rwlock);
 
 			for (bp = session->bugs; bp; bp = bp->next) {
@@ -750,6 +763,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 				}
 			}
 			switch_thread_rwlock_unlock(session->bug_rwlock);
+			switch_core_latency_accrue(&lat_bugs, lat_mark);
 			if (prune) {
 				switch_core_media_bug_prune(session);
 			}
@@ -809,12 +823,14 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 				enc_frame->codec->cur_frame = enc_frame;
 				switch_assert(enc_frame->datalen <= SWITCH_RECOMMENDED_BUFFER_SIZE);
 				switch_assert(session->enc_read_frame.datalen <= SWITCH_RECOMMENDED_BUFFER_SIZE);
+				lat_mark = switch_core_latency_start(session);
 				status = switch_core_codec_encode(session->read_codec,
 												  enc_frame->codec,
 												  enc_frame->data,
 												  enc_frame->datalen,
 												  session->read_impl.actual_samples_per_second,
 												  session->enc_read_frame.data, &session->enc_read_frame.datalen, &session->enc_read_frame.rate, &flag);
+				switch_core_latency_end(session, SWITCH_LATENCY_ENCODE, lat_mark);
 				switch_assert(session->enc_read_frame.datalen <= SWITCH_RECOMMENDED_BUFFER_SIZE);
 
 				session->read_codec->cur_frame = NULL;
@@ -879,6 +895,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 			switch_media_bug_t *bp;
 			switch_bool_t ok = SWITCH_TRUE;
 			int prune = 0;
+			lat_mark = switch_core_latency_start(session);
 			switch_thread_rwlock_rdlock(session->bug_rwlock);
 			for (bp = session->bugs; bp; bp = bp->next) {
 				ok = SWITCH_TRUE;
@@ -919,6 +936,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 				}
 			}
 			switch_thread_rwlock_unlock(session->bug_rwlock);
+			switch_core_latency_accrue(&lat_bugs, lat_mark);
 			if (prune) {
 				switch_core_media_bug_prune(session);
 			}
@@ -936,6 +954,10 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 	switch_mutex_unlock(session->read_codec->mutex);
 	switch_mutex_unlock(session->codec_read_mutex);
 
+	if (lat_bugs >= 0) {
+		switch_core_latency_record(session, SWITCH_LATENCY_READ_BUGS, lat_bugs);
+	}
+	switch_core_latency_end(session, SWITCH_LATENCY_READ_FRAME, lat_start);
 
 	if (status == SWITCH_STATUS_SUCCESS && switch_channel_get_callstate(session->channel) == CCS_UNHELD) {
 		switch_channel_set_callstate(session->channel, CCS_ACTIVE);
@@ -0,0 +1,315 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * switch_core_latency.c -- Latency histograms for the stages of a call
+ *
+ */
+
+#include <switch.h>
+#include "private/switch_core_pvt.h"
+
+static const char *STAGE_NAMES[] = {
+	"read_frame",
+	"read_wait",
+	"decode",
+	"read_bugs",
+	"encode",
+	"write_bugs",
+	"write",
+	"state_change",
+	"dialplan",
+	"application",
+	"originate_ring",
+	"originate_answer",
+	"answer_bridge",
+	"inband_queue",
+	"inband_detect",
+	"dtls_queue",
+	"dtls_handshake",
+	"ice_to_dtls",
+	NULL
+};
+
+static inline uint32_t latency_bucket(uint64_t usec)
+{
+	uint32_t msb = 0, idx;
+
+	if (usec < (1 << SWITCH_LATENCY_SUB_BITS)) {
+		return (uint32_t) usec;
+	}
+
+#if defined(__GNUC__)
+	msb = 63 - __builtin_clzll(usec);
+#else
+	{
+		uint64_t x = usec;
+		while (x >>= 1) {
+			msb++;
+		}
+	}
+#endif
+
+	idx = (msb - SWITCH_LATENCY_SUB_BITS + 1) * (1 << SWITCH_LATENCY_SUB_BITS) + (uint32_t) ((usec >> (msb - SWITCH_LATENCY_SUB_BITS)) & ((1 << SWITCH_LATENCY_SUB_BITS) - 1));
+
+	return idx < SWITCH_LATENCY_BUCKETS ? idx : SWITCH_LATENCY_BUCKETS - 1;
+}
+
+/* the highest value that lands in a bucket */
+static uint64_t latency_bucket_top(uint32_t idx)
+{
+	uint32_t msb, sub = 1 << SWITCH_LATENCY_SUB_BITS;
+
+	if (idx < sub) {
+		return idx;
+	}
+
+	msb = idx / sub + SWITCH_LATENCY_SUB_BITS - 1;
+
+	return (((uint64_t) (sub + idx % sub) + 1) << (msb - SWITCH_LATENCY_SUB_BITS)) - 1;
+}
+
+/* the counters are plain adds, the shards keep threads apart so a lost count is rare and harmless */
+static inline void latency_add(switch_latency_histogram_t *h, uint64_t usec)
+{
+	h->count++;
+	h->sum += usec;
+	if (usec > h->max) {
+		h->max = usec;
+	}
+	h->buckets[latency_bucket(usec)]++;
+}
+
+SWITCH_DECLARE(void) switch_core_latency_record(switch_core_session_t *session, switch_latency_stage_t stage, switch_time_t usec)
+{
+	if (stage >= SWITCH_LATENCY_STAGE_COUNT) {
+		return;
+	}
+
+	if (usec < 0) {
+		usec = 0;
+	}
+
+	if (runtime.latency_enabled && runtime.latency) {
+		latency_add(&runtime.latency[switch_core_thread_shard(SWITCH_LATENCY_SHARDS)].stage[stage], (uint64_t) usec);
+	}
+
+	if (session && session->latency_enabled && session->latency) {
+		latency_add(&session->latency->stage[stage], (uint64_t) usec);
+	}
+}
+
+SWITCH_DECLARE(void) switch_core_latency_enable(switch_bool_t enable)
+{
+	runtime.latency_enabled = enable ? 1 : 0;
+}
+
+SWITCH_DECLARE(switch_bool_t) switch_core_latency_enabled(void)
+{
+	return runtime.latency_enabled ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_core_session_latency_enable(switch_core_session_t *session, switch_bool_t enable)
+{
+	if (!session) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (enable && !session->latency) {
+		session->latency = switch_core_session_alloc(session, sizeof(*session->latency));
+	}
+
+	session->latency_enabled = enable ? 1 : 0;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(void) switch_core_latency_reset(switch_core_session_t *session)
+{
+	if (session) {
+		if (session->latency) {
+			memset(session->latency, 0, sizeof(*session->latency));
+		}
+	} else if (runtime.latency) {
+		memset(runtime.latency, 0, sizeof(*runtime.latency) * SWITCH_LATENCY_SHARDS);
+	}
+}
+
+static void latency_collect(switch_core_session_t *session, switch_latency_stage_t stage, switch_latency_histogram_t *out)
+{
+	int i, b;
+
+	memset(out, 0, sizeof(*out));
+
+	if (session) {
+		if (session->latency) {
+			memcpy(out, &session->latency->stage[stage], sizeof(*out));
+		}
+		return;
+	}
+
+	if (!runtime.latency) {
+		return;
+	}
+
+	for (i = 0; i < SWITCH_LATENCY_SHARDS; i++) {
+		switch_latency_histogram_t *h = &runtime.latency[i].stage[stage];
+
+		out->count += h->count;
+		out->sum += h->sum;
+		if (h->max > out->max) {
+			out->max = h->max;
+		}
+		for (b = 0; b < SWITCH_LATENCY_BUCKETS; b++) {
+			out->buckets[b] += h->buckets[b];
+		}
+	}
+}
+
+static void latency_summarize(const switch_latency_histogram_t *h, switch_latency_summary_t *summary)
+{
+	static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	uint64_t *values[4];
+	uint64_t total = 0, seen = 0;
+	int b, q = 0;
+
+	memset(summary, 0, sizeof(*summary));
+
+	values[0] = &summary->p50;
+	values[1] = &summary->p90;
+	values[2] = &summary->p99;
+	values[3] = &summary->p999;
+
+	for (b = 0; b < SWITCH_LATENCY_BUCKETS; b++) {
+		total += h->buckets[b];
+	}
+
+	if (!total) {
+		return;
+	}
+
+	summary->count = h->count;
+	summary->mean = h->count ? h->sum / h->count : 0;
+	summary->max = h->max;
+
+	for (b = 0; b < SWITCH_LATENCY_BUCKETS && q < 4; b++) {
+		seen += h->buckets[b];
+
+		while (q < 4 && (double) seen >= quantiles[q] * (double) total) {
+			uint64_t top = latency_bucket_top(b);
+			*values[q++] = top < h->max ? top : h->max;
+		}
+	}
+}
+
+SWITCH_DECLARE(switch_status_t) switch_core_latency_get(switch_core_session_t *session, switch_latency_stage_t stage, switch_latency_summary_t *summary)
+{
+	switch_latency_histogram_t *h;
+
+	if (stage >= SWITCH_LATENCY_STAGE_COUNT || (session && !session->latency)) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_zmalloc(h, sizeof(*h));
+	latency_collect(session, stage, h);
+	latency_summarize(h, summary);
+	free(h);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(cJSON *) switch_core_latency_json(switch_core_session_t *session)
+{
+	switch_latency_histogram_t *h;
+	cJSON *json;
+	int stage, b;
+
+	if (session && !session->latency) {
+		return NULL;
+	}
+
+	json = cJSON_CreateObject();
+	switch_zmalloc(h, sizeof(*h));
+
+	for (stage = 0; stage < SWITCH_LATENCY_STAGE_COUNT; stage++) {
+		switch_latency_summary_t summary;
+		cJSON *obj, *buckets;
+
+		latency_collect(session, stage, h);
+		latency_summarize(h, &summary);
+
+		obj = cJSON_CreateObject();
+		cJSON_AddNumberToObject(obj, "count", (double) summary.count);
+		cJSON_AddNumberToObject(obj, "mean", (double) summary.mean);
+		cJSON_AddNumberToObject(obj, "p50", (double) summary.p50);
+		cJSON_AddNumberToObject(obj, "p90", (double) summary.p90);
+		cJSON_AddNumberToObject(obj, "p99", (double) summary.p99);
+		cJSON_AddNumberToObject(obj, "p999", (double) summary.p999);
+		cJSON_AddNumberToObject(obj, "max", (double) summary.max);
+
+		/* [highest value in the bucket, count] for every bucket that has something */
+		buckets = cJSON_CreateArray();
+		for (b = 0; b < SWITCH_LATENCY_BUCKETS; b++) {
+			if (h->buckets[b]) {
+				cJSON *pair = cJSON_CreateArray();
+				cJSON_AddItemToArray(pair, cJSON_CreateNumber((double) latency_bucket_top(b)));
+				cJSON_AddItemToArray(pair, cJSON_CreateNumber((double) h->buckets[b]));
+				cJSON_AddItemToArray(buckets, pair);
+			}
+		}
+		cJSON_AddItemToObject(obj, "buckets", buckets);
+
+		cJSON_AddItemToObject(json, STAGE_NAMES[stage], obj);
+	}
+
+	free(h);
+
+	return json;
+}
+
+SWITCH_DECLARE(const char *) switch_core_latency_stage2str(switch_latency_stage_t stage)
+{
+	if (stage >= SWITCH_LATENCY_STAGE_COUNT) {
+		return "unknown";
+	}
+
+	return STAGE_NAMES[stage];
+}
+
+void switch_core_latency_init(switch_memory_pool_t *pool)
+{
+	runtime.latency = switch_core_alloc(pool, sizeof(*runtime.latency) * SWITCH_LATENCY_SHARDS);
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -2028,6 +2028,13 @@ static void set_stats(switch_core_session_t *session, switch_media_type_t type,
 		add_stat(stats->rtcp.packet_count, "rtcp_packet_count");
 		add_stat(stats->rtcp.octet_count, "rtcp_octet_count");
 
+		if (stats->setup.dtls_rounds) {
+			add_stat((switch_size_t) stats->setup.ice_to_dtls_usec, "setup_ice_to_dtls_usec");
+			add_stat((switch_size_t) stats->setup.dtls_queue_usec, "setup_dtls_queue_usec");
+			add_stat((switch_size_t) stats->setup.dtls_handshake_usec, "setup_dtls_handshake_usec");
+			add_stat((switch_size_t) stats->setup.dtls_rounds, "setup_dtls_rounds");
+		}
+
 	}
 }
 
@@ -7197,6 +7204,7 @@ static switch_status_t perform_write(switch_core_session_t *session, switch_fram
 	switch_io_event_hook_write_frame_t *ptr;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 	switch_media_handle_t *smh;
+	switch_time_t lat_mark;
 
 	switch_assert(session != NULL);
 
@@ -7219,6 +7227,7 @@ static switch_status_t perform_write(switch_core_session_t *session, switch_fram
 		switch_bool_t ok = SWITCH_TRUE;
 		int prune = 0;
 
+		lat_mark = switch_core_latency_start(session);
 		switch_thread_rwlock_rdlock(session->bug_rwlock);
 
 		for (bp = session->bugs; bp; bp = bp->next) {
@@ -7252,6 +7261,7 @@ static switch_status_t perform_write(switch_core_session_t *session, switch_fram
 			}
 		}
 		switch_thread_rwlock_unlock(session->bug_rwlock);
+		switch_core_latency_end(session, SWITCH_LATENCY_WRITE_BUGS, lat_mark);
 
 		if (prune) {
 			switch_core_media_bug_prune(session);
@@ -7260,6 +7270,7 @@ static switch_status_t perform_write(switch_core_session_t *session, switch_fram
 
 
 	if (session->endpoint_interface->io_routines->write_frame) {
+		lat_mark = switch_core_latency_start(session);
 		if ((status = session->endpoint_interface->io_routines->write_frame(session, frame, flags, stream_id)) == SWITCH_STATUS_SUCCESS) {
 			for (ptr = session->event_hooks.write_frame; ptr; ptr = ptr->next) {
 				if ((status = ptr->write_frame(session, frame, flags, stream_id)) != SWITCH_STATUS_SUCCESS) {
@@ -7267,6 +7278,7 @@ static switch_status_t perform_write(switch_core_session_t *session, switch_fram
 				}
 			}
 		}
+		switch_core_latency_end(session, SWITCH_LATENCY_WRITE, lat_mark);
 	}
 
 	return status;
@@ -15961,6 +15973,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 	switch_frame_t *enc_frame = NULL, *write_frame = frame;
 	unsigned int flag = 0, need_codec = 0, perfect = 0, do_bugs = 0, do_write = 0, do_resample = 0, ptime_mismatch = 0, pass_cng = 0, resample = 0;
 	int did_write_resample = 0;
+	switch_time_t lat_mark;
 
 	switch_assert(session != NULL);
 	switch_assert(frame != NULL);
@@ -16106,12 +16119,14 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 		session->raw_write_frame.datalen = session->raw_write_frame.buflen;
 		frame->codec->cur_frame = frame;
 		session->write_codec->cur_frame = frame;
+		lat_mark = switch_core_latency_start(session);
 		status = switch_core_codec_decode(frame->codec,
 										  session->write_codec,
 										  frame->data,
 										  frame->datalen,
 										  session->write_impl.actual_samples_per_second,
 										  session->raw_write_frame.data, &session->raw_write_frame.datalen, &session->raw_write_frame.rate, &frame->flags);
+		switch_core_latency_end(session, SWITCH_LATENCY_DECODE, lat_mark);
 		frame->codec->cur_frame = NULL;
 		session->write_codec->cur_frame = NULL;
 		if (do_resample && status == SWITCH_STATUS_SUCCESS) {
@@ -16247,6 +16262,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 		switch_media_bug_t *bp;
 		int prune = 0;
 
+		lat_mark = switch_core_latency_start(session);
 		switch_thread_rwlock_rdlock(session->bug_rwlock);
 		for (bp = session->bugs; bp; bp = bp->next) {
 			switch_bool_t ok = SWITCH_TRUE;
@@ -16300,6 +16316,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 			}
 		}
 		switch_thread_rwlock_unlock(session->bug_rwlock);
+		switch_core_latency_end(session, SWITCH_LATENCY_WRITE_BUGS, lat_mark);
 		if (prune) {
 			switch_core_media_bug_prune(session);
 		}
@@ -16332,12 +16349,14 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 			frame->codec->cur_frame = frame;
 			switch_assert(enc_frame->datalen <= SWITCH_RECOMMENDED_BUFFER_SIZE);
 			switch_assert(session->enc_write_frame.datalen <= SWITCH_RECOMMENDED_BUFFER_SIZE);
-			status = switch_core_codec_encode(session->write_codec,
+			lat_mark = switch_core_latency_start(session);
+			status = switch_core_codec_offload_encode(session->write_codec,
 											  frame->codec,
 											  enc_frame->data,
 											  enc_frame->datalen,
 											  session->write_impl.actual_samples_per_second,
 											  session->enc_write_frame.data, &session->enc_write_frame.datalen, &session->enc_write_frame.rate, &flag);
+			switch_core_latency_end(session, SWITCH_LATENCY_ENCODE, lat_mark);
 
 			switch_assert(session->enc_write_frame.datalen <= SWITCH_RECOMMENDED_BUFFER_SIZE);
 
@@ -16374,6 +16393,10 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 				enc_frame->payload = enc_frame->codec->implementation->ianacode;
 				write_frame = enc_frame;
 				break;
+			case SWITCH_STATUS_MORE_DATA:
+				/* the encoder is a frame behind, nothing to send yet */
+				status = SWITCH_STATUS_SUCCESS;
+				goto error;
 			case SWITCH_STATUS_NOT_INITALIZED:
 				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Codec init error!\n");
 				write_frame = NULL;
@@ -16442,12 +16465,14 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 				frame->codec->cur_frame = frame;
 				switch_assert(enc_frame->datalen <= SWITCH_RECOMMENDED_BUFFER_SIZE);
 				switch_assert(session->enc_write_frame.datalen <= SWITCH_RECOMMENDED_BUFFER_SIZE);
-				status = switch_core_codec_encode(session->write_codec,
+				lat_mark = switch_core_latency_start(session);
+				status = switch_core_codec_offload_encode(session->write_codec,
 												  frame->codec,
 												  enc_frame->data,
 												  enc_frame->datalen,
 												  rate,
 												  session->enc_write_frame.data, &session->enc_write_frame.datalen, &session->enc_write_frame.rate, &flag);
+				switch_core_latency_end(session, SWITCH_LATENCY_ENCODE, lat_mark);
 
 				switch_assert(session->enc_write_frame.datalen <= SWITCH_RECOMMENDED_BUFFER_SIZE);
 
@@ -16527,6 +16552,10 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 					enc_frame->payload = enc_frame->codec->implementation->ianacode;
 					write_frame = enc_frame;
 					break;
+				case SWITCH_STATUS_MORE_DATA:
+					/* the encoder is a frame behind, nothing to send yet */
+					status = SWITCH_STATUS_SUCCESS;
+					continue;
 				case SWITCH_STATUS_NOT_INITALIZED:
 					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Codec init error!\n");
 					write_frame = NULL;
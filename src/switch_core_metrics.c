@@ -0,0 +1,330 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * switch_core_metrics.c -- Core metrics registry and exposition
+ *
+ */
+
+#include <switch.h>
+#include "private/switch_core_pvt.h"
+
+#define METRICS_SHARDS 16
+#define METRICS_MAX 4096
+
+/* one counter per cache line so the shards never share one */
+typedef struct {
+	volatile int64_t value;
+	char pad[64 - sizeof(int64_t)];
+} metric_cell_t;
+
+/* 64 bit versions of switch_atomic_add/read/set, apr only has 32 bit ones */
+#ifdef WIN32
+#define metric_cell_add(cell, v) InterlockedExchangeAdd64((volatile LONGLONG *) &(cell)->value, (v))
+#define metric_cell_read(cell) InterlockedCompareExchange64((volatile LONGLONG *) &(cell)->value, 0, 0)
+#define metric_cell_set(cell, v) InterlockedExchange64((volatile LONGLONG *) &(cell)->value, (v))
+#define metric_barrier() MemoryBarrier()
+#else
+#define metric_cell_add(cell, v) __sync_fetch_and_add(&(cell)->value, (v))
+#define metric_cell_read(cell) __sync_fetch_and_add(&(cell)->value, 0)
+#define metric_cell_set(cell, v) __sync_lock_test_and_set(&(cell)->value, (v))
+#define metric_barrier() __sync_synchronize()
+#endif
+
+struct switch_metric {
+	metric_cell_t cells[METRICS_SHARDS];
+	char *name;
+	char *labels;
+	char *help;
+	switch_metric_type_t type;
+	switch_metric_callback_t callback;
+	void *user_data;
+	switch_metric_t *family;
+	volatile int retired;
+	/* scrapes inside the callback right now */
+	volatile switch_atomic_t scrapes;
+};
+
+/*
+ * Registration takes the mutex, scraping doesn't: metrics are only ever
+ * appended to list and never freed, a new one is filled in before count
+ * moves past it and an unregistered one is only flagged.  A scrape counts
+ * itself into the metric before it looks at the callback, and whoever
+ * clears the callback waits for that count to drop, so a callback is never
+ * called once unregister returned.
+ */
+static struct {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_hash_t *metrics;
+	switch_hash_t *families;
+	switch_metric_t *list[METRICS_MAX];
+	volatile switch_atomic_t count;
+} globals;
+
+/* no new scrape calls the old callback after this, the ones already in it are waited out */
+static void metric_callback_clear(switch_metric_t *m)
+{
+	m->callback = NULL;
+	metric_barrier();
+
+	while (switch_atomic_read(&m->scrapes)) {
+		switch_cond_next();
+	}
+}
+
+static switch_bool_t metric_name_ok(const char *name)
+{
+	const char *p;
+
+	if (zstr(name) || (!isalpha((unsigned char) *name) && *name != '_' && *name != ':')) {
+		return SWITCH_FALSE;
+	}
+
+	for (p = name; *p; p++) {
+		if (!isalnum((unsigned char) *p) && *p != '_' && *p != ':') {
+			return SWITCH_FALSE;
+		}
+	}
+
+	return SWITCH_TRUE;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_core_metric_register_callback(const char *name, const char *labels, const char *help, switch_metric_type_t type,
+																	  switch_metric_callback_t callback, void *user_data, switch_metric_t **metric)
+{
+	switch_metric_t *m;
+	char *key;
+	uint32_t count;
+
+	*metric = NULL;
+
+	if (!globals.mutex) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!metric_name_ok(name)) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Invalid metric name [%s]\n", switch_str_nil(name));
+		return SWITCH_STATUS_FALSE;
+	}
+
+	key = switch_mprintf("%s{%s}", name, switch_str_nil(labels));
+
+	switch_mutex_lock(globals.mutex);
+
+	if ((m = switch_core_hash_find(globals.metrics, key))) {
+		if (m->type != type) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Metric %s is already registered with another type\n", key);
+			m = NULL;
+		} else if (m->retired || callback) {
+			metric_callback_clear(m);
+			m->user_data = user_data;
+			metric_barrier();
+			m->callback = callback;
+			m->retired = 0;
+		}
+		goto end;
+	}
+
+	count = switch_atomic_read(&globals.count);
+
+	if (count >= METRICS_MAX) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Too many metrics, cannot register %s\n", key);
+		goto end;
+	}
+
+	m = switch_core_alloc(globals.pool, sizeof(*m));
+	m->name = switch_core_strdup(globals.pool, name);
+	m->labels = zstr(labels) ? NULL : switch_core_strdup(globals.pool, labels);
+	m->help = switch_core_strdup(globals.pool, zstr(help) ? name : help);
+	m->type = type;
+	m->callback = callback;
+	m->user_data = user_data;
+
+	if (!(m->family = switch_core_hash_find(globals.families, name))) {
+		m->family = m;
+		switch_core_hash_insert(globals.families, name, m);
+	} else if (m->family->type != type) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Metric %s is already registered with another type\n", name);
+		m = NULL;
+		goto end;
+	}
+
+	switch_core_hash_insert(globals.metrics, key, m);
+	globals.list[count] = m;
+	switch_atomic_set(&globals.count, count + 1);
+
+  end:
+
+	switch_mutex_unlock(globals.mutex);
+	switch_safe_free(key);
+
+	*metric = m;
+
+	return m ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_core_metric_register(const char *name, const char *labels, const char *help, switch_metric_type_t type,
+															 switch_metric_t **metric)
+{
+	return switch_core_metric_register_callback(name, labels, help, type, NULL, NULL, metric);
+}
+
+SWITCH_DECLARE(void) switch_core_metric_unregister(switch_metric_t *metric)
+{
+	if (!metric || !globals.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(globals.mutex);
+	metric->retired = 1;
+	metric_callback_clear(metric);
+	metric->user_data = NULL;
+	switch_mutex_unlock(globals.mutex);
+}
+
+/* threads that hash to the same shard share a cell, the add is atomic but the cache line mostly isn't contended */
+SWITCH_DECLARE(void) switch_core_metric_add(switch_metric_t *metric, int64_t value)
+{
+	if (metric) {
+		metric_cell_add(&metric->cells[switch_core_thread_shard(METRICS_SHARDS)], value);
+	}
+}
+
+SWITCH_DECLARE(void) switch_core_metric_set(switch_metric_t *metric, int64_t value)
+{
+	int i;
+
+	if (!metric) {
+		return;
+	}
+
+	for (i = 1; i < METRICS_SHARDS; i++) {
+		metric_cell_set(&metric->cells[i], 0);
+	}
+	metric_cell_set(&metric->cells[0], value);
+}
+
+SWITCH_DECLARE(double) switch_core_metric_value(switch_metric_t *metric)
+{
+	switch_metric_callback_t callback;
+	int64_t total = 0;
+	int i;
+
+	if (!metric) {
+		return 0;
+	}
+
+	if (metric->callback) {
+		double value = 0;
+
+		/* the increment is a full barrier, a clear after it waits for us */
+		switch_atomic_inc(&metric->scrapes);
+		if ((callback = metric->callback)) {
+			value = callback(metric, metric->user_data);
+		}
+		switch_atomic_dec(&metric->scrapes);
+
+		if (callback) {
+			return value;
+		}
+	}
+
+	for (i = 0; i < METRICS_SHARDS; i++) {
+		total += metric_cell_read(&metric->cells[i]);
+	}
+
+	return (double) total;
+}
+
+static void metric_write_sample(switch_stream_handle_t *stream, switch_metric_t *m)
+{
+	double value = switch_core_metric_value(m);
+
+	if (m->labels) {
+		stream->write_function(stream, "%s{%s} %.15g\n", m->name, m->labels, value);
+	} else {
+		stream->write_function(stream, "%s %.15g\n", m->name, value);
+	}
+}
+
+SWITCH_DECLARE(switch_status_t) switch_core_metrics_expose(switch_stream_handle_t *stream)
+{
+	uint32_t count, i, j;
+
+	if (!globals.mutex) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	count = switch_atomic_read(&globals.count);
+
+	/* a family is written where its first metric was registered, with every metric that shares its name */
+	for (i = 0; i < count; i++) {
+		switch_metric_t *family = globals.list[i];
+		int header = 0;
+
+		if (family->family != family) {
+			continue;
+		}
+
+		for (j = i; j < count; j++) {
+			switch_metric_t *m = globals.list[j];
+
+			if (m->family != family || m->retired) {
+				continue;
+			}
+
+			if (!header) {
+				stream->write_function(stream, "# HELP %s %s\n# TYPE %s %s\n", family->name, family->help,
+									   family->name, family->type == SWITCH_METRIC_COUNTER ? "counter" : "gauge");
+				header = 1;
+			}
+
+			metric_write_sample(stream, m);
+		}
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+void switch_core_metrics_init(switch_memory_pool_t *pool)
+{
+	memset(&globals, 0, sizeof(globals));
+	globals.pool = pool;
+	switch_core_hash_init(&globals.metrics);
+	switch_core_hash_init(&globals.families);
+	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, pool);
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
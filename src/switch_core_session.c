@@ -118,13 +118,137 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_codec_slin(switch_core_s
 }
 
 
+struct str_node {
+	char *str;
+	struct str_node *next;
+};
+
+static switch_session_shard_t *session_shard(const char *key)
+{
+	const unsigned char *p;
+	uint32_t hash = 0;
+
+	/* same case folding as the hash tables inside the shards */
+	for (p = (const unsigned char *) key; *p; p++) {
+		hash = hash * 33 + tolower(*p);
+	}
+
+	return &session_manager.session_shards[hash & (SWITCH_SESSION_TABLE_SHARDS - 1)];
+}
+
+static void session_shard_rdlock(switch_session_shard_t *shard)
+{
+	if (switch_thread_rwlock_tryrdlock(shard->rwlock) != SWITCH_STATUS_SUCCESS) {
+		switch_atomic_inc(&shard->contended);
+		switch_thread_rwlock_rdlock(shard->rwlock);
+	}
+}
+
+static void session_shard_wrlock(switch_session_shard_t *shard)
+{
+	if (switch_thread_rwlock_trywrlock(shard->rwlock) != SWITCH_STATUS_SUCCESS) {
+		switch_atomic_inc(&shard->contended);
+		switch_thread_rwlock_wrlock(shard->rwlock);
+	}
+}
+
+/* inserts key unless it is taken by another session, the shard must not be held */
+static switch_status_t session_table_insert(const char *key, switch_core_session_t *session)
+{
+	switch_session_shard_t *shard = session_shard(key);
+	switch_core_session_t *existing;
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	session_shard_wrlock(shard);
+	if ((existing = switch_core_hash_find(shard->table, key))) {
+		if (existing != session) {
+			status = SWITCH_STATUS_FALSE;
+		}
+	} else if (switch_core_hash_insert(shard->table, key, session) == SWITCH_STATUS_SUCCESS) {
+		if (++shard->count > shard->peak) {
+			shard->peak = shard->count;
+		}
+	}
+	switch_thread_rwlock_unlock(shard->rwlock);
+
+	return status;
+}
+
+static void session_table_delete(const char *key, switch_core_session_t *session)
+{
+	switch_session_shard_t *shard = session_shard(key);
+
+	session_shard_wrlock(shard);
+	if (switch_core_hash_find(shard->table, key) == session) {
+		switch_core_hash_delete(shard->table, key);
+		shard->count--;
+	}
+	switch_thread_rwlock_unlock(shard->rwlock);
+}
+
+static switch_bool_t session_table_exists(const char *key)
+{
+	switch_session_shard_t *shard = session_shard(key);
+	switch_bool_t exists;
+
+	session_shard_rdlock(shard);
+	exists = switch_core_hash_find(shard->table, key) ? SWITCH_TRUE : SWITCH_FALSE;
+	switch_thread_rwlock_unlock(shard->rwlock);
+
+	return exists;
+}
+
+typedef switch_bool_t (*session_table_filter_t)(switch_core_session_t *session, const void *user_data);
+
+/* collects the uuid of every session matching filter so the caller can act on them without holding any shard */
+static struct str_node *session_table_collect(switch_memory_pool_t *pool, session_table_filter_t filter, const void *user_data)
+{
+	struct str_node *head = NULL, *np;
+	switch_hash_index_t *hi;
+	const void *var;
+	void *val;
+	int i;
+
+	for (i = 0; i < SWITCH_SESSION_TABLE_SHARDS; i++) {
+		switch_session_shard_t *shard = &session_manager.session_shards[i];
+
+		session_shard_rdlock(shard);
+		for (hi = switch_core_hash_first(shard->table); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_session_t *session;
+
+			switch_core_hash_this(hi, &var, NULL, &val);
+			session = (switch_core_session_t *) val;
+
+			/* external ids point at the same session, only report it under its uuid */
+			if (!session || strcmp((const char *) var, session->uuid_str)) {
+				continue;
+			}
+
+			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
+				if (!filter || filter(session, user_data)) {
+					np = switch_core_alloc(pool, sizeof(*np));
+					np->str = switch_core_strdup(pool, session->uuid_str);
+					np->next = head;
+					head = np;
+				}
+				switch_core_session_rwunlock(session);
+			}
+		}
+		switch_thread_rwlock_unlock(shard->rwlock);
+	}
+
+	return head;
+}
+
 SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_locate(const char *uuid_str, const char *file, const char *func, int line)
 {
 	switch_core_session_t *session = NULL;
 
 	if (uuid_str) {
-		switch_mutex_lock(runtime.session_hash_mutex);
-		if ((session = switch_core_hash_find(session_manager.session_table, uuid_str))) {
+		switch_session_shard_t *shard = session_shard(uuid_str);
+
+		session_shard_rdlock(shard);
+		if ((session = switch_core_hash_find(shard->table, uuid_str))) {
 			/* Acquire a read lock on the session */
 #ifdef SWITCH_DEBUG_RWLOCKS
 			if (switch_core_session_perform_read_lock(session, file, func, line) != SWITCH_STATUS_SUCCESS) {
@@ -138,7 +262,7 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_locate(const
 				session = NULL;
 			}
 		}
-		switch_mutex_unlock(runtime.session_hash_mutex);
+		switch_thread_rwlock_unlock(shard->rwlock);
 	}
 
 	/* if its not NULL, now it's up to you to rwunlock this */
@@ -155,8 +279,10 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_force_locate
 	switch_status_t status;
 
 	if (uuid_str) {
-		switch_mutex_lock(runtime.session_hash_mutex);
-		if ((session = switch_core_hash_find(session_manager.session_table, uuid_str))) {
+		switch_session_shard_t *shard = session_shard(uuid_str);
+
+		session_shard_rdlock(shard);
+		if ((session = switch_core_hash_find(shard->table, uuid_str))) {
 			/* Acquire a read lock on the session */
 
 			if (switch_test_flag(session, SSF_DESTROYED)) {
@@ -178,7 +304,7 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_force_locate
 				session = NULL;
 			}
 		}
-		switch_mutex_unlock(runtime.session_hash_mutex);
+		switch_thread_rwlock_unlock(shard->rwlock);
 	}
 
 	/* if its not NULL, now it's up to you to rwunlock this */
@@ -203,15 +329,21 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_perform_get_partner(switch_c
 }
 
 
-struct str_node {
-	char *str;
-	struct str_node *next;
-};
+static switch_bool_t session_answered_filter(switch_core_session_t *session, const void *user_data)
+{
+	switch_hup_type_t type = *(const switch_hup_type_t *) user_data;
+	int ans = switch_channel_test_flag(switch_core_session_get_channel(session), CF_ANSWERED);
+
+	return ((ans && (type & SHT_ANSWERED)) || (!ans && (type & SHT_UNANSWERED))) ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
+static switch_bool_t session_endpoint_filter(switch_core_session_t *session, const void *user_data)
+{
+	return session->endpoint_interface == user_data ? SWITCH_TRUE : SWITCH_FALSE;
+}
 
 SWITCH_DECLARE(uint32_t) switch_core_session_hupall_matching_vars_ans(switch_event_t *vars, switch_call_cause_t cause, switch_hup_type_t type)
 {
-	switch_hash_index_t *hi;
-	void *val;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
@@ -222,24 +354,7 @@ SWITCH_DECLARE(uint32_t) switch_core_session_hupall_matching_vars_ans(switch_eve
 	if (!vars || !vars->headers)
 		return r;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				int ans = switch_channel_test_flag(switch_core_session_get_channel(session), CF_ANSWERED);
-				if ((ans && (type & SHT_ANSWERED)) || (!ans && (type & SHT_UNANSWERED))) {
-					np = switch_core_alloc(pool, sizeof(*np));
-					np->str = switch_core_strdup(pool, session->uuid_str);
-					np->next = head;
-					head = np;
-				}
-				switch_core_session_rwunlock(session);
-			}
-		}
-	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	head = session_table_collect(pool, session_answered_filter, &type);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -288,8 +403,6 @@ SWITCH_DECLARE(uint32_t) switch_core_session_hupall_matching_var_ans(const char
 
 SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall_matching_var(const char *var_name, const char *var_val)
 {
-	switch_hash_index_t *hi;
-	void *val;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
@@ -302,21 +415,7 @@ SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall_ma
 
 	switch_core_new_memory_pool(&pool);
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				np = switch_core_alloc(pool, sizeof(*np));
-				np->str = switch_core_strdup(pool, session->uuid_str);
-				np->next = head;
-				head = np;
-				switch_core_session_rwunlock(session);
-			}
-		}
-	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	head = session_table_collect(pool, NULL, NULL);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -338,31 +437,13 @@ SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall_ma
 
 SWITCH_DECLARE(void) switch_core_session_hupall_endpoint(const switch_endpoint_interface_t *endpoint_interface, switch_call_cause_t cause)
 {
-	switch_hash_index_t *hi;
-	void *val;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
 
 	switch_core_new_memory_pool(&pool);
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				if (session->endpoint_interface == endpoint_interface) {
-					np = switch_core_alloc(pool, sizeof(*np));
-					np->str = switch_core_strdup(pool, session->uuid_str);
-					np->next = head;
-					head = np;
-				}
-				switch_core_session_rwunlock(session);
-			}
-		}
-	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	head = session_table_collect(pool, session_endpoint_filter, endpoint_interface);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -377,8 +458,6 @@ SWITCH_DECLARE(void) switch_core_session_hupall_endpoint(const switch_endpoint_i
 
 SWITCH_DECLARE(void) switch_core_session_hupall(switch_call_cause_t cause)
 {
-	switch_hash_index_t *hi;
-	void *val;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
@@ -386,21 +465,7 @@ SWITCH_DECLARE(void) switch_core_session_hupall(switch_call_cause_t cause)
 	switch_core_new_memory_pool(&pool);
 
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				np = switch_core_alloc(pool, sizeof(*np));
-				np->str = switch_core_strdup(pool, session->uuid_str);
-				np->next = head;
-				head = np;
-				switch_core_session_rwunlock(session);
-			}
-		}
-	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	head = session_table_collect(pool, NULL, NULL);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -416,23 +481,19 @@ SWITCH_DECLARE(void) switch_core_session_hupall(switch_call_cause_t cause)
 
 SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall(void)
 {
-	switch_hash_index_t *hi;
-	void *val;
-	switch_core_session_t *session;
+	switch_memory_pool_t *pool;
+	struct str_node *head, *np;
 	switch_console_callback_match_t *my_matches = NULL;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				switch_console_push_match(&my_matches, session->uuid_str);
-				switch_core_session_rwunlock(session);
-			}
-		}
+	switch_core_new_memory_pool(&pool);
+
+	head = session_table_collect(pool, NULL, NULL);
+
+	for (np = head; np; np = np->next) {
+		switch_console_push_match(&my_matches, np->str);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+
+	switch_core_destroy_memory_pool(&pool);
 
 	return my_matches;
 }
@@ -442,17 +503,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_message_send(const char *uui
 	switch_core_session_t *session = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if ((session = switch_core_hash_find(session_manager.session_table, uuid_str)) != 0) {
-		/* Acquire a read lock on the session or forget it the channel is dead */
-		if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-			if (switch_channel_up_nosig(session->channel)) {
-				status = switch_core_session_receive_message(session, message);
-			}
-			switch_core_session_rwunlock(session);
+	/* the read lock keeps the session alive, no need to hold its shard while it works */
+	if ((session = switch_core_session_locate(uuid_str))) {
+		if (switch_channel_up_nosig(session->channel)) {
+			status = switch_core_session_receive_message(session, message);
 		}
+		switch_core_session_rwunlock(session);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	return status;
 }
@@ -462,17 +519,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_event_send(const char *uuid_
 	switch_core_session_t *session = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if ((session = switch_core_hash_find(session_manager.session_table, uuid_str)) != 0) {
-		/* Acquire a read lock on the session or forget it the channel is dead */
-		if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-			if (switch_channel_up_nosig(session->channel)) {
-				status = switch_core_session_queue_event(session, event);
-			}
-			switch_core_session_rwunlock(session);
+	/* the read lock keeps the session alive, no need to hold its shard while it works */
+	if ((session = switch_core_session_locate(uuid_str))) {
+		if (switch_channel_up_nosig(session->channel)) {
+			status = switch_core_session_queue_event(session, event);
 		}
+		switch_core_session_rwunlock(session);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	return status;
 }
@@ -1488,6 +1541,10 @@ SWITCH_DECLARE(void) switch_core_session_signal_state_change(switch_core_session
 	switch_status_t status = SWITCH_STATUS_SUCCESS;
 	switch_io_event_hook_state_change_t *ptr;
 
+	if (!session->latency_state_mark) {
+		session->latency_state_mark = switch_core_latency_start(session);
+	}
+
 	switch_core_session_wake_session_thread(session);
 
 	if (session->endpoint_interface->io_routines->state_change) {
@@ -1568,11 +1625,12 @@ SWITCH_DECLARE(void) switch_core_session_perform_destroy(switch_core_session_t *
 
 	switch_scheduler_del_task_group((*session)->uuid_str);
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	switch_core_hash_delete(session_manager.session_table, (*session)->uuid_str);
+	session_table_delete((*session)->uuid_str, *session);
 	if ((*session)->external_id) {
-		switch_core_hash_delete(session_manager.session_table, (*session)->external_id);
+		session_table_delete((*session)->external_id, *session);
 	}
+
+	switch_mutex_lock(runtime.session_hash_mutex);
 	if (session_manager.session_count) {
 		session_manager.session_count--;
 		if (session_manager.session_count == 0) {
@@ -2037,10 +2095,9 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_uuid(switch_core_session
 	}
 
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if (switch_core_hash_find(session_manager.session_table, use_uuid)) {
+	/* claim the new uuid first, the session is briefly reachable under both */
+	if (session_table_insert(use_uuid, session) != SWITCH_STATUS_SUCCESS) {
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_CRIT, "Duplicate UUID!\n");
-		switch_mutex_unlock(runtime.session_hash_mutex);
 		return SWITCH_STATUS_FALSE;
 	}
 
@@ -2059,10 +2116,8 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_uuid(switch_core_session
 
 	switch_event_create(&event, SWITCH_EVENT_CHANNEL_UUID);
 	switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Old-Unique-ID", session->uuid_str);
-	switch_core_hash_delete(session_manager.session_table, session->uuid_str);
+	session_table_delete(session->uuid_str, session);
 	switch_set_string(session->uuid_str, use_uuid);
-	switch_core_hash_insert(session_manager.session_table, session->uuid_str, session);
-	switch_mutex_unlock(runtime.session_hash_mutex);
 	switch_channel_event_set_data(session->channel, event);
 	switch_event_fire(&event);
 
@@ -2079,26 +2134,19 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_external_id(switch_core_
 	}
 
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if (strcmp(use_external_id, session->uuid_str) && switch_core_hash_find(session_manager.session_table, use_external_id)) {
+	if (strcmp(use_external_id, session->uuid_str) && session_table_insert(use_external_id, session) != SWITCH_STATUS_SUCCESS) {
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_WARNING, "Duplicate External ID!\n");
-		switch_mutex_unlock(runtime.session_hash_mutex);
 		return SWITCH_STATUS_FALSE;
 	}
 
 	switch_channel_set_variable(session->channel, "session_external_id", use_external_id);
 
 	if (session->external_id && strcmp(session->external_id, session->uuid_str)) {
-		switch_core_hash_delete(session_manager.session_table, session->external_id);
+		session_table_delete(session->external_id, session);
 	}
 
 	session->external_id = switch_core_session_strdup(session, use_external_id);
 
-	if (strcmp(session->external_id, session->uuid_str)) {
-		switch_core_hash_insert(session_manager.session_table, session->external_id, session);
-	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
-
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -2390,7 +2438,7 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_request_uuid(switch_
 	int32_t sps = 0;
 
 
-	if (use_uuid && switch_core_hash_find(session_manager.session_table, use_uuid)) {
+	if (use_uuid && session_table_exists(use_uuid)) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Duplicate UUID!\n");
 		return NULL;
 	}
@@ -2500,8 +2548,16 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_request_uuid(switch_
 	switch_queue_create(&session->private_event_queue, SWITCH_EVENT_QUEUE_LEN, session->pool);
 	switch_queue_create(&session->private_event_queue_pri, SWITCH_EVENT_QUEUE_LEN, session->pool);
 
+	/* a concurrent request for the same use_uuid can get past the check above, only one wins here */
+	if (session_table_insert(session->uuid_str, session) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Duplicate UUID!\n");
+		switch_channel_uninit(session->channel);
+		switch_core_destroy_memory_pool(&usepool);
+		UNPROTECT_INTERFACE(endpoint_interface);
+		return NULL;
+	}
+
 	switch_mutex_lock(runtime.session_hash_mutex);
-	switch_core_hash_insert(session_manager.session_table, session->uuid_str, session);
 	session->id = session_manager.session_id++;
 	session_manager.session_count++;
 
@@ -2626,26 +2682,89 @@ SWITCH_DECLARE(uint32_t) switch_core_sessions_per_second(uint32_t new_limit)
 	return runtime.sps_total;
 }
 
+static double session_count_metric(switch_metric_t *metric, void *user_data)
+{
+	return session_manager.session_count;
+}
+
+static double session_total_metric(switch_metric_t *metric, void *user_data)
+{
+	return (double) (session_manager.session_id - 1);
+}
+
+static double session_sps_metric(switch_metric_t *metric, void *user_data)
+{
+	return runtime.sps_last;
+}
+
 void switch_core_session_init(switch_memory_pool_t *pool)
 {
+	switch_metric_t *metric;
+	int i;
+
 	memset(&session_manager, 0, sizeof(session_manager));
 	session_manager.session_limit = 1000;
 	session_manager.session_id = 1;
 	session_manager.memory_pool = pool;
-	switch_core_hash_init(&session_manager.session_table);
+
+	for (i = 0; i < SWITCH_SESSION_TABLE_SHARDS; i++) {
+		switch_core_hash_init(&session_manager.session_shards[i].table);
+		switch_thread_rwlock_create(&session_manager.session_shards[i].rwlock, pool);
+	}
+
 	switch_mutex_init(&session_manager.mutex, SWITCH_MUTEX_DEFAULT, session_manager.memory_pool);
 	switch_thread_cond_create(&session_manager.cond, session_manager.memory_pool);
 	switch_queue_create(&session_manager.thread_queue, 100000, session_manager.memory_pool);
+
+	switch_core_metric_register_callback("freeswitch_sessions", NULL, "Sessions in progress", SWITCH_METRIC_GAUGE,
+										 session_count_metric, NULL, &metric);
+	switch_core_metric_register_callback("freeswitch_sessions_total", NULL, "Sessions created since startup", SWITCH_METRIC_COUNTER,
+										 session_total_metric, NULL, &metric);
+	switch_core_metric_register_callback("freeswitch_sessions_per_second", NULL, "Sessions created in the last second", SWITCH_METRIC_GAUGE,
+										 session_sps_metric, NULL, &metric);
 }
 
 void switch_core_session_uninit(void)
 {
+	int i;
+
 	switch_queue_term(session_manager.thread_queue);
 	switch_mutex_lock(session_manager.mutex);
 	if (session_manager.running)
 		switch_thread_cond_timedwait(session_manager.cond, session_manager.mutex, 10000000);
 	switch_mutex_unlock(session_manager.mutex);
-	switch_core_hash_destroy(&session_manager.session_table);
+
+	for (i = 0; i < SWITCH_SESSION_TABLE_SHARDS; i++) {
+		switch_core_hash_destroy(&session_manager.session_shards[i].table);
+	}
+}
+
+SWITCH_DECLARE(void) switch_core_session_table_stats(switch_stream_handle_t *stream)
+{
+	uint32_t min = 0, max = 0, total = 0;
+	uint64_t contended = 0;
+	int i;
+
+	for (i = 0; i < SWITCH_SESSION_TABLE_SHARDS; i++) {
+		switch_session_shard_t *shard = &session_manager.session_shards[i];
+
+		uint32_t shard_contended = switch_atomic_read(&shard->contended);
+
+		stream->write_function(stream, "shard %2d: entries=%u peak=%u contended=%u\n",
+							   i, shard->count, shard->peak, shard_contended);
+
+		if (!i || shard->count < min) {
+			min = shard->count;
+		}
+		if (shard->count > max) {
+			max = shard->count;
+		}
+		total += shard->count;
+		contended += shard_contended;
+	}
+
+	stream->write_function(stream, "shards: %d entries: %u min: %u max: %u contended: %" SWITCH_UINT64_T_FMT "\n",
+						   SWITCH_SESSION_TABLE_SHARDS, total, min, max, contended);
 }
 
 SWITCH_DECLARE(switch_app_log_t *) switch_core_session_get_app_log(switch_core_session_t *session)
@@ -2850,6 +2969,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_exec(switch_core_session_t *
 	char uuid_str[SWITCH_UUID_FORMATTED_LENGTH + 1];
 	char *app_uuid = uuid_str;
 	switch_bool_t expand_variables = !switch_true(switch_channel_get_variable(session->channel, "app_disable_expand_variables"));
+	switch_time_t lat_mark;
 
 	if ((app_uuid_var = switch_channel_get_variable(channel, "app_uuid"))) {
 		app_uuid = (char *)app_uuid_var;
@@ -2966,7 +3086,9 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_exec(switch_core_session_t *
 	msg.string_array_arg[1] = expanded;
 	switch_core_session_receive_message(session, &msg);
 
+	lat_mark = switch_core_latency_start(session);
 	application_interface->application_function(session, expanded);
+	switch_core_latency_end(session, SWITCH_LATENCY_APPLICATION, lat_mark);
 
 	if (switch_event_create(&event, SWITCH_EVENT_CHANNEL_EXECUTE_COMPLETE) == SWITCH_STATUS_SUCCESS) {
 		const char *resp = switch_channel_get_variable(session->channel, SWITCH_CURRENT_APPLICATION_RESPONSE_VARIABLE);
@@ -69,6 +69,7 @@ static struct {
 	uint32_t total_used_handles;
 	switch_cache_db_handle_t *dbh;
 	switch_sql_queue_manager_t *qm;
+	switch_metric_t *qm_metric;
 	int paused;
 } sql_manager;
 
@@ -298,6 +299,7 @@ static void sql_close(time_t prune)
 				break;
 			case SCDB_TYPE_CORE_DB:
 				{
+					switch_core_db_flush_stmt_cache(dbh->native_handle.core_db_dbh);
 					switch_core_db_close(dbh->native_handle.core_db_dbh->handle);
 					dbh->native_handle.core_db_dbh->handle = NULL;
 				}
@@ -1393,6 +1395,85 @@ SWITCH_DECLARE(switch_status_t) switch_cache_db_execute_sql_callback_err(switch_
 	return status;
 }
 
+/* render the ? placeholders of a parameterized statement for backends without native binding */
+static char *sql_params_render(const char *sql, int argc, const char *const *argv)
+{
+	switch_stream_handle_t stream = { 0 };
+	const char *p, *run;
+	int i = 0, quoted = 0;
+
+	SWITCH_STANDARD_STREAM(stream);
+
+	for (p = run = sql; *p; p++) {
+		if (*p == '\'') {
+			quoted = !quoted;
+		} else if (*p == '?' && !quoted && i < argc) {
+			stream.write_function(&stream, "%.*s", (int) (p - run), run);
+
+			if (argv[i]) {
+				char *val = switch_mprintf("'%q'", argv[i]);
+				stream.write_function(&stream, "%s", val);
+				switch_safe_free(val);
+			} else {
+				stream.write_function(&stream, "NULL");
+			}
+
+			run = p + 1;
+			i++;
+		}
+	}
+
+	stream.write_function(&stream, "%s", run);
+
+	return (char *) stream.data;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_cache_db_execute_sql_params(switch_cache_db_handle_t *dbh, const char *sql, int argc, const char *const *argv,
+																   switch_core_db_callback_func_t callback, void *pdata, char **err)
+{
+	switch_status_t status = SWITCH_STATUS_FALSE;
+
+	if (err) {
+		*err = NULL;
+	}
+
+	switch (dbh->type) {
+	case SCDB_TYPE_CORE_DB:
+		{
+			char *errmsg = NULL;
+			int ret = switch_core_db_exec_params(dbh->native_handle.core_db_dbh, sql, argc, argv, callback, pdata, &errmsg);
+
+			if (ret == SWITCH_CORE_DB_OK || ret == SWITCH_CORE_DB_ABORT) {
+				status = SWITCH_STATUS_SUCCESS;
+			}
+
+			if (errmsg) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "[%s] NATIVE SQL ERR [%s]\n%s\n", dbh->name, errmsg, sql);
+				if (err) {
+					*err = strdup(errmsg);
+				}
+				switch_core_db_free(errmsg);
+			}
+		}
+		break;
+	default:
+		{
+			char *rendered = sql_params_render(sql, argc, argv);
+
+			if (callback) {
+				status = switch_cache_db_execute_sql_callback(dbh, rendered, callback, pdata, err);
+			} else {
+				status = switch_cache_db_execute_sql_real(dbh, rendered, err);
+			}
+
+			switch_safe_free(rendered);
+		}
+		break;
+	}
+
+	return status;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_cache_db_create_schema(switch_cache_db_handle_t *dbh, char *sql, char **err)
 {
 	switch_status_t r = SWITCH_STATUS_SUCCESS;
@@ -1743,6 +1824,82 @@ SWITCH_DECLARE(void) switch_sql_queue_manager_execute_sql_event_callback_err(swi
 }
 
 
+/*
+ * A parameterized statement travels through the sql queue packed into one malloced string:
+ * SQL_PARAMS_TAG, the template, \0, then per parameter a type byte ('v' value or 'n' NULL),
+ * the value and \0, and a final \0.  The template stays readable so the queue can still be
+ * routed on its text.
+ */
+#define SQL_PARAMS_TAG '\001'
+#define SQL_PARAMS_MAX 64
+
+static char *sql_params_pack(const char *sql, int argc, const char *const *argv)
+{
+	switch_size_t len = strlen(sql) + 3;
+	char *packed, *p;
+	int i;
+
+	for (i = 0; i < argc; i++) {
+		len += (argv[i] ? strlen(argv[i]) : 0) + 2;
+	}
+
+	switch_malloc(packed, len);
+	p = packed;
+
+	*p++ = SQL_PARAMS_TAG;
+	len = strlen(sql) + 1;
+	memcpy(p, sql, len);
+	p += len;
+
+	for (i = 0; i < argc; i++) {
+		if (argv[i]) {
+			*p++ = 'v';
+			len = strlen(argv[i]) + 1;
+			memcpy(p, argv[i], len);
+			p += len;
+		} else {
+			*p++ = 'n';
+			*p++ = '\0';
+		}
+	}
+
+	*p = '\0';
+
+	return packed;
+}
+
+static int sql_params_unpack(char *packed, const char **sql, const char **argv, int max)
+{
+	char *p = packed + 1;
+	int argc = 0;
+
+	*sql = p;
+	p += strlen(p) + 1;
+
+	while (*p && argc < max) {
+		char type = *p++;
+
+		argv[argc++] = type == 'n' ? NULL : p;
+		p += strlen(p) + 1;
+	}
+
+	return argc;
+}
+
+/* runs one item popped off an sql queue, plain sql or a packed parameterized statement */
+static switch_status_t sql_queue_item_execute(switch_cache_db_handle_t *dbh, char *item)
+{
+	if (*item == SQL_PARAMS_TAG) {
+		const char *argv[SQL_PARAMS_MAX];
+		const char *sql;
+		int argc = sql_params_unpack(item, &sql, argv, SQL_PARAMS_MAX);
+
+		return switch_cache_db_execute_sql_params(dbh, sql, argc, argv, NULL, NULL, NULL);
+	}
+
+	return switch_cache_db_execute_sql(dbh, item, NULL);
+}
+
 static void do_flush(switch_sql_queue_manager_t *qm, int i, switch_cache_db_handle_t *dbh)
 {
 	void *pop = NULL;
@@ -1752,7 +1909,7 @@ static void do_flush(switch_sql_queue_manager_t *qm, int i, switch_cache_db_hand
 	while (switch_queue_trypop(q, &pop) == SWITCH_STATUS_SUCCESS) {
 		if (pop) {
 			if (dbh) {
-				switch_cache_db_execute_sql(dbh, (char *) pop, NULL);
+				sql_queue_item_execute(dbh, (char *) pop);
 			}
 			switch_safe_free(pop);
 		}
@@ -1889,6 +2046,11 @@ SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_destroy(switch_sql_queu
 	return status;
 }
 
+SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push_params(switch_sql_queue_manager_t *qm, const char *sql, int argc, const char *const *argv, uint32_t pos)
+{
+	return switch_sql_queue_manager_push(qm, sql_params_pack(sql, argc, argv), pos, SWITCH_FALSE);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push(switch_sql_queue_manager_t *qm, const char *sql, uint32_t pos, switch_bool_t dup)
 {
 	char *sqlptr = NULL;
@@ -2134,7 +2296,9 @@ static uint32_t do_trans(switch_sql_queue_manager_t *qm)
 		}
 
 		if (pop) {
-			if ((status = switch_cache_db_execute_sql(qm->event_db, (char *) pop, NULL)) == SWITCH_STATUS_SUCCESS) {
+			status = sql_queue_item_execute(qm->event_db, (char *) pop);
+
+			if (status == SWITCH_STATUS_SUCCESS) {
 				switch_mutex_lock(qm->mutex);
 				qm->pre_written[i]++;
 				switch_mutex_unlock(qm->mutex);
@@ -2451,12 +2615,10 @@ static void core_event_handler(switch_event_t *event)
 			const char *uuid = switch_event_get_header(event, "unique-id");
 
 			if (uuid) {
-				new_sql() = switch_mprintf("delete from channels where uuid='%q'",
-										   uuid);
-
-				new_sql() = switch_mprintf("delete from calls where (caller_uuid='%q' or callee_uuid='%q')",
-										   uuid, uuid);
+				const char *args[2] = { uuid, uuid };
 
+				new_sql() = sql_params_pack("delete from channels where uuid=?", 1, args);
+				new_sql() = sql_params_pack("delete from calls where (caller_uuid=? or callee_uuid=?)", 2, args);
 			}
 		}
 		break;
@@ -2496,30 +2658,35 @@ static void core_event_handler(switch_event_t *event)
 	case SWITCH_EVENT_CHANNEL_ANSWER:
 	case SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA:
 	case SWITCH_EVENT_CODEC:
-		new_sql() =
-			switch_mprintf
-			("update channels set read_codec='%q',read_rate='%q',read_bit_rate='%q',write_codec='%q',write_rate='%q',write_bit_rate='%q' where uuid='%q'",
-			 switch_event_get_header_nil(event, "channel-read-codec-name"),
-			 switch_event_get_header_nil(event, "channel-read-codec-rate"),
-			 switch_event_get_header_nil(event, "channel-read-codec-bit-rate"),
-			 switch_event_get_header_nil(event, "channel-write-codec-name"),
-			 switch_event_get_header_nil(event, "channel-write-codec-rate"),
-			 switch_event_get_header_nil(event, "channel-write-codec-bit-rate"),
-			 switch_event_get_header_nil(event, "unique-id"));
+		{
+			const char *args[7];
+
+			args[0] = switch_event_get_header_nil(event, "channel-read-codec-name");
+			args[1] = switch_event_get_header_nil(event, "channel-read-codec-rate");
+			args[2] = switch_event_get_header_nil(event, "channel-read-codec-bit-rate");
+			args[3] = switch_event_get_header_nil(event, "channel-write-codec-name");
+			args[4] = switch_event_get_header_nil(event, "channel-write-codec-rate");
+			args[5] = switch_event_get_header_nil(event, "channel-write-codec-bit-rate");
+			args[6] = switch_event_get_header_nil(event, "unique-id");
+
+			new_sql() = sql_params_pack("update channels set read_codec=?,read_rate=?,read_bit_rate=?,write_codec=?,write_rate=?,write_bit_rate=? "
+										"where uuid=?", 7, args);
+		}
 		break;
 	case SWITCH_EVENT_CHANNEL_HOLD:
 	case SWITCH_EVENT_CHANNEL_UNHOLD:
 	case SWITCH_EVENT_CHANNEL_EXECUTE: {
+		const char *args[6];
 
-		new_sql() = switch_mprintf("update channels set application='%q',application_data='%q',"
-								   "presence_id='%q',presence_data='%q',accountcode='%q' where uuid='%q'",
-								   switch_event_get_header_nil(event, "application"),
-								   switch_event_get_header_nil(event, "application-data"),
-								   switch_event_get_header_nil(event, "channel-presence-id"),
-								   switch_event_get_header_nil(event, "channel-presence-data"),
-								   switch_event_get_header_nil(event, "variable_accountcode"),
-								   switch_event_get_header_nil(event, "unique-id")
-								   );
+		args[0] = switch_event_get_header_nil(event, "application");
+		args[1] = switch_event_get_header_nil(event, "application-data");
+		args[2] = switch_event_get_header_nil(event, "channel-presence-id");
+		args[3] = switch_event_get_header_nil(event, "channel-presence-data");
+		args[4] = switch_event_get_header_nil(event, "variable_accountcode");
+		args[5] = switch_event_get_header_nil(event, "unique-id");
+
+		new_sql() = sql_params_pack("update channels set application=?,application_data=?,"
+									"presence_id=?,presence_data=?,accountcode=? where uuid=?", 6, args);
 
 	}
 		break;
@@ -2581,9 +2748,11 @@ static void core_event_handler(switch_event_t *event)
 											   switch_event_get_header_nil(event, "unique-id"));
 					free(extra_cols);
 				} else {
-					new_sql() = switch_mprintf("update channels set callstate='%q' where uuid='%q'",
-											   switch_event_get_header_nil(event, "channel-call-state"),
-											   switch_event_get_header_nil(event, "unique-id"));
+					const char *args[2];
+
+					args[0] = switch_event_get_header_nil(event, "channel-call-state");
+					args[1] = switch_event_get_header_nil(event, "unique-id");
+					new_sql() = sql_params_pack("update channels set callstate=? where uuid=?", 2, args);
 				}
 			}
 
@@ -2623,9 +2792,11 @@ static void core_event_handler(switch_event_t *event)
 					free(extra_cols);
 
 				} else {
-					new_sql() = switch_mprintf("update channels set state='%q' where uuid='%q'",
-											   switch_event_get_header_nil(event, "channel-state"),
-											   switch_event_get_header_nil(event, "unique-id"));
+					const char *args[2];
+
+					args[0] = switch_event_get_header_nil(event, "channel-state");
+					args[1] = switch_event_get_header_nil(event, "unique-id");
+					new_sql() = sql_params_pack("update channels set state=? where uuid=?", 2, args);
 				}
 				break;
 			case CS_ROUTING:
@@ -2674,9 +2845,13 @@ static void core_event_handler(switch_event_t *event)
 				}
 				break;
 			default:
-				new_sql() = switch_mprintf("update channels set state='%q' where uuid='%q'",
-										   switch_event_get_header_nil(event, "channel-state"),
-										   switch_event_get_header_nil(event, "unique-id"));
+				{
+					const char *args[2];
+
+					args[0] = switch_event_get_header_nil(event, "channel-state");
+					args[1] = switch_event_get_header_nil(event, "unique-id");
+					new_sql() = sql_params_pack("update channels set state=? where uuid=?", 2, args);
+				}
 				break;
 			}
 
@@ -3464,74 +3639,71 @@ SWITCH_DECLARE(switch_status_t) switch_core_add_registration(const char *user, c
 															 const char *network_ip, const char *network_port, const char *network_proto,
 															 const char *metadata)
 {
-	char *sql;
+	const char *args[10];
+	char expires_str[32];
 
 	if (!switch_test_flag((&runtime), SCF_USE_SQL)) {
 		return SWITCH_STATUS_FALSE;
 	}
 
 	if (runtime.multiple_registrations) {
-		sql = switch_mprintf("delete from registrations where hostname='%q' and (url='%q' or token='%q')",
-							 switch_core_get_switchname(), url, switch_str_nil(token));
+		args[0] = switch_core_get_switchname();
+		args[1] = url;
+		args[2] = switch_str_nil(token);
+		switch_sql_queue_manager_push_params(sql_manager.qm, "delete from registrations where hostname=? and (url=? or token=?)", 3, args, 0);
 	} else {
-		sql = switch_mprintf("delete from registrations where reg_user='%q' and realm='%q' and hostname='%q'",
-							 user, realm, switch_core_get_switchname());
+		args[0] = user;
+		args[1] = realm;
+		args[2] = switch_core_get_switchname();
+		switch_sql_queue_manager_push_params(sql_manager.qm, "delete from registrations where reg_user=? and realm=? and hostname=?", 3, args, 0);
 	}
 
-	switch_sql_queue_manager_push(sql_manager.qm, sql, 0, SWITCH_FALSE);
+	switch_snprintf(expires_str, sizeof(expires_str), "%ld", (long) expires);
+
+	args[0] = switch_str_nil(user);
+	args[1] = switch_str_nil(realm);
+	args[2] = switch_str_nil(token);
+	args[3] = switch_str_nil(url);
+	args[4] = expires_str;
+	args[5] = switch_str_nil(network_ip);
+	args[6] = switch_str_nil(network_port);
+	args[7] = switch_str_nil(network_proto);
+	args[8] = switch_core_get_switchname();
+	args[9] = metadata;
 
 	if ( !zstr(metadata) ) {
-		sql = switch_mprintf("insert into registrations (reg_user,realm,token,url,expires,network_ip,network_port,network_proto,hostname,metadata) "
-							 "values ('%q','%q','%q','%q',%ld,'%q','%q','%q','%q','%q')",
-							 switch_str_nil(user),
-							 switch_str_nil(realm),
-							 switch_str_nil(token),
-							 switch_str_nil(url),
-							 expires,
-							 switch_str_nil(network_ip),
-							 switch_str_nil(network_port),
-							 switch_str_nil(network_proto),
-							 switch_core_get_switchname(),
-							 metadata
-							 );
+		switch_sql_queue_manager_push_params(sql_manager.qm,
+											 "insert into registrations (reg_user,realm,token,url,expires,network_ip,network_port,network_proto,hostname,metadata) "
+											 "values (?,?,?,?,?,?,?,?,?,?)", 10, args, 0);
 	} else {
-		sql = switch_mprintf("insert into registrations (reg_user,realm,token,url,expires,network_ip,network_port,network_proto,hostname) "
-							 "values ('%q','%q','%q','%q',%ld,'%q','%q','%q','%q')",
-							 switch_str_nil(user),
-							 switch_str_nil(realm),
-							 switch_str_nil(token),
-							 switch_str_nil(url),
-							 expires,
-							 switch_str_nil(network_ip),
-							 switch_str_nil(network_port),
-							 switch_str_nil(network_proto),
-							 switch_core_get_switchname()
-							 );
+		switch_sql_queue_manager_push_params(sql_manager.qm,
+											 "insert into registrations (reg_user,realm,token,url,expires,network_ip,network_port,network_proto,hostname) "
+											 "values (?,?,?,?,?,?,?,?,?)", 9, args, 0);
 	}
 
-
-	switch_sql_queue_manager_push(sql_manager.qm, sql, 0, SWITCH_FALSE);
-
 	return SWITCH_STATUS_SUCCESS;
 }
 
 SWITCH_DECLARE(switch_status_t) switch_core_del_registration(const char *user, const char *realm, const char *token)
 {
 
-	char *sql;
+	const char *args[4];
 
 	if (!switch_test_flag((&runtime), SCF_USE_SQL)) {
 		return SWITCH_STATUS_FALSE;
 	}
 
+	args[0] = user;
+	args[1] = realm;
+	args[2] = switch_core_get_switchname();
+	args[3] = token;
+
 	if (!zstr(token) && runtime.multiple_registrations) {
-		sql = switch_mprintf("delete from registrations where reg_user='%q' and realm='%q' and hostname='%q' and token='%q'", user, realm, switch_core_get_switchname(), token);
+		switch_sql_queue_manager_push_params(sql_manager.qm, "delete from registrations where reg_user=? and realm=? and hostname=? and token=?", 4, args, 0);
 	} else {
-		sql = switch_mprintf("delete from registrations where reg_user='%q' and realm='%q' and hostname='%q'", user, realm, switch_core_get_switchname());
+		switch_sql_queue_manager_push_params(sql_manager.qm, "delete from registrations where reg_user=? and realm=? and hostname=?", 3, args, 0);
 	}
 
-	switch_sql_queue_manager_push(sql_manager.qm, sql, 0, SWITCH_FALSE);
-
 
 	return SWITCH_STATUS_SUCCESS;
 }
@@ -3866,11 +4038,19 @@ SWITCH_DECLARE(void) switch_core_sqldb_resume(void)
 }
 
 
+static double sql_queue_metric(switch_metric_t *metric, void *user_data)
+{
+	switch_sql_queue_manager_t *qm = (switch_sql_queue_manager_t *) user_data;
+
+	return qm ? qm_ttl(qm) : 0;
+}
+
 static void switch_core_sqldb_stop_thread(void)
 {
 	switch_mutex_lock(sql_manager.ctl_mutex);
 	if (sql_manager.manage) {
 		if (sql_manager.qm) {
+			switch_core_metric_unregister(sql_manager.qm_metric);
 			switch_sql_queue_manager_destroy(&sql_manager.qm);
 		}
 	} else {
@@ -3907,6 +4087,8 @@ static void switch_core_sqldb_start_thread(void)
 
 		}
 		switch_sql_queue_manager_start(sql_manager.qm);
+		switch_core_metric_register_callback("freeswitch_sql_queue_depth", NULL, "Statements waiting in the core SQL queues", SWITCH_METRIC_GAUGE,
+											 sql_queue_metric, sql_manager.qm, &sql_manager.qm_metric);
 	} else {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "SQL is not enabled\n");
 	}
@@ -226,6 +226,7 @@ static void switch_core_standard_on_routing(switch_core_session_t *session)
 	switch_caller_extension_t *extension = NULL;
 	char *expanded = NULL;
 	char *dpstr = NULL;
+	switch_time_t lat_mark;
 
 	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "%s Standard ROUTING\n", switch_channel_get_name(session->channel));
 
@@ -273,7 +274,9 @@ static void switch_core_standard_on_routing(switch_core_session_t *session)
 
 					count++;
 
+					lat_mark = switch_core_latency_start(session);
 					extension = dialplan_interface->hunt_function(session, dparg, NULL);
+					switch_core_latency_end(session, SWITCH_LATENCY_DIALPLAN, lat_mark);
 					UNPROTECT_INTERFACE(dialplan_interface);
 
 					if (extension) {
@@ -579,6 +582,8 @@ SWITCH_DECLARE(void) switch_core_session_run(switch_core_session_t *session)
 			switch_status_t rstatus = SWITCH_STATUS_SUCCESS;
 
 			switch_channel_set_running_state(session->channel, state);
+			switch_core_latency_end(session, SWITCH_LATENCY_STATE_CHANGE, session->latency_state_mark);
+			session->latency_state_mark = 0;
 			switch_channel_clear_flag(session->channel, CF_TRANSFER);
 			switch_channel_clear_flag(session->channel, CF_REDIRECT);
 			switch_ivr_parse_all_messages(session);
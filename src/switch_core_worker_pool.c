@@ -0,0 +1,283 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * switch_core_worker_pool.c -- Pools of worker threads fed by per-worker queues
+ *
+ */
+
+#include <switch.h>
+#include "private/switch_core_pvt.h"
+
+#define WORKER_POOL_MAX_BATCH 64
+
+typedef struct {
+	switch_worker_pool_t *pool;
+	int id;
+	int cpu;
+	switch_thread_t *thread;
+	switch_queue_t *queue;
+	/* only the worker itself writes these */
+	uint64_t jobs;
+	uint64_t batches;
+	uint64_t queue_usec;
+	uint64_t run_usec;
+	int64_t max_queue_usec;
+} worker_t;
+
+struct switch_worker_pool {
+	char *name;
+	switch_memory_pool_t *pool;
+	int worker_count;
+	worker_t *workers;
+	uint32_t max_queue;
+	switch_worker_pool_callback_t callback;
+	void *user_data;
+	volatile int running;
+	/* pushers hold it shared, stop takes it exclusive to shut the door */
+	switch_thread_rwlock_t *rwlock;
+	volatile switch_atomic_t next;
+	volatile switch_atomic_t rejected;
+};
+
+static void *SWITCH_THREAD_FUNC worker_thread(switch_thread_t *thread, void *obj)
+{
+	worker_t *worker = (worker_t *) obj;
+	switch_worker_pool_t *pool = worker->pool;
+	switch_worker_job_t *batch[WORKER_POOL_MAX_BATCH];
+	void *pop;
+
+	if (worker->cpu > -1 && switch_core_thread_set_cpu_affinity(worker->cpu) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%s worker %d cannot be pinned to cpu %d\n", pool->name, worker->id, worker->cpu);
+	}
+
+	while (switch_queue_pop(worker->queue, &pop) == SWITCH_STATUS_SUCCESS) {
+		int count = 0, i;
+		switch_time_t start = switch_time_ref();
+
+		if (!pop) {
+			break;
+		}
+
+		/* take whatever piled up while we slept, one wakeup serves many callers */
+		do {
+			batch[count++] = (switch_worker_job_t *) pop;
+		} while (count < WORKER_POOL_MAX_BATCH && switch_queue_trypop(worker->queue, &pop) == SWITCH_STATUS_SUCCESS && pop);
+
+		for (i = 0; i < count; i++) {
+			switch_worker_job_t *job = batch[i];
+
+			job->waited = switch_time_ref() - job->queued;
+			worker->queue_usec += job->waited;
+			if (job->waited > worker->max_queue_usec) {
+				worker->max_queue_usec = job->waited;
+			}
+
+			/* the job may be gone once this returns */
+			pool->callback(job, pool->user_data);
+		}
+
+		worker->run_usec += switch_time_ref() - start;
+		worker->jobs += count;
+		worker->batches++;
+
+		if (!pop) {
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_worker_pool_create(switch_worker_pool_t **poolp, const char *name, int threads, uint32_t max_queue, int first_cpu,
+														  switch_thread_priority_t priority, switch_worker_pool_callback_t callback, void *user_data)
+{
+	switch_memory_pool_t *mpool = NULL;
+	switch_worker_pool_t *pool;
+	int i;
+
+	*poolp = NULL;
+
+	if (threads < 1 || !callback) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_core_new_memory_pool(&mpool);
+
+	pool = switch_core_alloc(mpool, sizeof(*pool));
+	pool->pool = mpool;
+	pool->name = switch_core_strdup(mpool, name);
+	pool->worker_count = threads;
+	pool->workers = switch_core_alloc(mpool, sizeof(worker_t) * threads);
+	pool->max_queue = max_queue ? max_queue : 1024;
+	pool->callback = callback;
+	pool->user_data = user_data;
+	switch_thread_rwlock_create(&pool->rwlock, mpool);
+	pool->running = 1;
+
+	for (i = 0; i < threads; i++) {
+		worker_t *worker = &pool->workers[i];
+		switch_threadattr_t *thd_attr;
+
+		worker->pool = pool;
+		worker->id = i;
+		worker->cpu = first_cpu > -1 ? (first_cpu + i) % switch_core_cpu_count() : -1;
+		/* one spare slot for the stop marker */
+		switch_queue_create(&worker->queue, pool->max_queue + 1, mpool);
+
+		switch_threadattr_create(&thd_attr, mpool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_threadattr_priority_set(thd_attr, priority);
+		switch_thread_create(&worker->thread, thd_attr, worker_thread, worker, mpool);
+	}
+
+	*poolp = pool;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_worker_pool_push(switch_worker_pool_t *pool, uint32_t slot, switch_worker_job_t *job)
+{
+	switch_status_t status = SWITCH_STATUS_FALSE;
+	worker_t *worker;
+
+	if (!pool) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (switch_thread_rwlock_tryrdlock(pool->rwlock) != SWITCH_STATUS_SUCCESS) {
+		switch_atomic_inc(&pool->rejected);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (pool->running) {
+		if (slot == SWITCH_WORKER_ANY) {
+			slot = switch_atomic_fetch_inc(&pool->next);
+		}
+
+		worker = &pool->workers[slot % pool->worker_count];
+		job->queued = switch_time_ref();
+
+		if (switch_queue_size(worker->queue) < pool->max_queue) {
+			status = switch_queue_trypush(worker->queue, job);
+		}
+	}
+
+	switch_thread_rwlock_unlock(pool->rwlock);
+
+	if (status != SWITCH_STATUS_SUCCESS) {
+		switch_atomic_inc(&pool->rejected);
+	}
+
+	return status;
+}
+
+SWITCH_DECLARE(void) switch_worker_pool_stop(switch_worker_pool_t *pool)
+{
+	switch_status_t st;
+	int i;
+
+	if (!pool) {
+		return;
+	}
+
+	switch_thread_rwlock_wrlock(pool->rwlock);
+	if (!pool->running) {
+		switch_thread_rwlock_unlock(pool->rwlock);
+		return;
+	}
+	pool->running = 0;
+	switch_thread_rwlock_unlock(pool->rwlock);
+
+	/* the marker goes behind every job already queued */
+	for (i = 0; i < pool->worker_count; i++) {
+		switch_queue_push(pool->workers[i].queue, NULL);
+	}
+
+	for (i = 0; i < pool->worker_count; i++) {
+		switch_thread_join(&st, pool->workers[i].thread);
+	}
+}
+
+SWITCH_DECLARE(void) switch_worker_pool_destroy(switch_worker_pool_t **poolp)
+{
+	switch_worker_pool_t *pool = *poolp;
+	switch_memory_pool_t *mpool;
+
+	if (!pool) {
+		return;
+	}
+
+	*poolp = NULL;
+
+	switch_worker_pool_stop(pool);
+
+	mpool = pool->pool;
+	switch_core_destroy_memory_pool(&mpool);
+}
+
+SWITCH_DECLARE(switch_bool_t) switch_worker_pool_running(switch_worker_pool_t *pool)
+{
+	return (pool && pool->running) ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
+SWITCH_DECLARE(int) switch_worker_pool_size(switch_worker_pool_t *pool)
+{
+	return pool ? pool->worker_count : 0;
+}
+
+SWITCH_DECLARE(void) switch_worker_pool_status(switch_worker_pool_t *pool, switch_stream_handle_t *stream)
+{
+	int i;
+
+	if (!pool) {
+		return;
+	}
+
+	stream->write_function(stream, "workers: %d%s rejected=%u\n", pool->worker_count, pool->running ? "" : " (stopped)", switch_atomic_read(&pool->rejected));
+
+	for (i = 0; i < pool->worker_count; i++) {
+		worker_t *worker = &pool->workers[i];
+		uint64_t jobs = worker->jobs, batches = worker->batches;
+
+		stream->write_function(stream, "worker %d: cpu=%d queued=%u jobs=%" SWITCH_UINT64_T_FMT " batches=%" SWITCH_UINT64_T_FMT
+							   " jobs-per-wakeup=%.2f avg-queue-usec=%.1f max-queue-usec=%" SWITCH_INT64_T_FMT " avg-run-usec=%.1f\n",
+							   worker->id, worker->cpu, switch_queue_size(worker->queue), jobs, batches,
+							   batches ? (double) jobs / batches : 0.0,
+							   jobs ? (double) worker->queue_usec / jobs : 0.0, worker->max_queue_usec,
+							   jobs ? (double) worker->run_usec / jobs : 0.0);
+	}
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -77,6 +77,8 @@ static struct {
 	switch_hash_t *perm_hash;
 	switch_hash_t *lahash;
 	switch_mutex_t *lamutex;
+	switch_mutex_t *payload_mutex;
+	switch_metric_t *coalesced;
 } event_channel_manager;
 
 #define MAX_DISPATCH_VAL 64
@@ -110,17 +112,38 @@ static switch_queue_t *EVENT_HEADER_RECYCLE_QUEUE = NULL;
 
 static void unsub_all_switch_event_channel(void);
 
+/* the allocations of one thread, counted for tests and benchmarks; a flag check when nobody counts */
+static struct {
+	volatile int on;
+	switch_thread_id_t thread;
+	uint32_t count;
+} ALLOC_COUNTER;
+
+static inline void alloc_count(void)
+{
+	if (ALLOC_COUNTER.on && switch_thread_equal(switch_thread_self(), ALLOC_COUNTER.thread)) {
+		ALLOC_COUNTER.count++;
+	}
+}
+
 static char *my_dup(const char *s)
 {
 	size_t len = strlen(s) + 1;
 	void *new = malloc(len);
 	switch_assert(new);
+	alloc_count();
 
 	return (char *) memcpy(new, s, len);
 }
 
+static void *my_alloc(size_t size)
+{
+	alloc_count();
+	return malloc(size);
+}
+
 #ifndef ALLOC
-#define ALLOC(size) malloc(size)
+#define ALLOC(size) my_alloc(size)
 #endif
 #ifndef DUP
 #define DUP(str) my_dup(str)
@@ -129,7 +152,14 @@ static char *my_dup(const char *s)
 #define FREE(ptr) switch_safe_free(ptr)
 #endif
 
+struct switch_event_shared_headers {
+	switch_event_header_t *headers;
+	switch_event_header_t *last_header;
+	switch_atomic_t refs;
+};
+
 static void free_header(switch_event_header_t **header);
+static switch_event_header_t *shared_find_header(switch_event_shared_headers_t *shared, const char *header_name);
 
 /* make sure this is synced with the switch_event_types_t enum in switch_types.h
    also never put any new ones before EVENT_ALL
@@ -688,8 +718,16 @@ SWITCH_DECLARE(void) switch_event_launch_dispatch_threads(uint32_t max)
 	SOFT_MAX_DISPATCH = index;
 }
 
+static double event_queue_metric(switch_metric_t *metric, void *user_data)
+{
+	switch_queue_t *queue = EVENT_DISPATCH_QUEUE;
+
+	return queue ? switch_queue_size(queue) : 0;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 {
+	switch_metric_t *metric;
 
 	/* don't need any more dispatch threads than we have CPU's*/
 	MAX_DISPATCH = (switch_core_cpu_count() / 2) + 1;
@@ -714,6 +752,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 
 	switch_core_hash_init(&event_channel_manager.lahash);
 	switch_mutex_init(&event_channel_manager.lamutex, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
+	switch_mutex_init(&event_channel_manager.payload_mutex, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 
 	switch_thread_rwlock_create(&event_channel_manager.rwlock, RUNTIME_POOL);
 	switch_core_hash_init(&event_channel_manager.hash);
@@ -736,6 +775,12 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 
 	check_dispatch();
 
+	switch_core_metric_register_callback("freeswitch_event_queue_depth", NULL, "Events waiting for a dispatch thread", SWITCH_METRIC_GAUGE,
+										 event_queue_metric, NULL, &metric);
+	switch_core_metric_register("freeswitch_live_array_updates_coalesced_total", NULL,
+								"Live array modifications folded into an update that had not been delivered yet", SWITCH_METRIC_COUNTER,
+								&event_channel_manager.coalesced);
+
 	switch_mutex_lock(EVENT_QUEUE_MUTEX);
 	SYSTEM_RUNNING = 1;
 	switch_mutex_unlock(EVENT_QUEUE_MUTEX);
@@ -805,6 +850,10 @@ SWITCH_DECLARE(switch_status_t) switch_event_rename_header(switch_event_t *event
 		return SWITCH_STATUS_FALSE;
 	}
 
+	if (event->shared && shared_find_header(event->shared, header_name)) {
+		switch_event_unshare_headers(event);
+	}
+
 	hash = switch_ci_hashfunc_default(header_name, &hlen);
 
 	for (hp = event->headers; hp; hp = hp->next) {
@@ -870,15 +919,23 @@ SWITCH_DECLARE(char *) switch_event_get_body(switch_event_t *event)
 
 SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *event, const char *header_name, const char *val)
 {
-	switch_event_header_t *hp, *lp = NULL, *tp;
+	switch_event_header_t *hp, *lp = NULL, *tp, *stop = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 	int x = 0;
 	switch_ssize_t hlen = -1;
 	unsigned long hash = 0;
 
+	if (event->shared) {
+		if (shared_find_header(event->shared, header_name)) {
+			switch_event_unshare_headers(event);
+		} else {
+			stop = event->shared->headers;
+		}
+	}
+
 	tp = event->headers;
 	hash = switch_ci_hashfunc_default(header_name, &hlen);
-	while (tp) {
+	while (tp && tp != stop) {
 		hp = tp;
 		tp = tp->next;
 
@@ -894,6 +951,9 @@ SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *even
 			if (hp == event->last_header || !hp->next) {
 				event->last_header = lp;
 			}
+			if (hp == event->owned_tail) {
+				event->owned_tail = lp;
+			}
 			free_header(&hp);
 			status = SWITCH_STATUS_SUCCESS;
 		} else {
@@ -958,6 +1018,167 @@ static void free_header(switch_event_header_t **header)
 	}
 }
 
+static switch_event_header_t *shared_find_header(switch_event_shared_headers_t *shared, const char *header_name)
+{
+	switch_event_header_t *hp;
+	switch_ssize_t hlen = -1;
+	unsigned long hash = 0;
+
+	if (!shared || !header_name) {
+		return NULL;
+	}
+
+	hash = switch_ci_hashfunc_default(header_name, &hlen);
+
+	for (hp = shared->headers; hp; hp = hp->next) {
+		if ((!hp->hash || hash == hp->hash) && !strcasecmp(hp->name, header_name)) {
+			return hp;
+		}
+	}
+
+	return NULL;
+}
+
+SWITCH_DECLARE(switch_event_shared_headers_t *) switch_event_shared_headers_create(switch_event_t **event)
+{
+	switch_event_shared_headers_t *shared;
+
+	switch_assert(event && *event);
+
+	switch_event_unshare_headers(*event);
+
+	shared = ALLOC(sizeof(*shared));
+	switch_assert(shared);
+	memset(shared, 0, sizeof(*shared));
+
+	shared->headers = (*event)->headers;
+	shared->last_header = (*event)->last_header;
+	switch_atomic_set(&shared->refs, 1);
+
+	(*event)->headers = (*event)->last_header = NULL;
+	switch_event_destroy(event);
+
+	return shared;
+}
+
+SWITCH_DECLARE(switch_event_shared_headers_t *) switch_event_shared_headers_ref(switch_event_shared_headers_t *shared)
+{
+	switch_assert(shared);
+	switch_atomic_inc(&shared->refs);
+	return shared;
+}
+
+SWITCH_DECLARE(void) switch_event_shared_headers_release(switch_event_shared_headers_t **shared)
+{
+	switch_event_header_t *hp, *this;
+
+	if (!shared || !*shared) {
+		return;
+	}
+
+	if (!switch_atomic_dec(&(*shared)->refs)) {
+		for (hp = (*shared)->headers; hp;) {
+			this = hp;
+			hp = hp->next;
+			free_header(&this);
+		}
+		FREE(*shared);
+	}
+
+	*shared = NULL;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_attach_shared_headers(switch_event_t *event, switch_event_shared_headers_t *shared)
+{
+	switch_assert(event);
+
+	if (!shared || !shared->headers) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (event->shared) {
+		switch_event_unshare_headers(event);
+	}
+
+	if (switch_test_flag(event, EF_UNIQ_HEADERS)) {
+		switch_event_header_t *hp, *lp = NULL, *tp = event->headers;
+
+		while (tp) {
+			hp = tp;
+			tp = tp->next;
+
+			if (shared_find_header(shared, hp->name)) {
+				if (lp) {
+					lp->next = hp->next;
+				} else {
+					event->headers = hp->next;
+				}
+				free_header(&hp);
+			} else {
+				lp = hp;
+			}
+		}
+
+		event->last_header = lp;
+	}
+
+	if ((event->owned_tail = event->last_header)) {
+		event->owned_tail->next = shared->headers;
+	} else {
+		event->headers = shared->headers;
+	}
+
+	event->last_header = shared->last_header;
+	event->shared = switch_event_shared_headers_ref(shared);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(void) switch_event_alloc_count_begin(void)
+{
+	ALLOC_COUNTER.thread = switch_thread_self();
+	ALLOC_COUNTER.count = 0;
+	ALLOC_COUNTER.on = 1;
+}
+
+SWITCH_DECLARE(uint32_t) switch_event_alloc_count_end(void)
+{
+	ALLOC_COUNTER.on = 0;
+	return ALLOC_COUNTER.count;
+}
+
+SWITCH_DECLARE(void) switch_event_unshare_headers(switch_event_t *event)
+{
+	switch_event_shared_headers_t *shared;
+	switch_event_header_t *hp;
+
+	if (!event || !(shared = event->shared)) {
+		return;
+	}
+
+	/* cut the shared run off first so the copies below land on the event's own list */
+	event->shared = NULL;
+	if ((event->last_header = event->owned_tail)) {
+		event->last_header->next = NULL;
+	} else {
+		event->headers = NULL;
+	}
+	event->owned_tail = NULL;
+
+	for (hp = shared->headers; hp; hp = hp->next) {
+		if (hp->idx) {
+			int i;
+			for (i = 0; i < hp->idx; i++) {
+				switch_event_add_header_string(event, SWITCH_STACK_PUSH, hp->name, hp->array[i]);
+			}
+		} else {
+			switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, hp->name, hp->value);
+		}
+	}
+
+	switch_event_shared_headers_release(&shared);
+}
+
 SWITCH_DECLARE(int) switch_event_add_array(switch_event_t *event, const char *var, const char *val)
 {
 	char *data;
@@ -1028,6 +1249,10 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 	if (index_ptr || (stack & SWITCH_STACK_PUSH) || (stack & SWITCH_STACK_UNSHIFT)) {
 		switch_event_header_t *tmp_header = NULL;
 
+		if (event->shared && shared_find_header(event->shared, header_name)) {
+			switch_event_unshare_headers(event);
+		}
+
 		if (!(header = switch_event_get_header_ptr(event, header_name)) && index_ptr) {
 
 			tmp_header = header = new_header(header_name);
@@ -1185,6 +1410,18 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 			if (!event->last_header) {
 				event->last_header = header;
 			}
+			if (event->shared && !event->owned_tail) {
+				event->owned_tail = header;
+			}
+		} else if (event->shared) {
+			/* the shared run stays at the tail, new headers go in front of it */
+			header->next = event->shared->headers;
+			if (event->owned_tail) {
+				event->owned_tail->next = header;
+			} else {
+				event->headers = header;
+			}
+			event->owned_tail = header;
 		} else {
 			if (event->last_header) {
 				event->last_header->next = header;
@@ -1277,14 +1514,16 @@ SWITCH_DECLARE(switch_status_t) switch_event_add_body(switch_event_t *event, con
 SWITCH_DECLARE(void) switch_event_destroy(switch_event_t **event)
 {
 	switch_event_t *ep = *event;
-	switch_event_header_t *hp, *this;
+	switch_event_header_t *hp, *this, *stop;
 
 	if (ep) {
-		for (hp = ep->headers; hp;) {
+		stop = ep->shared ? ep->shared->headers : NULL;
+		for (hp = ep->headers; hp && hp != stop;) {
 			this = hp;
 			hp = hp->next;
 			free_header(&this);
 		}
+		switch_event_shared_headers_release(&ep->shared);
 		FREE(ep->body);
 		FREE(ep->subclass_name);
 #ifdef SWITCH_EVENT_RECYCLE
@@ -1331,7 +1570,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_dup(switch_event_t **event, switch_
 	(*event)->event_user_data = todup->event_user_data;
 	(*event)->bind_user_data = todup->bind_user_data;
 	(*event)->flags = todup->flags;
-	for (hp = todup->headers; hp; hp = hp->next) {
+	for (hp = todup->headers; hp && (!todup->shared || hp != todup->shared->headers); hp = hp->next) {
 		if (todup->subclass_name && !strcmp(hp->name, "Event-Subclass")) {
 			continue;
 		}
@@ -1346,6 +1585,10 @@ SWITCH_DECLARE(switch_status_t) switch_event_dup(switch_event_t **event, switch_
 		}
 	}
 
+	if (todup->shared) {
+		switch_event_attach_shared_headers(*event, todup->shared);
+	}
+
 	if (todup->body) {
 		(*event)->body = DUP(todup->body);
 	}
@@ -2706,6 +2949,8 @@ struct switch_event_channel_sub_node_head_s;
 typedef struct switch_event_channel_sub_node_s {
 	switch_event_channel_func_t func;
 	void *user_data;
+	/* func is really a switch_event_channel_payload_func_t */
+	switch_bool_t payload;
 	switch_event_channel_id_t id;
 	struct switch_event_channel_sub_node_head_s *head;
 	struct switch_event_channel_sub_node_s *next;
@@ -2815,7 +3060,8 @@ static uint32_t switch_event_channel_unsub_channel(switch_event_channel_func_t f
 	return x;
 }
 
-static switch_status_t switch_event_channel_sub_channel(const char *event_channel, switch_event_channel_func_t func, switch_event_channel_id_t id, void *user_data)
+static switch_status_t switch_event_channel_sub_channel(const char *event_channel, switch_event_channel_func_t func, switch_event_channel_id_t id,
+														 void *user_data, switch_bool_t payload)
 
 {
 	switch_event_channel_sub_node_t *node, *np;
@@ -2832,6 +3078,7 @@ static switch_status_t switch_event_channel_sub_channel(const char *event_channe
 		switch_zmalloc(node, sizeof(*node));
 		node->func = func;
 		node->user_data = user_data;
+		node->payload = payload;
 		node->id = id;
 
 		node->head = head;
@@ -2853,6 +3100,7 @@ static switch_status_t switch_event_channel_sub_channel(const char *event_channe
 
 			node->func = func;
 			node->user_data = user_data;
+			node->payload = payload;
 			node->id = id;
 			node->head = head;
 
@@ -2873,17 +3121,90 @@ static switch_status_t switch_event_channel_sub_channel(const char *event_channe
 	return status;
 }
 
+/* One broadcast, shared by every subscriber it is delivered to.  Until delivery starts the
+   owner of the payload (a live array) may still rewrite the json in place; once sealed it is
+   immutable and the text form is serialized at most once. */
+struct switch_event_channel_payload_s {
+	cJSON *json;
+	char *text;
+	switch_size_t len;
+	switch_atomic_t refs;
+	switch_bool_t sealed;
+};
+
 typedef struct {
 	char *event_channel;
-	cJSON *json;
+	switch_event_channel_payload_t *payload;
 	char *key;
 	switch_event_channel_id_t id;
 } event_channel_data_t;
 
+static switch_event_channel_payload_t *event_channel_payload_create(cJSON **json)
+{
+	switch_event_channel_payload_t *payload;
+
+	switch_zmalloc(payload, sizeof(*payload));
+	payload->json = *json;
+	payload->refs = 1;
+	*json = NULL;
+
+	return payload;
+}
+
+static void event_channel_payload_seal(switch_event_channel_payload_t *payload)
+{
+	switch_mutex_lock(event_channel_manager.payload_mutex);
+	payload->sealed = SWITCH_TRUE;
+	switch_mutex_unlock(event_channel_manager.payload_mutex);
+}
+
+SWITCH_DECLARE(cJSON *) switch_event_channel_payload_json(switch_event_channel_payload_t *payload)
+{
+	return payload->json;
+}
+
+SWITCH_DECLARE(const char *) switch_event_channel_payload_text(switch_event_channel_payload_t *payload, switch_size_t *len)
+{
+	switch_mutex_lock(event_channel_manager.payload_mutex);
+	if (!payload->text && payload->json) {
+		if ((payload->text = cJSON_PrintUnformatted(payload->json))) {
+			payload->len = strlen(payload->text);
+		}
+	}
+	switch_mutex_unlock(event_channel_manager.payload_mutex);
+
+	if (len) {
+		*len = payload->len;
+	}
+
+	return payload->text;
+}
+
+SWITCH_DECLARE(switch_event_channel_payload_t *) switch_event_channel_payload_ref(switch_event_channel_payload_t *payload)
+{
+	switch_atomic_inc(&payload->refs);
+	return payload;
+}
+
+SWITCH_DECLARE(void) switch_event_channel_payload_release(switch_event_channel_payload_t **payloadP)
+{
+	switch_event_channel_payload_t *payload = *payloadP;
+
+	*payloadP = NULL;
+
+	if (!payload || switch_atomic_dec(&payload->refs)) {
+		return;
+	}
 
+	if (payload->json) {
+		cJSON_Delete(payload->json);
+	}
+	switch_safe_free(payload->text);
+	free(payload);
+}
 
 static uint32_t _switch_event_channel_broadcast(const char *event_channel, const char *broadcast_channel,
-												cJSON *json, const char *key, switch_event_channel_id_t id)
+												switch_event_channel_payload_t *payload, const char *key, switch_event_channel_id_t id)
 {
 	switch_event_channel_sub_node_t *np;
 	switch_event_channel_sub_node_head_t *head;
@@ -2896,7 +3217,11 @@ static uint32_t _switch_event_channel_broadcast(const char *event_channel, const
 				continue;
 			}
 
-			np->func(broadcast_channel, json, key, id, np->user_data);
+			if (np->payload) {
+				((switch_event_channel_payload_func_t) np->func)(broadcast_channel, payload, key, id, np->user_data);
+			} else {
+				np->func(broadcast_channel, payload->json, key, id, np->user_data);
+			}
 			x++;
 		}
 	}
@@ -2912,10 +3237,7 @@ static void destroy_ecd(event_channel_data_t **ecdP)
 
 	switch_safe_free(ecd->event_channel);
 	switch_safe_free(ecd->key);
-	if (ecd->json) {
-		cJSON_Delete(ecd->json);
-		ecd->json = NULL;
-	}
+	switch_event_channel_payload_release(&ecd->payload);
 
 	free(ecd);
 }
@@ -2932,7 +3254,9 @@ static void ecd_deliver(event_channel_data_t **ecdP)
 
 	*ecdP = NULL;
 
-	t = _switch_event_channel_broadcast(ecd->event_channel, ecd->event_channel, ecd->json, ecd->key, ecd->id);
+	event_channel_payload_seal(ecd->payload);
+
+	t = _switch_event_channel_broadcast(ecd->event_channel, ecd->event_channel, ecd->payload, ecd->key, ecd->id);
 
 	key = strdup(ecd->event_channel);
 	if (switch_core_test_flag(SCF_EVENT_CHANNEL_ENABLE_HIERARCHY_DELIVERY)) {
@@ -2949,7 +3273,7 @@ static void ecd_deliver(event_channel_data_t **ecdP)
 				strcat(buf, sep);
 				strcat(buf, x_argv[z]);
 			}
-			r = _switch_event_channel_broadcast(buf, ecd->event_channel, ecd->json, ecd->key, ecd->id);
+			r = _switch_event_channel_broadcast(buf, ecd->event_channel, ecd->payload, ecd->key, ecd->id);
 			t += r;
 			if (r && switch_core_test_flag(SCF_EVENT_CHANNEL_HIERARCHY_DELIVERY_ONCE)) {
 				break;
@@ -2959,16 +3283,16 @@ static void ecd_deliver(event_channel_data_t **ecdP)
 		char *p = NULL;
 		if ((p = strchr(key, '.'))) {
 			*p = '\0';
-			t += _switch_event_channel_broadcast(key, ecd->event_channel, ecd->json, ecd->key, ecd->id);
+			t += _switch_event_channel_broadcast(key, ecd->event_channel, ecd->payload, ecd->key, ecd->id);
 		}
 	}
 	switch_safe_free(key);
 
-	t += _switch_event_channel_broadcast(SWITCH_EVENT_CHANNEL_GLOBAL, ecd->event_channel, ecd->json, ecd->key, ecd->id);
+	t += _switch_event_channel_broadcast(SWITCH_EVENT_CHANNEL_GLOBAL, ecd->event_channel, ecd->payload, ecd->key, ecd->id);
 
 	if(t == 0) {
 		if (switch_core_test_flag(SCF_EVENT_CHANNEL_LOG_UNDELIVERABLE_JSON)) {
-			char *json = cJSON_Print(ecd->json);
+			char *json = cJSON_Print(ecd->payload->json);
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "no subscribers for %s , %s => %s\n", ecd->event_channel, ecd->key, json);
 			switch_safe_free(json);
 		} else {
@@ -3022,27 +3346,26 @@ static void *SWITCH_THREAD_FUNC switch_event_channel_deliver_thread(switch_threa
 	return NULL;
 }
 
-SWITCH_DECLARE(switch_status_t) switch_event_channel_broadcast(const char *event_channel, cJSON **json, const char *key, switch_event_channel_id_t id)
+static switch_status_t event_channel_broadcast_payload(const char *event_channel, switch_event_channel_payload_t *payload, const char *key,
+													   switch_event_channel_id_t id)
 {
 	event_channel_data_t *ecd = NULL;
 	switch_status_t status = SWITCH_STATUS_SUCCESS;
 	int launch = 0;
 
 	if (!SYSTEM_RUNNING) {
-		cJSON_Delete(*json);
-		*json = NULL;
+		event_channel_payload_seal(payload);
+		switch_event_channel_payload_release(&payload);
 		return SWITCH_STATUS_FALSE;
 	}
 
 	switch_zmalloc(ecd, sizeof(*ecd));
 
 	ecd->event_channel = strdup(event_channel);
-	ecd->json = *json;
+	ecd->payload = payload;
 	ecd->key = strdup(key);
 	ecd->id = id;
 
-	*json = NULL;
-
 	switch_mutex_lock(EVENT_QUEUE_MUTEX);
 	if (!EVENT_CHANNEL_DISPATCH_THREAD_COUNT && !EVENT_CHANNEL_DISPATCH_THREAD_STARTING && SYSTEM_RUNNING) {
 		EVENT_CHANNEL_DISPATCH_THREAD_STARTING = 1;
@@ -3069,8 +3392,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_channel_broadcast(const char *event
 	}
 
 	if ((status = switch_queue_trypush(EVENT_CHANNEL_DISPATCH_QUEUE, ecd)) != SWITCH_STATUS_SUCCESS) {
-		cJSON_Delete(ecd->json);
-		ecd->json = NULL;
+		event_channel_payload_seal(ecd->payload);
 		destroy_ecd(&ecd);
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Event Channel Queue failure for channel %s, status = %d\n", event_channel, status);
 	} else {
@@ -3080,18 +3402,21 @@ SWITCH_DECLARE(switch_status_t) switch_event_channel_broadcast(const char *event
 	return status;
 }
 
+SWITCH_DECLARE(switch_status_t) switch_event_channel_broadcast(const char *event_channel, cJSON **json, const char *key, switch_event_channel_id_t id)
+{
+	return event_channel_broadcast_payload(event_channel, event_channel_payload_create(json), key, id);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_event_channel_deliver(const char *event_channel, cJSON **json, const char *key, switch_event_channel_id_t id)
 {
 	event_channel_data_t *ecd = NULL;
 	switch_zmalloc(ecd, sizeof(*ecd));
 
 	ecd->event_channel = strdup(event_channel);
-	ecd->json = *json;
+	ecd->payload = event_channel_payload_create(json);
 	ecd->key = strdup(key);
 	ecd->id = id;
 
-	*json = NULL;
-
 	ecd_deliver(&ecd);
 
 	return SWITCH_STATUS_SUCCESS;
@@ -3114,11 +3439,30 @@ SWITCH_DECLARE(switch_status_t) switch_event_channel_bind(const char *event_chan
 		switch_thread_rwlock_unlock(event_channel_manager.rwlock);
 	}
 
-	status = switch_event_channel_sub_channel(event_channel, func, *id, user_data);
+	status = switch_event_channel_sub_channel(event_channel, func, *id, user_data, SWITCH_FALSE);
 
 	return status;
 }
 
+SWITCH_DECLARE(uint32_t) switch_event_channel_unbind_payload(const char *event_channel, switch_event_channel_payload_func_t func, void *user_data)
+{
+	return switch_event_channel_unsub_channel((switch_event_channel_func_t) func, event_channel, user_data);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_channel_bind_payload(const char *event_channel, switch_event_channel_payload_func_t func,
+																   switch_event_channel_id_t *id, void *user_data)
+{
+	switch_assert(id);
+
+	if (!*id) {
+		switch_thread_rwlock_wrlock(event_channel_manager.rwlock);
+		*id = event_channel_manager.ID++;
+		switch_thread_rwlock_unlock(event_channel_manager.rwlock);
+	}
+
+	return switch_event_channel_sub_channel(event_channel, (switch_event_channel_func_t) func, *id, user_data, SWITCH_TRUE);
+}
+
 SWITCH_DECLARE(switch_bool_t) switch_event_channel_permission_verify(const char *cookie, const char *event_channel)
 {
 	switch_event_t *vals;
@@ -3182,6 +3526,8 @@ typedef struct la_node_s {
 	cJSON *obj;
 	struct la_node_s *next;
 	int pos;
+	/* last add/modify broadcast for this row, rewritten in place until the dispatcher picks it up */
+	switch_event_channel_payload_t *pending;
 } la_node_t;
 
 struct switch_live_array_s {
@@ -3204,9 +3550,10 @@ struct switch_live_array_s {
 	int refs;
 };
 
-static switch_status_t la_broadcast(switch_live_array_t *la, cJSON **json)
+static switch_status_t la_broadcast(switch_live_array_t *la, cJSON **json, switch_event_channel_payload_t **pending)
 {
 	alias_node_t *np;
+	switch_event_channel_payload_t *payload;
 
 	if (la->aliases) {
 		switch_mutex_lock(la->mutex);
@@ -3222,8 +3569,43 @@ static switch_status_t la_broadcast(switch_live_array_t *la, cJSON **json)
 		switch_mutex_unlock(la->mutex);
 	}
 
-	return switch_event_channel_broadcast(la->event_channel, json, __FILE__, la->channel_id);
+	payload = event_channel_payload_create(json);
+
+	if (pending && !la->aliases) {
+		*pending = switch_event_channel_payload_ref(payload);
+	}
+
+	return event_channel_broadcast_payload(la->event_channel, payload, __FILE__, la->channel_id);
+
+}
+
+/* Fold a modify into the row's previous update if that one is still sitting in the dispatch
+   queue: subscribers get the latest data once instead of every intermediate state, and the
+   wire serial numbers stay contiguous because the folded update never takes one. */
+static switch_bool_t la_coalesce(la_node_t *node)
+{
+	switch_bool_t r = SWITCH_FALSE;
+
+	switch_mutex_lock(event_channel_manager.payload_mutex);
+	if (!node->pending->sealed) {
+		cJSON *msg = node->pending->json;
+		cJSON *data = cJSON_GetObjectItem(msg, "data");
+		const char *visibility;
+
+		cJSON_ReplaceItemInObject(data, "data", cJSON_Duplicate(node->obj, 1));
+		cJSON_DeleteItemFromObject(msg, "contentVisibility");
+		if ((visibility = cJSON_GetObjectCstr(node->obj, "contentVisibility"))) {
+			cJSON_AddItemToObject(msg, "contentVisibility", cJSON_CreateString(visibility));
+		}
+		r = SWITCH_TRUE;
+	}
+	switch_mutex_unlock(event_channel_manager.payload_mutex);
+
+	if (r) {
+		switch_core_metric_inc(event_channel_manager.coalesced);
+	}
 
+	return r;
 }
 
 
@@ -3242,7 +3624,7 @@ SWITCH_DECLARE(switch_status_t) switch_live_array_visible(switch_live_array_t *l
 		cJSON_AddItemToObject(data, "action", cJSON_CreateString(visible ? "hide" : "show"));
 		cJSON_AddItemToObject(data, "wireSerno", cJSON_CreateNumber(la->serno++));
 
-		la_broadcast(la, &msg);
+		la_broadcast(la, &msg, NULL);
 
 		la->visible = visible;
 	}
@@ -3268,12 +3650,13 @@ SWITCH_DECLARE(switch_status_t) switch_live_array_clear(switch_live_array_t *la)
 	cJSON_AddItemToObject(data, "wireSerno", cJSON_CreateNumber(-1));
 	cJSON_AddItemToObject(data, "data", cJSON_CreateObject());
 
-	la_broadcast(la, &msg);
+	la_broadcast(la, &msg, NULL);
 
 	while(np) {
 		cur = np;
 		np  = np->next;
 		cJSON_Delete(cur->obj);
+		switch_event_channel_payload_release(&cur->pending);
 		free(cur->name);
 		free(cur);
 	}
@@ -3587,7 +3970,8 @@ SWITCH_DECLARE(switch_status_t) switch_live_array_del(switch_live_array_t *la, c
 				cJSON_AddItemToObject(data, "data", cur->obj);
 				cur->obj = NULL;
 
-				la_broadcast(la, &msg);
+				la_broadcast(la, &msg, NULL);
+				switch_event_channel_payload_release(&cur->pending);
 				free(cur->name);
 				free(cur);
 			} else {
@@ -3674,6 +4058,13 @@ SWITCH_DECLARE(switch_status_t) switch_live_array_add(switch_live_array_t *la, c
 		node->obj = *obj;
 	}
 
+	if (node->pending) {
+		if (index < 0 && !la->aliases && la_coalesce(node)) {
+			goto end;
+		}
+		switch_event_channel_payload_release(&node->pending);
+	}
+
 	msg = cJSON_CreateObject();
 	data = json_add_child_obj(msg, "data", NULL);
 	if ((visibility = cJSON_GetObjectCstr(node->obj, "contentVisibility"))) {
@@ -3691,7 +4082,9 @@ SWITCH_DECLARE(switch_status_t) switch_live_array_add(switch_live_array_t *la, c
 	cJSON_AddItemToObject(data, "wireSerno", cJSON_CreateNumber(la->serno++));
 	cJSON_AddItemToObject(data, "data", cJSON_Duplicate(node->obj, 1));
 
-	la_broadcast(la, &msg);
+	la_broadcast(la, &msg, &node->pending);
+
+ end:
 
 	switch_mutex_unlock(la->mutex);
 
@@ -3786,33 +3786,237 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_session_audio(switch_core_session_t *
 }
 
 
+/*
+ * Inband detection workers.  start_dtmf and tone_detect copy each frame into a
+ * small ring on their target and hand it to the core worker pool, which runs the
+ * detectors of many sessions per wakeup.  A target always lands on the same worker
+ * so its frames are seen in order; the hits come back to the media thread on the
+ * next frame, which delivers them exactly as the inline path does.
+ */
+#define INBAND_DETECT_SLOTS 8
+#define INBAND_DETECT_QUEUE_LEN 8192
+
+typedef struct inband_detect_target_s inband_detect_target_t;
+typedef void (*inband_detect_run_func_t)(inband_detect_target_t *target, int16_t *data, uint32_t samples, uint32_t mask);
+
+typedef struct {
+	/* must be first, the worker pool hands this back */
+	switch_worker_job_t job;
+	inband_detect_target_t *target;
+	int16_t *data;
+	uint32_t samples;
+	uint32_t len;
+	uint32_t mask;
+	volatile switch_atomic_t busy;
+} inband_detect_slot_t;
+
+struct inband_detect_target_s {
+	switch_core_session_t *session;
+	inband_detect_run_func_t run;
+	void *obj;
+	inband_detect_slot_t slots[INBAND_DETECT_SLOTS];
+	uint32_t next;
+	uint32_t worker;
+	/* guards what the detectors leave for the media thread */
+	switch_mutex_t *mutex;
+	uint32_t hits;
+	switch_dtmf_t dtmf[INBAND_DETECT_SLOTS];
+	int dtmf_count;
+};
+
+/* set up once by switch_ivr_inband_detect_start() and never changed after, the pool outlives its stop */
+static struct {
+	switch_worker_pool_t *pool;
+	volatile switch_atomic_t next_worker;
+	volatile switch_atomic_t inline_frames;
+	volatile switch_atomic_t stalls;
+} inband_detect;
+
+static void inband_detect_callback(switch_worker_job_t *job, void *user_data)
+{
+	inband_detect_slot_t *slot = (inband_detect_slot_t *) job;
+	inband_detect_target_t *target = slot->target;
+	switch_time_t begin = switch_time_ref();
+
+	target->run(target, slot->data, slot->samples, slot->mask);
+
+	switch_core_latency_record(target->session, SWITCH_LATENCY_INBAND_QUEUE, job->waited);
+	switch_core_latency_record(target->session, SWITCH_LATENCY_INBAND_DETECT, switch_time_ref() - begin);
+
+	/* the target may go away as soon as this is clear */
+	switch_atomic_set(&slot->busy, 0);
+}
+
+switch_status_t switch_ivr_inband_detect_start(int threads)
+{
+	if (inband_detect.pool || threads < 1) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (switch_worker_pool_create(&inband_detect.pool, "Inband", threads, INBAND_DETECT_QUEUE_LEN, -1, SWITCH_PRI_REALTIME,
+								  inband_detect_callback, NULL) != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Inband detection started with %d workers\n", threads);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+void switch_ivr_inband_detect_stop(void)
+{
+	/* new frames run inline from here on, the queued ones are drained before the workers exit */
+	switch_worker_pool_stop(inband_detect.pool);
+}
+
+SWITCH_DECLARE(void) switch_ivr_inband_detect_status(switch_stream_handle_t *stream)
+{
+	if (!switch_worker_pool_running(inband_detect.pool)) {
+		stream->write_function(stream, "inband detection runs on the session threads\n");
+		return;
+	}
+
+	stream->write_function(stream, "inline-frames: %u\nstalls: %u\n",
+						   switch_atomic_read(&inband_detect.inline_frames), switch_atomic_read(&inband_detect.stalls));
+
+	switch_worker_pool_status(inband_detect.pool, stream);
+}
+
+static void inband_detect_target_init(inband_detect_target_t *target, switch_core_session_t *session, inband_detect_run_func_t run, void *obj)
+{
+	target->session = session;
+	target->run = run;
+	target->obj = obj;
+	target->worker = switch_atomic_fetch_inc(&inband_detect.next_worker);
+	switch_mutex_init(&target->mutex, SWITCH_MUTEX_NESTED, switch_core_session_get_pool(session));
+}
+
+/* wait for the frames of this target still on a worker */
+static void inband_detect_drain(inband_detect_target_t *target)
+{
+	int i;
+
+	for (i = 0; i < INBAND_DETECT_SLOTS; i++) {
+		while (switch_atomic_read(&target->slots[i].busy)) {
+			switch_cond_next();
+		}
+	}
+}
+
+/* run the detectors selected by mask over a frame, on a worker when there are any */
+static void inband_detect_frame(inband_detect_target_t *target, switch_frame_t *frame, uint32_t mask)
+{
+	switch_time_t start;
+
+	if (switch_worker_pool_running(inband_detect.pool)) {
+		inband_detect_slot_t *slot = &target->slots[target->next++ % INBAND_DETECT_SLOTS];
+
+		if (switch_atomic_read(&slot->busy)) {
+			/* the worker is a whole ring behind, better hold the media thread than lose audio */
+			switch_atomic_inc(&inband_detect.stalls);
+			while (switch_atomic_read(&slot->busy)) {
+				switch_cond_next();
+			}
+		}
+
+		if (slot->len < frame->samples) {
+			slot->len = frame->samples;
+			slot->data = switch_core_session_alloc(target->session, slot->len * sizeof(int16_t));
+		}
+		memcpy(slot->data, frame->data, frame->samples * sizeof(int16_t));
+		slot->samples = frame->samples;
+		slot->mask = mask;
+		slot->target = target;
+		switch_atomic_set(&slot->busy, 1);
+
+		if (switch_worker_pool_push(inband_detect.pool, target->worker, &slot->job) == SWITCH_STATUS_SUCCESS) {
+			return;
+		}
+
+		switch_atomic_set(&slot->busy, 0);
+	}
+
+	/* inline, after whatever is still queued so the detectors see the frames in order */
+	inband_detect_drain(target);
+	switch_atomic_inc(&inband_detect.inline_frames);
+
+	start = switch_time_ref();
+	target->run(target, frame->data, frame->samples, mask);
+	switch_core_latency_record(target->session, SWITCH_LATENCY_INBAND_DETECT, switch_time_ref() - start);
+}
+
+static uint32_t inband_detect_take_hits(inband_detect_target_t *target)
+{
+	uint32_t hits;
+
+	switch_mutex_lock(target->mutex);
+	hits = target->hits;
+	target->hits = 0;
+	switch_mutex_unlock(target->mutex);
+
+	return hits;
+}
+
+static int inband_detect_take_dtmf(inband_detect_target_t *target, switch_dtmf_t *dtmf, int max)
+{
+	int count;
+
+	switch_mutex_lock(target->mutex);
+	count = target->dtmf_count < max ? target->dtmf_count : max;
+	memcpy(dtmf, target->dtmf, count * sizeof(*dtmf));
+	target->dtmf_count = 0;
+	switch_mutex_unlock(target->mutex);
+
+	return count;
+}
+
 typedef struct {
 	switch_core_session_t *session;
 	teletone_dtmf_detect_state_t dtmf_detect;
+	inband_detect_target_t detect;
 } switch_inband_dtmf_t;
 
+static void inband_dtmf_run(inband_detect_target_t *target, int16_t *data, uint32_t samples, uint32_t mask)
+{
+	switch_inband_dtmf_t *pvt = (switch_inband_dtmf_t *) target->obj;
+
+	if (teletone_dtmf_detect(&pvt->dtmf_detect, data, samples) == TT_HIT_END) {
+		switch_dtmf_t dtmf = {0};
+
+		teletone_dtmf_get(&pvt->dtmf_detect, &dtmf.digit, &dtmf.duration);
+		dtmf.source = SWITCH_DTMF_INBAND_AUDIO;
+
+		switch_mutex_lock(target->mutex);
+		if (target->dtmf_count < INBAND_DETECT_SLOTS) {
+			target->dtmf[target->dtmf_count++] = dtmf;
+		}
+		switch_mutex_unlock(target->mutex);
+	}
+}
+
 static switch_bool_t inband_dtmf_callback(switch_media_bug_t *bug, void *user_data, switch_abc_type_t type)
 {
 	switch_inband_dtmf_t *pvt = (switch_inband_dtmf_t *) user_data;
 	switch_frame_t *frame = NULL;
 	switch_channel_t *channel = switch_core_session_get_channel(pvt->session);
-	teletone_hit_type_t hit;
+	switch_dtmf_t dtmf[INBAND_DETECT_SLOTS];
+	int count, i;
 
 	switch (type) {
 	case SWITCH_ABC_TYPE_INIT:
 		break;
 	case SWITCH_ABC_TYPE_CLOSE:
+		inband_detect_drain(&pvt->detect);
 		break;
 	case SWITCH_ABC_TYPE_READ_REPLACE:
 		if ((frame = switch_core_media_bug_get_read_replace_frame(bug))) {
-			if ((hit = teletone_dtmf_detect(&pvt->dtmf_detect, frame->data, frame->samples)) == TT_HIT_END) {
-				switch_dtmf_t dtmf = {0};
+			inband_detect_frame(&pvt->detect, frame, 0);
 
-				teletone_dtmf_get(&pvt->dtmf_detect, &dtmf.digit, &dtmf.duration);
+			count = inband_detect_take_dtmf(&pvt->detect, dtmf, INBAND_DETECT_SLOTS);
+			for (i = 0; i < count; i++) {
 				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(switch_core_media_bug_get_session(bug)), SWITCH_LOG_DEBUG, "DTMF DETECTED: [%c][%d]\n",
-								  dtmf.digit, dtmf.duration);
-				dtmf.source = SWITCH_DTMF_INBAND_AUDIO;
-				switch_channel_queue_dtmf(channel, &dtmf);
+								  dtmf[i].digit, dtmf[i].duration);
+				switch_channel_queue_dtmf(channel, &dtmf[i]);
 			}
 			switch_core_media_bug_set_read_replace_frame(bug, frame);
 		}
@@ -3855,6 +4059,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_inband_dtmf_session(switch_core_sessi
 	teletone_dtmf_detect_init(&pvt->dtmf_detect, read_impl.actual_samples_per_second);
 
 	pvt->session = session;
+	inband_detect_target_init(&pvt->detect, session, inband_dtmf_run, pvt);
 
 
 	if (switch_channel_pre_answer(channel) != SWITCH_STATUS_SUCCESS) {
@@ -4134,6 +4339,7 @@ typedef struct {
 	switch_core_session_t *session;
 	int bug_running;
 	int detect_fax;
+	inband_detect_target_t detect;
 } switch_tone_container_t;
 
 
@@ -4174,11 +4380,31 @@ static switch_status_t tone_on_dtmf(switch_core_session_t *session, const switch
 
 }
 
+static void tone_detect_run(inband_detect_target_t *target, int16_t *data, uint32_t samples, uint32_t mask)
+{
+	switch_tone_container_t *cont = (switch_tone_container_t *) target->obj;
+	uint32_t hits = 0;
+	int i;
+
+	for (i = 0; i < MAX_TONES; i++) {
+		if ((mask & (1 << i)) && teletone_multi_tone_detect(&cont->list[i].mt, data, samples)) {
+			hits |= 1 << i;
+		}
+	}
+
+	if (hits) {
+		switch_mutex_lock(target->mutex);
+		target->hits |= hits;
+		switch_mutex_unlock(target->mutex);
+	}
+}
+
 static switch_bool_t tone_detect_callback(switch_media_bug_t *bug, void *user_data, switch_abc_type_t type)
 {
 	switch_tone_container_t *cont = (switch_tone_container_t *) user_data;
 	switch_frame_t *frame = NULL;
 	int i = 0;
+	uint32_t mask = 0, hits;
 	switch_bool_t rval = SWITCH_TRUE;
 
 	switch (type) {
@@ -4188,6 +4414,7 @@ static switch_bool_t tone_detect_callback(switch_media_bug_t *bug, void *user_da
 		}
 		break;
 	case SWITCH_ABC_TYPE_CLOSE:
+		inband_detect_drain(&cont->detect);
 		break;
 	case SWITCH_ABC_TYPE_READ_REPLACE:
 	case SWITCH_ABC_TYPE_WRITE_REPLACE:
@@ -4224,7 +4451,17 @@ static switch_bool_t tone_detect_callback(switch_media_bug_t *bug, void *user_da
 				if (skip)
 					continue;
 
-				if (teletone_multi_tone_detect(&cont->list[i].mt, frame->data, frame->samples)) {
+				mask |= 1 << i;
+			}
+
+			if (mask) {
+				inband_detect_frame(&cont->detect, frame, mask);
+			}
+
+			hits = inband_detect_take_hits(&cont->detect);
+
+			for (i = 0; hits && i < cont->index; i++) {
+				if ((hits & (1 << i)) && cont->list[i].up) {
 					switch_event_t *event;
 					cont->list[i].hits++;
 
@@ -4355,8 +4592,11 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_tone_detect_session(switch_core_sessi
 		return SWITCH_STATUS_FALSE;
 	}
 
-	if (!cont && !(cont = switch_core_session_alloc(session, sizeof(*cont)))) {
-		return SWITCH_STATUS_MEMERR;
+	if (!cont) {
+		if (!(cont = switch_core_session_alloc(session, sizeof(*cont)))) {
+			return SWITCH_STATUS_MEMERR;
+		}
+		inband_detect_target_init(&cont->detect, session, tone_detect_run, cont);
 	}
 
 	if ((var = switch_channel_get_variable(channel, "tone_detect_hits"))) {
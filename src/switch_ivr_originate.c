@@ -162,9 +162,16 @@ typedef struct {
 	switch_caller_profile_t *caller_profile_override;
 	switch_bool_t check_vars;
 	switch_memory_pool_t *pool;
+	switch_channel_watcher_t *watcher;
+	switch_time_t start_time;
+	uint8_t ring_recorded;
 	originate_status_t originate_status[MAX_PEERS];// = { {0} };
 } originate_global_t;
 
+/* The wait loops sleep on oglobals.watcher, which the peer channels signal on every state and flag change.
+   Nothing signals the caller's cancel_cause or the seconds based timeouts, so don't sleep longer than this. */
+#define ORIGINATE_WAIT_MS 100
+
 
 
 typedef enum {
@@ -460,6 +467,15 @@ static void inherit_codec(switch_channel_t *caller_channel, switch_core_session_
 	}
 }
 
+/* Time from the originate request until the first leg rang or sent early media */
+static void originate_record_ring(originate_global_t *oglobals)
+{
+	if (!oglobals->ring_recorded) {
+		oglobals->ring_recorded = 1;
+		switch_core_latency_record(oglobals->session, SWITCH_LATENCY_ORIGINATE_RING, switch_micro_time_now() - oglobals->start_time);
+	}
+}
+
 static uint8_t check_channel_status(originate_global_t *oglobals, uint32_t len, switch_call_cause_t *force_reason, time_t start)
 {
 
@@ -502,6 +518,7 @@ static uint8_t check_channel_status(originate_global_t *oglobals, uint32_t len,
 				oglobals->originate_status[i].peer_channel = switch_core_session_get_channel(oglobals->originate_status[i].peer_session);
 				oglobals->originate_status[i].caller_profile = switch_channel_get_caller_profile(oglobals->originate_status[i].peer_channel);
 				switch_channel_set_flag(oglobals->originate_status[i].peer_channel, CF_ORIGINATING);
+				switch_channel_watch(oglobals->originate_status[i].peer_channel, oglobals->watcher);
 
 				switch_channel_answer(oglobals->originate_status[i].peer_channel);
 
@@ -550,6 +567,7 @@ static uint8_t check_channel_status(originate_global_t *oglobals, uint32_t len,
 		if ((ring_ready_val = (uint8_t)switch_channel_test_flag(oglobals->originate_status[i].peer_channel, CF_RING_READY))) {
 			if (!oglobals->originate_status[i].ring_ready) {
 				oglobals->originate_status[i].ring_ready = ring_ready_val;
+				originate_record_ring(oglobals);
 			}
 
 			if (oglobals->sending_ringback == 1) {
@@ -587,6 +605,7 @@ static uint8_t check_channel_status(originate_global_t *oglobals, uint32_t len,
 
 			if (!oglobals->originate_status[i].early_media) {
 				oglobals->originate_status[i].early_media = 1;
+				originate_record_ring(oglobals);
 				if (oglobals->early_ok) {
 					pindex = i;
 				}
@@ -2119,7 +2138,9 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 	oglobals.bridge_early_media = -1;
 	oglobals.file = NULL;
 	oglobals.error_file = NULL;
+	oglobals.start_time = switch_micro_time_now();
 	switch_core_new_memory_pool(&oglobals.pool);
+	switch_channel_watcher_create(&oglobals.watcher);
 
 	if (caller_profile_override) {
 		oglobals.caller_profile_override = switch_caller_profile_dup(oglobals.pool, caller_profile_override);
@@ -3071,6 +3092,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 				oglobals.originate_status[i].peer_session = new_session;
 
 				switch_channel_set_flag(oglobals.originate_status[i].peer_channel, CF_ORIGINATING);
+				switch_channel_watch(oglobals.originate_status[i].peer_channel, oglobals.watcher);
 
 				if (caller_channel) {
 					switch_channel_set_variable(oglobals.originate_status[i].peer_channel, "call_uuid", switch_channel_get_variable(caller_channel, "call_uuid"));
@@ -3279,8 +3301,10 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 						}
 						goto notready;
 					}
+				}
 
-					switch_cond_next();
+				if (valid_channels) {
+					switch_channel_watcher_wait(oglobals.watcher, ORIGINATE_WAIT_MS);
 				}
 
 				check_per_channel_timeouts(&oglobals, and_argc, start, &force_reason);
@@ -3565,7 +3589,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 			do_continue:
 
 				if (!read_packet) {
-					switch_yield(20000);
+					switch_channel_watcher_wait(oglobals.watcher, ORIGINATE_WAIT_MS);
 				}
 			}
 
@@ -4198,6 +4222,13 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 
 	if (bleg && *bleg) {
 		switch_channel_t *bchan = switch_core_session_get_channel(*bleg);
+		switch_channel_timetable_t *times = switch_channel_get_timetable(bchan);
+
+		switch_channel_unwatch(bchan, oglobals.watcher);
+
+		if (times && times->answered) {
+			switch_core_latency_record(oglobals.session, SWITCH_LATENCY_ORIGINATE_ANSWER, times->answered - oglobals.start_time);
+		}
 
 		if (session && caller_channel) {
 			switch_caller_profile_t *cloned_profile, *peer_profile = switch_channel_get_caller_profile(switch_core_session_get_channel(*bleg));
@@ -4262,6 +4293,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 	}
 
 
+	switch_channel_watcher_release(&oglobals.watcher);
 	switch_core_destroy_memory_pool(&oglobals.pool);
 
 	return status;
@@ -1278,6 +1278,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_play_file(switch_core_session_t *sess
 	int flags;
 	int cumulative = 0;
 	int last_speed = -1;
+	int framed = 0;
 
 	if (switch_channel_pre_answer(channel) != SWITCH_STATUS_SUCCESS) {
 		return SWITCH_STATUS_FALSE;
@@ -1467,6 +1468,9 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_play_file(switch_core_session_t *sess
 		}
 
 
+		/* lets format modules that produce encoded audio pick the matching packetization */
+		fh->interval = read_impl.microseconds_per_packet / 1000;
+
 		for(;;) {
 			if (switch_core_file_open(fh,
 									  file,
@@ -1577,13 +1581,14 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_play_file(switch_core_session_t *sess
 		}
 
 		test_native = switch_test_flag(fh, SWITCH_FILE_NATIVE);
+		framed = test_native && switch_test_flag(fh, SWITCH_FILE_NATIVE_FRAMED);
 
 		if (test_native) {
 			write_frame.codec = switch_core_session_get_read_codec(session);
 			samples = read_impl.samples_per_packet;
 			framelen = read_impl.encoded_bytes_per_packet;
 			channels = read_impl.number_of_channels;
-			if (framelen == 0) {
+			if (framelen == 0 && !framed) {
 				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "%s cannot play or record native files with variable length data\n", switch_channel_get_name(channel));
 
 				switch_core_session_io_write_lock(session);
@@ -1735,7 +1740,11 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_play_file(switch_core_session_t *sess
 				write_frame.buflen = buflen;
 			}
 
-			if (switch_test_flag(fh, SWITCH_FILE_PAUSE)) {
+			if (framed && switch_test_flag(fh, SWITCH_FILE_PAUSE)) {
+				/* there is no silence pattern for an arbitrary codec, just hold the position */
+				switch_yield(interval * 1000);
+				continue;
+			} else if (switch_test_flag(fh, SWITCH_FILE_PAUSE)) {
 				if (framelen > FILE_STARTSAMPLES) {
 					framelen = FILE_STARTSAMPLES;
 				}
@@ -1757,6 +1766,26 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_play_file(switch_core_session_t *sess
 
 				olen = switch_test_flag(fh, SWITCH_FILE_NATIVE) ? framelen : ilen;
 				do_speed = 0;
+			} else if (framed) {
+				switch_status_t rstatus;
+
+				if (eof) {
+					break;
+				}
+
+				/* one read is one ready to send packet, no need to go through the audio buffer */
+				olen = write_frame.buflen;
+
+				if ((rstatus = switch_core_file_read(fh, abuf, &olen)) == SWITCH_STATUS_BREAK) {
+					continue;
+				}
+
+				if (rstatus != SWITCH_STATUS_SUCCESS || !olen) {
+					eof++;
+					continue;
+				}
+
+				fh->offset_pos += samples;
 			} else if (fh->audio_buffer && (eof || (switch_buffer_inuse(fh->audio_buffer) > (switch_size_t) (framelen)))) {
 				if (!(bread = switch_buffer_read(fh->audio_buffer, abuf, framelen))) {
 					if (eof) {
@@ -1889,7 +1918,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_play_file(switch_core_session_t *sess
 				continue;
 			}
 
-			if (olen < llen) {
+			if (!framed && olen < llen) {
 				uint8_t *dp = (uint8_t *) write_frame.data;
 				memset(dp + (int) olen, 255, (int) (llen - olen));
 				olen = llen;
@@ -1937,7 +1966,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_play_file(switch_core_session_t *sess
 			}
 
 			more_data = 0;
-			write_frame.samples = (uint32_t) olen;
+			write_frame.samples = framed ? samples : (uint32_t) olen;
 
 			if (switch_test_flag(fh, SWITCH_FILE_NATIVE)) {
 				write_frame.datalen = (uint32_t) olen;
@@ -332,6 +332,8 @@ static inline void hide_nodes(switch_jb_t *jb)
 	switch_mutex_unlock(jb->list_mutex);
 }
 
+static switch_metric_t *jb_drop_metric = NULL;
+
 static inline void drop_ts(switch_jb_t *jb, uint32_t ts)
 {
 	switch_jb_node_t *np;
@@ -349,6 +351,7 @@ static inline void drop_ts(switch_jb_t *jb, uint32_t ts)
 
 	if (x) {
 		sort_free_nodes(jb);
+		switch_core_metric_add(jb_drop_metric, x);
 	}
 
 	switch_mutex_unlock(jb->list_mutex);
@@ -1082,6 +1085,11 @@ SWITCH_DECLARE(switch_status_t) switch_jb_create(switch_jb_t **jbp, switch_jb_ty
 		free_pool = 1;
 	}
 
+	if (!jb_drop_metric) {
+		switch_core_metric_register("freeswitch_jitterbuffer_dropped_packets_total", NULL, "Packets dropped by jitter buffers",
+									SWITCH_METRIC_COUNTER, &jb_drop_metric);
+	}
+
 	jb = switch_core_alloc(pool, sizeof(*jb));
 	jb->free_pool = free_pool;
 	jb->min_frame_len = jb->frame_len = min_frame_len;
@@ -1231,6 +1239,7 @@ SWITCH_DECLARE(switch_status_t) switch_jb_put_packet(switch_jb_t *jb, switch_rtp
 	if (jb->highest_dropped_ts) {
 		if (ntohl(packet->header.ts) < jb->highest_dropped_ts) {
 			jb_debug(jb, 2, "%s", "TS ALREADY DROPPED, DROPPING PACKET\n");
+			switch_core_metric_inc(jb_drop_metric);
 			switch_mutex_unlock(jb->mutex);
 			return SWITCH_STATUS_SUCCESS;
 		}
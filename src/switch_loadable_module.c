@@ -43,6 +43,10 @@
 /* for apr file and directory handling */
 #include <apr_file_io.h>
 
+#ifdef __GLIBC__
+#include <malloc.h> /* mallinfo() */
+#endif
+
 typedef struct switch_file_node_s {
 	const switch_file_interface_t *ptr;
 	const char *interface_name;
@@ -78,6 +82,11 @@ struct switch_loadable_module {
 	switch_loadable_module_type_t type;
 };
 
+typedef struct module_timing_node_s {
+	switch_module_timing_t timing;
+	struct module_timing_node_s *next;
+} module_timing_node_t;
+
 struct switch_loadable_module_container {
 	switch_hash_t *module_hash;
 	switch_hash_t *endpoint_hash;
@@ -100,12 +109,17 @@ struct switch_loadable_module_container {
 	switch_hash_t *secondary_recover_hash;
 	switch_mutex_t *mutex;
 	switch_memory_pool_t *pool;
+	module_timing_node_t *timings;
+	module_timing_node_t *last_timing;
+	switch_time_t startup_usec;
+	uint32_t startup_threads;
 };
 
 static struct switch_loadable_module_container loadable_modules;
 static switch_status_t do_shutdown(switch_loadable_module_t *module, switch_bool_t shutdown, switch_bool_t unload, switch_bool_t fail_if_busy,
 								   const char **err);
 static switch_status_t switch_loadable_module_load_module_ex(const char *dir, const char *fname, switch_bool_t runtime, switch_bool_t global, const char **err, switch_loadable_module_type_t type, switch_hash_t *event_hash);
+static void record_module_timing(const char *name, switch_time_t dlopen_usec, switch_time_t load_usec, switch_status_t status);
 
 static void *SWITCH_THREAD_FUNC switch_loadable_module_exec(switch_thread_t *thread, void *obj)
 {
@@ -1629,7 +1643,8 @@ static switch_status_t switch_loadable_module_unprocess(switch_loadable_module_t
 }
 
 
-static switch_status_t switch_loadable_module_load_file(char *path, char *filename, switch_bool_t global, switch_loadable_module_t **new_module)
+static switch_status_t switch_loadable_module_load_file(char *path, char *filename, switch_bool_t global, switch_loadable_module_t **new_module,
+														switch_time_t *dlopen_usec, switch_time_t *load_usec)
 {
 	switch_loadable_module_t *module = NULL;
 	switch_dso_lib_t dso = NULL;
@@ -1644,6 +1659,7 @@ static switch_status_t switch_loadable_module_load_file(char *path, char *filena
 	const char *err = NULL;
 	switch_memory_pool_t *pool = NULL;
 	switch_bool_t load_global = global;
+	switch_time_t started = switch_time_now(), load_started = 0;
 
 	switch_assert(path != NULL);
 
@@ -1713,7 +1729,9 @@ static switch_status_t switch_loadable_module_load_file(char *path, char *filena
 			break;
 		}
 
+		load_started = switch_time_now();
 		status = load_func_ptr(&module_interface, pool);
+		*load_usec = switch_time_now() - load_started;
 
 		if (status != SWITCH_STATUS_SUCCESS && status != SWITCH_STATUS_NOUNLOAD) {
 			err = "Module load routine returned an error";
@@ -1737,6 +1755,7 @@ static switch_status_t switch_loadable_module_load_file(char *path, char *filena
 		loading = 0;
 	}
 
+	*dlopen_usec = (load_started ? load_started : switch_time_now()) - started;
 
 	if (err) {
 
@@ -1784,6 +1803,7 @@ static switch_status_t switch_loadable_module_load_module_ex(const char *dir, co
 	char *file, *dot;
 	switch_loadable_module_t *new_module = NULL;
 	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	switch_time_t dlopen_usec = 0, load_usec = 0;
 
 #ifdef WIN32
 	const char *ext = ".dll";
@@ -1820,7 +1840,7 @@ static switch_status_t switch_loadable_module_load_module_ex(const char *dir, co
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Module %s Already Loaded!\n", file);
 		*err = "Module already loaded";
 		status = SWITCH_STATUS_FALSE;
-	} else if ((status = switch_loadable_module_load_file(path, file, global, &new_module)) == SWITCH_STATUS_SUCCESS) {
+	} else if ((status = switch_loadable_module_load_file(path, file, global, &new_module, &dlopen_usec, &load_usec)) == SWITCH_STATUS_SUCCESS) {
 		new_module->type = type;
 
 		if ((status = switch_loadable_module_process(file, new_module, event_hash)) == SWITCH_STATUS_SUCCESS && runtime) {
@@ -1830,8 +1850,10 @@ static switch_status_t switch_loadable_module_load_module_ex(const char *dir, co
 		} else if (status != SWITCH_STATUS_SUCCESS) {
 			*err = "module load routine returned an error";
 		}
+		record_module_timing(file, dlopen_usec, load_usec, status);
 	} else {
 		*err = "module load file routine returned an error";
+		record_module_timing(file, dlopen_usec, load_usec, status);
 	}
 
 
@@ -2073,6 +2095,277 @@ static void switch_loadable_module_path_init()
 }
 #endif
 
+static void record_module_timing(const char *name, switch_time_t dlopen_usec, switch_time_t load_usec, switch_status_t status)
+{
+	module_timing_node_t *node;
+
+	switch_mutex_lock(loadable_modules.mutex);
+
+	for (node = loadable_modules.timings; node; node = node->next) {
+		if (!strcmp(node->timing.name, name)) {
+			break;
+		}
+	}
+
+	if (!node) {
+		node = switch_core_alloc(loadable_modules.pool, sizeof(*node));
+		node->timing.name = switch_core_strdup(loadable_modules.pool, name);
+
+		if (loadable_modules.last_timing) {
+			loadable_modules.last_timing->next = node;
+		} else {
+			loadable_modules.timings = node;
+		}
+		loadable_modules.last_timing = node;
+	}
+
+	node->timing.dlopen_usec = dlopen_usec;
+	node->timing.load_usec = load_usec;
+	node->timing.wait_usec = 0;
+	node->timing.status = status;
+
+	switch_mutex_unlock(loadable_modules.mutex);
+}
+
+static void record_module_wait(const char *name, switch_time_t wait_usec)
+{
+	module_timing_node_t *node;
+
+	switch_mutex_lock(loadable_modules.mutex);
+	for (node = loadable_modules.timings; node; node = node->next) {
+		if (!strcmp(node->timing.name, name)) {
+			node->timing.wait_usec = wait_usec;
+			break;
+		}
+	}
+	switch_mutex_unlock(loadable_modules.mutex);
+}
+
+SWITCH_DECLARE(int) switch_loadable_module_get_timings(switch_module_timing_callback_t callback, void *user_data)
+{
+	module_timing_node_t *node;
+	int count = 0;
+
+	switch_mutex_lock(loadable_modules.mutex);
+	for (node = loadable_modules.timings; node; node = node->next) {
+		if (callback) {
+			callback(&node->timing, user_data);
+		}
+		count++;
+	}
+	switch_mutex_unlock(loadable_modules.mutex);
+
+	return count;
+}
+
+static void module_timing_report_callback(const switch_module_timing_t *timing, void *user_data)
+{
+	switch_stream_handle_t *stream = (switch_stream_handle_t *) user_data;
+
+	stream->write_function(stream, "%-32s %12.3f %12.3f %12.3f   %s\n", timing->name,
+						   (double) timing->dlopen_usec / 1000, (double) timing->load_usec / 1000, (double) timing->wait_usec / 1000,
+						   timing->status == SWITCH_STATUS_SUCCESS ? "ok" : "failed");
+}
+
+SWITCH_DECLARE(void) switch_loadable_module_timing_report(switch_stream_handle_t *stream)
+{
+	module_timing_node_t *node;
+	switch_time_t dlopen_usec = 0, load_usec = 0;
+	int count;
+
+	stream->write_function(stream, "%-32s %12s %12s %12s   %s\n", "module", "dlopen(ms)", "load(ms)", "queued(ms)", "status");
+	count = switch_loadable_module_get_timings(module_timing_report_callback, stream);
+
+	switch_mutex_lock(loadable_modules.mutex);
+	for (node = loadable_modules.timings; node; node = node->next) {
+		dlopen_usec += node->timing.dlopen_usec;
+		load_usec += node->timing.load_usec;
+	}
+	switch_mutex_unlock(loadable_modules.mutex);
+
+	stream->write_function(stream, "\n%d modules, %.3fms in dlopen, %.3fms in load functions", count, (double) dlopen_usec / 1000, (double) load_usec / 1000);
+
+	if (loadable_modules.startup_usec) {
+		stream->write_function(stream, ", startup took %.3fms with %u loader thread%s", (double) loadable_modules.startup_usec / 1000,
+							   loadable_modules.startup_threads, loadable_modules.startup_threads == 1 ? "" : "s");
+	}
+
+	stream->write_function(stream, "\n");
+}
+
+typedef enum {
+	MODULE_JOB_PENDING,
+	MODULE_JOB_RUNNING,
+	MODULE_JOB_DONE
+} module_job_state_t;
+
+#define MODULE_JOB_MAX_AFTER 32
+#define MODULE_LOAD_MAX_THREADS 64
+
+typedef struct module_load_job_s {
+	char *name;
+	char *path;
+	char *module;
+	switch_bool_t global;
+	switch_bool_t critical;
+	switch_bool_t serial;
+	int argc;
+	char *argv[MODULE_JOB_MAX_AFTER];
+	module_job_state_t state;
+	struct module_load_job_s *next;
+} module_load_job_t;
+
+typedef struct {
+	module_load_job_t *jobs;
+	module_load_job_t *last_job;
+	int pending;
+	int running;
+	switch_time_t started;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_memory_pool_t *pool;
+} module_load_plan_t;
+
+static void module_load_plan_add(module_load_plan_t *plan, const char *path, const char *module, switch_bool_t global, switch_bool_t critical, switch_xml_t ld)
+{
+	module_load_job_t *job = switch_core_alloc(plan->pool, sizeof(*job));
+	const char *after = switch_xml_attr(ld, "after");
+	char *dot;
+
+	job->path = path ? switch_core_strdup(plan->pool, path) : NULL;
+	job->module = switch_core_strdup(plan->pool, module);
+	job->name = switch_core_strdup(plan->pool, switch_cut_path(module));
+	if ((dot = strchr(job->name, '.'))) {
+		*dot = '\0';
+	}
+	job->global = global;
+	job->critical = critical;
+	job->serial = switch_true(switch_xml_attr(ld, "serial"));
+
+	if (!zstr(after)) {
+		job->argc = switch_separate_string(switch_core_strdup(plan->pool, after), ',', job->argv, MODULE_JOB_MAX_AFTER);
+	}
+
+	if (plan->last_job) {
+		plan->last_job->next = job;
+	} else {
+		plan->jobs = job;
+	}
+	plan->last_job = job;
+	plan->pending++;
+}
+
+static switch_bool_t module_load_job_ready(module_load_plan_t *plan, module_load_job_t *job)
+{
+	module_load_job_t *jp;
+	int i;
+
+	/* a serial module waits for everything listed before it and holds back everything listed after it */
+	for (jp = plan->jobs; jp && jp != job; jp = jp->next) {
+		if ((job->serial || jp->serial) && jp->state != MODULE_JOB_DONE) {
+			return SWITCH_FALSE;
+		}
+	}
+
+	for (i = 0; i < job->argc; i++) {
+		for (jp = plan->jobs; jp; jp = jp->next) {
+			if (jp != job && jp->state != MODULE_JOB_DONE && !strcasecmp(jp->name, job->argv[i])) {
+				return SWITCH_FALSE;
+			}
+		}
+	}
+
+	return SWITCH_TRUE;
+}
+
+static void *SWITCH_THREAD_FUNC module_load_thread(switch_thread_t *thread, void *obj)
+{
+	module_load_plan_t *plan = (module_load_plan_t *) obj;
+	module_load_job_t *job;
+	switch_time_t wait_usec;
+	const char *err;
+
+	switch_mutex_lock(plan->mutex);
+
+	while (plan->pending) {
+		for (job = plan->jobs; job; job = job->next) {
+			if (job->state == MODULE_JOB_PENDING && module_load_job_ready(plan, job)) {
+				break;
+			}
+		}
+
+		if (!job && !plan->running) {
+			/* nothing can start and nothing is left to finish, the ordering has a cycle in it */
+			for (job = plan->jobs; job && job->state != MODULE_JOB_PENDING; job = job->next);
+			switch_assert(job);
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Load ordering for %s cannot be satisfied, loading it anyway\n", job->name);
+		}
+
+		if (!job) {
+			switch_thread_cond_wait(plan->cond, plan->mutex);
+			continue;
+		}
+
+		job->state = MODULE_JOB_RUNNING;
+		plan->pending--;
+		plan->running++;
+		switch_mutex_unlock(plan->mutex);
+
+		wait_usec = switch_time_now() - plan->started;
+
+		if (switch_loadable_module_load_module_ex(job->path, job->module, SWITCH_FALSE, job->global, &err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, NULL) == SWITCH_STATUS_GENERR) {
+			if (job->critical) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Failed to load critical module '%s', abort()\n", job->module);
+				abort();
+			}
+		}
+
+		record_module_wait(job->name, wait_usec);
+
+		switch_mutex_lock(plan->mutex);
+		job->state = MODULE_JOB_DONE;
+		plan->running--;
+		switch_thread_cond_broadcast(plan->cond);
+	}
+
+	switch_mutex_unlock(plan->mutex);
+
+	return NULL;
+}
+
+static void module_load_plan_run(module_load_plan_t *plan, uint32_t threads)
+{
+	switch_thread_t *thread[MODULE_LOAD_MAX_THREADS];
+	switch_threadattr_t *thd_attr = NULL;
+	switch_status_t st;
+	uint32_t i, started = 0;
+
+	if (threads > (uint32_t) plan->pending) {
+		threads = plan->pending;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Loading %d modules with %u threads\n", plan->pending, threads);
+
+	plan->started = switch_time_now();
+	switch_threadattr_create(&thd_attr, plan->pool);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+	for (i = 0; i < threads; i++) {
+		if (switch_thread_create(&thread[started], thd_attr, module_load_thread, plan, plan->pool) == SWITCH_STATUS_SUCCESS) {
+			started++;
+		}
+	}
+
+	if (!started) {
+		/* no threads to be had, work through the plan on this one */
+		module_load_thread(NULL, plan);
+	}
+
+	for (i = 0; i < started; i++) {
+		switch_thread_join(&st, thread[i]);
+	}
+}
+
 SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autoload)
 {
 
@@ -2090,6 +2383,8 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autolo
 	switch_hash_index_t *hi;
 	void *hash_val;
 	switch_event_t *event;
+	switch_time_t started = switch_time_now();
+	uint32_t load_threads = 1;
 
 
 #ifdef WIN32
@@ -2222,6 +2517,21 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autolo
 	if ((xml = switch_xml_open_cfg(cf, &cfg, NULL))) {
 		switch_xml_t mods, ld;
 		if ((mods = switch_xml_child(cfg, "modules"))) {
+			module_load_plan_t plan = { 0 };
+			const char *threads = switch_xml_attr(mods, "load-threads");
+
+			/* with load-threads set the modules are loaded in parallel, constrained by their after= and serial= attributes */
+			if (!zstr(threads) && atoi(threads) > 1) {
+				load_threads = atoi(threads);
+				if (load_threads > MODULE_LOAD_MAX_THREADS) {
+					load_threads = MODULE_LOAD_MAX_THREADS;
+				}
+
+				switch_core_new_memory_pool(&plan.pool);
+				switch_mutex_init(&plan.mutex, SWITCH_MUTEX_NESTED, plan.pool);
+				switch_thread_cond_create(&plan.cond, plan.pool);
+			}
+
 			for (ld = switch_xml_child(mods, "load"); ld; ld = ld->next) {
 				switch_bool_t global = SWITCH_FALSE;
 				const char *val = switch_xml_attr_soft(ld, "module");
@@ -2237,7 +2547,9 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autolo
 				if (path && zstr(path)) {
 					path = SWITCH_GLOBAL_dirs.mod_dir;
 				}
-				if (switch_loadable_module_load_module_ex(path, val, SWITCH_FALSE, global, &err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, NULL) == SWITCH_STATUS_GENERR) {
+				if (plan.pool) {
+					module_load_plan_add(&plan, path, val, global, switch_true(critical), ld);
+				} else if (switch_loadable_module_load_module_ex(path, val, SWITCH_FALSE, global, &err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, NULL) == SWITCH_STATUS_GENERR) {
 					if (critical && switch_true(critical)) {
 						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Failed to load critical module '%s', abort()\n", val);
 						abort();
@@ -2245,6 +2557,13 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autolo
 				}
 				count++;
 			}
+
+			if (plan.pool) {
+				if (plan.pending) {
+					module_load_plan_run(&plan, load_threads);
+				}
+				switch_core_destroy_memory_pool(&plan.pool);
+			}
 		}
 		switch_xml_free(xml);
 
@@ -2315,6 +2634,18 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autolo
 		apr_dir_close(module_dir_handle);
 	}
 
+	loadable_modules.startup_usec = switch_time_now() - started;
+	loadable_modules.startup_threads = load_threads;
+
+	{
+		switch_stream_handle_t stream = { 0 };
+
+		SWITCH_STANDARD_STREAM(stream);
+		switch_loadable_module_timing_report(&stream);
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Module startup timing:\n%s", (char *) stream.data);
+		switch_safe_free(stream.data);
+	}
+
 	switch_loadable_module_runtime();
 
 	memset(&chat_globals, 0, sizeof(chat_globals));
@@ -2738,6 +3069,223 @@ SWITCH_DECLARE(int) switch_loadable_module_get_codecs(const switch_codec_impleme
 
 }
 
+typedef struct codec_benchmark_target_s {
+	char iananame[64];
+	char modname[256];
+	uint32_t rate;
+	uint32_t ptime;
+	int channels;
+} codec_benchmark_target_t;
+
+#define CODEC_BENCHMARK_BATCH 50
+
+static int64_t codec_benchmark_heap_in_use(void)
+{
+#ifdef __GLIBC__
+#if defined(__GLIBC_PREREQ) && __GLIBC_PREREQ(2, 33)
+	struct mallinfo2 mi = mallinfo2();
+#else
+	struct mallinfo mi = mallinfo();
+#endif
+	return (int64_t) mi.uordblks + (int64_t) mi.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+/* speech-ish reference signal: two partials under a syllabic envelope plus a little noise */
+static void codec_benchmark_reference(int16_t *data, uint32_t samples, int channels, uint32_t rate, uint32_t offset)
+{
+	static uint32_t seed = 0x1f2e3d4c;
+	uint32_t i;
+	int c;
+
+	for (i = 0; i < samples; i++) {
+		double t = (double) (offset + i) / rate;
+		double env = 0.5 + 0.5 * sin(2 * M_PI * 4 * t);
+		double v = env * (6000 * sin(2 * M_PI * 220 * t) + 3000 * sin(2 * M_PI * 1330 * t));
+
+		seed = seed * 1103515245 + 12345;
+		v += (int16_t) (seed >> 16) / 64;
+
+		for (c = 0; c < channels; c++) {
+			data[i * channels + c] = (int16_t) v;
+		}
+	}
+}
+
+static void codec_benchmark_run(const codec_benchmark_target_t *target, uint32_t frames, switch_codec_benchmark_t *result)
+{
+	switch_codec_t codec = { 0 };
+	const switch_codec_implementation_t *impl;
+	uint8_t *decoded = NULL, *encoded = NULL, *out = NULL;
+	uint32_t *encoded_len = NULL;
+	uint32_t decoded_len, done = 0, samples = 0;
+	int64_t heap;
+
+	memset(result, 0, sizeof(*result));
+	result->iananame = target->iananame;
+	result->modname = target->modname;
+	result->samples_per_second = target->rate;
+	result->ptime = target->ptime;
+	result->channels = target->channels;
+
+	heap = codec_benchmark_heap_in_use();
+
+	if ((result->status = switch_core_codec_init(&codec, target->iananame, target->modname, NULL, target->rate, target->ptime, target->channels,
+												 SWITCH_CODEC_FLAG_ENCODE | SWITCH_CODEC_FLAG_DECODE, NULL, NULL)) != SWITCH_STATUS_SUCCESS) {
+		return;
+	}
+
+	result->init_heap_bytes = codec_benchmark_heap_in_use() - heap;
+
+	impl = codec.implementation;
+	result->actual_samples_per_second = impl->actual_samples_per_second;
+	decoded_len = impl->decoded_bytes_per_packet;
+
+	if (!decoded_len || decoded_len > SWITCH_RECOMMENDED_BUFFER_SIZE) {
+		result->status = SWITCH_STATUS_NOTIMPL;
+		goto end;
+	}
+
+	switch_zmalloc(decoded, decoded_len * CODEC_BENCHMARK_BATCH);
+	switch_zmalloc(encoded, SWITCH_RECOMMENDED_BUFFER_SIZE * CODEC_BENCHMARK_BATCH);
+	switch_zmalloc(encoded_len, sizeof(uint32_t) * CODEC_BENCHMARK_BATCH);
+	switch_zmalloc(out, SWITCH_RECOMMENDED_BUFFER_SIZE);
+
+	heap = codec_benchmark_heap_in_use();
+
+	/* batches keep the clock reads out of the per frame cost */
+	while (done < frames && result->status == SWITCH_STATUS_SUCCESS) {
+		uint32_t batch = frames - done > CODEC_BENCHMARK_BATCH ? CODEC_BENCHMARK_BATCH : frames - done, i;
+		uint32_t frame_samples = decoded_len / 2 / impl->number_of_channels;
+		switch_time_t start;
+
+		for (i = 0; i < batch; i++) {
+			codec_benchmark_reference((int16_t *) (decoded + i * decoded_len), frame_samples, impl->number_of_channels,
+									  impl->actual_samples_per_second, samples);
+			samples += frame_samples;
+		}
+
+		start = switch_time_ref();
+		for (i = 0; i < batch; i++) {
+			uint32_t rate = impl->actual_samples_per_second;
+			unsigned int flag = 0;
+
+			encoded_len[i] = SWITCH_RECOMMENDED_BUFFER_SIZE;
+			if (switch_core_codec_encode(&codec, NULL, decoded + i * decoded_len, decoded_len, impl->actual_samples_per_second,
+										 encoded + i * SWITCH_RECOMMENDED_BUFFER_SIZE, &encoded_len[i], &rate, &flag) != SWITCH_STATUS_SUCCESS) {
+				result->status = SWITCH_STATUS_GENERR;
+				break;
+			}
+		}
+		result->encode_usec += switch_time_ref() - start;
+
+		if (result->status != SWITCH_STATUS_SUCCESS) {
+			break;
+		}
+
+		start = switch_time_ref();
+		for (i = 0; i < batch; i++) {
+			uint32_t rate = impl->actual_samples_per_second, len = SWITCH_RECOMMENDED_BUFFER_SIZE;
+			unsigned int flag = 0;
+
+			if (switch_core_codec_decode(&codec, NULL, encoded + i * SWITCH_RECOMMENDED_BUFFER_SIZE, encoded_len[i], impl->actual_samples_per_second,
+										 out, &len, &rate, &flag) != SWITCH_STATUS_SUCCESS) {
+				result->status = SWITCH_STATUS_GENERR;
+				break;
+			}
+		}
+		result->decode_usec += switch_time_ref() - start;
+
+		for (i = 0; i < batch; i++) {
+			result->encoded_bytes += encoded_len[i];
+		}
+
+		done += batch;
+	}
+
+	result->run_heap_bytes = codec_benchmark_heap_in_use() - heap;
+	result->frames = done;
+
+	if (done) {
+		result->encode_ns_per_frame = (double) result->encode_usec * 1000 / done;
+		result->decode_ns_per_frame = (double) result->decode_usec * 1000 / done;
+		result->encode_fps = result->encode_usec ? (double) done * 1000000 / result->encode_usec : 0;
+		result->decode_fps = result->decode_usec ? (double) done * 1000000 / result->decode_usec : 0;
+	}
+
+  end:
+
+	switch_core_codec_destroy(&codec);
+	switch_safe_free(decoded);
+	switch_safe_free(encoded);
+	switch_safe_free(encoded_len);
+	switch_safe_free(out);
+}
+
+SWITCH_DECLARE(int) switch_loadable_module_benchmark_codecs(const char *name, uint32_t frames, switch_codec_benchmark_callback_t callback, void *user_data)
+{
+	switch_hash_index_t *hi;
+	const void *var;
+	void *val;
+	switch_codec_node_t *node;
+	const switch_codec_implementation_t *imp;
+	codec_benchmark_target_t *targets = NULL;
+	int count = 0, alloc = 0, i;
+
+	if (!frames) {
+		frames = 1000;
+	}
+
+	/* snapshot the implementations so no module lock is held while the codecs run */
+	switch_mutex_lock(loadable_modules.mutex);
+	for (hi = switch_core_hash_first(loadable_modules.codec_hash); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, &var, NULL, &val);
+
+		for (node = (switch_codec_node_t *) val; node; node = node->next) {
+			for (imp = node->ptr->implementations; imp; imp = imp->next) {
+				codec_benchmark_target_t *target;
+
+				/* an interface is listed under each of its iananames, take only the matching implementations */
+				if (imp->codec_type != SWITCH_CODEC_TYPE_AUDIO || strcasecmp((const char *) var, imp->iananame) ||
+					(name && strcasecmp(name, imp->iananame))) {
+					continue;
+				}
+
+				if (count == alloc) {
+					alloc = alloc ? alloc * 2 : 64;
+					targets = realloc(targets, sizeof(*targets) * alloc);
+					switch_assert(targets);
+				}
+
+				target = &targets[count++];
+				switch_copy_string(target->iananame, imp->iananame, sizeof(target->iananame));
+				switch_copy_string(target->modname, switch_str_nil(node->ptr->modname), sizeof(target->modname));
+				target->rate = imp->samples_per_second;
+				target->ptime = imp->microseconds_per_packet / 1000;
+				target->channels = imp->number_of_channels;
+			}
+		}
+	}
+	switch_safe_free(hi);
+	switch_mutex_unlock(loadable_modules.mutex);
+
+	for (i = 0; i < count; i++) {
+		switch_codec_benchmark_t result;
+
+		codec_benchmark_run(&targets[i], frames, &result);
+
+		if (callback) {
+			callback(&result, user_data);
+		}
+	}
+
+	switch_safe_free(targets);
+
+	return count;
+}
+
 SWITCH_DECLARE(char *) switch_parse_codec_buf(char *buf, uint32_t *interval, uint32_t *rate, uint32_t *bit, uint32_t *channels, char **modname, char **fmtp)
 {
 	char *cur, *next = NULL, *name, *p;
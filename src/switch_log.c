@@ -32,6 +32,17 @@
 
 #include <switch.h>
 #include "private/switch_core_pvt.h"
+#ifdef WIN32
+#include <io.h>
+#define open _open
+#define write _write
+#define close _close
+#else
+#include <unistd.h>
+#endif
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 
 static const char *LEVELS[] = {
 	"DISABLE",
@@ -49,21 +60,35 @@ static const char *LEVELS[] = {
 struct switch_log_binding {
 	switch_log_function_t function;
 	switch_log_level_t level;
+	/* the level the logger currently wants, never above level */
+	switch_log_level_t hint;
+	switch_log_flush_function_t flush;
 	int is_console;
 	struct switch_log_binding *next;
 };
 
 typedef struct switch_log_binding switch_log_binding_t;
 
+/* the logging threads are spread over this many queues so they don't all contend on one lock */
+#define SWITCH_LOG_SHARDS 8
+/* most lines the log thread takes from one queue per round */
+#define SWITCH_LOG_BATCH 128
+
 static switch_memory_pool_t *LOG_POOL = NULL;
 static switch_log_binding_t *BINDINGS = NULL;
 static switch_mutex_t *BINDLOCK = NULL;
-static switch_queue_t *LOG_QUEUE = NULL;
+static switch_queue_t *LOG_QUEUES[SWITCH_LOG_SHARDS] = { 0 };
+/* wakes the log thread, only rung while it is idle */
+static switch_queue_t *LOG_DOORBELL = NULL;
+static volatile int LOG_IDLE = 0;
+static volatile int LOG_STOP = 0;
+static switch_atomic_t LOG_DROPPED = 0;
+static uint64_t LOG_DELIVERED = 0;
 #ifdef SWITCH_LOG_RECYCLE
 static switch_queue_t *LOG_RECYCLE_QUEUE = NULL;
 #endif
 static int8_t THREAD_RUNNING = 0;
-static uint8_t MAX_LEVEL = 0;
+static int MAX_LEVEL = SWITCH_LOG_DISABLE;
 static int mods_loaded = 0;
 static int console_mods_loaded = 0;
 static switch_bool_t COLORIZE = SWITCH_FALSE;
@@ -422,6 +447,77 @@ SWITCH_DECLARE(switch_log_level_t) switch_log_str2level(const char *str)
 	return level;
 }
 
+/* the most verbose level any logger wants, call with BINDLOCK held */
+static void update_max_level(void)
+{
+	switch_log_binding_t *ptr;
+	int max = SWITCH_LOG_DISABLE;
+
+	for (ptr = BINDINGS; ptr; ptr = ptr->next) {
+		int level = ptr->hint < ptr->level ? ptr->hint : ptr->level;
+
+		if (level > max) {
+			max = level;
+		}
+	}
+
+	MAX_LEVEL = max;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_log_set_logger_level_hint(switch_log_function_t function, switch_log_level_t level)
+{
+	switch_log_binding_t *ptr = NULL;
+	switch_status_t status = SWITCH_STATUS_FALSE;
+
+	switch_mutex_lock(BINDLOCK);
+	for (ptr = BINDINGS; ptr; ptr = ptr->next) {
+		if (ptr->function == function) {
+			ptr->hint = level;
+			status = SWITCH_STATUS_SUCCESS;
+			break;
+		}
+	}
+	update_max_level();
+	switch_mutex_unlock(BINDLOCK);
+
+	return status;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_log_bind_logger_flush(switch_log_function_t function, switch_log_flush_function_t flush)
+{
+	switch_log_binding_t *ptr = NULL;
+	switch_status_t status = SWITCH_STATUS_FALSE;
+
+	switch_mutex_lock(BINDLOCK);
+	for (ptr = BINDINGS; ptr; ptr = ptr->next) {
+		if (ptr->function == function) {
+			ptr->flush = flush;
+			status = SWITCH_STATUS_SUCCESS;
+			break;
+		}
+	}
+	switch_mutex_unlock(BINDLOCK);
+
+	return status;
+}
+
+SWITCH_DECLARE(void) switch_log_get_stats(switch_log_stats_t *stats)
+{
+	int i;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->shards = SWITCH_LOG_SHARDS;
+
+	for (i = 0; i < SWITCH_LOG_SHARDS; i++) {
+		if (LOG_QUEUES[i]) {
+			stats->backlog += switch_queue_size(LOG_QUEUES[i]);
+		}
+	}
+
+	stats->delivered = LOG_DELIVERED;
+	stats->dropped = LOG_DROPPED;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_log_unbind_logger(switch_log_function_t function)
 {
 	switch_log_binding_t *ptr = NULL, *last = NULL;
@@ -444,6 +540,7 @@ SWITCH_DECLARE(switch_status_t) switch_log_unbind_logger(switch_log_function_t f
 		}
 		last = ptr;
 	}
+	update_max_level();
 	switch_mutex_unlock(BINDLOCK);
 
 	return status;
@@ -458,12 +555,9 @@ SWITCH_DECLARE(switch_status_t) switch_log_bind_logger(switch_log_function_t fun
 		return SWITCH_STATUS_MEMERR;
 	}
 
-	if ((uint8_t) level > MAX_LEVEL) {
-		MAX_LEVEL = level;
-	}
-
 	binding->function = function;
 	binding->level = level;
+	binding->hint = level;
 	binding->is_console = is_console;
 
 	switch_mutex_lock(BINDLOCK);
@@ -478,6 +572,7 @@ SWITCH_DECLARE(switch_status_t) switch_log_bind_logger(switch_log_function_t fun
 		console_mods_loaded++;
 	}
 	mods_loaded++;
+	update_max_level();
 	switch_mutex_unlock(BINDLOCK);
 
 	return SWITCH_STATUS_SUCCESS;
@@ -485,40 +580,704 @@ SWITCH_DECLARE(switch_status_t) switch_log_bind_logger(switch_log_function_t fun
 
 static switch_thread_t *thread;
 
-static void *SWITCH_THREAD_FUNC log_thread(switch_thread_t *t, void *obj)
+/* the binary trace of lines nobody is logging, see switch_log_trace_init() */
+#define SWITCH_LOG_TRACE_MAGIC "FSTRACE1"
+/* numeric arguments kept per record */
+#define SWITCH_LOG_TRACE_ARGS 5
+/* distinct call sites remembered, a power of 2 */
+#define SWITCH_LOG_TRACE_SITES 16384
+#define SWITCH_LOG_TRACE_PROBES 8
+
+typedef struct {
+	switch_time_t timestamp;
+	/* position in the ring + 1, written last so a record torn by a crash or a wrap reads as 0 */
+	uint32_t seq;
+	uint32_t site;
+	uint32_t session;
+	int16_t level;
+	uint8_t nargs;
+	uint8_t pad;
+	int64_t args[SWITCH_LOG_TRACE_ARGS];
+} log_trace_record_t;
+
+typedef struct {
+	const char *key;
+	int line;
+	char *file;
+	char *func;
+	char *fmt;
+} log_trace_site_t;
+
+typedef struct {
+	switch_atomic_t head;
+	log_trace_record_t *records;
+} log_trace_ring_t;
+
+typedef struct {
+	char magic[8];
+	uint32_t record_size;
+	uint32_t rings;
+	uint32_t records;
+	uint32_t reserved;
+} log_trace_header_t;
+
+typedef enum {
+	TRACE_CONV_INT,
+	TRACE_CONV_UINT,
+	TRACE_CONV_STR,
+	TRACE_CONV_PTR,
+	TRACE_CONV_DOUBLE
+} log_trace_conv_type_t;
+
+typedef struct {
+	const char *start;
+	const char *length;
+	log_trace_conv_type_t type;
+	char conv;
+	/* 0 int, 1 long, 2 long long, 3 size_t, 4 intmax_t, 5 long double */
+	int size;
+} log_trace_conv_t;
+
+static log_trace_ring_t TRACE_RINGS[SWITCH_LOG_SHARDS];
+static log_trace_site_t *TRACE_SITES = NULL;
+/* records per ring, a power of 2, 0 while tracing is off */
+static uint32_t TRACE_RECORDS = 0;
+static switch_mutex_t *TRACE_MUTEX = NULL;
+static char TRACE_CRASH_PATH[1024] = "";
+
+/* find the next conversion in a printf format, returns NULL at the end or at one we can't follow */
+static const char *log_trace_next_conv(const char *p, log_trace_conv_t *conv)
 {
+	while ((p = strchr(p, '%'))) {
+		if (*(p + 1) == '%') {
+			p += 2;
+			continue;
+		}
 
-	if (!obj) {
-		obj = NULL;
+		conv->start = p++;
+		conv->size = 0;
+
+		while (*p && strchr("-+ #0'", *p)) p++;
+		while ((*p >= '0' && *p <= '9') || *p == '.') p++;
+
+		conv->length = p;
+
+		for (;; p++) {
+			if (*p == 'l' || *p == 'q') {
+				conv->size = conv->size == 1 ? 2 : (*p == 'q' ? 2 : 1);
+			} else if (*p == 'z' || *p == 't') {
+				conv->size = 3;
+			} else if (*p == 'j') {
+				conv->size = 4;
+			} else if (*p == 'L') {
+				conv->size = 5;
+			} else if (*p != 'h') {
+				break;
+			}
+		}
+
+		conv->conv = *p;
+
+		switch (*p) {
+		case 'd':
+		case 'i':
+		case 'c':
+			conv->type = TRACE_CONV_INT;
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			conv->type = TRACE_CONV_UINT;
+			break;
+		case 's':
+			conv->type = TRACE_CONV_STR;
+			break;
+		case 'p':
+			conv->type = TRACE_CONV_PTR;
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			conv->type = TRACE_CONV_DOUBLE;
+			break;
+		default:
+			/* '*' widths, %n and anything else we don't know */
+			return NULL;
+		}
+
+		return p + 1;
 	}
-	THREAD_RUNNING = 1;
 
-	while (THREAD_RUNNING == 1) {
+	return NULL;
+}
+
+/* pull the first few numbers off the arguments, strings only hold their place */
+static uint8_t log_trace_args(const char *fmt, va_list ap, int64_t *args)
+{
+	log_trace_conv_t conv;
+	const char *p = fmt;
+	uint8_t n = 0;
+
+	while (n < SWITCH_LOG_TRACE_ARGS && (p = log_trace_next_conv(p, &conv))) {
+		switch (conv.type) {
+		case TRACE_CONV_INT:
+			switch (conv.size) {
+			case 1: args[n] = va_arg(ap, long); break;
+			case 2: args[n] = va_arg(ap, long long); break;
+			case 3: args[n] = va_arg(ap, intptr_t); break;
+			case 4: args[n] = va_arg(ap, intmax_t); break;
+			default: args[n] = va_arg(ap, int); break;
+			}
+			break;
+		case TRACE_CONV_UINT:
+			switch (conv.size) {
+			case 1: args[n] = (int64_t) va_arg(ap, unsigned long); break;
+			case 2: args[n] = (int64_t) va_arg(ap, unsigned long long); break;
+			case 3: args[n] = (int64_t) va_arg(ap, size_t); break;
+			case 4: args[n] = (int64_t) va_arg(ap, uintmax_t); break;
+			default: args[n] = va_arg(ap, unsigned int); break;
+			}
+			break;
+		case TRACE_CONV_STR:
+		case TRACE_CONV_PTR:
+			args[n] = (int64_t) (intptr_t) va_arg(ap, void *);
+			break;
+		case TRACE_CONV_DOUBLE:
+			{
+				double d = conv.size == 5 ? (double) va_arg(ap, long double) : va_arg(ap, double);
+				memcpy(&args[n], &d, sizeof(d));
+			}
+			break;
+		}
+		n++;
+	}
+
+	return n;
+}
+
+static uint32_t log_trace_site(const char *file, const char *func, int line, const char *fmt)
+{
+	uint32_t hash = (uint32_t) (((uintptr_t) fmt >> 3) ^ ((uint32_t) line * 0x9e3779b1));
+	uint32_t i;
+
+	for (i = 0; i < SWITCH_LOG_TRACE_PROBES; i++) {
+		uint32_t slot = (hash + i) & (SWITCH_LOG_TRACE_SITES - 1);
+		log_trace_site_t *site = &TRACE_SITES[slot];
+		uint32_t found = 0;
+
+		if (site->key == fmt && site->line == line) {
+			return slot + 1;
+		}
+
+		if (site->key) {
+			continue;
+		}
+
+		switch_mutex_lock(TRACE_MUTEX);
+		if (!site->key) {
+			site->line = line;
+			site->file = strdup(file);
+			site->func = strdup(func);
+			site->fmt = strdup(fmt);
+			site->key = fmt;
+			found = slot + 1;
+		} else if (site->key == fmt && site->line == line) {
+			found = slot + 1;
+		}
+		switch_mutex_unlock(TRACE_MUTEX);
+
+		if (found) {
+			return found;
+		}
+	}
+
+	return 0;
+}
+
+static void log_trace(switch_text_channel_t channel, const char *file, const char *func, int line, const char *userdata,
+					  switch_log_level_t level, switch_time_t now, const char *fmt, va_list ap)
+{
+	log_trace_ring_t *ring = &TRACE_RINGS[switch_core_thread_shard(SWITCH_LOG_SHARDS)];
+	log_trace_record_t *rec;
+	uint32_t pos;
+
+	if (!fmt) {
+		return;
+	}
+
+	pos = switch_atomic_fetch_inc(&ring->head);
+	rec = &ring->records[pos & (TRACE_RECORDS - 1)];
+
+	rec->seq = 0;
+	rec->timestamp = now;
+	rec->site = log_trace_site(file, func, line, fmt);
+	rec->session = (channel == SWITCH_CHANNEL_ID_SESSION && userdata) ? (uint32_t) ((switch_core_session_t *) userdata)->id : 0;
+	rec->level = (int16_t) level;
+	rec->nargs = log_trace_args(fmt, ap, rec->args);
+	rec->seq = pos + 1;
+}
+
+/* only plain write() from here down to log_trace_write(), it runs in the crash handler too */
+static int log_trace_write_all(int fd, const void *data, size_t len)
+{
+	const char *p = (const char *) data;
+
+	while (len) {
+		int r = write(fd, p, (unsigned int) len);
+
+		if (r <= 0) {
+			return -1;
+		}
+
+		p += r;
+		len -= r;
+	}
+
+	return 0;
+}
+
+static int log_trace_write(int fd)
+{
+	log_trace_header_t header;
+	uint32_t i, end[5] = { 0 };
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SWITCH_LOG_TRACE_MAGIC, sizeof(header.magic));
+	header.record_size = sizeof(log_trace_record_t);
+	header.rings = SWITCH_LOG_SHARDS;
+	header.records = TRACE_RECORDS;
+
+	if (log_trace_write_all(fd, &header, sizeof(header))) {
+		return -1;
+	}
+
+	/* the call sites: id, line and the lengths of file, func and fmt, then the strings */
+	for (i = 0; i < SWITCH_LOG_TRACE_SITES; i++) {
+		log_trace_site_t *site = &TRACE_SITES[i];
+		uint32_t head[5];
+
+		if (!site->key) {
+			continue;
+		}
+
+		head[0] = i + 1;
+		head[1] = (uint32_t) site->line;
+		head[2] = (uint32_t) strlen(site->file);
+		head[3] = (uint32_t) strlen(site->func);
+		head[4] = (uint32_t) strlen(site->fmt);
+
+		if (log_trace_write_all(fd, head, sizeof(head)) || log_trace_write_all(fd, site->file, head[2]) ||
+			log_trace_write_all(fd, site->func, head[3]) || log_trace_write_all(fd, site->fmt, head[4])) {
+			return -1;
+		}
+	}
+
+	if (log_trace_write_all(fd, end, sizeof(end))) {
+		return -1;
+	}
+
+	for (i = 0; i < SWITCH_LOG_SHARDS; i++) {
+		if (log_trace_write_all(fd, TRACE_RINGS[i].records, TRACE_RECORDS * sizeof(log_trace_record_t))) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+#ifndef WIN32
+static void log_trace_crash(int sig)
+{
+	int fd;
+
+	if ((fd = open(TRACE_CRASH_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0640)) > -1) {
+		log_trace_write(fd);
+		close(fd);
+	}
+
+	/* SA_RESETHAND put the default action back, so this dumps core as usual */
+	raise(sig);
+}
+#endif
+
+SWITCH_DECLARE(switch_status_t) switch_log_trace_init(uint32_t records)
+{
+	uint32_t size = 1, i;
+
+	if (TRACE_RECORDS || !records || !TRACE_MUTEX) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	while (size < records && size < (1 << 24)) {
+		size <<= 1;
+	}
+
+	TRACE_SITES = calloc(SWITCH_LOG_TRACE_SITES, sizeof(*TRACE_SITES));
+	switch_assert(TRACE_SITES);
+
+	for (i = 0; i < SWITCH_LOG_SHARDS; i++) {
+		TRACE_RINGS[i].records = calloc(size, sizeof(log_trace_record_t));
+		switch_assert(TRACE_RINGS[i].records);
+	}
+
+	switch_snprintf(TRACE_CRASH_PATH, sizeof(TRACE_CRASH_PATH), "%s%sfreeswitch.crash.trace", SWITCH_GLOBAL_dirs.log_dir, SWITCH_PATH_SEPARATOR);
+
+	TRACE_RECORDS = size;
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Log trace keeping %u records on each of %d rings\n", size, SWITCH_LOG_SHARDS);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_log_trace_crash_handler(void)
+{
+#ifndef WIN32
+	int sigs[] = { SIGSEGV, SIGABRT, SIGFPE };
+	struct sigaction sa, old;
+	int i;
+
+	if (!TRACE_RECORDS) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = log_trace_crash;
+	sa.sa_flags = SA_RESETHAND;
+	sigemptyset(&sa.sa_mask);
+
+	for (i = 0; i < (int) (sizeof(sigs) / sizeof(sigs[0])); i++) {
+		/* leave alone whatever a debugger or sanitizer put there */
+		if (sigaction(sigs[i], NULL, &old) || old.sa_handler != SIG_DFL) {
+			continue;
+		}
+		sigaction(sigs[i], &sa, NULL);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+#else
+	return SWITCH_STATUS_FALSE;
+#endif
+}
+
+SWITCH_DECLARE(switch_status_t) switch_log_trace_dump(const char *path)
+{
+	int fd, r;
+
+	if (!TRACE_RECORDS || zstr(path)) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0640)) < 0) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_mutex_lock(TRACE_MUTEX);
+	r = log_trace_write(fd);
+	switch_mutex_unlock(TRACE_MUTEX);
+
+	close(fd);
+
+	return r ? SWITCH_STATUS_FALSE : SWITCH_STATUS_SUCCESS;
+}
+
+static int log_trace_record_cmp(const void *a, const void *b)
+{
+	const log_trace_record_t *ra = *(const log_trace_record_t **) a;
+	const log_trace_record_t *rb = *(const log_trace_record_t **) b;
+
+	if (ra->timestamp != rb->timestamp) {
+		return ra->timestamp < rb->timestamp ? -1 : 1;
+	}
+
+	return ra->seq < rb->seq ? -1 : (ra->seq > rb->seq);
+}
+
+/* print one record through its call site's format, conversions we didn't capture are left as they were */
+static void log_trace_format(switch_stream_handle_t *stream, const char *fmt, const log_trace_record_t *rec)
+{
+	log_trace_conv_t conv;
+	const char *p = fmt, *next;
+	uint8_t n = 0;
+
+	while (n < rec->nargs && (next = log_trace_next_conv(p, &conv))) {
+		const char *q;
+		char spec[64], buf[256];
+		int64_t arg = rec->args[n++];
+		size_t flags = conv.length - conv.start;
+
+		for (q = p; q < conv.start; q++) {
+			if (*q == '%' && *(q + 1) == '%') {
+				q++;
+			}
+			stream->write_function(stream, "%c", *q);
+		}
+
+		if (flags > sizeof(spec) - 4) {
+			flags = sizeof(spec) - 4;
+		}
+		memcpy(spec, conv.start, flags);
+
+		switch (conv.type) {
+		case TRACE_CONV_INT:
+			if (conv.conv == 'c') {
+				switch_snprintf(spec + flags, sizeof(spec) - flags, "c");
+				switch_snprintf(buf, sizeof(buf), spec, (int) arg);
+			} else {
+				switch_snprintf(spec + flags, sizeof(spec) - flags, "ll%c", conv.conv);
+				switch_snprintf(buf, sizeof(buf), spec, (long long) arg);
+			}
+			break;
+		case TRACE_CONV_UINT:
+			switch_snprintf(spec + flags, sizeof(spec) - flags, "ll%c", conv.conv);
+			switch_snprintf(buf, sizeof(buf), spec, (unsigned long long) arg);
+			break;
+		case TRACE_CONV_STR:
+			switch_snprintf(spec + flags, sizeof(spec) - flags, "s");
+			switch_snprintf(buf, sizeof(buf), spec, "(str)");
+			break;
+		case TRACE_CONV_PTR:
+			switch_snprintf(buf, sizeof(buf), "%p", (void *) (intptr_t) arg);
+			break;
+		case TRACE_CONV_DOUBLE:
+			{
+				double d;
+				memcpy(&d, &arg, sizeof(d));
+				switch_snprintf(spec + flags, sizeof(spec) - flags, "%c", conv.conv);
+				switch_snprintf(buf, sizeof(buf), spec, d);
+			}
+			break;
+		}
+
+		stream->write_function(stream, "%s", buf);
+		p = next;
+	}
+
+	stream->write_function(stream, "%s", p);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_log_trace_decode(const char *path, switch_stream_handle_t *stream)
+{
+	log_trace_header_t header;
+	log_trace_site_t *sites = NULL;
+	log_trace_record_t *records = NULL, **sorted = NULL;
+	switch_status_t status = SWITCH_STATUS_FALSE;
+	size_t total, count = 0, i;
+	FILE *f;
+
+	if (zstr(path) || !(f = fopen(path, "rb"))) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, SWITCH_LOG_TRACE_MAGIC, sizeof(header.magic)) ||
+		header.record_size != sizeof(log_trace_record_t) || !header.rings || header.rings > 1024 || !header.records || header.records > (1 << 24)) {
+		stream->write_function(stream, "-ERR %s is not a trace from this build\n", path);
+		goto end;
+	}
+
+	sites = calloc(SWITCH_LOG_TRACE_SITES, sizeof(*sites));
+	switch_assert(sites);
+
+	for (;;) {
+		uint32_t head[5];
+		log_trace_site_t *site;
+
+		if (fread(head, sizeof(head), 1, f) != 1 || head[0] > SWITCH_LOG_TRACE_SITES) {
+			stream->write_function(stream, "-ERR %s is truncated\n", path);
+			goto end;
+		}
+
+		if (!head[0]) {
+			break;
+		}
+
+		site = &sites[head[0] - 1];
+		site->line = (int) head[1];
+		site->file = calloc(1, head[2] + 1);
+		site->func = calloc(1, head[3] + 1);
+		site->fmt = calloc(1, head[4] + 1);
+		switch_assert(site->file && site->func && site->fmt);
+
+		if ((head[2] && fread(site->file, head[2], 1, f) != 1) || (head[3] && fread(site->func, head[3], 1, f) != 1) ||
+			(head[4] && fread(site->fmt, head[4], 1, f) != 1)) {
+			stream->write_function(stream, "-ERR %s is truncated\n", path);
+			goto end;
+		}
+	}
+
+	total = (size_t) header.rings * header.records;
+	records = malloc(total * sizeof(*records));
+	sorted = malloc(total * sizeof(*sorted));
+	switch_assert(records && sorted);
+
+	if (fread(records, sizeof(*records), total, f) != total) {
+		stream->write_function(stream, "-ERR %s is truncated\n", path);
+		goto end;
+	}
+
+	for (i = 0; i < total; i++) {
+		if (records[i].seq) {
+			sorted[count++] = &records[i];
+		}
+	}
+
+	qsort(sorted, count, sizeof(*sorted), log_trace_record_cmp);
+
+	for (i = 0; i < count; i++) {
+		log_trace_record_t *rec = sorted[i];
+		log_trace_site_t *site = (rec->site && rec->site <= SWITCH_LOG_TRACE_SITES) ? &sites[rec->site - 1] : NULL;
+		switch_time_exp_t tm;
+		char date[80] = "";
+
+		switch_time_exp_lt(&tm, rec->timestamp);
+		switch_snprintf(date, sizeof(date), "%0.4d-%0.2d-%0.2d %0.2d:%0.2d:%0.2d.%0.6d",
+						tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, tm.tm_usec);
+
+		if (!site || !site->fmt) {
+			stream->write_function(stream, "%s [%s] unknown call site\n", date, switch_log_level2str(rec->level));
+			continue;
+		}
+
+		stream->write_function(stream, "%s [%s] %s:%d %s()", date, switch_log_level2str(rec->level), site->file, site->line, site->func);
+		if (rec->session) {
+			stream->write_function(stream, " [session %u]", rec->session);
+		}
+		stream->write_function(stream, " ");
+		log_trace_format(stream, site->fmt, rec);
+		if (!*site->fmt || site->fmt[strlen(site->fmt) - 1] != '\n') {
+			stream->write_function(stream, "\n");
+		}
+	}
+
+	status = SWITCH_STATUS_SUCCESS;
+
+  end:
+
+	if (sites) {
+		for (i = 0; i < SWITCH_LOG_TRACE_SITES; i++) {
+			switch_safe_free(sites[i].file);
+			switch_safe_free(sites[i].func);
+			switch_safe_free(sites[i].fmt);
+		}
+		free(sites);
+	}
+	switch_safe_free(records);
+	switch_safe_free(sorted);
+	fclose(f);
+
+	return status;
+}
+
+/* hand whatever is queued to the loggers, returns the number of lines */
+static uint32_t log_drain(void)
+{
+	switch_log_node_t *batch[SWITCH_LOG_SHARDS][SWITCH_LOG_BATCH];
+	uint32_t count[SWITCH_LOG_SHARDS] = { 0 }, pos[SWITCH_LOG_SHARDS] = { 0 };
+	uint32_t i, total = 0;
+	switch_log_binding_t *binding;
+
+	for (i = 0; i < SWITCH_LOG_SHARDS; i++) {
 		void *pop = NULL;
+
+		while (count[i] < SWITCH_LOG_BATCH && switch_queue_trypop(LOG_QUEUES[i], &pop) == SWITCH_STATUS_SUCCESS) {
+			if (pop) {
+				batch[i][count[i]++] = (switch_log_node_t *) pop;
+			}
+		}
+
+		total += count[i];
+	}
+
+	if (!total) {
+		return 0;
+	}
+
+	switch_mutex_lock(BINDLOCK);
+
+	for (;;) {
 		switch_log_node_t *node = NULL;
-		switch_log_binding_t *binding;
+		uint32_t shard = 0;
 
-		if (switch_queue_pop(LOG_QUEUE, &pop) != SWITCH_STATUS_SUCCESS) {
-			break;
+		/* each queue is in order already, merge them back into one stream by timestamp */
+		for (i = 0; i < SWITCH_LOG_SHARDS; i++) {
+			if (pos[i] < count[i] && (!node || batch[i][pos[i]]->timestamp < node->timestamp)) {
+				node = batch[i][pos[i]];
+				shard = i;
+			}
 		}
 
-		if (!pop) {
-			THREAD_RUNNING = -1;
+		if (!node) {
 			break;
 		}
 
-		node = (switch_log_node_t *) pop;
-		switch_mutex_lock(BINDLOCK);
+		pos[shard]++;
+
 		node->sequence = ++log_sequence;
 		for (binding = BINDINGS; binding; binding = binding->next) {
 			if (binding->level >= node->level) {
 				binding->function(node, node->level);
 			}
 		}
-		switch_mutex_unlock(BINDLOCK);
 
 		switch_log_node_free(&node);
+	}
+
+	for (binding = BINDINGS; binding; binding = binding->next) {
+		if (binding->flush) {
+			binding->flush();
+		}
+	}
+
+	switch_mutex_unlock(BINDLOCK);
+
+	LOG_DELIVERED += total;
 
+	return total;
+}
+
+static void *SWITCH_THREAD_FUNC log_thread(switch_thread_t *t, void *obj)
+{
+	uint32_t reported = 0;
+	switch_time_t last_report = 0;
+
+	if (!obj) {
+		obj = NULL;
+	}
+	THREAD_RUNNING = 1;
+
+	while (THREAD_RUNNING == 1) {
+		uint32_t dropped = LOG_DROPPED;
+
+		if (dropped != reported) {
+			switch_time_t now = switch_micro_time_now();
+
+			if (now - last_report >= 1000000) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Dropped %u log lines, the log queues are full\n", dropped - reported);
+				reported = dropped;
+				last_report = now;
+			}
+		}
+
+		if (log_drain()) {
+			continue;
+		}
+
+		if (LOG_STOP) {
+			break;
+		}
+
+		/* producers ring the doorbell once they see us idle, look again after raising the flag so nothing is missed */
+		LOG_IDLE = 1;
+		if (!log_drain()) {
+			void *pop = NULL;
+			switch_queue_pop_timeout(LOG_DOORBELL, &pop, 100000);
+		}
+		LOG_IDLE = 0;
 	}
 
 	THREAD_RUNNING = 0;
@@ -545,7 +1304,7 @@ SWITCH_DECLARE(void) switch_log_printf(switch_text_channel_t channel, const char
 	va_end(ap);
 }
 
-#define do_mods (LOG_QUEUE && THREAD_RUNNING)
+#define do_mods (LOG_QUEUES[0] && THREAD_RUNNING)
 SWITCH_DECLARE(void) switch_log_vprintf(switch_text_channel_t channel, const char *file, const char *func, int line,
 										const char *userdata, switch_log_level_t level, const char *fmt, va_list ap)
 {
@@ -571,6 +1330,7 @@ SWITCH_DECLARE(void) switch_log_meta_vprintf(switch_text_channel_t channel, cons
 #endif
 	switch_log_level_t limit_level = runtime.hard_log_level;
 	switch_log_level_t special_level = SWITCH_LOG_UNINIT;
+	int wanted;
 
 	if (meta && *meta) {
 		log_meta = *meta;
@@ -598,11 +1358,24 @@ SWITCH_DECLARE(void) switch_log_meta_vprintf(switch_text_channel_t channel, cons
 	}
 
 	if (level > limit_level) {
+		if (TRACE_RECORDS) {
+			log_trace(channel, filep, funcp, line, userdata, level, now, fmt, ap);
+		}
 		goto end;
 	}
 
 	switch_assert(level < SWITCH_LOG_INVALID);
 
+	wanted = (int) level <= MAX_LEVEL || (special_level != SWITCH_LOG_UNINIT && level <= special_level);
+
+	/* no logger is going to look at it, don't bother formatting it */
+	if (!wanted && channel != SWITCH_CHANNEL_ID_EVENT && console_mods_loaded && do_mods) {
+		if (TRACE_RECORDS) {
+			log_trace(channel, filep, funcp, line, userdata, level, now, fmt, ap);
+		}
+		goto end;
+	}
+
 	handle = switch_core_data_channel(channel);
 
 	if (channel != SWITCH_CHANNEL_ID_LOG_CLEAN) {
@@ -703,7 +1476,7 @@ SWITCH_DECLARE(void) switch_log_meta_vprintf(switch_text_channel_t channel, cons
 		}
 	}
 
-	if (do_mods && level <= MAX_LEVEL) {
+	if (do_mods && wanted) {
 		switch_log_node_t *node = switch_log_node_alloc();
 
 		node->data = data;
@@ -729,8 +1502,11 @@ SWITCH_DECLARE(void) switch_log_meta_vprintf(switch_text_channel_t channel, cons
 			node->userdata = !zstr(userdata) ? strdup(userdata) : NULL;
 		}
 
-		if (switch_queue_trypush(LOG_QUEUE, node) != SWITCH_STATUS_SUCCESS) {
+		if (switch_queue_trypush(LOG_QUEUES[switch_core_thread_shard(SWITCH_LOG_SHARDS)], node) != SWITCH_STATUS_SUCCESS) {
+			switch_atomic_inc(&LOG_DROPPED);
 			switch_log_node_free(&node);
+		} else if (LOG_IDLE) {
+			switch_queue_trypush(LOG_DOORBELL, (void *) &LOG_DOORBELL);
 		}
 	}
 
@@ -744,7 +1520,8 @@ SWITCH_DECLARE(void) switch_log_meta_vprintf(switch_text_channel_t channel, cons
 
 SWITCH_DECLARE(switch_status_t) switch_log_init(switch_memory_pool_t *pool, switch_bool_t colorize)
 {
-	switch_threadattr_t *thd_attr;;
+	switch_threadattr_t *thd_attr;
+	int i;
 
 	switch_assert(pool != NULL);
 
@@ -752,7 +1529,12 @@ SWITCH_DECLARE(switch_status_t) switch_log_init(switch_memory_pool_t *pool, swit
 
 	switch_threadattr_create(&thd_attr, LOG_POOL);
 
-	switch_queue_create(&LOG_QUEUE, SWITCH_CORE_QUEUE_LEN, LOG_POOL);
+	for (i = 0; i < SWITCH_LOG_SHARDS; i++) {
+		switch_queue_create(&LOG_QUEUES[i], SWITCH_CORE_QUEUE_LEN / SWITCH_LOG_SHARDS, LOG_POOL);
+	}
+	switch_queue_create(&LOG_DOORBELL, 1, LOG_POOL);
+	switch_mutex_init(&TRACE_MUTEX, SWITCH_MUTEX_NESTED, LOG_POOL);
+	LOG_STOP = 0;
 #ifdef SWITCH_LOG_RECYCLE
 	switch_queue_create(&LOG_RECYCLE_QUEUE, SWITCH_CORE_QUEUE_LEN, LOG_POOL);
 #endif
@@ -801,7 +1583,8 @@ SWITCH_DECLARE(switch_status_t) switch_log_shutdown(void)
 	switch_status_t st;
 
 
-	switch_queue_push(LOG_QUEUE, NULL);
+	LOG_STOP = 1;
+	switch_queue_trypush(LOG_DOORBELL, (void *) &LOG_DOORBELL);
 	while (THREAD_RUNNING) {
 		switch_cond_next();
 	}
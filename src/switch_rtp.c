@@ -32,6 +32,7 @@
  *
  */
 #include <switch.h>
+#include "private/switch_core_pvt.h"
 #ifndef _MSC_VER
 #include <switch_private.h>
 #endif
@@ -280,6 +281,8 @@ static void switch_rtp_dtls_destroy();
 #define MAX_DTLS_MTU 4096
 
 typedef struct switch_dtls_s {
+	/* must be first, the handshake worker pool hands this back */
+	switch_worker_job_t job;
 	/* DTLS */
 	SSL_CTX *ssl_ctx;
 	SSL *ssl;
@@ -302,6 +305,17 @@ typedef struct switch_dtls_s {
 	char *pem;
 	struct switch_rtp *rtp_session;
 	int mtu;
+	/* handshake offload, the worker owns ssl and the bios while busy is set */
+	switch_mutex_t *inbox_mutex;
+	switch_buffer_t *inbox;
+	volatile switch_atomic_t busy;
+	int handshake_result;
+	int handshake_err;
+	/* setup timing, folded into the session stats once the keys are in */
+	switch_time_t ice_ready;
+	switch_time_t handshake_usec;
+	switch_time_t queue_usec;
+	uint32_t rounds;
 } switch_dtls_t;
 
 typedef int (*dtls_state_handler_t)(switch_rtp_t *, switch_dtls_t *);
@@ -812,6 +826,8 @@ static handle_rfc2833_result_t handle_rfc2833(switch_rtp_t *rtp_session, switch_
 
 static int rtp_write_ready(switch_rtp_t *rtp_session, uint32_t bytes, int line);
 static int global_init = 0;
+static switch_metric_t *rtp_rx_metric = NULL;
+static switch_metric_t *rtp_tx_metric = NULL;
 static int rtp_common_write(switch_rtp_t *rtp_session,
 							rtp_msg_t *send_msg, void *data, uint32_t datalen, switch_payload_t payload, uint32_t timestamp, switch_frame_flag_t *flags);
 
@@ -1589,6 +1605,8 @@ SWITCH_DECLARE(void) switch_rtp_init(switch_memory_pool_t *pool)
 #endif
 	switch_mutex_init(&port_lock, SWITCH_MUTEX_NESTED, pool);
 	switch_rtp_dtls_init();
+	switch_core_metric_register("freeswitch_rtp_packets_received_total", NULL, "RTP packets received", SWITCH_METRIC_COUNTER, &rtp_rx_metric);
+	switch_core_metric_register("freeswitch_rtp_packets_sent_total", NULL, "RTP packets sent", SWITCH_METRIC_COUNTER, &rtp_tx_metric);
 	global_init = 1;
 }
 
@@ -3373,6 +3391,19 @@ static int dtls_state_setup(switch_rtp_t *rtp_session, switch_dtls_t *dtls)
 
 	dtls_set_state(dtls, DS_READY);
 
+	if (dtls->ice_ready) {
+		switch_time_t ice_to_dtls = switch_time_ref() - dtls->ice_ready;
+
+		switch_core_latency_record(rtp_session->session, SWITCH_LATENCY_ICE_TO_DTLS, ice_to_dtls);
+
+		if (dtls == rtp_session->dtls) {
+			rtp_session->stats.setup.ice_to_dtls_usec = ice_to_dtls;
+			rtp_session->stats.setup.dtls_handshake_usec = dtls->handshake_usec;
+			rtp_session->stats.setup.dtls_queue_usec = dtls->queue_usec;
+			rtp_session->stats.setup.dtls_rounds = dtls->rounds;
+		}
+	}
+
 	return 0;
 }
 
@@ -3404,30 +3435,181 @@ static int dtls_state_fail(switch_rtp_t *rtp_session, switch_dtls_t *dtls)
 }
 
 
-static int dtls_state_handshake(switch_rtp_t *rtp_session, switch_dtls_t *dtls)
+/* feed what arrived to openssl and advance the handshake, safe to run off the media thread */
+static void dtls_handshake_step(switch_dtls_t *dtls)
 {
+	unsigned char buf[MAX_DTLS_MTU];
+	switch_size_t len;
+	switch_time_t start = switch_time_ref();
 	int ret;
 
-	if ((ret = SSL_do_handshake(dtls->ssl)) != 1){
-		switch((ret = SSL_get_error(dtls->ssl, ret))){
+	if (dtls->inbox) {
+		switch_mutex_lock(dtls->inbox_mutex);
+		while ((len = switch_buffer_read(dtls->inbox, buf, sizeof(buf))) > 0) {
+			if ((ret = BIO_write(dtls->read_bio, buf, (int) len)) != (int) len) {
+				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(dtls->rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet decode err: wrote %d bytes instead of %d\n",
+								  rtp_type(dtls->rtp_session), ret, (int) len);
+			}
+		}
+		switch_mutex_unlock(dtls->inbox_mutex);
+	}
+
+	if ((ret = SSL_do_handshake(dtls->ssl)) != 1) {
+		switch((ret = SSL_get_error(dtls->ssl, ret))) {
 		case SSL_ERROR_WANT_READ:
 		case SSL_ERROR_WANT_WRITE:
 		case SSL_ERROR_NONE:
 			break;
 		default:
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_WARNING, "%s Handshake failure %d. This may happen when you use legacy DTLS v1.0 (legacyDTLS channel var is set) but endpoint requires DTLS v1.2.\n", rtp_type(rtp_session), ret);
-			dtls_set_state(dtls, DS_FAIL);
-			return -1;
+			dtls->handshake_err = ret;
+			dtls->handshake_result = -1;
+			break;
 		}
 	}
 
-	if (SSL_is_init_finished(dtls->ssl)) {
+	if (!dtls->handshake_result && SSL_is_init_finished(dtls->ssl)) {
+		dtls->handshake_result = 1;
+	}
+
+	dtls->handshake_usec += switch_time_ref() - start;
+	dtls->rounds++;
+}
+
+static int dtls_state_handshake(switch_rtp_t *rtp_session, switch_dtls_t *dtls)
+{
+	if (!dtls->handshake_result) {
+		dtls_handshake_step(dtls);
+	}
+
+	if (dtls->handshake_result < 0) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_WARNING, "%s Handshake failure %d. This may happen when you use legacy DTLS v1.0 (legacyDTLS channel var is set) but endpoint requires DTLS v1.2.\n", rtp_type(rtp_session), dtls->handshake_err);
+		dtls_set_state(dtls, DS_FAIL);
+		return -1;
+	}
+
+	if (dtls->handshake_result > 0) {
 		dtls_set_state(dtls, DS_SETUP);
 	}
 
 	return 0;
 }
 
+/* send what openssl produced */
+static void dtls_flush(switch_rtp_t *rtp_session, switch_dtls_t *dtls)
+{
+	unsigned char buf[MAX_DTLS_MTU] = "";
+	switch_size_t bytes;
+	int pending, len, ret;
+
+	while ((pending = BIO_ctrl_pending(dtls->filter_bio)) > 0) {
+		switch_assert(pending <= sizeof(buf));
+
+		len = BIO_read(dtls->write_bio, buf, pending);
+		if (len > 0) {
+			bytes = len;
+			ret = switch_socket_sendto(dtls->sock_output, dtls->remote_addr, 0, (void *)buf, &bytes);
+
+			if (ret != SWITCH_STATUS_SUCCESS) {
+				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet not written to socket: %d\n", rtp_type(rtp_session), ret);
+			} else if (bytes != len) {
+				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet write err: written %d bytes instead of %d\n", rtp_type(rtp_session), (int)bytes, len);
+			}
+		} else {
+			ret = SSL_get_error(dtls->ssl, len);
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet encode err: SSL err %d\n", rtp_type(rtp_session), ret);
+		}
+	}
+}
+
+/*
+ * DTLS handshake workers.  With dtls-handshake-threads set, the media thread only
+ * copies handshake datagrams into the inbox and queues a round on the core worker
+ * pool; a worker feeds them to openssl, runs SSL_do_handshake (where the key exchange
+ * and signatures happen) and sends the reply flight.  A dtls has at most one round
+ * queued, the media thread picks up the result and runs the rest of the state machine itself.
+ */
+#define DTLS_OFFLOAD_QUEUE_LEN 4096
+/* what a dtls may hold of handshake datagrams not yet fed to openssl */
+#define DTLS_INBOX_MAX (MAX_DTLS_MTU * 16)
+
+/* set up once by switch_rtp_dtls_offload_start() and never changed after, the pool outlives its stop */
+static struct {
+	switch_worker_pool_t *pool;
+	volatile switch_atomic_t inline_rounds;
+} dtls_offload;
+
+static void dtls_offload_callback(switch_worker_job_t *job, void *user_data)
+{
+	switch_dtls_t *dtls = (switch_dtls_t *) job;
+	switch_time_t begin = switch_time_ref();
+
+	dtls->queue_usec += job->waited;
+
+	dtls_handshake_step(dtls);
+	dtls_flush(dtls->rtp_session, dtls);
+
+	switch_core_latency_record(dtls->rtp_session->session, SWITCH_LATENCY_DTLS_QUEUE, job->waited);
+	switch_core_latency_record(dtls->rtp_session->session, SWITCH_LATENCY_DTLS_HANDSHAKE, switch_time_ref() - begin);
+
+	/* the dtls may be freed as soon as this is clear */
+	switch_atomic_set(&dtls->busy, 0);
+}
+
+switch_status_t switch_rtp_dtls_offload_start(int threads)
+{
+	if (dtls_offload.pool || threads < 1) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (switch_worker_pool_create(&dtls_offload.pool, "DTLS", threads, DTLS_OFFLOAD_QUEUE_LEN, -1, SWITCH_PRI_NORMAL,
+								  dtls_offload_callback, NULL) != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "DTLS handshakes offloaded to %d workers\n", threads);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+void switch_rtp_dtls_offload_stop(void)
+{
+	/* new rounds run inline from here on, the queued ones finish before the workers exit */
+	switch_worker_pool_stop(dtls_offload.pool);
+}
+
+/* queue a handshake round, SWITCH_STATUS_SUCCESS while the workers have it, SWITCH_STATUS_FALSE to run it here */
+static switch_status_t dtls_offload_submit(switch_dtls_t *dtls)
+{
+	if (switch_atomic_read(&dtls->busy)) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (dtls->handshake_result) {
+		/* a worker finished it, the state machine goes on here */
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_atomic_set(&dtls->busy, 1);
+
+	/* rounds of one dtls never overlap, so any worker will do */
+	if (switch_worker_pool_push(dtls_offload.pool, SWITCH_WORKER_ANY, &dtls->job) == SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_atomic_set(&dtls->busy, 0);
+	switch_atomic_inc(&dtls_offload.inline_rounds);
+
+	return SWITCH_STATUS_FALSE;
+}
+
+/* wait for the round a worker may still be running */
+static void dtls_offload_drain(switch_dtls_t *dtls)
+{
+	while (switch_atomic_read(&dtls->busy)) {
+		switch_cond_next();
+	}
+}
+
 static void free_dtls(switch_dtls_t **dtlsp)
 {
 	switch_dtls_t *dtls;
@@ -3439,60 +3621,80 @@ static void free_dtls(switch_dtls_t **dtlsp)
 	dtls = *dtlsp;
 	*dtlsp = NULL;
 
+	dtls_offload_drain(dtls);
+
 	if (dtls->ssl) {
 		SSL_free(dtls->ssl);
 	}
 
-	if (dtls->ssl_ctx) {
-		SSL_CTX_free(dtls->ssl_ctx);
+	/* ssl_ctx is shared, see dtls_ssl_new(), the SSL held its own reference */
+
+	if (dtls->inbox) {
+		switch_buffer_destroy(&dtls->inbox);
 	}
 }
 
 static int do_dtls(switch_rtp_t *rtp_session, switch_dtls_t *dtls)
 {
-	int r = 0, ret = 0, len;
-	switch_size_t bytes;
-	unsigned char buf[MAX_DTLS_MTU] = "";
+	int r = 0, ret = 0;
 	int ready = rtp_session->ice.ice_user ? (rtp_session->ice.rready && rtp_session->ice.ready) : 1;
-	int pending;
 
 	if (!dtls->bytes && !ready) {
 		return 0;
 	}
 
+	if (ready && !dtls->ice_ready) {
+		dtls->ice_ready = switch_time_ref();
+	}
+
 	if (dtls->bytes > 0 && dtls->data) {
-		ret = BIO_write(dtls->read_bio, dtls->data, (int)dtls->bytes);
-		if (ret <= 0) {
-			ret = SSL_get_error(dtls->ssl, ret);
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet decode err: SSL err %d\n", rtp_type(rtp_session), ret);
-		} else if (ret != (int)dtls->bytes) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet decode err: read %d bytes instead of %d\n", rtp_type(rtp_session), ret, (int)dtls->bytes);
+		if (dtls->inbox) {
+			switch_size_t w;
+
+			switch_mutex_lock(dtls->inbox_mutex);
+			w = switch_buffer_write(dtls->inbox, dtls->data, dtls->bytes);
+			switch_mutex_unlock(dtls->inbox_mutex);
+
+			if (!w) {
+				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_WARNING, "%s DTLS inbox full, dropped a %d byte datagram\n",
+								  rtp_type(rtp_session), (int)dtls->bytes);
+			}
+		} else {
+			ret = BIO_write(dtls->read_bio, dtls->data, (int)dtls->bytes);
+			if (ret <= 0) {
+				ret = SSL_get_error(dtls->ssl, ret);
+				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet decode err: SSL err %d\n", rtp_type(rtp_session), ret);
+			} else if (ret != (int)dtls->bytes) {
+				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet decode err: read %d bytes instead of %d\n", rtp_type(rtp_session), ret, (int)dtls->bytes);
+			}
 		}
 	}
 
-	if (dtls_states[dtls->state]) {
-		r = dtls_states[dtls->state](rtp_session, dtls);
+	if (dtls->inbox && dtls->state == DS_HANDSHAKE && dtls_offload_submit(dtls) == SWITCH_STATUS_SUCCESS) {
+		return 0;
 	}
 
-	while ((pending = BIO_ctrl_pending(dtls->filter_bio)) > 0) {
-		switch_assert(pending <= sizeof(buf));
-
-		len = BIO_read(dtls->write_bio, buf, pending);
-		if (len > 0) {
-			bytes = len;
-			ret = switch_socket_sendto(dtls->sock_output, dtls->remote_addr, 0, (void *)buf, &bytes);
+	if (dtls->inbox && dtls->state != DS_HANDSHAKE) {
+		/* anything after the handshake goes straight to openssl again */
+		unsigned char buf[MAX_DTLS_MTU];
+		switch_size_t len;
 
-			if (ret != SWITCH_STATUS_SUCCESS) {
-				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet not written to socket: %d\n", rtp_type(rtp_session), ret);
-			} else if (bytes != len) {
-				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet write err: written %d bytes instead of %d\n", rtp_type(rtp_session), (int)bytes, len);
+		switch_mutex_lock(dtls->inbox_mutex);
+		while ((len = switch_buffer_read(dtls->inbox, buf, sizeof(buf))) > 0) {
+			if ((ret = BIO_write(dtls->read_bio, buf, (int) len)) != (int) len) {
+				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet decode err: wrote %d bytes instead of %d\n",
+								  rtp_type(rtp_session), ret, (int) len);
 			}
-		} else {
-			ret = SSL_get_error(dtls->ssl, len);
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS packet encode err: SSL err %d\n", rtp_type(rtp_session), ret);
 		}
+		switch_mutex_unlock(dtls->inbox_mutex);
+	}
+
+	if (dtls_states[dtls->state]) {
+		r = dtls_states[dtls->state](rtp_session, dtls);
 	}
 
+	dtls_flush(rtp_session, dtls);
+
 	return r;
 }
 
@@ -3736,6 +3938,145 @@ static BIO_METHOD dtls_bio_filter_methods = {
 static BIO_METHOD *dtls_bio_filter_methods = NULL;
 #endif
 
+/*
+ * One SSL_CTX per certificate, key, ca bundle and role, loading and checking the
+ * cert and key is most of what a new context costs.  A context is rebuilt when the
+ * cert or key file changes on disk, sessions already set up keep their reference.
+ */
+typedef struct {
+	SSL_CTX *ssl_ctx;
+	time_t rsa_mtime;
+	time_t pvt_mtime;
+} dtls_ctx_entry_t;
+
+static struct {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_hash_t *hash;
+	uint32_t created;
+	uint32_t reused;
+} dtls_ctx_cache;
+
+static time_t dtls_file_mtime(const char *path)
+{
+	struct stat st;
+
+	if (stat(path, &st) != 0) {
+		return 0;
+	}
+
+	return st.st_mtime;
+}
+
+static SSL_CTX *dtls_ctx_create(switch_rtp_t *rtp_session, switch_dtls_t *dtls, const SSL_METHOD *ssl_method)
+{
+	SSL_CTX *ssl_ctx;
+	BIO *bio;
+	DH *dh;
+	int ret;
+
+	if (!(ssl_ctx = SSL_CTX_new(ssl_method))) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s SSL_CTX_new failed [%lu]\n", rtp_type(rtp_session), ERR_peek_error());
+		switch_channel_hangup(switch_core_session_get_channel(rtp_session->session), SWITCH_CAUSE_NORMAL_TEMPORARY_FAILURE);
+		return NULL;
+	}
+
+	bio = BIO_new_file(dtls->pem, "r");
+	dh = PEM_read_bio_DHparams(bio, NULL, NULL, NULL);
+	BIO_free(bio);
+	if (dh) {
+		SSL_CTX_set_tmp_dh(ssl_ctx, dh);
+		DH_free(dh);
+	}
+
+	SSL_CTX_set_mode(ssl_ctx, SSL_MODE_AUTO_RETRY);
+
+	//SSL_CTX_set_verify(ssl_ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
+	SSL_CTX_set_verify(ssl_ctx, SSL_VERIFY_NONE, NULL);
+
+	//SSL_CTX_set_cipher_list(ssl_ctx, "ECDH:!RC4:!SSLv3:RSA_WITH_AES_128_CBC_SHA");
+	//SSL_CTX_set_cipher_list(ssl_ctx, "ECDHE-RSA-AES256-GCM-SHA384");
+	SSL_CTX_set_cipher_list(ssl_ctx, "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
+	//SSL_CTX_set_cipher_list(ssl_ctx, "SUITEB128");
+	SSL_CTX_set_read_ahead(ssl_ctx, 1);
+#ifdef HAVE_OPENSSL_DTLS_SRTP
+	//SSL_CTX_set_tlsext_use_srtp(ssl_ctx, "SRTP_AES128_CM_SHA1_80:SRTP_AES128_CM_SHA1_32");
+	SSL_CTX_set_tlsext_use_srtp(ssl_ctx, "SRTP_AES128_CM_SHA1_80");
+#endif
+
+	if ((ret = SSL_CTX_use_certificate_file(ssl_ctx, dtls->rsa, SSL_FILETYPE_PEM)) != 1) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS cert err [%lu]\n", rtp_type(rtp_session), ERR_peek_error());
+		goto fail;
+	}
+
+	if ((ret = SSL_CTX_use_PrivateKey_file(ssl_ctx, dtls->pvt, SSL_FILETYPE_PEM)) != 1) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS key err [%lu]\n", rtp_type(rtp_session), ERR_peek_error());
+		goto fail;
+	}
+
+	if (SSL_CTX_check_private_key(ssl_ctx) == 0) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS check key failed\n", rtp_type(rtp_session));
+		goto fail;
+	}
+
+	if (!zstr(dtls->ca) && switch_file_exists(dtls->ca, rtp_session->pool) == SWITCH_STATUS_SUCCESS
+		&& (ret = SSL_CTX_load_verify_locations(ssl_ctx, dtls->ca, NULL)) != 1) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS check chain cert failed [%lu]\n",
+						  rtp_type(rtp_session), ERR_peek_error());
+		goto fail;
+	}
+
+	return ssl_ctx;
+
+ fail:
+
+	SSL_CTX_free(ssl_ctx);
+	return NULL;
+}
+
+/* find or build the context for this dtls and create its SSL from it */
+static switch_status_t dtls_ssl_new(switch_rtp_t *rtp_session, switch_dtls_t *dtls, const SSL_METHOD *ssl_method, uint8_t want_DTLSv1_2)
+{
+	dtls_ctx_entry_t *entry;
+	char key[1024];
+	time_t rsa_mtime = dtls_file_mtime(dtls->rsa), pvt_mtime = dtls_file_mtime(dtls->pvt);
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	switch_snprintf(key, sizeof(key), "%s|%d|%s|%s|%s", (dtls->type & DTLS_TYPE_SERVER) ? "server" : "client", want_DTLSv1_2, dtls->rsa, dtls->pvt, dtls->ca);
+
+	switch_mutex_lock(dtls_ctx_cache.mutex);
+
+	if (!(entry = switch_core_hash_find(dtls_ctx_cache.hash, key))) {
+		entry = switch_core_alloc(dtls_ctx_cache.pool, sizeof(*entry));
+		switch_core_hash_insert(dtls_ctx_cache.hash, key, entry);
+	}
+
+	if (entry->ssl_ctx && (entry->rsa_mtime != rsa_mtime || entry->pvt_mtime != pvt_mtime)) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_NOTICE, "%s DTLS certificate %s changed, reloading\n", rtp_type(rtp_session), dtls->rsa);
+		SSL_CTX_free(entry->ssl_ctx);
+		entry->ssl_ctx = NULL;
+	}
+
+	if (entry->ssl_ctx) {
+		dtls_ctx_cache.reused++;
+	} else if ((entry->ssl_ctx = dtls_ctx_create(rtp_session, dtls, ssl_method))) {
+		entry->rsa_mtime = rsa_mtime;
+		entry->pvt_mtime = pvt_mtime;
+		dtls_ctx_cache.created++;
+	} else {
+		switch_goto_status(SWITCH_STATUS_FALSE, end);
+	}
+
+	dtls->ssl_ctx = entry->ssl_ctx;
+	dtls->ssl = SSL_new(dtls->ssl_ctx);
+
+ end:
+
+	switch_mutex_unlock(dtls_ctx_cache.mutex);
+
+	return status;
+}
+
 static void switch_rtp_dtls_init() {
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
 	dtls_bio_filter_methods = BIO_meth_new(BIO_TYPE_FILTER | BIO_get_new_index(), "DTLS filter");
@@ -3744,15 +4085,57 @@ static void switch_rtp_dtls_init() {
 	BIO_meth_set_create(dtls_bio_filter_methods, dtls_bio_filter_new);
 	BIO_meth_set_destroy(dtls_bio_filter_methods, dtls_bio_filter_free);
 #endif
+
+	switch_core_new_memory_pool(&dtls_ctx_cache.pool);
+	switch_mutex_init(&dtls_ctx_cache.mutex, SWITCH_MUTEX_NESTED, dtls_ctx_cache.pool);
+	switch_core_hash_init(&dtls_ctx_cache.hash);
 }
 
 static void switch_rtp_dtls_destroy() {
+	switch_hash_index_t *hi;
+	const void *var;
+	void *val;
+
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
 	if (dtls_bio_filter_methods) {
 		BIO_meth_free(dtls_bio_filter_methods);
 		dtls_bio_filter_methods = NULL;
 	}
 #endif
+
+	if (!dtls_ctx_cache.hash) {
+		return;
+	}
+
+	for (hi = switch_core_hash_first(dtls_ctx_cache.hash); hi; hi = switch_core_hash_next(&hi)) {
+		dtls_ctx_entry_t *entry;
+
+		switch_core_hash_this(hi, &var, NULL, &val);
+		entry = (dtls_ctx_entry_t *) val;
+
+		if (entry->ssl_ctx) {
+			SSL_CTX_free(entry->ssl_ctx);
+		}
+	}
+
+	switch_core_hash_destroy(&dtls_ctx_cache.hash);
+	switch_core_destroy_memory_pool(&dtls_ctx_cache.pool);
+	memset(&dtls_ctx_cache, 0, sizeof(dtls_ctx_cache));
+}
+
+SWITCH_DECLARE(void) switch_rtp_dtls_offload_status(switch_stream_handle_t *stream)
+{
+	switch_mutex_lock(dtls_ctx_cache.mutex);
+	stream->write_function(stream, "ssl contexts: created=%u reused=%u\n", dtls_ctx_cache.created, dtls_ctx_cache.reused);
+	switch_mutex_unlock(dtls_ctx_cache.mutex);
+
+	if (!switch_worker_pool_running(dtls_offload.pool)) {
+		stream->write_function(stream, "handshake offload disabled, inline rounds=%u\n", switch_atomic_read(&dtls_offload.inline_rounds));
+		return;
+	}
+
+	stream->write_function(stream, "inline rounds=%u\n", switch_atomic_read(&dtls_offload.inline_rounds));
+	switch_worker_pool_status(dtls_offload.pool, stream);
 }
 
 ///////////
@@ -3871,14 +4254,9 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_add_dtls(switch_rtp_t *rtp_session, d
 {
 	switch_dtls_t *dtls;
 	const char *var;
-	int ret;
 	const char *kind = "";
 	unsigned long ssl_method_error = 0;
-	unsigned long ssl_ctx_error = 0;
 	const SSL_METHOD *ssl_method;
-	SSL_CTX *ssl_ctx;
-	BIO *bio;
-	DH *dh;
 	switch_status_t status = SWITCH_STATUS_SUCCESS;
 #ifndef OPENSSL_NO_EC
 #if OPENSSL_VERSION_NUMBER < 0x10002000L
@@ -3946,41 +4324,14 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_add_dtls(switch_rtp_t *rtp_session, d
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s ssl_method is NULL [%lu]\n", rtp_type(rtp_session), ssl_method_error);
 	}
 
-	dtls->ssl_ctx = ssl_ctx = SSL_CTX_new(ssl_method);
+	dtls->type = type;
 
-	if (!ssl_ctx) {
-		ssl_ctx_error = ERR_peek_error();
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s SSL_CTX_new failed [%lu]\n", rtp_type(rtp_session), ssl_ctx_error);
-		switch_channel_hangup(switch_core_session_get_channel(rtp_session->session), SWITCH_CAUSE_NORMAL_TEMPORARY_FAILURE);
+	if (dtls_ssl_new(rtp_session, dtls, ssl_method, want_DTLSv1_2) != SWITCH_STATUS_SUCCESS) {
 		switch_goto_status(SWITCH_STATUS_FALSE, done);
 	}
 
-	switch_assert(dtls->ssl_ctx);
-
-	bio = BIO_new_file(dtls->pem, "r");
-	dh = PEM_read_bio_DHparams(bio, NULL, NULL, NULL);
-	BIO_free(bio);
-	if (dh) {
-		SSL_CTX_set_tmp_dh(dtls->ssl_ctx, dh);
-		DH_free(dh);
-	}
-
-	SSL_CTX_set_mode(dtls->ssl_ctx, SSL_MODE_AUTO_RETRY);
+	switch_assert(dtls->ssl);
 
-	//SSL_CTX_set_verify(dtls->ssl_ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
-	SSL_CTX_set_verify(dtls->ssl_ctx, SSL_VERIFY_NONE, NULL);
-
-	//SSL_CTX_set_cipher_list(dtls->ssl_ctx, "ECDH:!RC4:!SSLv3:RSA_WITH_AES_128_CBC_SHA");
-	//SSL_CTX_set_cipher_list(dtls->ssl_ctx, "ECDHE-RSA-AES256-GCM-SHA384");
-	SSL_CTX_set_cipher_list(dtls->ssl_ctx, "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
-	//SSL_CTX_set_cipher_list(dtls->ssl_ctx, "SUITEB128");
-	SSL_CTX_set_read_ahead(dtls->ssl_ctx, 1);
-#ifdef HAVE_OPENSSL_DTLS_SRTP
-	//SSL_CTX_set_tlsext_use_srtp(dtls->ssl_ctx, "SRTP_AES128_CM_SHA1_80:SRTP_AES128_CM_SHA1_32");
-	SSL_CTX_set_tlsext_use_srtp(dtls->ssl_ctx, "SRTP_AES128_CM_SHA1_80");
-#endif
-
-	dtls->type = type;
 	dtls->read_bio = BIO_new(BIO_s_mem());
 	switch_assert(dtls->read_bio);
 
@@ -3990,31 +4341,6 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_add_dtls(switch_rtp_t *rtp_session, d
 	BIO_set_mem_eof_return(dtls->read_bio, -1);
 	BIO_set_mem_eof_return(dtls->write_bio, -1);
 
-	if ((ret=SSL_CTX_use_certificate_file(dtls->ssl_ctx, dtls->rsa, SSL_FILETYPE_PEM)) != 1) {
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS cert err [%d]\n", rtp_type(rtp_session), SSL_get_error(dtls->ssl, ret));
-		switch_goto_status(SWITCH_STATUS_FALSE, done);
-	}
-
-	if ((ret=SSL_CTX_use_PrivateKey_file(dtls->ssl_ctx, dtls->pvt, SSL_FILETYPE_PEM)) != 1) {
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS key err [%d]\n", rtp_type(rtp_session), SSL_get_error(dtls->ssl, ret));
-		switch_goto_status(SWITCH_STATUS_FALSE, done);
-	}
-
-	if (SSL_CTX_check_private_key(dtls->ssl_ctx) == 0) {
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS check key failed\n", rtp_type(rtp_session));
-		switch_goto_status(SWITCH_STATUS_FALSE, done);
-	}
-
-	if (!zstr(dtls->ca) && switch_file_exists(dtls->ca, rtp_session->pool) == SWITCH_STATUS_SUCCESS
-		&& (ret = SSL_CTX_load_verify_locations(dtls->ssl_ctx, dtls->ca, NULL)) != 1) {
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s DTLS check chain cert failed [%d]\n",
-						  rtp_type(rtp_session) ,
-						  SSL_get_error(dtls->ssl, ret));
-		switch_goto_status(SWITCH_STATUS_FALSE, done);
-	}
-
-	dtls->ssl = SSL_new(dtls->ssl_ctx);
-
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 	dtls->filter_bio = BIO_new(BIO_dtls_filter());
 #else
@@ -4049,62 +4375,220 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_add_dtls(switch_rtp_t *rtp_session, d
 #endif
 #endif
 
-	SSL_set_verify(dtls->ssl, SSL_VERIFY_NONE, NULL);
-	SSL_set_app_data(dtls->ssl, dtls);
+	SSL_set_verify(dtls->ssl, SSL_VERIFY_NONE, NULL);
+	SSL_set_app_data(dtls->ssl, dtls);
+
+	dtls->local_fp = local_fp;
+	dtls->remote_fp = remote_fp;
+	dtls->rtp_session = rtp_session;
+	dtls->mtu = 1200;
+
+	if (switch_worker_pool_running(dtls_offload.pool)) {
+		switch_mutex_init(&dtls->inbox_mutex, SWITCH_MUTEX_NESTED, rtp_session->pool);
+		switch_buffer_create_dynamic(&dtls->inbox, MAX_DTLS_MTU, MAX_DTLS_MTU * 4, DTLS_INBOX_MAX);
+	}
+
+	if (rtp_session->session) {
+		switch_channel_t *channel = switch_core_session_get_channel(rtp_session->session);
+		if ((var = switch_channel_get_variable(channel, "rtp_dtls_mtu"))) {
+			int mtu = atoi(var);
+
+			if (mtu > 0 && mtu < MAX_DTLS_MTU) {
+				dtls->mtu = mtu;
+			}
+
+		}
+	}
+	
+	BIO_ctrl(dtls->filter_bio, BIO_CTRL_DGRAM_SET_MTU, dtls->mtu, NULL);
+	
+	switch_core_cert_expand_fingerprint(remote_fp, remote_fp->str);
+
+	if ((type & DTLS_TYPE_RTP)) {
+		rtp_session->dtls = dtls;
+		dtls->sock_output = rtp_session->sock_output;
+		dtls->remote_addr = rtp_session->remote_addr;
+	}
+
+	if ((type & DTLS_TYPE_RTCP)) {
+		rtp_session->rtcp_dtls = dtls;
+		if (!(type & DTLS_TYPE_RTP)) {
+			dtls->sock_output = rtp_session->rtcp_sock_output;
+			dtls->remote_addr = rtp_session->rtcp_remote_addr;
+		}
+	}
+
+	if ((type & DTLS_TYPE_SERVER)) {
+		SSL_set_accept_state(dtls->ssl);
+	} else {
+		SSL_set_connect_state(dtls->ssl);
+	}
+
+	dtls_set_state(dtls, DS_HANDSHAKE);
+
+	rtp_session->flags[SWITCH_RTP_FLAG_VIDEO_BREAK] = 1;
+	switch_rtp_break(rtp_session);
+
+ done:
+
+	switch_mutex_unlock(rtp_session->ice_mutex);
+
+	return status;
+
+}
+
+#ifdef ENABLE_SRTP
+/* set the libsrtp policy of a suite, returns its name or NULL when there is no policy for it */
+static const char *rtp_srtp_policy_set(srtp_policy_t *policy, switch_rtp_crypto_key_type_t type)
+{
+	switch (type) {
+	case AES_CM_128_HMAC_SHA1_80:
+		srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy->rtp);
+		srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy->rtcp);
+		return "AES_CM_128_HMAC_SHA1_80";
+	case AES_CM_128_HMAC_SHA1_32:
+		srtp_crypto_policy_set_aes_cm_128_hmac_sha1_32(&policy->rtp);
+		srtp_crypto_policy_set_aes_cm_128_hmac_sha1_32(&policy->rtcp);
+		return "AES_CM_128_HMAC_SHA1_32";
+	case AEAD_AES_256_GCM_8:
+		srtp_crypto_policy_set_aes_gcm_256_8_auth(&policy->rtp);
+		srtp_crypto_policy_set_aes_gcm_256_8_auth(&policy->rtcp);
+		return "AEAD_AES_256_GCM_8";
+	case AEAD_AES_256_GCM:
+		srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy->rtp);
+		srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy->rtcp);
+		return "AEAD_AES_256_GCM";
+	case AEAD_AES_128_GCM_8:
+		srtp_crypto_policy_set_aes_gcm_128_8_auth(&policy->rtp);
+		srtp_crypto_policy_set_aes_gcm_128_8_auth(&policy->rtcp);
+		return "AEAD_AES_128_GCM_8";
+	case AEAD_AES_128_GCM:
+		srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy->rtp);
+		srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy->rtcp);
+		return "AEAD_AES_128_GCM";
+	case AES_CM_256_HMAC_SHA1_80:
+		srtp_crypto_policy_set_aes_cm_256_hmac_sha1_80(&policy->rtp);
+		srtp_crypto_policy_set_aes_cm_256_hmac_sha1_80(&policy->rtcp);
+		return "AES_CM_256_HMAC_SHA1_80";
+	case AES_CM_256_HMAC_SHA1_32:
+		srtp_crypto_policy_set_aes_cm_256_hmac_sha1_32(&policy->rtp);
+		srtp_crypto_policy_set_aes_cm_256_hmac_sha1_32(&policy->rtcp);
+		return "AES_CM_256_HMAC_SHA1_32";
+	case AES_CM_128_NULL_AUTH:
+		srtp_crypto_policy_set_aes_cm_128_null_auth(&policy->rtp);
+		srtp_crypto_policy_set_aes_cm_128_null_auth(&policy->rtcp);
+		return "AES_CM_128_NULL_AUTH";
+	default:
+		break;
+	}
+
+	return NULL;
+}
+
+/* (re)create the RTP send context after a key change, call with ice_mutex held */
+static switch_status_t rtp_srtp_send_ctx_ready(switch_rtp_t *rtp_session)
+{
+	srtp_err_status_t stat;
+
+	if (!rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND_RESET] && rtp_session->send_ctx[rtp_session->srtp_idx_rtp]) {
+		return SWITCH_STATUS_SUCCESS;
+	}
 
-	dtls->local_fp = local_fp;
-	dtls->remote_fp = remote_fp;
-	dtls->rtp_session = rtp_session;
-	dtls->mtu = 1200;
+	switch_rtp_clear_flag(rtp_session, SWITCH_RTP_FLAG_SECURE_SEND_RESET);
+	srtp_dealloc(rtp_session->send_ctx[rtp_session->srtp_idx_rtp]);
+	rtp_session->send_ctx[rtp_session->srtp_idx_rtp] = NULL;
 
-	if (rtp_session->session) {
-		switch_channel_t *channel = switch_core_session_get_channel(rtp_session->session);
-		if ((var = switch_channel_get_variable(channel, "rtp_dtls_mtu"))) {
-			int mtu = atoi(var);
+	if ((stat = srtp_create(&rtp_session->send_ctx[rtp_session->srtp_idx_rtp],
+							&rtp_session->send_policy[rtp_session->srtp_idx_rtp])) || !rtp_session->send_ctx[rtp_session->srtp_idx_rtp]) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR,
+						  "Error! RE-Activating %s Secure RTP SEND\n", rtp_type(rtp_session));
+		rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND] = 0;
+		return SWITCH_STATUS_FALSE;
+	}
 
-			if (mtu > 0 && mtu < MAX_DTLS_MTU) {
-				dtls->mtu = mtu;
-			}
+	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_INFO,
+					  "RE-Activating %s Secure RTP SEND\n", rtp_type(rtp_session));
 
-		}
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/* (re)create the RTP receive context after a key change, call with ice_mutex held */
+static switch_status_t rtp_srtp_recv_ctx_ready(switch_rtp_t *rtp_session)
+{
+	srtp_err_status_t stat;
+
+	if (!rtp_session->flags[SWITCH_RTP_FLAG_SECURE_RECV_RESET] && rtp_session->recv_ctx[rtp_session->srtp_idx_rtp]) {
+		return SWITCH_STATUS_SUCCESS;
 	}
-	
-	BIO_ctrl(dtls->filter_bio, BIO_CTRL_DGRAM_SET_MTU, dtls->mtu, NULL);
-	
-	switch_core_cert_expand_fingerprint(remote_fp, remote_fp->str);
 
-	if ((type & DTLS_TYPE_RTP)) {
-		rtp_session->dtls = dtls;
-		dtls->sock_output = rtp_session->sock_output;
-		dtls->remote_addr = rtp_session->remote_addr;
+	switch_rtp_clear_flag(rtp_session, SWITCH_RTP_FLAG_SECURE_RECV_RESET);
+	srtp_dealloc(rtp_session->recv_ctx[rtp_session->srtp_idx_rtp]);
+	rtp_session->recv_ctx[rtp_session->srtp_idx_rtp] = NULL;
+
+	if ((stat = srtp_create(&rtp_session->recv_ctx[rtp_session->srtp_idx_rtp],
+							&rtp_session->recv_policy[rtp_session->srtp_idx_rtp])) || !rtp_session->recv_ctx[rtp_session->srtp_idx_rtp]) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "Error! RE-Activating Secure RTP RECV\n");
+		rtp_session->flags[SWITCH_RTP_FLAG_SECURE_RECV] = 0;
+		return SWITCH_STATUS_FALSE;
 	}
 
-	if ((type & DTLS_TYPE_RTCP)) {
-		rtp_session->rtcp_dtls = dtls;
-		if (!(type & DTLS_TYPE_RTP)) {
-			dtls->sock_output = rtp_session->rtcp_sock_output;
-			dtls->remote_addr = rtp_session->rtcp_remote_addr;
+	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_INFO, "RE-Activating Secure RTP RECV\n");
+	rtp_session->srtp_errs[rtp_session->srtp_idx_rtp] = 0;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/*
+ * libsrtp only takes one packet per call, so the vector walks the packets back to
+ * back on one context while its keys and cipher state are hot.  The AES-CM and GCM
+ * kernels come from the OpenSSL backend and use AES-NI/PCLMUL where the cpu has them.
+ */
+static int srtp_protect_vector(srtp_t ctx, int mki, void *packets[], int lens[], int count, srtp_err_status_t *last)
+{
+	srtp_err_status_t stat;
+	int i, ok = 0;
+
+	for (i = 0; i < count; i++) {
+		if (mki) {
+			stat = srtp_protect_mki(ctx, packets[i], &lens[i], 1, SWITCH_CRYPTO_MKI_INDEX);
+		} else {
+			stat = srtp_protect(ctx, packets[i], &lens[i]);
 		}
-	}
 
-	if ((type & DTLS_TYPE_SERVER)) {
-		SSL_set_accept_state(dtls->ssl);
-	} else {
-		SSL_set_connect_state(dtls->ssl);
+		if (stat) {
+			*last = stat;
+			lens[i] = 0;
+		} else {
+			ok++;
+		}
 	}
 
-	dtls_set_state(dtls, DS_HANDSHAKE);
-
-	rtp_session->flags[SWITCH_RTP_FLAG_VIDEO_BREAK] = 1;
-	switch_rtp_break(rtp_session);
+	return ok;
+}
 
- done:
+static int srtp_unprotect_vector(srtp_t ctx, int mki, void *packets[], int lens[], int count, srtp_err_status_t *last)
+{
+	srtp_err_status_t stat;
+	int i, ok = 0;
 
-	switch_mutex_unlock(rtp_session->ice_mutex);
+	for (i = 0; i < count; i++) {
+		if (mki) {
+			stat = srtp_unprotect_mki(ctx, packets[i], &lens[i], 1);
+		} else {
+			stat = srtp_unprotect(ctx, packets[i], &lens[i]);
+		}
 
-	return status;
+		if (stat) {
+			*last = stat;
+			lens[i] = 0;
+		} else {
+			ok++;
+		}
+	}
 
+	return ok;
 }
+#endif
 
 SWITCH_DECLARE(switch_status_t) switch_rtp_add_crypto_key(switch_rtp_t *rtp_session, switch_rtp_crypto_direction_t direction, uint32_t index, switch_secure_settings_t *ssec)
 {
@@ -4132,6 +4616,7 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_add_crypto_key(switch_rtp_t *rtp_sess
 	srtp_master_key_t		**mkis = NULL;
 	srtp_master_key_t		*mki = NULL;
 	int mki_idx = 0;
+	const char *suite;
 
 	keysalt_len = switch_core_media_crypto_keysalt_len(ssec->crypto_type);
 
@@ -4235,85 +4720,8 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_add_crypto_key(switch_rtp_t *rtp_sess
 		switch_channel_set_variable(channel, "send_silence_when_idle", "-1");
 	}
 
-	switch (crypto_key->type) {
-	case AES_CM_128_HMAC_SHA1_80:
-		srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy->rtp);
-		srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy->rtcp);
-
-		if (switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
-			switch_channel_set_variable(channel, "rtp_has_crypto", "AES_CM_128_HMAC_SHA1_80");
-		}
-		break;
-	case AES_CM_128_HMAC_SHA1_32:
-		srtp_crypto_policy_set_aes_cm_128_hmac_sha1_32(&policy->rtp);
-		srtp_crypto_policy_set_aes_cm_128_hmac_sha1_32(&policy->rtcp);
-
-
-		if (switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
-			switch_channel_set_variable(channel, "rtp_has_crypto", "AES_CM_128_HMAC_SHA1_32");
-		}
-		break;
-
-	case AEAD_AES_256_GCM_8:
-		srtp_crypto_policy_set_aes_gcm_256_8_auth(&policy->rtp);
-		srtp_crypto_policy_set_aes_gcm_256_8_auth(&policy->rtcp);
-
-		if (switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
-			switch_channel_set_variable(channel, "rtp_has_crypto", "AEAD_AES_256_GCM_8");
-		}
-		break;
-
-	case AEAD_AES_256_GCM:
-		srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy->rtp);
-		srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy->rtcp);
-
-		if (switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
-			switch_channel_set_variable(channel, "rtp_has_crypto", "AEAD_AES_256_GCM");
-		}
-		break;
-
-	case AEAD_AES_128_GCM_8:
-		srtp_crypto_policy_set_aes_gcm_128_8_auth(&policy->rtp);
-		srtp_crypto_policy_set_aes_gcm_128_8_auth(&policy->rtcp);
-
-		if (switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
-			switch_channel_set_variable(channel, "rtp_has_crypto", "AEAD_AES_128_GCM_8");
-		}
-		break;
-
-	case AEAD_AES_128_GCM:
-		srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy->rtp);
-		srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy->rtcp);
-
-		if (switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
-			switch_channel_set_variable(channel, "rtp_has_crypto", "AEAD_AES_128_GCM");
-		}
-		break;
-
-	case AES_CM_256_HMAC_SHA1_80:
-		srtp_crypto_policy_set_aes_cm_256_hmac_sha1_80(&policy->rtp);
-		srtp_crypto_policy_set_aes_cm_256_hmac_sha1_80(&policy->rtcp);
-		if (switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
-			switch_channel_set_variable(channel, "rtp_has_crypto", "AES_CM_256_HMAC_SHA1_80");
-		}
-		break;
-	case AES_CM_256_HMAC_SHA1_32:
-		srtp_crypto_policy_set_aes_cm_256_hmac_sha1_32(&policy->rtp);
-		srtp_crypto_policy_set_aes_cm_256_hmac_sha1_32(&policy->rtcp);
-		if (switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
-			switch_channel_set_variable(channel, "rtp_has_crypto", "AES_CM_256_HMAC_SHA1_32");
-		}
-		break;
-	case AES_CM_128_NULL_AUTH:
-		srtp_crypto_policy_set_aes_cm_128_null_auth(&policy->rtp);
-		srtp_crypto_policy_set_aes_cm_128_null_auth(&policy->rtcp);
-
-		if (switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
-			switch_channel_set_variable(channel, "rtp_has_crypto", "AES_CM_128_NULL_AUTH");
-		}
-		break;
-	default:
-		break;
+	if ((suite = rtp_srtp_policy_set(policy, crypto_key->type)) && switch_channel_direction(channel) == SWITCH_CALL_DIRECTION_OUTBOUND) {
+		switch_channel_set_variable(channel, "rtp_has_crypto", suite);
 	}
 
 	/* Setup the policy with MKI if they are used. Number of key materials must be positive to use MKI. */
@@ -4451,6 +4859,207 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_add_crypto_key(switch_rtp_t *rtp_sess
 #endif
 }
 
+SWITCH_DECLARE(int) switch_rtp_protect_batch(switch_rtp_t *rtp_session, void *packets[], int lens[], int count)
+{
+	int ok = 0;
+#ifdef ENABLE_SRTP
+	srtp_err_status_t stat = srtp_err_status_ok;
+
+	switch_mutex_lock(rtp_session->ice_mutex);
+	if (rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND] && rtp_srtp_send_ctx_ready(rtp_session) == SWITCH_STATUS_SUCCESS) {
+		ok = srtp_protect_vector(rtp_session->send_ctx[rtp_session->srtp_idx_rtp], rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND_MKI],
+								 packets, lens, count, &stat);
+	} else {
+		memset(lens, 0, count * sizeof(*lens));
+	}
+	switch_mutex_unlock(rtp_session->ice_mutex);
+
+	if (stat) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR,
+						  "Error: %s SRTP protection failed on %d of %d packets, last code %d\n", rtp_type(rtp_session), count - ok, count, stat);
+	}
+#else
+	memset(lens, 0, count * sizeof(*lens));
+#endif
+
+	return ok;
+}
+
+SWITCH_DECLARE(int) switch_rtp_unprotect_batch(switch_rtp_t *rtp_session, void *packets[], int lens[], int count)
+{
+	int ok = 0;
+#ifdef ENABLE_SRTP
+	srtp_err_status_t stat = srtp_err_status_ok;
+	int errs = 0;
+
+	switch_mutex_lock(rtp_session->ice_mutex);
+	if (rtp_session->flags[SWITCH_RTP_FLAG_SECURE_RECV] && rtp_srtp_recv_ctx_ready(rtp_session) == SWITCH_STATUS_SUCCESS) {
+		ok = srtp_unprotect_vector(rtp_session->recv_ctx[rtp_session->srtp_idx_rtp], rtp_session->flags[SWITCH_RTP_FLAG_SECURE_RECV_MKI],
+								   packets, lens, count, &stat);
+
+		if (ok == count) {
+			rtp_session->srtp_errs[rtp_session->srtp_idx_rtp] = 0;
+		} else {
+			rtp_session->srtp_errs[rtp_session->srtp_idx_rtp] += count - ok;
+			errs = rtp_session->srtp_errs[rtp_session->srtp_idx_rtp];
+		}
+	} else {
+		memset(lens, 0, count * sizeof(*lens));
+	}
+	switch_mutex_unlock(rtp_session->ice_mutex);
+
+	/* warn every WARN_SRTP_ERRS errors like the single packet path */
+	if (errs >= WARN_SRTP_ERRS && errs / WARN_SRTP_ERRS != (errs - (count - ok)) / WARN_SRTP_ERRS) {
+		char *msg;
+
+		switch_srtp_err_to_txt(stat, &msg);
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_WARNING,
+						  "SRTP %s unprotect failed with code %d (%s) on %d of %d packets, %d errors\n",
+						  rtp_type(rtp_session), stat, msg, count - ok, count, errs);
+	}
+#else
+	memset(lens, 0, count * sizeof(*lens));
+#endif
+
+	return ok;
+}
+
+#define SRTP_BENCH_RING 256
+#define SRTP_BENCH_SSRC 0x5eed5eed
+
+SWITCH_DECLARE(int) switch_rtp_benchmark_crypto(const char *name, uint32_t packets, uint32_t payload_bytes,
+												switch_rtp_crypto_benchmark_callback_t callback, void *user_data)
+{
+#ifndef ENABLE_SRTP
+	return 0;
+#else
+	switch_memory_pool_t *pool = NULL;
+	switch_rtp_crypto_key_type_t only = CRYPTO_INVALID, type;
+	void *wire[SRTP_BENCH_RING];
+	int lens[SRTP_BENCH_RING];
+	uint32_t hdr_len = sizeof(switch_rtp_hdr_t);
+	int count = 0, i;
+
+	if (!packets || payload_bytes > SWITCH_RTP_MAX_BUF_LEN) {
+		return 0;
+	}
+
+	if (name && (only = switch_core_media_crypto_str2type(name)) == CRYPTO_INVALID) {
+		return 0;
+	}
+
+	switch_core_new_memory_pool(&pool);
+
+	for (i = 0; i < SRTP_BENCH_RING; i++) {
+		wire[i] = switch_core_alloc(pool, hdr_len + payload_bytes + SRTP_MAX_TRAILER_LEN);
+	}
+
+	for (type = 0; type < CRYPTO_INVALID; type++) {
+		switch_rtp_crypto_benchmark_t result = { 0 };
+		srtp_policy_t send_policy = { { 0 } }, recv_policy;
+		srtp_t send_ctx = NULL, recv_ctx = NULL;
+		srtp_err_status_t stat = srtp_err_status_ok;
+		unsigned char key[SWITCH_RTP_MAX_CRYPTO_LEN];
+		uint32_t done = 0, seq = 0;
+
+		if (only != CRYPTO_INVALID && type != only) {
+			continue;
+		}
+
+		result.name = switch_core_media_crypto_type2str(type);
+		result.type = type;
+		result.payload_bytes = payload_bytes;
+		result.status = SWITCH_STATUS_FALSE;
+
+		if (!rtp_srtp_policy_set(&send_policy, type)) {
+			/* switch_rtp_add_crypto_key cannot activate it either */
+			result.status = SWITCH_STATUS_NOTIMPL;
+			goto done;
+		}
+
+		for (i = 0; i < SWITCH_RTP_MAX_CRYPTO_LEN; i++) {
+			key[i] = (unsigned char) (i * 31 + type);
+		}
+
+		send_policy.key = key;
+		send_policy.window_size = 1024;
+		send_policy.allow_repeat_tx = 1;
+		recv_policy = send_policy;
+		send_policy.ssrc.type = ssrc_any_outbound;
+		recv_policy.ssrc.type = ssrc_any_inbound;
+
+		if (srtp_create(&send_ctx, &send_policy) || srtp_create(&recv_ctx, &recv_policy)) {
+			goto done;
+		}
+
+		while (done < packets) {
+			int n = packets - done > SRTP_BENCH_RING ? SRTP_BENCH_RING : (int) (packets - done);
+			switch_time_t start;
+
+			for (i = 0; i < n; i++, seq++) {
+				switch_rtp_hdr_t *hdr = (switch_rtp_hdr_t *) wire[i];
+
+				memset(hdr, 0, hdr_len);
+				hdr->version = 2;
+				hdr->seq = htons((uint16_t) seq);
+				hdr->ts = htonl(seq * 160);
+				hdr->ssrc = htonl(SRTP_BENCH_SSRC);
+				memset((uint8_t *) wire[i] + hdr_len, (int) (seq & 0xff), payload_bytes);
+				lens[i] = hdr_len + payload_bytes;
+			}
+
+			start = switch_time_ref();
+			if (srtp_protect_vector(send_ctx, 0, wire, lens, n, &stat) != n) {
+				goto done;
+			}
+			result.protect_usec += switch_time_ref() - start;
+
+			start = switch_time_ref();
+			if (srtp_unprotect_vector(recv_ctx, 0, wire, lens, n, &stat) != n) {
+				goto done;
+			}
+			result.unprotect_usec += switch_time_ref() - start;
+
+			if (lens[n - 1] != (int) (hdr_len + payload_bytes) || *((uint8_t *) wire[n - 1] + hdr_len) != ((seq - 1) & 0xff)) {
+				goto done;
+			}
+
+			done += n;
+		}
+
+		result.packets = packets;
+		result.protect_pps = packets * 1000000.0 / (result.protect_usec ? result.protect_usec : 1);
+		result.unprotect_pps = packets * 1000000.0 / (result.unprotect_usec ? result.unprotect_usec : 1);
+		result.protect_ns_per_packet = result.protect_usec * 1000.0 / packets;
+		result.unprotect_ns_per_packet = result.unprotect_usec * 1000.0 / packets;
+		result.status = SWITCH_STATUS_SUCCESS;
+
+	  done:
+		if (result.status == SWITCH_STATUS_FALSE) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "SRTP benchmark of %s failed with code %d\n", result.name, stat);
+		}
+
+		if (send_ctx) {
+			srtp_dealloc(send_ctx);
+		}
+
+		if (recv_ctx) {
+			srtp_dealloc(recv_ctx);
+		}
+
+		if (callback) {
+			callback(&result, user_data);
+		}
+
+		count++;
+	}
+
+	switch_core_destroy_memory_pool(&pool);
+
+	return count;
+#endif
+}
+
 SWITCH_DECLARE(switch_status_t) switch_rtp_set_interval(switch_rtp_t *rtp_session, uint32_t ms_per_packet, uint32_t samples_per_interval)
 {
 	rtp_session->ms_per_packet = ms_per_packet;
@@ -6415,23 +7024,9 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 				int sbytes = (int) *bytes;
 				srtp_err_status_t stat = 0;
 
-				if (rtp_session->flags[SWITCH_RTP_FLAG_SECURE_RECV_RESET] || !rtp_session->recv_ctx[rtp_session->srtp_idx_rtp]) {
-					switch_rtp_clear_flag(rtp_session, SWITCH_RTP_FLAG_SECURE_RECV_RESET);
-					srtp_dealloc(rtp_session->recv_ctx[rtp_session->srtp_idx_rtp]);
-					rtp_session->recv_ctx[rtp_session->srtp_idx_rtp] = NULL;
-					if ((stat = srtp_create(&rtp_session->recv_ctx[rtp_session->srtp_idx_rtp],
-											&rtp_session->recv_policy[rtp_session->srtp_idx_rtp])) || !rtp_session->recv_ctx[rtp_session->srtp_idx_rtp]) {
-
-						rtp_session->flags[SWITCH_RTP_FLAG_SECURE_RECV] = 0;
-						switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "Error! RE-Activating Secure RTP RECV\n");
-						rtp_session->flags[SWITCH_RTP_FLAG_SECURE_RECV] = 0;
-						switch_mutex_unlock(rtp_session->ice_mutex);
-						return SWITCH_STATUS_FALSE;
-					} else {
-
-						switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_INFO, "RE-Activating Secure RTP RECV\n");
-						rtp_session->srtp_errs[rtp_session->srtp_idx_rtp] = 0;
-					}
+				if (rtp_srtp_recv_ctx_ready(rtp_session) != SWITCH_STATUS_SUCCESS) {
+					switch_mutex_unlock(rtp_session->ice_mutex);
+					return SWITCH_STATUS_FALSE;
 				}
 
 				if (!(*flags & SFF_PLC) && rtp_session->recv_ctx[rtp_session->srtp_idx_rtp]) {
@@ -6544,6 +7139,7 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 		}
 
 		rtp_session->stats.inbound.packet_count++;
+		switch_core_metric_inc(rtp_rx_metric);
 	}
 
 	if (!rtp_session->flags[SWITCH_RTP_FLAG_VIDEO] &&
@@ -8784,23 +9380,10 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 			srtp_err_status_t stat;
 
 
-			if (rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND_RESET] || !rtp_session->send_ctx[rtp_session->srtp_idx_rtp]) {
-
-				switch_rtp_clear_flag(rtp_session, SWITCH_RTP_FLAG_SECURE_SEND_RESET);
-				srtp_dealloc(rtp_session->send_ctx[rtp_session->srtp_idx_rtp]);
-				rtp_session->send_ctx[rtp_session->srtp_idx_rtp] = NULL;
-				if ((stat = srtp_create(&rtp_session->send_ctx[rtp_session->srtp_idx_rtp],
-										&rtp_session->send_policy[rtp_session->srtp_idx_rtp])) || !rtp_session->send_ctx[rtp_session->srtp_idx_rtp]) {
-					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR,
-									  "Error! RE-Activating %s Secure RTP SEND\n", rtp_type(rtp_session));
-					rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND] = 0;
-					ret = -1;
-					switch_mutex_unlock(rtp_session->ice_mutex);
-					goto end;
-				} else {
-					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_INFO,
-									  "RE-Activating %s Secure RTP SEND\n", rtp_type(rtp_session));
-				}
+			if (rtp_srtp_send_ctx_ready(rtp_session) != SWITCH_STATUS_SUCCESS) {
+				ret = -1;
+				switch_mutex_unlock(rtp_session->ice_mutex);
+				goto end;
 			}
 
 			if (!rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND_MKI]) {
@@ -8942,6 +9525,7 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 
 		rtp_session->stats.outbound.raw_bytes += bytes;
 		rtp_session->stats.outbound.packet_count++;
+		switch_core_metric_inc(rtp_tx_metric);
 
 		if (rtp_session->flags[SWITCH_RTP_FLAG_ENABLE_RTCP]) {
 			rtp_session->stats.rtcp.sent_pkt_count++;
@@ -9130,6 +9714,7 @@ SWITCH_DECLARE(int) switch_rtp_write_frame(switch_rtp_t *rtp_session, switch_fra
 		rtp_session->stats.outbound.media_bytes += bytes;
 		rtp_session->stats.outbound.media_packet_count++;
 		rtp_session->stats.outbound.packet_count++;
+		switch_core_metric_inc(rtp_tx_metric);
 		return (int) bytes;
 	}
 #ifdef ENABLE_ZRTP
@@ -9220,6 +9805,7 @@ SWITCH_DECLARE(int) switch_rtp_write_frame(switch_rtp_t *rtp_session, switch_fra
 		rtp_session->stats.outbound.media_bytes += wrote;
 		rtp_session->stats.outbound.media_packet_count++;
 		rtp_session->stats.outbound.packet_count++;
+		switch_core_metric_inc(rtp_tx_metric);
 
 		return wrote;
 	}
@@ -9381,20 +9967,10 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_write_raw(switch_rtp_t *rtp_session,
 			int sbytes = (int) *bytes;
 			srtp_err_status_t stat;
 
-			if (rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND_RESET]) {
-				switch_rtp_clear_flag(rtp_session, SWITCH_RTP_FLAG_SECURE_SEND_RESET);
-				srtp_dealloc(rtp_session->send_ctx[rtp_session->srtp_idx_rtp]);
-				rtp_session->send_ctx[rtp_session->srtp_idx_rtp] = NULL;
-				if ((stat = srtp_create(&rtp_session->send_ctx[rtp_session->srtp_idx_rtp],
-										&rtp_session->send_policy[rtp_session->srtp_idx_rtp])) || !rtp_session->send_ctx[rtp_session->srtp_idx_rtp]) {
-					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "Error! RE-Activating Secure RTP SEND\n");
-					rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND] = 0;
-					status = SWITCH_STATUS_FALSE;
-					switch_mutex_unlock(rtp_session->ice_mutex);
-					goto end;
-				} else {
-					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_INFO, "RE-Activating Secure RTP SEND\n");
-				}
+			if (rtp_srtp_send_ctx_ready(rtp_session) != SWITCH_STATUS_SUCCESS) {
+				status = SWITCH_STATUS_FALSE;
+				switch_mutex_unlock(rtp_session->ice_mutex);
+				goto end;
 			}
 
 			if (!rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND_MKI]) {
@@ -0,0 +1,116 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2018, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * switch_codec_bench.c -- encode/decode cost of the loaded codecs
+ *
+ * Set CODEC_BENCH_NAME and/or CODEC_BENCH_FRAMES to benchmark on purpose, e.g.
+ * CODEC_BENCH_NAME=OPUS CODEC_BENCH_FRAMES=50000 ./switch_codec_bench,
+ * the defaults keep "make check" fast.
+ *
+ */
+#include <switch.h>
+#include <stdlib.h>
+
+#include <test/switch_test.h>
+
+static void bench_callback(const switch_codec_benchmark_t *result, void *user_data)
+{
+	int *failed = (int *) user_data;
+
+	if (result->status != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s@%uh@%ui/%d from %s failed\n",
+						  result->iananame, result->samples_per_second, result->ptime, result->channels, result->modname);
+		(*failed)++;
+		return;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO,
+					  "%s@%uh@%ui/%d: encode %.0f fps %.0f ns/frame, decode %.0f fps %.0f ns/frame, heap init %" SWITCH_INT64_T_FMT " run %" SWITCH_INT64_T_FMT "\n",
+					  result->iananame, result->samples_per_second, result->ptime, result->channels,
+					  result->encode_fps, result->encode_ns_per_frame, result->decode_fps, result->decode_ns_per_frame,
+					  result->init_heap_bytes, result->run_heap_bytes);
+}
+
+static void single_callback(const switch_codec_benchmark_t *result, void *user_data)
+{
+	switch_codec_benchmark_t *last = (switch_codec_benchmark_t *) user_data;
+
+	/* the names only live for the duration of the callback */
+	*last = *result;
+	last->iananame = strcasecmp(result->iananame, "PCMU") ? NULL : "PCMU";
+	last->modname = NULL;
+}
+
+FST_CORE_BEGIN("./conf")
+{
+	FST_SUITE_BEGIN(switch_codec_bench)
+	{
+		FST_SETUP_BEGIN()
+		{
+			fst_requires_module("mod_opus");
+			fst_requires_module("mod_spandsp");
+		}
+		FST_SETUP_END()
+
+		FST_TEARDOWN_BEGIN()
+		{
+		}
+		FST_TEARDOWN_END()
+
+		FST_TEST_BEGIN(benchmark_one_implementation)
+		{
+			switch_codec_benchmark_t last = { 0 };
+			int count;
+
+			count = switch_loadable_module_benchmark_codecs("PCMU", 100, single_callback, &last);
+			fst_check(count > 0);
+			fst_check(last.status == SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(last.frames, 100);
+			fst_check(last.encoded_bytes > 0);
+			fst_check_string_equals(last.iananame, "PCMU");
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(benchmark_all_implementations)
+		{
+			const char *name = getenv("CODEC_BENCH_NAME");
+			const char *frames = getenv("CODEC_BENCH_FRAMES");
+			int failed = 0, count;
+
+			count = switch_loadable_module_benchmark_codecs(zstr(name) ? NULL : name, zstr(frames) ? 200 : atoi(frames), bench_callback, &failed);
+			fst_check(count > 0);
+			fst_check_int_equals(failed, 0);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(unknown_codec)
+		{
+			fst_check_int_equals(switch_loadable_module_benchmark_codecs("NO-SUCH-CODEC", 10, NULL, NULL), 0);
+		}
+		FST_TEST_END()
+	}
+	FST_SUITE_END()
+}
+FST_CORE_END()
@@ -36,6 +36,74 @@
 #include <openssl/ssl.h>
 #endif
 
+static struct {
+	switch_mutex_t *mutex;
+	int count;
+	int last_serno;
+	int last_value;
+	switch_bool_t contiguous;
+	switch_bool_t text_ok;
+} la_sub;
+
+static void la_payload_handler(const char *event_channel, switch_event_channel_payload_t *payload, const char *key, switch_event_channel_id_t id,
+							   void *user_data)
+{
+	cJSON *json = switch_event_channel_payload_json(payload);
+	cJSON *data = cJSON_GetObjectItem(json, "data");
+	switch_size_t len = 0;
+	const char *text = switch_event_channel_payload_text(payload, &len);
+	char *again = cJSON_PrintUnformatted(json);
+	int serno = (int) cJSON_GetObjectItem(data, "wireSerno")->valuedouble;
+
+	switch_mutex_lock(la_sub.mutex);
+	if (!text || !again || strcmp(text, again) || len != strlen(again) || text != switch_event_channel_payload_text(payload, NULL)) {
+		la_sub.text_ok = SWITCH_FALSE;
+	}
+	if (la_sub.count++ && serno != la_sub.last_serno + 1) {
+		la_sub.contiguous = SWITCH_FALSE;
+	}
+	la_sub.last_serno = serno;
+	la_sub.last_value = (int) cJSON_GetObjectItem(cJSON_GetObjectItem(data, "data"), "v")->valuedouble;
+	switch_mutex_unlock(la_sub.mutex);
+
+	switch_safe_free(again);
+}
+
+static struct {
+	switch_thread_t *thread;
+	volatile switch_atomic_t registered;
+	volatile switch_atomic_t calls;
+} metric_scrape;
+
+static void *SWITCH_THREAD_FUNC metric_register_thread(switch_thread_t *thread, void *obj)
+{
+	switch_metric_t *m = NULL;
+
+	switch_core_metric_register("test_scrape_side_total", NULL, NULL, SWITCH_METRIC_COUNTER, &m);
+	switch_atomic_set(&metric_scrape.registered, 1);
+
+	return NULL;
+}
+
+/* registers from another thread while the scrape is in here, which only gets through if the scrape holds no registry lock */
+static double metric_scrape_callback(switch_metric_t *metric, void *user_data)
+{
+	switch_memory_pool_t *pool = (switch_memory_pool_t *) user_data;
+	switch_threadattr_t *thd_attr;
+	int i;
+
+	switch_atomic_inc(&metric_scrape.calls);
+
+	switch_threadattr_create(&thd_attr, pool);
+	switch_thread_create(&metric_scrape.thread, thd_attr, metric_register_thread, NULL, pool);
+
+	for (i = 0; i < 1000 && !switch_atomic_read(&metric_scrape.registered); i++) {
+		switch_yield(1000);
+	}
+
+	return switch_atomic_read(&metric_scrape.registered) ? 1 : 0;
+}
+
 FST_CORE_BEGIN("./conf")
 {
 	FST_SUITE_BEGIN(switch_core)
@@ -343,6 +411,157 @@ FST_CORE_BEGIN("./conf")
 			fst_requires(hash == NULL);
 		}
 		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_core_latency)
+		{
+			switch_latency_summary_t summary = { 0 };
+			cJSON *json, *stage;
+			int i;
+
+			switch_core_latency_enable(SWITCH_TRUE);
+			switch_core_latency_reset(NULL);
+
+			for (i = 1; i <= 100; i++) {
+				switch_core_latency_record(NULL, SWITCH_LATENCY_APPLICATION, i);
+			}
+
+			fst_check_int_equals(switch_core_latency_get(NULL, SWITCH_LATENCY_APPLICATION, &summary), SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(summary.count, 100);
+			fst_check_int_equals(summary.mean, 50);
+			fst_check_int_equals(summary.max, 100);
+			fst_check(summary.p50 >= 50 && summary.p50 <= 53);
+			fst_check(summary.p99 >= 99 && summary.p99 <= 100);
+			fst_check(summary.p999 == 100);
+
+			fst_check_int_equals(switch_core_latency_get(NULL, SWITCH_LATENCY_DIALPLAN, &summary), SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(summary.count, 0);
+
+			json = switch_core_latency_json(NULL);
+			fst_requires(json);
+			stage = cJSON_GetObjectItem(json, "application");
+			fst_requires(stage);
+			fst_check_int_equals(cJSON_GetObjectItem(stage, "count")->valueint, 100);
+			cJSON_Delete(json);
+
+			switch_core_latency_reset(NULL);
+			fst_check_int_equals(switch_core_latency_get(NULL, SWITCH_LATENCY_APPLICATION, &summary), SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(summary.count, 0);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_core_metrics)
+		{
+			switch_metric_t *counter = NULL, *again = NULL, *gauge = NULL, *other = NULL;
+			switch_stream_handle_t stream = { 0 };
+			char *out, *a, *b;
+
+			fst_check_int_equals(switch_core_metric_register("test_metric_total", NULL, "A test counter", SWITCH_METRIC_COUNTER, &counter), SWITCH_STATUS_SUCCESS);
+			fst_requires(counter);
+			fst_check_int_equals(switch_core_metric_register("test_metric_total", NULL, "A test counter", SWITCH_METRIC_COUNTER, &again), SWITCH_STATUS_SUCCESS);
+			fst_check(counter == again);
+			fst_check_int_equals(switch_core_metric_register("test_metric_total", NULL, NULL, SWITCH_METRIC_GAUGE, &again), SWITCH_STATUS_FALSE);
+			fst_check_int_equals(switch_core_metric_register("bad name", NULL, NULL, SWITCH_METRIC_GAUGE, &again), SWITCH_STATUS_FALSE);
+
+			switch_core_metric_inc(counter);
+			switch_core_metric_add(counter, 41);
+			fst_check(switch_core_metric_value(counter) == 42);
+
+			fst_check_int_equals(switch_core_metric_register("test_gauge", "kind=\"a\"", "A test gauge", SWITCH_METRIC_GAUGE, &gauge), SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(switch_core_metric_register("test_gauge", "kind=\"b\"", "A test gauge", SWITCH_METRIC_GAUGE, &other), SWITCH_STATUS_SUCCESS);
+			fst_check(gauge != other);
+			switch_core_metric_set(gauge, 7);
+			switch_core_metric_add(other, 3);
+			switch_core_metric_dec(other);
+
+			SWITCH_STANDARD_STREAM(stream);
+			fst_check_int_equals(switch_core_metrics_expose(&stream), SWITCH_STATUS_SUCCESS);
+			out = (char *) stream.data;
+			fst_requires(out);
+			fst_check(strstr(out, "# TYPE test_metric_total counter\ntest_metric_total 42\n") != NULL);
+			fst_check(strstr(out, "# HELP test_gauge A test gauge\n") != NULL);
+			a = strstr(out, "test_gauge{kind=\"a\"} 7\n");
+			b = strstr(out, "test_gauge{kind=\"b\"} 2\n");
+			fst_check(a && b && b > a);
+			switch_safe_free(stream.data);
+
+			switch_core_metric_unregister(other);
+			SWITCH_STANDARD_STREAM(stream);
+			switch_core_metrics_expose(&stream);
+			out = (char *) stream.data;
+			fst_check(strstr(out, "test_gauge{kind=\"b\"}") == NULL);
+			fst_check(strstr(out, "test_gauge{kind=\"a\"} 7\n") != NULL);
+			switch_safe_free(stream.data);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_core_metric_callback_scrape)
+		{
+			switch_metric_t *metric = NULL;
+			switch_status_t st;
+
+			memset(&metric_scrape, 0, sizeof(metric_scrape));
+
+			fst_check_int_equals(switch_core_metric_register_callback("test_scrape_gauge", NULL, NULL, SWITCH_METRIC_GAUGE,
+																	  metric_scrape_callback, fst_pool, &metric), SWITCH_STATUS_SUCCESS);
+			fst_requires(metric);
+
+			/* registration went ahead while the callback was running */
+			fst_check(switch_core_metric_value(metric) == 1);
+			fst_requires(metric_scrape.thread);
+			switch_thread_join(&st, metric_scrape.thread);
+			fst_check_int_equals(switch_atomic_read(&metric_scrape.calls), 1);
+
+			/* once unregistered the callback is never called again */
+			switch_core_metric_unregister(metric);
+			fst_check(switch_core_metric_value(metric) == 0);
+			fst_check_int_equals(switch_atomic_read(&metric_scrape.calls), 1);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_live_array_payload_coalesce)
+		{
+			switch_live_array_t *la = NULL;
+			switch_event_channel_id_t id = 0;
+			int i, last_value = -1, count = 0, waited = 0;
+
+			memset(&la_sub, 0, sizeof(la_sub));
+			la_sub.last_value = -1;
+			la_sub.contiguous = SWITCH_TRUE;
+			la_sub.text_ok = SWITCH_TRUE;
+			switch_mutex_init(&la_sub.mutex, SWITCH_MUTEX_NESTED, fst_pool);
+
+			fst_check_int_equals(switch_event_channel_bind_payload("test-la", la_payload_handler, &id, NULL), SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(switch_live_array_create("test-la", "rows", NO_EVENT_CHANNEL_ID, &la), SWITCH_STATUS_SUCCESS);
+			fst_requires(la);
+
+			for (i = 0; i < 100; i++) {
+				cJSON *obj = cJSON_CreateObject();
+
+				cJSON_AddItemToObject(obj, "v", cJSON_CreateNumber(i));
+				switch_live_array_add(la, "row", -1, &obj, SWITCH_FALSE);
+			}
+
+			while (waited++ < 200) {
+				switch_mutex_lock(la_sub.mutex);
+				last_value = la_sub.last_value;
+				count = la_sub.count;
+				switch_mutex_unlock(la_sub.mutex);
+
+				if (last_value == 99) {
+					break;
+				}
+				switch_yield(10000);
+			}
+
+			fst_check_int_equals(last_value, 99);
+			fst_check(count >= 1 && count <= 100);
+			fst_check(la_sub.contiguous);
+			fst_check(la_sub.text_ok);
+
+			switch_event_channel_unbind_payload("test-la", la_payload_handler, NULL);
+			switch_live_array_destroy(&la);
+		}
+		FST_TEST_END()
 	}
 	FST_SUITE_END()
 }
@@ -46,6 +46,15 @@ int table_count_func(void *pArg, int argc, char **argv, char **columnNames){
 	return -1;
 }
 
+static int first_column_func(void *pArg, int argc, char **argv, char **columnNames)
+{
+	if (argc > 0 && argv[0]) {
+		switch_copy_string((char *) pArg, argv[0], 64);
+	}
+
+	return 0;
+}
+
 FST_CORE_DB_BEGIN("./conf")
 {
 	FST_SUITE_BEGIN(switch_core_db)
@@ -118,6 +127,151 @@ FST_CORE_DB_BEGIN("./conf")
 		}
 		FST_TEST_END()
 
+		FST_TEST_BEGIN(test_switch_cache_db_execute_sql_params)
+		{
+			switch_cache_db_handle_t *dbh = NULL;
+			char *dsn = "test_switch_cache_db_execute_sql_params.db";
+			int i, rows = 20000;
+			switch_time_t start, mprintf_usec, params_usec;
+			char name[64] = "";
+			char count[64] = "";
+
+			fst_requires(switch_cache_db_get_db_handle_dsn(&dbh, dsn) == SWITCH_STATUS_SUCCESS);
+
+			switch_cache_db_execute_sql(dbh, "DROP TABLE IF EXISTS params", NULL);
+			switch_cache_db_execute_sql(dbh, "CREATE TABLE params (id INTEGER, name VARCHAR(255))", NULL);
+
+			start = switch_time_now();
+			switch_cache_db_execute_sql(dbh, "BEGIN", NULL);
+			for (i = 0; i < rows; i++) {
+				char *sql = switch_mprintf("insert into params (id, name) values (%d, '%q')", i, "o'brien");
+				switch_cache_db_execute_sql(dbh, sql, NULL);
+				switch_safe_free(sql);
+			}
+			switch_cache_db_execute_sql(dbh, "COMMIT", NULL);
+			mprintf_usec = switch_time_now() - start;
+
+			start = switch_time_now();
+			switch_cache_db_execute_sql(dbh, "BEGIN", NULL);
+			for (i = 0; i < rows; i++) {
+				char id[32];
+				const char *args[2] = { id, "o'brien" };
+
+				switch_snprintf(id, sizeof(id), "%d", rows + i);
+				switch_cache_db_execute_sql_params(dbh, "insert into params (id, name) values (?, ?)", 2, args, NULL, NULL, NULL);
+			}
+			switch_cache_db_execute_sql(dbh, "COMMIT", NULL);
+			params_usec = switch_time_now() - start;
+
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "mprintf: %d inserts in %" SWITCH_TIME_T_FMT "us (%.0f/sec)\n",
+							  rows, mprintf_usec, rows * 1000000.0 / (mprintf_usec ? mprintf_usec : 1));
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "params:  %d inserts in %" SWITCH_TIME_T_FMT "us (%.0f/sec)\n",
+							  rows, params_usec, rows * 1000000.0 / (params_usec ? params_usec : 1));
+
+			{
+				const char *args[1] = { "o'brien" };
+
+				fst_check(switch_cache_db_execute_sql_params(dbh, "select count(*) from params where name=?", 1, args,
+															 first_column_func, count, NULL) == SWITCH_STATUS_SUCCESS);
+			}
+			fst_check_int_equals(atoi(count), rows * 2);
+
+			{
+				const char *args[1] = { "25000" };
+
+				fst_check(switch_cache_db_execute_sql_params(dbh, "select name from params where id=?", 1, args,
+															 first_column_func, name, NULL) == SWITCH_STATUS_SUCCESS);
+			}
+			fst_check_string_equals(name, "o'brien");
+
+			switch_cache_db_execute_sql(dbh, "DROP TABLE params", NULL);
+			switch_cache_db_release_db_handle(&dbh);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_cache_db_queue_manager_push_params)
+		{
+			int i;
+			switch_sql_queue_manager_t *qm = NULL;
+
+			status = 0;
+
+			switch_sql_queue_manager_init_name("TEST_PARAMS",
+				&qm,
+				2,
+				"test_switch_cache_db_queue_manager_push_params",
+				SWITCH_MAX_TRANS,
+				NULL, NULL, NULL, NULL);
+
+			switch_sql_queue_manager_start(qm);
+
+			switch_sql_queue_manager_push_confirm(qm, "DROP TABLE IF EXISTS tp;", 0, SWITCH_TRUE);
+			switch_sql_queue_manager_push_confirm(qm, "CREATE TABLE tp (col1 INT, col2 VARCHAR(255));", 0, SWITCH_TRUE);
+
+			for (i = 0; i < max_rows; i++) {
+				const char *args[2] = { "1", i % 2 ? "it's" : NULL };
+
+				switch_sql_queue_manager_push_params(qm, "INSERT INTO tp (col1, col2) VALUES (?, ?);", 2, args, 0);
+			}
+
+			while (switch_sql_queue_manager_size(qm, 0)) {
+				switch_cond_next();
+			}
+
+			switch_sleep(1 * 1000 * 1000);
+
+			switch_sql_queue_manager_execute_sql_callback(qm, "SELECT COUNT(col1) FROM tp WHERE col2 = 'it''s';", table_count_func, NULL);
+
+			switch_sql_queue_manager_stop(qm);
+			switch_sql_queue_manager_destroy(&qm);
+
+			fst_check_int_equals(status, max_rows / 2);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_cache_db_queue_manager_flush_params)
+		{
+			int i;
+			switch_sql_queue_manager_t *qm = NULL;
+			switch_cache_db_handle_t *dbh = NULL;
+			char *dsn = "test_switch_cache_db_queue_manager_flush_params";
+			char count[64] = "";
+
+			switch_sql_queue_manager_init_name("TEST_FLUSH_PARAMS",
+				&qm,
+				2,
+				dsn,
+				SWITCH_MAX_TRANS,
+				NULL, NULL, NULL, NULL);
+
+			switch_sql_queue_manager_start(qm);
+
+			switch_sql_queue_manager_push_confirm(qm, "DROP TABLE IF EXISTS tf;", 0, SWITCH_TRUE);
+			switch_sql_queue_manager_push_confirm(qm, "CREATE TABLE tf (col1 INT, col2 VARCHAR(255));", 0, SWITCH_TRUE);
+
+			/* nothing runs while paused, so the rows are all still queued when the thread goes down */
+			switch_sql_queue_manager_pause(qm, SWITCH_FALSE);
+
+			for (i = 0; i < max_rows; i++) {
+				const char *args[2] = { "1", i % 2 ? "it's" : NULL };
+
+				switch_sql_queue_manager_push_params(qm, "INSERT INTO tf (col1, col2) VALUES (?, ?);", 2, args, 0);
+			}
+
+			fst_check_int_equals(switch_sql_queue_manager_size(qm, 0), max_rows);
+
+			switch_sql_queue_manager_stop(qm);
+			switch_sql_queue_manager_destroy(&qm);
+
+			fst_requires(switch_cache_db_get_db_handle_dsn(&dbh, dsn) == SWITCH_STATUS_SUCCESS);
+			switch_cache_db_execute_sql2str(dbh, "SELECT COUNT(col1) FROM tf WHERE col2 = 'it''s';", count, sizeof(count), NULL);
+			fst_check_int_equals(atoi(count), max_rows / 2);
+			switch_cache_db_execute_sql2str(dbh, "SELECT COUNT(col1) FROM tf WHERE col2 IS NULL;", count, sizeof(count), NULL);
+			fst_check_int_equals(atoi(count), max_rows / 2);
+			switch_cache_db_execute_sql(dbh, "DROP TABLE tf", NULL);
+			switch_cache_db_release_db_handle(&dbh);
+		}
+		FST_TEST_END()
 
 	}
 	FST_SUITE_END()
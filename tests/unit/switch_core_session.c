@@ -32,6 +32,40 @@
 #include <test/switch_test.h>
 
 
+#define LOCATE_THREADS 8
+#define LOCATES_PER_THREAD 100000
+
+typedef struct {
+	const char *uuid;
+	int found;
+	int missing;
+} locate_bench_t;
+
+static void *SWITCH_THREAD_FUNC locate_thread(switch_thread_t *thread, void *obj)
+{
+	locate_bench_t *bench = (locate_bench_t *) obj;
+	switch_core_session_t *session;
+	int i;
+
+	for (i = 0; i < LOCATES_PER_THREAD; i++) {
+		if ((session = switch_core_session_locate(bench->uuid))) {
+			bench->found++;
+			switch_core_session_rwunlock(session);
+		}
+
+		if ((session = switch_core_session_locate("00000000-0000-0000-0000-000000000000"))) {
+			switch_core_session_rwunlock(session);
+		} else {
+			bench->missing++;
+		}
+	}
+
+	return NULL;
+}
+
+#define EVENT_BENCH_VARIABLES 200
+#define EVENT_BENCH_LOOPS 1000
+
 FST_CORE_BEGIN("./conf")
 {
 	FST_SUITE_BEGIN(switch_core_session)
@@ -46,6 +80,133 @@ FST_CORE_BEGIN("./conf")
 		}
 		FST_TEARDOWN_END()
 
+		FST_SESSION_BEGIN(session_locate_contention)
+		{
+			locate_bench_t bench[LOCATE_THREADS] = {{ 0 }};
+			switch_thread_t *threads[LOCATE_THREADS];
+			switch_threadattr_t *thd_attr = NULL;
+			switch_stream_handle_t stream = { 0 };
+			switch_time_t start, elapsed;
+			switch_status_t status;
+			int i, writes = 0;
+
+			switch_threadattr_create(&thd_attr, fst_pool);
+			start = switch_time_now();
+
+			for (i = 0; i < LOCATE_THREADS; i++) {
+				bench[i].uuid = switch_core_session_get_uuid(fst_session);
+				switch_thread_create(&threads[i], thd_attr, locate_thread, &bench[i], fst_pool);
+			}
+
+			/* keep writers busy on the table while the readers run */
+			for (i = 0; i < 2000; i++) {
+				char id[32];
+
+				switch_snprintf(id, sizeof(id), "bench-%d", i);
+				if (switch_core_session_set_external_id(fst_session, id) == SWITCH_STATUS_SUCCESS) {
+					writes++;
+				}
+			}
+
+			for (i = 0; i < LOCATE_THREADS; i++) {
+				switch_thread_join(&status, threads[i]);
+				fst_check_int_equals(bench[i].found, LOCATES_PER_THREAD);
+				fst_check_int_equals(bench[i].missing, LOCATES_PER_THREAD);
+			}
+
+			elapsed = switch_time_now() - start;
+			fst_check_int_equals(writes, 2000);
+
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "%d threads did %d locates each against %d writes in %" SWITCH_TIME_T_FMT "ms, %.0f locates/sec\n",
+							  LOCATE_THREADS, LOCATES_PER_THREAD * 2, writes, elapsed / 1000,
+							  elapsed ? (double) LOCATE_THREADS * LOCATES_PER_THREAD * 2 * 1000000 / elapsed : 0.0);
+
+			SWITCH_STANDARD_STREAM(stream);
+			switch_core_session_table_stats(&stream);
+			fst_check(strstr((char *) stream.data, "shards: ") != NULL);
+			switch_safe_free(stream.data);
+		}
+		FST_SESSION_END()
+
+		FST_SESSION_BEGIN(channel_event_shared_variables)
+		{
+			const char *value = "a value long enough to be worth sharing between events";
+			switch_event_t *event = NULL, *older = NULL;
+			switch_event_header_t *hp;
+			switch_time_t start, elapsed;
+			uint32_t basic = 0, full = 0, copied = 0;
+			int i, shared = 0;
+
+			for (i = 0; i < EVENT_BENCH_VARIABLES; i++) {
+				char name[32];
+
+				switch_snprintf(name, sizeof(name), "bench_var_%d", i);
+				switch_channel_set_variable(fst_channel, name, value);
+			}
+
+			switch_channel_set_flag(fst_channel, CF_VERBOSE_EVENTS);
+
+			/* the first event builds the snapshot, the rest only take a reference to it */
+			switch_event_create(&older, SWITCH_EVENT_CHANNEL_DATA);
+			switch_channel_event_set_data(fst_channel, older);
+			fst_check_string_equals(switch_event_get_header(older, "variable_bench_var_7"), value);
+			fst_requires(older->shared);
+			hp = switch_event_get_header_ptr(older, "variable_bench_var_7");
+
+			for (i = 0; i < EVENT_BENCH_LOOPS; i++) {
+				switch_event_alloc_count_begin();
+				switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+				switch_channel_event_set_basic_data(fst_channel, event);
+				switch_event_destroy(&event);
+				basic += switch_event_alloc_count_end();
+			}
+
+			start = switch_time_now();
+			for (i = 0; i < EVENT_BENCH_LOOPS; i++) {
+				switch_event_alloc_count_begin();
+				switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+				switch_channel_event_set_data(fst_channel, event);
+				full += switch_event_alloc_count_end();
+				/* the very same headers, nothing was copied */
+				if (event->shared == older->shared && switch_event_get_header_ptr(event, "variable_bench_var_7") == hp) {
+					shared++;
+				}
+				switch_event_destroy(&event);
+			}
+			elapsed = switch_time_now() - start;
+
+			/* what every event paid before: its own copy of each variable */
+			for (i = 0; i < EVENT_BENCH_LOOPS; i++) {
+				switch_event_alloc_count_begin();
+				switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+				switch_channel_event_set_data(fst_channel, event);
+				switch_event_unshare_headers(event);
+				copied += switch_event_alloc_count_end();
+				switch_event_destroy(&event);
+			}
+
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "%d events with %d variables: %u allocations per event shared, %u copied (%u for the basic data), %.2f us per event\n",
+							  EVENT_BENCH_LOOPS, EVENT_BENCH_VARIABLES, full / EVENT_BENCH_LOOPS, copied / EVENT_BENCH_LOOPS, basic / EVENT_BENCH_LOOPS,
+							  (double) elapsed / EVENT_BENCH_LOOPS);
+
+			fst_check_int_equals(shared, EVENT_BENCH_LOOPS);
+			fst_check(basic > 0);
+			/* the shared variables cost next to nothing on top of the basic data */
+			fst_check(full - basic < (uint32_t) EVENT_BENCH_LOOPS * EVENT_BENCH_VARIABLES / 10);
+			/* copying them costs a header, a name and a value each */
+			fst_check(copied - full >= (uint32_t) EVENT_BENCH_LOOPS * EVENT_BENCH_VARIABLES * 3);
+
+			/* a new value builds a new snapshot, events already out keep the old one */
+			switch_channel_set_variable(fst_channel, "bench_var_7", "changed");
+			switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+			switch_channel_event_set_data(fst_channel, event);
+			fst_check_string_equals(switch_event_get_header(event, "variable_bench_var_7"), "changed");
+			fst_check_string_equals(switch_event_get_header(older, "variable_bench_var_7"), value);
+			switch_event_destroy(&event);
+			switch_event_destroy(&older);
+		}
+		FST_SESSION_END()
+
 		FST_SESSION_BEGIN(session_external_id)
 		{
 			switch_core_session_t *session;
@@ -104,6 +104,61 @@ FST_TEST_BEGIN(benchmark)
 }
 FST_TEST_END()
 
+FST_TEST_BEGIN(shared_headers)
+{
+  switch_event_t *snapshot = NULL, *event = NULL, *clone = NULL;
+  switch_event_shared_headers_t *shared = NULL;
+  char *str = NULL;
+
+  switch_event_create(&snapshot, SWITCH_EVENT_CLONE);
+  fst_requires(snapshot);
+  switch_event_add_header_string(snapshot, SWITCH_STACK_BOTTOM, "variable_a", "1");
+  switch_event_add_header_string(snapshot, SWITCH_STACK_BOTTOM, "variable_b", "2");
+  shared = switch_event_shared_headers_create(&snapshot);
+  fst_requires(shared);
+  fst_check(snapshot == NULL);
+
+  switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Unique-ID", "1234");
+  fst_check(switch_event_attach_shared_headers(event, shared) == SWITCH_STATUS_SUCCESS);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Application", "park");
+
+  /* the shared run stays at the tail, later headers go in front of it */
+  fst_check_string_equals(event->last_header->name, "variable_b");
+  fst_check_string_equals(switch_event_get_header(event, "variable_a"), "1");
+  fst_check_string_equals(switch_event_get_header(event, "Application"), "park");
+
+  switch_event_serialize(event, &str, SWITCH_FALSE);
+  fst_requires(str);
+  fst_check_string_has(str, "variable_b: 2");
+  switch_safe_free(str);
+
+  fst_check(switch_event_dup(&clone, event) == SWITCH_STATUS_SUCCESS);
+  fst_check(clone->shared == shared);
+  fst_check_string_equals(switch_event_get_header(clone, "Unique-ID"), "1234");
+  fst_check_string_equals(switch_event_get_header(clone, "variable_b"), "2");
+
+  /* deleting a header of its own keeps the run shared */
+  switch_event_del_header(clone, "Unique-ID");
+  fst_check(clone->shared == shared);
+  fst_check(switch_event_get_header(clone, "Unique-ID") == NULL);
+
+  /* changing a shared header copies the run, the other holders keep the original */
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "variable_a", "changed");
+  fst_check(event->shared == NULL);
+  fst_check_string_equals(switch_event_get_header(event, "variable_a"), "changed");
+  fst_check_string_equals(switch_event_get_header(event, "variable_b"), "2");
+  fst_check_string_equals(switch_event_get_header(event, "Application"), "park");
+  fst_check_string_equals(switch_event_get_header(clone, "variable_a"), "1");
+
+  switch_event_destroy(&event);
+  switch_event_shared_headers_release(&shared);
+  fst_check(shared == NULL);
+  fst_check_string_equals(switch_event_get_header(clone, "variable_a"), "1");
+  switch_event_destroy(&clone);
+}
+FST_TEST_END()
+
 FST_SUITE_END()
 
 FST_MINCORE_END()
@@ -195,6 +195,41 @@ FST_CORE_BEGIN("./conf_async")
 			unlink(record_filename);
 		}
 		FST_SESSION_END()
+
+		FST_TEST_BEGIN(goertzel_bank_matches_single)
+		{
+			teletone_goertzel_state_t single[TELETONE_MAX_TONES], banked[TELETONE_MAX_TONES];
+			teletone_goertzel_state_t *bank[TELETONE_MAX_TONES];
+			int16_t samples[160];
+			int i, j;
+
+			for (i = 0; i < TELETONE_MAX_TONES; i++) {
+				single[i].v2 = single[i].v3 = 0.0f;
+				single[i].fac = 2.0 * cos(2.0 * M_PI * (300.0 + 100.0 * i) / 8000.0);
+				banked[i] = single[i];
+				bank[i] = &banked[i];
+			}
+
+			/* two tones with some noise, the bank must follow the filters one by one */
+			for (i = 0; i < 160; i++) {
+				samples[i] = (int16_t) (4000.0 * sin(2.0 * M_PI * 697.0 * i / 8000.0) + 4000.0 * sin(2.0 * M_PI * 1209.0 * i / 8000.0) + (rand() % 200) - 100);
+			}
+
+			for (j = 0; j < 3; j++) {
+				for (i = 0; i < TELETONE_MAX_TONES; i++) {
+					teletone_goertzel_update(&single[i], samples, 160);
+				}
+				teletone_goertzel_bank_update(bank, TELETONE_MAX_TONES, samples, 160);
+			}
+
+			for (i = 0; i < TELETONE_MAX_TONES; i++) {
+				double expected = single[i].v3 * single[i].v3 + single[i].v2 * single[i].v2 - single[i].v2 * single[i].v3 * single[i].fac;
+				double got = banked[i].v3 * banked[i].v3 + banked[i].v2 * banked[i].v2 - banked[i].v2 * banked[i].v3 * banked[i].fac;
+
+				fst_xcheck(fabs(expected - got) <= 1e-3 * fabs(expected) + 1.0, "Expect the goertzel bank to match the single filter update");
+			}
+		}
+		FST_TEST_END()
 	}
 	FST_SUITE_END()
 }
@@ -785,6 +785,72 @@ FST_CORE_BEGIN("./conf")
 		}
 		FST_TEST_END()
 
+		FST_TEST_BEGIN(originate_test_watcher)
+		{
+			switch_core_session_t *session = NULL;
+			switch_channel_t *channel = NULL;
+			switch_channel_watcher_t *watcher = NULL;
+			switch_status_t status;
+			switch_call_cause_t cause;
+
+			status = switch_ivr_originate(NULL, &session, &cause, "null/+15553334444", 2, NULL, NULL, NULL, NULL, NULL, SOF_NONE, NULL, NULL);
+			fst_requires(session);
+			fst_check(status == SWITCH_STATUS_SUCCESS);
+
+			channel = switch_core_session_get_channel(session);
+			fst_requires(channel);
+
+			fst_check(switch_channel_watcher_create(&watcher) == SWITCH_STATUS_SUCCESS);
+			fst_requires(watcher);
+
+			switch_channel_watch(channel, watcher);
+			/* attaching wakes the watcher once */
+			fst_check(switch_channel_watcher_wait(watcher, 10) == SWITCH_STATUS_SUCCESS);
+			fst_check(switch_channel_watcher_wait(watcher, 10) == SWITCH_STATUS_TIMEOUT);
+
+			switch_channel_set_flag(channel, CF_RING_READY);
+			fst_check(switch_channel_watcher_wait(watcher, 1000) == SWITCH_STATUS_SUCCESS);
+
+			switch_channel_unwatch(channel, watcher);
+			switch_channel_clear_flag(channel, CF_RING_READY);
+			fst_check(switch_channel_watcher_wait(watcher, 10) == SWITCH_STATUS_TIMEOUT);
+
+			/* a watched channel keeps the watcher alive after its creator let go */
+			switch_channel_watch(channel, watcher);
+			switch_channel_watcher_release(&watcher);
+			fst_check(watcher == NULL);
+
+			switch_channel_hangup(channel, SWITCH_CAUSE_NORMAL_CLEARING);
+			switch_core_session_rwunlock(session);
+			switch_sleep(1000000);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(originate_test_latency)
+		{
+			switch_core_session_t *session = NULL;
+			switch_latency_summary_t summary = { 0 };
+			switch_status_t status;
+			switch_call_cause_t cause;
+
+			switch_core_latency_enable(SWITCH_TRUE);
+			switch_core_latency_reset(NULL);
+
+			status = switch_ivr_originate(NULL, &session, &cause, "{null_enable_auto_answer=1,null_auto_answer_delay=500}null/+15553334444", 2, NULL, NULL, NULL, NULL, NULL, SOF_NONE, NULL, NULL);
+			fst_requires(session);
+			fst_check(status == SWITCH_STATUS_SUCCESS);
+
+			fst_check(switch_core_latency_get(NULL, SWITCH_LATENCY_ORIGINATE_ANSWER, &summary) == SWITCH_STATUS_SUCCESS);
+			fst_check(summary.count == 1);
+			fst_check(summary.max >= 500000);
+
+			switch_channel_hangup(switch_core_session_get_channel(session), SWITCH_CAUSE_NORMAL_CLEARING);
+			switch_core_session_rwunlock(session);
+			switch_core_latency_enable(SWITCH_FALSE);
+			switch_sleep(1000000);
+		}
+		FST_TEST_END()
+
 		FST_TEST_BEGIN(enterprise_originate_test_group_confirm_two_handles)
 		{
 			switch_core_session_t *session = NULL;
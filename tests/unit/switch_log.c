@@ -67,6 +67,25 @@ static switch_status_t test_logger(const switch_log_node_t *node, switch_log_lev
 	return SWITCH_STATUS_SUCCESS;
 }
 
+static int order_count = 0;
+static int order_errors = 0;
+
+static switch_status_t order_logger(const switch_log_node_t *node, switch_log_level_t level)
+{
+	const char *p;
+
+	if (level == SWITCH_LOG_ALERT && node->content && (p = strstr(node->content, "switch_log order: "))) {
+		switch_mutex_lock(mutex);
+		if (atoi(p + strlen("switch_log order: ")) != order_count) {
+			order_errors++;
+		}
+		order_count++;
+		switch_thread_cond_signal(cond);
+		switch_mutex_unlock(mutex);
+	}
+	return SWITCH_STATUS_SUCCESS;
+}
+
 static char *wait_for_log(switch_interval_time_t timeout_ms)
 {
 	char *log_str = NULL;
@@ -189,6 +208,64 @@ FST_CORE_BEGIN("./conf")
 			switch_log_unbind_logger(test_logger);
 		}
 		FST_SESSION_END()
+
+		FST_TEST_BEGIN(switch_log_trace)
+		{
+			switch_stream_handle_t stream = { 0 };
+			char path[1024];
+			int level = -2, quiet = SWITCH_LOG_ERROR;
+
+			switch_log_trace_init(1024);
+			switch_snprintf(path, sizeof(path), "%s%sswitch_log_trace.%d", SWITCH_GLOBAL_dirs.temp_dir, SWITCH_PATH_SEPARATOR, (int) getpid());
+
+			switch_core_session_ctl(SCSC_LOGLEVEL, &level);
+			switch_core_session_ctl(SCSC_LOGLEVEL, &quiet);
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "switch_log trace: %d %s %u %0.2f\n", -42, "not kept", 7u, 1.5);
+			switch_core_session_ctl(SCSC_LOGLEVEL, &level);
+
+			fst_requires(switch_log_trace_dump(path) == SWITCH_STATUS_SUCCESS);
+
+			SWITCH_STANDARD_STREAM(stream);
+			fst_check(switch_log_trace_decode(path, &stream) == SWITCH_STATUS_SUCCESS);
+			fst_check(stream.data && strstr((char *) stream.data, "[WARNING] switch_log.c:"));
+			fst_check(stream.data && strstr((char *) stream.data, "switch_log trace: -42 (str) 7 1.50\n"));
+			switch_safe_free(stream.data);
+
+			unlink(path);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(switch_log_batch_order)
+		{
+			switch_log_stats_t before = { 0 }, after = { 0 };
+			switch_time_t expiration;
+			int i, lines = 2000;
+
+			switch_log_get_stats(&before);
+			fst_check_int_equals(before.shards, 8);
+
+			switch_log_bind_logger(order_logger, SWITCH_LOG_ALERT, SWITCH_FALSE);
+
+			for (i = 0; i < lines; i++) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ALERT, "switch_log order: %d\n", i);
+			}
+
+			expiration = switch_time_now() + 5000000;
+			switch_mutex_lock(mutex);
+			while (order_count < lines && switch_time_now() < expiration) {
+				switch_thread_cond_timedwait(cond, mutex, 100000);
+			}
+			switch_mutex_unlock(mutex);
+
+			switch_log_unbind_logger(order_logger);
+			switch_log_get_stats(&after);
+
+			fst_check_int_equals(order_count, lines);
+			fst_check_int_equals(order_errors, 0);
+			fst_check(after.delivered >= before.delivered + lines);
+			fst_check_int_equals(after.dropped, before.dropped);
+		}
+		FST_TEST_END()
 	}
 	FST_SUITE_END()
 
@@ -42,6 +42,51 @@ static void send_rtcp_event_handler(switch_event_t *event)
 	show_event(event);
 }
 
+static void srtp_bench_callback(const switch_rtp_crypto_benchmark_t *result, void *user_data)
+{
+	int *failed = (int *) user_data;
+
+	if (result->status == SWITCH_STATUS_NOTIMPL) {
+		return;
+	}
+
+	if (result->status != SWITCH_STATUS_SUCCESS) {
+		(*failed)++;
+		return;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "%s: protect %.0f pps, unprotect %.0f pps\n",
+					  result->name, result->protect_pps, result->unprotect_pps);
+}
+
+/* both ends use the core cert, so each end's remote fingerprint is its own */
+static switch_status_t dtls_test_certs(dtls_fingerprint_t *local_fp, dtls_fingerprint_t *remote_fp)
+{
+	switch_core_gen_certs(DTLS_SRTP_FNAME ".pem");
+
+	local_fp->type = "sha-256";
+	if (!switch_core_cert_gen_fingerprint(DTLS_SRTP_FNAME, local_fp)) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	remote_fp->type = "sha-256";
+	switch_set_string(remote_fp->str, local_fp->str);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void dtls_test_ctx_counts(unsigned int *created, unsigned int *reused)
+{
+	switch_stream_handle_t stream = { 0 };
+
+	SWITCH_STANDARD_STREAM(stream);
+	switch_rtp_dtls_offload_status(&stream);
+	if (sscanf((char *) stream.data, "ssl contexts: created=%u reused=%u", created, reused) != 2) {
+		*created = *reused = 0;
+	}
+	switch_safe_free(stream.data);
+}
+
 FST_CORE_BEGIN("./conf")
 {
 FST_SUITE_BEGIN(switch_rtp)
@@ -277,6 +322,189 @@ FST_TEARDOWN_END()
 	}
 	FST_TEST_END()
 
+	FST_TEST_BEGIN(test_srtp_batch)
+	{
+		switch_core_session_t *session = NULL;
+		switch_secure_settings_t ssec = { 0 };
+		switch_call_cause_t cause;
+		switch_rtp_hdr_t *hdr;
+		uint8_t wire[4][sizeof(switch_rtp_hdr_t) + 160 + 256];
+		void *packets[4];
+		int lens[4], i;
+
+		switch_core_new_memory_pool(&pool);
+
+		switch_ivr_originate(NULL, &session, &cause, "null/+15553334444", 2, NULL, NULL, NULL, NULL, NULL, SOF_NONE, NULL, NULL);
+		fst_requires(session);
+		switch_core_memory_pool_set_data(pool, "__session", session);
+
+		rtp_session = switch_rtp_new(rx_host, rx_port, tx_host, tx_port, TEST_PT, 8000, 20 * 1000, flags, "soft", &err, pool, 0, 0);
+		fst_requires(rtp_session);
+
+		/* loop our own packets back through the receive context */
+		ssec.crypto_type = AEAD_AES_128_GCM;
+		for (i = 0; i < SWITCH_RTP_MAX_CRYPTO_LEN; i++) {
+			ssec.local_raw_key[i] = ssec.remote_raw_key[i] = (unsigned char) i;
+		}
+		fst_check(switch_rtp_add_crypto_key(rtp_session, SWITCH_RTP_CRYPTO_SEND, 1, &ssec) == SWITCH_STATUS_SUCCESS);
+		fst_check(switch_rtp_add_crypto_key(rtp_session, SWITCH_RTP_CRYPTO_RECV, 1, &ssec) == SWITCH_STATUS_SUCCESS);
+
+		for (i = 0; i < 4; i++) {
+			hdr = (switch_rtp_hdr_t *) wire[i];
+			memset(wire[i], 0, sizeof(wire[i]));
+			hdr->version = 2;
+			hdr->pt = TEST_PT;
+			hdr->seq = htons(100 + i);
+			hdr->ts = htonl(160 * i);
+			hdr->ssrc = htonl(0xabcd);
+			memset(wire[i] + sizeof(switch_rtp_hdr_t), 'a' + i, 160);
+			packets[i] = wire[i];
+			lens[i] = sizeof(switch_rtp_hdr_t) + 160;
+		}
+
+		fst_check_int_equals(switch_rtp_protect_batch(rtp_session, packets, lens, 4), 4);
+		fst_check(lens[3] > (int) sizeof(switch_rtp_hdr_t) + 160);
+		fst_check(wire[3][sizeof(switch_rtp_hdr_t)] != 'd');
+
+		fst_check_int_equals(switch_rtp_unprotect_batch(rtp_session, packets, lens, 4), 4);
+		fst_check_int_equals(lens[3], sizeof(switch_rtp_hdr_t) + 160);
+		fst_check(wire[3][sizeof(switch_rtp_hdr_t)] == 'd');
+
+		/* a replayed packet must not pass */
+		lens[0] = sizeof(switch_rtp_hdr_t) + 160;
+		fst_check_int_equals(switch_rtp_protect_batch(rtp_session, packets, lens, 1), 1);
+		fst_check_int_equals(switch_rtp_unprotect_batch(rtp_session, packets, lens, 1), 0);
+		fst_check_int_equals(lens[0], 0);
+
+		switch_rtp_destroy(&rtp_session);
+		switch_core_session_rwunlock(session);
+		switch_core_destroy_memory_pool(&pool);
+	}
+	FST_TEST_END()
+
+	FST_TEST_BEGIN(test_srtp_benchmark)
+	{
+		int failed = 0;
+
+		fst_check_int_equals(switch_rtp_benchmark_crypto(NULL, 1000, 160, srtp_bench_callback, &failed), CRYPTO_INVALID);
+		fst_check_int_equals(failed, 0);
+		fst_check_int_equals(switch_rtp_benchmark_crypto("AEAD_AES_128_GCM", 300, 1200, srtp_bench_callback, &failed), 1);
+		fst_check_int_equals(failed, 0);
+		fst_check_int_equals(switch_rtp_benchmark_crypto("NO_SUCH_SUITE", 10, 160, NULL, NULL), 0);
+	}
+	FST_TEST_END()
+
+	FST_TEST_BEGIN(test_dtls_setup_stats)
+	{
+		switch_rtp_stats_t *stats;
+		switch_stream_handle_t stream = { 0 };
+
+		switch_core_new_memory_pool(&pool);
+
+		rtp_session = switch_rtp_new(rx_host, rx_port, tx_host, tx_port, TEST_PT, 8000, 20 * 1000, flags, "soft", &err, pool, 0, 0);
+		fst_requires(rtp_session);
+
+		/* no dtls, no setup numbers */
+		fst_check(switch_rtp_dtls_state(rtp_session, DTLS_TYPE_RTP) == DS_OFF);
+		stats = switch_rtp_get_stats(rtp_session, pool);
+		fst_requires(stats);
+		fst_check_int_equals(stats->setup.dtls_rounds, 0);
+		fst_check(stats->setup.ice_to_dtls_usec == 0);
+
+		SWITCH_STANDARD_STREAM(stream);
+		switch_rtp_dtls_offload_status(&stream);
+		fst_check(strstr((char *) stream.data, "ssl contexts:") != NULL);
+		switch_safe_free(stream.data);
+
+		switch_rtp_destroy(&rtp_session);
+		switch_core_destroy_memory_pool(&pool);
+	}
+	FST_TEST_END()
+
+	FST_TEST_BEGIN(test_dtls_ctx_reuse)
+	{
+		switch_rtp_t *rtp_a = NULL, *rtp_b = NULL;
+		dtls_fingerprint_t local_fp = { 0 }, remote_fp = { 0 };
+		unsigned int created = 0, reused = 0, created2 = 0, reused2 = 0;
+
+		fst_requires(dtls_test_certs(&local_fp, &remote_fp) == SWITCH_STATUS_SUCCESS);
+
+		switch_core_new_memory_pool(&pool);
+
+		rtp_a = switch_rtp_new(rx_host, rx_port, tx_host, tx_port, TEST_PT, 8000, 20 * 1000, flags, "soft", &err, pool, 0, 0);
+		fst_requires(rtp_a);
+		rtp_b = switch_rtp_new(tx_host, tx_port, rx_host, rx_port, TEST_PT, 8000, 20 * 1000, flags, "soft", &err, pool, 0, 0);
+		fst_requires(rtp_b);
+
+		fst_requires(switch_rtp_add_dtls(rtp_a, &local_fp, &remote_fp, DTLS_TYPE_RTP | DTLS_TYPE_SERVER, 1) == SWITCH_STATUS_SUCCESS);
+		dtls_test_ctx_counts(&created, &reused);
+
+		/* same cert and role, the second one must not build another context */
+		fst_requires(switch_rtp_add_dtls(rtp_b, &local_fp, &remote_fp, DTLS_TYPE_RTP | DTLS_TYPE_SERVER, 1) == SWITCH_STATUS_SUCCESS);
+		dtls_test_ctx_counts(&created2, &reused2);
+
+		fst_check(created > 0);
+		fst_check_int_equals(created2, created);
+		fst_check_int_equals(reused2, reused + 1);
+
+		switch_rtp_destroy(&rtp_a);
+		switch_rtp_destroy(&rtp_b);
+		switch_core_destroy_memory_pool(&pool);
+	}
+	FST_TEST_END()
+
+	FST_TEST_BEGIN(test_dtls_handshake_workers)
+	{
+		switch_rtp_t *rtp_a = NULL, *rtp_b = NULL;
+		dtls_fingerprint_t local_fp = { 0 }, remote_fp_a = { 0 }, remote_fp_b;
+		switch_stream_handle_t stream = { 0 };
+		switch_rtp_stats_t *stats;
+		switch_frame_t frame = { 0 };
+		int loops;
+
+		fst_requires(dtls_test_certs(&local_fp, &remote_fp_a) == SWITCH_STATUS_SUCCESS);
+		/* each end checks the peer cert into its own remote fingerprint */
+		remote_fp_b = remote_fp_a;
+
+		switch_core_new_memory_pool(&pool);
+
+		rtp_a = switch_rtp_new(rx_host, rx_port, tx_host, tx_port, TEST_PT, 8000, 20 * 1000, flags, "soft", &err, pool, 0, 0);
+		fst_requires(rtp_a);
+		rtp_b = switch_rtp_new(tx_host, tx_port, rx_host, rx_port, TEST_PT, 8000, 20 * 1000, flags, "soft", &err, pool, 0, 0);
+		fst_requires(rtp_b);
+
+		fst_requires(switch_rtp_add_dtls(rtp_a, &local_fp, &remote_fp_a, DTLS_TYPE_RTP | DTLS_TYPE_SERVER, 1) == SWITCH_STATUS_SUCCESS);
+		fst_requires(switch_rtp_add_dtls(rtp_b, &local_fp, &remote_fp_b, DTLS_TYPE_RTP | DTLS_TYPE_CLIENT, 1) == SWITCH_STATUS_SUCCESS);
+
+		/* the read path feeds the handshake, the pool runs it */
+		for (loops = 0; loops < 200; loops++) {
+			if (switch_rtp_dtls_state(rtp_a, DTLS_TYPE_RTP) == DS_READY && switch_rtp_dtls_state(rtp_b, DTLS_TYPE_RTP) == DS_READY) {
+				break;
+			}
+
+			switch_rtp_zerocopy_read_frame(rtp_a, &frame, SWITCH_IO_FLAG_NOBLOCK);
+			switch_rtp_zerocopy_read_frame(rtp_b, &frame, SWITCH_IO_FLAG_NOBLOCK);
+			switch_yield(10000);
+		}
+
+		fst_check(switch_rtp_dtls_state(rtp_a, DTLS_TYPE_RTP) == DS_READY);
+		fst_check(switch_rtp_dtls_state(rtp_b, DTLS_TYPE_RTP) == DS_READY);
+
+		stats = switch_rtp_get_stats(rtp_b, pool);
+		fst_requires(stats);
+		fst_check(stats->setup.dtls_rounds > 0);
+
+		SWITCH_STANDARD_STREAM(stream);
+		switch_rtp_dtls_offload_status(&stream);
+		fst_check(strstr((char *) stream.data, "workers: 2") != NULL);
+		switch_safe_free(stream.data);
+
+		switch_rtp_destroy(&rtp_a);
+		switch_rtp_destroy(&rtp_b);
+		switch_core_destroy_memory_pool(&pool);
+	}
+	FST_TEST_END()
+
 }
 FST_SUITE_END()
 }